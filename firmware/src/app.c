@@ -56,6 +56,23 @@
 #include "definitions.h"
 #include "app_ble.h"
 #include "blecb_pipe.h"
+#include "app_heap_diag.h"
+#include "app_prof.h"
+#include "app_uart_tx.h"
+#include "app_uart_bridge.h"
+#include "app_spi_host.h"
+#include "app_trace.h"
+#include "app_lat.h"
+#include "app_dma_copy.h"
+#include "app_flash.h"
+#include "app_log.h"
+#include "app_spill.h"
+#include "app_aead.h"
+#include "app_digest.h"
+#include "app_dlog.h"
+#include "app_btsnoop.h"
+#include "app_gateway.h"
+#include "app_static.h"
 
 
 
@@ -137,7 +154,7 @@ void _BUTTON_Task(  void *pvParameters  )
     {
         if(CheckUserKeyPressed())
         {
-            Debug_Uart_Write_blocking((uint8_t *)"\n-> Pressed", 11);
+            APP_DLOG("\n-> Pressed");
             BLECB_Pipe_SendData((uint8_t *)"Message from WBZ451\r\n",21);
         }
     }
@@ -145,24 +162,56 @@ void _BUTTON_Task(  void *pvParameters  )
 
 
 /**
- * DEBUG UART BLOCKING WRITE
+ * DEBUG UART LOSSLESS WRITE: WAITS FOR ROOM IN THE TX RING, NOT FOR THE LINE
  * @param data
  * @param length
  */
 void Debug_Uart_Write_blocking(uint8_t *data, uint16_t length)
 {
-    SERCOM0_USART_Write(data, length);
-    while(SERCOM0_USART_WriteIsBusy());
+#if APP_UART_BRIDGE_ENABLE
+    // The UART only carries bridged data
+    (void)data;
+    (void)length;
+#else
+    APP_UartTxWriteAll(data, length);
+#endif
 }
 
 /**
- * DEBUG UART NON-BLOCKING WRITE
+ * DEBUG UART NON-BLOCKING WRITE: DROPS WHAT DOES NOT FIT IN THE TX RING
  * @param data
  * @param length
  */
 void Debug_Uart_Write(uint8_t *data, uint16_t length)
 {
-    SERCOM0_USART_Write(data, length);    
+#if APP_UART_BRIDGE_ENABLE
+    (void)data;
+    (void)length;
+#else
+    (void)APP_UartTxWrite(data, length);
+#endif
+}
+
+/**
+ * DIAGNOSTIC OUTPUT OVER THE PIPE (WRITE CALLBACK SIGNATURE OF THE DIAG MODULES)
+ * @param data
+ * @param length
+ */
+static void APP_PipeWrite(uint8_t *data, uint16_t length)
+{
+    (void)BLECB_Pipe_SendData(data, length);
+}
+
+/**
+ * TRACE FRAME OUTPUT: A DRAIN EMPTIES THE RING, SO EACH FRAME GOES TO BOTH
+ * THE DEBUG UART AND THE PIPE
+ * @param data
+ * @param length
+ */
+static void APP_TraceWrite(uint8_t *data, uint16_t length)
+{
+    Debug_Uart_Write_blocking(data, length);
+    BLECB_Pipe_SendData(data, length);
 }
 
 /**
@@ -174,13 +223,49 @@ void BLE_Rx_Callback(uint8_t *data, uint16_t length)
 {
     if (length >= 64)
     {   // print '*' if length >=64
-        SERCOM0_USART_Write((uint8_t *)"*", 1);
+        Debug_Uart_Write((uint8_t *)"*", 1);
     }
     else
     {
-        SERCOM0_USART_Write(data, length);        
+        Debug_Uart_Write(data, length);
+    }
+}
+
+/*******************************************************************************
+  Function:
+    bool APP_MsgSend ( uint8_t msgId, const void *p_data, uint16_t dataLen )
+
+  Remarks:
+    See prototype in app.h.
+ */
+
+bool APP_MsgSend(uint8_t msgId, const void *p_data, uint16_t dataLen)
+{
+    // Staging copy of the message, owned by whoever holds appMsgLock
+    static uint8_t msg[1 + APP_MSG_DATA_MAX];
+    size_t sent;
+
+    if (dataLen > APP_MSG_DATA_MAX)
+    {
+        return false;
+    }
+
+    // A message buffer has a single writer; senders in several tasks are
+    // serialized by the mutex, held only for the copy and the send
+    OSAL_MUTEX_Lock(&appData.appMsgLock, OSAL_WAIT_FOREVER);
+    msg[0] = msgId;
+    if (dataLen != 0)
+    {
+        memcpy(&msg[1], p_data, dataLen);
+    }
+    sent = xMessageBufferSend(appData.appMsgBuf, msg, 1U + dataLen, 0);
+    if (sent == 0)
+    {
+        appData.msgDropped++;
     }
-    while(SERCOM0_USART_WriteIsBusy());
+    OSAL_MUTEX_Unlock(&appData.appMsgLock);
+
+    return (sent != 0);
 }
 
 // *****************************************************************************
@@ -203,12 +288,40 @@ void APP_Initialize ( void )
     appData.state = APP_STATE_INIT;
 
 
-    appData.appQueue = xQueueCreate( 64, sizeof(APP_Msg_T) );
+    appData.appMsgBuf = APP_STATIC_MSGBUF_CREATE( APP_MSG_BUFFER_SIZE );
+    APP_STATIC_MUTEX_CREATE(&appData.appMsgLock);
+    appData.msgDropped = 0;
+
+    APP_ProfInit();
+    APP_UartTxInit();
+    APP_DlogInit(Debug_Uart_Write_blocking);
+#if APP_UART_BRIDGE_ENABLE
+    APP_BtSnoopInit(APP_PipeWrite, APP_BTSNOOP_PIPE_ACL_SNAPLEN);
+#else
+    APP_BtSnoopInit(Debug_Uart_Write_blocking, APP_BTSNOOP_ACL_SNAPLEN);
+#endif
+#if APP_GATEWAY_ENABLE
+#if APP_UART_BRIDGE_ENABLE || APP_SPI_HOST_ENABLE
+#error "The gateway takes the pipe and the UART, disable the UART bridge and the SPI host"
+#endif
+    APP_GatewayInit(APP_UartTxWrite, APP_UartTxSpace);
+#elif APP_UART_BRIDGE_ENABLE
+    APP_UartBridgeInit();
+#elif APP_SPI_HOST_ENABLE
+    APP_SpiHostInit();
+#endif
+    APP_TraceInit();
+    APP_LatInit();
+    APP_DmaCopyInit();
+    APP_FlashInit();
+#if APP_LOG_ENABLE
+    APP_LogInit();
+#endif
     /* TODO: Initialize your application's state machine and other
      * parameters.
      */
     
-    xTaskCreate((TaskFunction_t) _BUTTON_Task,
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _BUTTON_Task,
             "BUTTON_Task",
             1024,
             NULL,
@@ -244,13 +357,19 @@ void APP_Tasks ( void )
             GPIOB_REGS->GPIO_TRISSET =  APP_KEY_PB4;
             USERKEY_PRESSED = false;
 
-            //appData.appQueue = xQueueCreate( 10, sizeof(APP_Msg_T) );
             APP_BleStackInit();
+#if APP_BTSNOOP_AUTOSTART
+            APP_BtSnoopStart();
+#endif
 
             // Configure Bluetooth device address
             BLE_GAP_Addr_T devAddr;
             devAddr.addrType = BLE_GAP_ADDR_TYPE_PUBLIC;
+#if APP_BLE_CENTRAL_ENABLE
+            devAddr.addr[0] = 0xB0;     // The central board needs its own address
+#else
             devAddr.addr[0] = 0xB1;
+#endif
             devAddr.addr[1] = 0xB2;
             devAddr.addr[2] = 0xA3;
             devAddr.addr[3] = 0xA4;
@@ -258,10 +377,28 @@ void APP_Tasks ( void )
             devAddr.addr[5] = 0xA6;
             BLE_GAP_SetDeviceAddr(&devAddr); 
             
+#if APP_GATEWAY_ENABLE
+            APP_GatewayStart();
+            APP_DLOG("\n-> Initialized");
+            APP_DLOG("\n-> Gateway Scanning");
+#else
+#if APP_UART_BRIDGE_ENABLE
+            BLECB_Pipe_Init(APP_UartBridgePipeRx);
+            BLECB_Pipe_SetRxFlowControl(APP_UartTxSpace, APP_UART_TX_RING_SIZE);
+#elif APP_SPI_HOST_ENABLE
+            BLECB_Pipe_Init(APP_SpiHostPipeRx);
+            BLECB_Pipe_SetRxFlowControl(APP_SpiHostTxSpace, APP_SPI_HOST_TX_RING_SIZE);
+#else
             BLECB_Pipe_Init(BLE_Rx_Callback);
-            Debug_Uart_Write_blocking((uint8_t *)"\n-> Initialized", 15);
-            BLE_GAP_SetAdvEnable(0x01, 0x00);
-            Debug_Uart_Write_blocking((uint8_t *)"\n-> Start Advertising", 21);
+#endif
+            APP_DLOG("\n-> Initialized");
+            BLECB_Pipe_StartLink();
+#if APP_TRCBPC_ENABLE
+            APP_DLOG("\n-> Start Scanning");
+#else
+            APP_DLOG("\n-> Start Advertising");
+#endif
+#endif
 
             if (appInitialized)
             {
@@ -273,41 +410,115 @@ void APP_Tasks ( void )
 
         case APP_STATE_SERVICE_TASKS:
         {
-            if (OSAL_QUEUE_Receive(&appData.appQueue, &appMsg, OSAL_WAIT_FOREVER))
+            if (xMessageBufferReceive(appData.appMsgBuf, appMsg, sizeof(APP_Msg_T), portMAX_DELAY) != 0)
             {
                 if(p_appMsg->msgId==APP_MSG_BLE_STACK_EVT)
                 {
-                    bool eventConsumed = BLECB_Pipe_Event_Handler((STACK_Event_T *)p_appMsg->msgData);
-                    if (eventConsumed) return;
+                    APP_BLE_StackEvtMsg_T stackMsg;
+
+                    // The message carries a pointer to a pooled event slot
+                    memcpy(&stackMsg, p_appMsg->msgData, sizeof(stackMsg));
+                    APP_LatRecord(APP_LAT_STAGE_STACK_TO_APP, stackMsg.cbEntry);
                     
                     // Pass BLE Stack Event Message to User Application for handling
-                    APP_BleStackEvtHandler((STACK_Event_T *)p_appMsg->msgData);
+                    APP_BleStackEvtHandler(stackMsg.p_stackEvt);
                 }
                 else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_CONNECTED)
                 {
-                    SERCOM0_USART_Write((uint8_t *)"\n-> BLECB PIPE OPENED", 21);
+#if APP_UART_BRIDGE_ENABLE
+                    // btsnoop frames go over this channel: keep them out of the capture
+                    uint16_t connHandle, peerCid;
+                    if(BLECB_Pipe_GetChannel(&connHandle, &peerCid))
+                        APP_BtSnoopExcludeChannel(connHandle, peerCid);
+#endif
+                    APP_DLOG("\n-> BLECB PIPE OPENED");
                 }
                 else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_DISCONNECTED)
                 {
-                    SERCOM0_USART_Write((uint8_t *)"\n-> BLECB PIPE CLOSED", 21);
+#if APP_UART_BRIDGE_ENABLE
+                    APP_BtSnoopExcludeChannel(0, 0);
+#endif
+                    APP_DLOG("\n-> BLECB PIPE CLOSED");
                 }
                 else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_PHY_UPDATED)
                 {
                     if(phyInUse==BLE_GAP_PHY_OPTION_2M){
-                        SERCOM0_USART_Write((uint8_t *)"\n-> BLE PHY Updated to 2M", 25);
+                        APP_DLOG("\n-> BLE PHY Updated to 2M");
                     }
                     else{
-                        SERCOM0_USART_Write((uint8_t *)"\n-> BLE PHY Updated to 1M", 25);
+                        APP_DLOG("\n-> BLE PHY Updated to 1M");
                     }
                 }
                 else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_FILE_TX_START)
                 {
-                    SERCOM0_USART_Write((uint8_t *)"\n",1);
+                    APP_DLOG("\n");
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_HEAP_DUMP)
+                {
+                    // Heap snapshot requested over the pipe: answer on both the UART and the pipe
+                    APP_HeapDiagDump(Debug_Uart_Write_blocking);
+                    APP_HeapDiagDump(APP_PipeWrite);
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_PROF_REPORT)
+                {
+                    // Binary CPU profile frame, decoded by tools/prof_decoder.py
+                    APP_ProfSendReport(Debug_Uart_Write_blocking);
+                    APP_ProfSendReport(APP_PipeWrite);
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_PROF_RESET)
+                {
+                    APP_ProfReset();
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_TRACE_DUMP)
+                {
+                    // Binary trace frames, converted by tools/trace_to_json.py
+                    APP_TraceDrain(APP_TraceWrite);
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_TRACE_START)
+                {
+                    APP_TraceStart();
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_TRACE_STOP)
+                {
+                    APP_TraceStop();
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_DMA_BENCH)
+                {
+                    // memcpy against DMA copy timings, used to pick APP_DMA_COPY_THRESHOLD
+                    APP_DmaCopyBenchmark(Debug_Uart_Write_blocking);
+                    APP_DmaCopyBenchmark(APP_PipeWrite);
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_SNOOP_START)
+                {
+                    // btsnoop frames, collected by tools/btsnoop_extract.py
+                    APP_BtSnoopStart();
+                }
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_SNOOP_STOP)
+                {
+                    APP_BtSnoopStop();
+                }
+#if APP_SPILL_ENABLE
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_SPILL_REPORT)
+                {
+                    // Flash spill counters and rates; the pipe copy may itself be spilled
+                    APP_SpillReport(Debug_Uart_Write_blocking);
+                    APP_SpillReport(APP_PipeWrite);
+                }
+#endif
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_AES_BENCH)
+                {
+                    // Engine against software AES; with APP_AEAD_ENABLE the pipe copy goes out sealed
+                    APP_AeadBenchmark(Debug_Uart_Write_blocking);
+                    APP_AeadBenchmark(APP_PipeWrite);
                 }
-                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_FILE_TX_END)
+#if APP_DIGEST_ENABLE
+                else if(p_appMsg->msgId==APP_MSG_BLECB_PIPE_DIGEST_REPORT)
                 {
-                    SERCOM0_USART_Write((uint8_t *)p_appMsg->msgData,51);
+                    // Transfer digest counters; the pipe copy is itself hashed
+                    APP_DigestReport(Debug_Uart_Write_blocking);
+                    APP_DigestReport(APP_PipeWrite);
                 }
+#endif
                 else if(p_appMsg->msgId==APP_MSG_BLE_STACK_LOG)
                 {
                     // Pass BLE LOG Event Message to User Application for handling
@@ -58,6 +58,7 @@
 #include <stdlib.h>
 #include "configuration.h"
 #include "osal/osal_freertos_extend.h"
+#include "message_buffer.h"
 
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
@@ -106,17 +107,37 @@ typedef enum APP_MsgId_T
     APP_MSG_BLECB_PIPE_DISCONNECTED,
     APP_MSG_BLECB_PIPE_PHY_UPDATED,
     APP_MSG_BLECB_PIPE_FILE_TX_START,
-    APP_MSG_BLECB_PIPE_FILE_TX_END,
+    APP_MSG_BLECB_PIPE_HEAP_DUMP,
+    APP_MSG_BLECB_PIPE_PROF_REPORT,
+    APP_MSG_BLECB_PIPE_PROF_RESET,
+    APP_MSG_BLECB_PIPE_TRACE_DUMP,
+    APP_MSG_BLECB_PIPE_TRACE_START,
+    APP_MSG_BLECB_PIPE_TRACE_STOP,
+    APP_MSG_BLECB_PIPE_DMA_BENCH,
+    APP_MSG_BLECB_PIPE_SNOOP_START,
+    APP_MSG_BLECB_PIPE_SNOOP_STOP,
+    APP_MSG_BLECB_PIPE_SPILL_REPORT,
+    APP_MSG_BLECB_PIPE_AES_BENCH,
+    APP_MSG_BLECB_PIPE_DIGEST_REPORT,
     APP_MSG_IDLE            
             
 } APP_MsgId_T;
 
+/* Bytes of the application message buffer. Messages are stored with their
+ * real length (4 byte length word + msgId + data), so a pointer message takes
+ * 9 bytes instead of a full APP_Msg_T. */
+#define APP_MSG_BUFFER_SIZE     2048
+
+/* Layout of a message as it is sent and received. Only the msgId and the used
+ * part of msgData travel through the message buffer. */
 typedef struct APP_Msg_T
 {
     uint8_t msgId;
     uint8_t msgData[256];
 } APP_Msg_T;
 
+#define APP_MSG_DATA_MAX        sizeof(((APP_Msg_T *)0)->msgData)
+
 // *****************************************************************************
 /* Application Data
 
@@ -136,7 +157,13 @@ typedef struct
     APP_STATES state;
 
     /* TODO: Define any additional data used by the application. */
-    OSAL_QUEUE_HANDLE_TYPE appQueue;
+    MessageBufferHandle_t appMsgBuf;
+
+    /* Serializes the writers of appMsgBuf (APP_MsgSend) */
+    OSAL_MUTEX_HANDLE_TYPE appMsgLock;
+
+    /* Messages lost because the message buffer was full */
+    uint32_t msgDropped;
 
 } APP_DATA;
 
@@ -223,6 +250,33 @@ void APP_Initialize ( void );
 
 void APP_Tasks( void );
 
+
+/*******************************************************************************
+  Function:
+    bool APP_MsgSend ( uint8_t msgId, const void *p_data, uint16_t dataLen )
+
+  Summary:
+    Post a message to the application task.
+
+  Description:
+    Copies msgId and dataLen bytes of p_data into the application message
+    buffer. The receiver gets them back as an APP_Msg_T with the data at the
+    start of msgData. Never waits for room: a full buffer drops the message.
+    It only waits, with priority inheritance, while another task is inside
+    APP_MsgSend, so it may be called from the BLE stack callback and from
+    other tasks. Must not be called from an interrupt.
+
+  Parameters:
+    msgId   - One of APP_MsgId_T.
+    p_data  - Message data, may be NULL when dataLen is 0.
+    dataLen - Data length, up to APP_MSG_DATA_MAX.
+
+  Returns:
+    true if the message was queued, false if it does not fit.
+*/
+
+bool APP_MsgSend(uint8_t msgId, const void *p_data, uint16_t dataLen);
+
 void Debug_Uart_Write_blocking(uint8_t *data, uint16_t length);
 void Debug_Uart_Write(uint8_t *data, uint16_t length);
 
@@ -0,0 +1,786 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_aead.c
+
+  Summary:
+    AES-128-CCM sealing of the pipe messages, on the AES engine.
+
+  Description:
+    wolfCrypt's CCM (HAVE_AESCCM) calls wc_AesEncrypt per block, and on the
+    U2238 port every call resets the engine and loads the key again. Here a
+    message goes through the engine a chunk at a time instead: one CBC start
+    over the plaintext of the chunk for the MAC, its chaining value left in
+    aes.reg for the next chunk, and one ECB start over the chunk's counter
+    blocks for the key stream. The chunk is copied to a word aligned buffer
+    first, since the port moves words and pipe payloads sit 2 bytes into
+    their buffers.
+
+    The engine is started with the scheduler suspended, so starts of
+    different contexts never interleave; the device manager AES
+    (ble_dm_aes.c) does the same, and powers the engine on. TX and RX have
+    their own context: TX is sealed from any task (inside the pipe's TX
+    queue insertion, which fixes the nonce order), RX in the pipe task.
+
+    When the engine fails the device manager's known answer test, or CCM on
+    it does not give the bytes of RFC 3610 packet vector #1, sessions run on
+    the software AES of ble_dm_aes.c instead, a block at a time: the same
+    messages, many times slower.
+
+    The CCM core and the benchmark are built without APP_AEAD_ENABLE too.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include "definitions.h"
+#include "app_aead.h"
+#include "blecb_pipe.h"
+#include "wolfssl/wolfcrypt/aes.h"
+#include "ble_dm/ble_dm_aes.h"
+
+#if APP_AEAD_CHUNK == 0 || (APP_AEAD_CHUNK % 16) != 0
+#error "APP_AEAD_CHUNK must be a multiple of 16"
+#endif
+#if APP_AEAD_TAG_LEN < 4 || APP_AEAD_TAG_LEN > 16 || (APP_AEAD_TAG_LEN % 2) != 0
+#error "APP_AEAD_TAG_LEN must be 4, 6, 8, 10, 12, 14 or 16"
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_AEAD_BLOCK              16U
+#define APP_AEAD_DIR_TX             0x00U
+#define APP_AEAD_DIR_RX             0x01U
+
+/* CCM flags: 2 byte length field (L - 1 = 1); B0 adds the tag length, and
+ * whether associated data follows it */
+#define APP_AEAD_FLAGS_A            0x01U
+#define APP_AEAD_FLAGS_B0(tagLen)   (APP_AEAD_FLAGS_A | (8U * (((tagLen) - 2U) / 2U)))
+#define APP_AEAD_FLAGS_ADATA        0x40U
+
+/* Associated data fits the block after B0. Sessions have none; the known
+ * answer test has the 8 bytes of its vector. */
+#define APP_AEAD_AAD_MAX            14U
+
+#define APP_AEAD_BENCH_MAX          2048U
+#define APP_AEAD_BENCH_RUNS         4U
+
+typedef struct APP_AEAD_Ctx_T
+{
+    Aes         aes;
+    uint32_t    work[APP_AEAD_CHUNK / 4U];  /* Plaintext of the chunk */
+    uint32_t    ks[APP_AEAD_CHUNK / 4U];    /* Counter blocks, then key stream */
+} APP_AEAD_Ctx_T;
+
+static const uint16_t s_benchSizes[] = { 16, 64, 244, 512, 1024, 2048 };
+
+/* RFC 3610 packet vector #1: associated data 00..07, payload 08..1E, M = 8.
+ * Its key, C0..CF, is the benchmark's too. */
+#define APP_AEAD_KAT_AAD_LEN        8U
+#define APP_AEAD_KAT_LEN            23U
+#define APP_AEAD_KAT_TAG_LEN        8U
+
+static const uint8_t s_katKey[APP_AEAD_KEY_LEN] = {
+    0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF };
+static const uint8_t s_katNonce[APP_AEAD_NONCE_LEN] = {
+    0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+static const uint8_t s_katSealed[APP_AEAD_KAT_LEN + APP_AEAD_KAT_TAG_LEN] = {
+    0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+    0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84,
+    0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0 };
+
+#if APP_AEAD_ENABLE
+#if defined(APP_AEAD_KEY)
+static const uint8_t s_cfgKey[] = APP_AEAD_KEY;
+_Static_assert(sizeof(s_cfgKey) == APP_AEAD_KEY_LEN, "APP_AEAD_KEY must be 16 bytes");
+#else
+#error "APP_AEAD_ENABLE needs APP_AEAD_KEY, see configuration.h"
+#endif
+
+static APP_AEAD_Ctx_T s_tx;
+static APP_AEAD_Ctx_T s_rx;
+
+static uint8_t s_key[APP_AEAD_KEY_LEN];
+static uint8_t s_sessionKey[APP_AEAD_KEY_LEN];  /* For the software path */
+static bool s_haveKey;
+static bool s_engineOk;                     /* The engine passed its known answer test */
+static volatile bool s_session;
+static bool s_peerKeyed;                    /* A message of the peer opened in the session */
+static uint64_t s_txCount;                  /* Nonce of the next message, each way */
+static uint64_t s_rxCount;
+static uint8_t s_rsp[APP_AEAD_RSP_LEN];
+
+static APP_AEAD_Stats_T s_stats;
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_AeadEcb(APP_AEAD_Ctx_T *p_ctx, uint8_t *p_out, const uint8_t *p_in, uint32_t len)
+{
+    vTaskSuspendAll();
+    (void)wc_AesEcbEncrypt(&p_ctx->aes, p_out, p_in, len);
+    (void)xTaskResumeAll();
+}
+
+/* CBC-MAC len bytes, chained from and back into aes.reg; the CBC output
+ * itself is not needed and goes to ks. */
+static void APP_AeadCbcMac(APP_AEAD_Ctx_T *p_ctx, const uint8_t *p_in, uint32_t len)
+{
+    vTaskSuspendAll();
+    (void)wc_AesCbcEncrypt(&p_ctx->aes, (uint8_t *)p_ctx->ks, p_in, len);
+    (void)xTaskResumeAll();
+}
+
+static void APP_AeadNonce(uint8_t *p_nonce, uint8_t dir, uint64_t count)
+{
+    uint8_t i;
+
+    p_nonce[0] = dir;
+    for (i = 0; i < 8U; i++)
+    {
+        p_nonce[1U + i] = (uint8_t)(count >> (8U * i));
+    }
+    memset(&p_nonce[9], 0, APP_AEAD_NONCE_LEN - 9U);
+}
+
+/* Counter block A_i, or B0 with the flags and message length of B0 */
+static void APP_AeadCounterBlock(uint8_t *p_block, uint8_t flags, const uint8_t *p_nonce, uint16_t value)
+{
+    p_block[0] = flags;
+    memcpy(&p_block[1], p_nonce, APP_AEAD_NONCE_LEN);
+    p_block[14] = (uint8_t)(value >> 8);
+    p_block[15] = (uint8_t)value;
+}
+
+/* The blocks the CBC-MAC starts with: B0, then with associated data a block
+ * of its 2 byte length and the data, padded with zeros. Returns their size. */
+static uint32_t APP_AeadMacHeader(uint8_t *p_out, const uint8_t *p_nonce, const uint8_t *p_aad, uint8_t aadLen,
+                                  uint16_t length, uint8_t tagLen)
+{
+    if (aadLen == 0U)
+    {
+        APP_AeadCounterBlock(p_out, APP_AEAD_FLAGS_B0(tagLen), p_nonce, length);
+        return APP_AEAD_BLOCK;
+    }
+    APP_AeadCounterBlock(p_out, APP_AEAD_FLAGS_B0(tagLen) | APP_AEAD_FLAGS_ADATA, p_nonce, length);
+    memset(&p_out[APP_AEAD_BLOCK], 0, APP_AEAD_BLOCK);
+    p_out[APP_AEAD_BLOCK + 1U] = aadLen;
+    memcpy(&p_out[APP_AEAD_BLOCK + 2U], p_aad, aadLen);
+    return 2U * APP_AEAD_BLOCK;
+}
+
+/* CCM in place over length bytes: encrypt, or decrypt when open is set.
+ * Writes the tagLen byte tag the message should carry. aadLen is at most
+ * APP_AEAD_AAD_MAX. */
+static void APP_AeadCcm(APP_AEAD_Ctx_T *p_ctx, const uint8_t *p_nonce, const uint8_t *p_aad, uint8_t aadLen,
+                        uint8_t *p_msg, uint16_t length, bool open, uint8_t *p_tag, uint8_t tagLen)
+{
+    uint8_t *p_work = (uint8_t *)p_ctx->work;
+    uint8_t *p_ks = (uint8_t *)p_ctx->ks;
+    uint32_t block[2U * APP_AEAD_BLOCK / 4U];
+    uint32_t off;
+    uint32_t n;
+    uint32_t nb;
+    uint32_t i;
+    uint16_t counter = 1;
+
+    memset(p_ctx->aes.reg, 0, APP_AEAD_BLOCK);
+    n = APP_AeadMacHeader((uint8_t *)block, p_nonce, p_aad, aadLen, length, tagLen);
+    APP_AeadCbcMac(p_ctx, (uint8_t *)block, n);
+
+    for (off = 0; off < length; off += n)
+    {
+        n = length - off;
+        if (n > APP_AEAD_CHUNK)
+        {
+            n = APP_AEAD_CHUNK;
+        }
+        nb = (n + APP_AEAD_BLOCK - 1U) & ~(APP_AEAD_BLOCK - 1U);
+        memcpy(p_work, &p_msg[off], n);
+        memset(&p_work[n], 0, nb - n);      // CCM pads the last block of the MAC with zeros
+        if (!open)
+        {
+            APP_AeadCbcMac(p_ctx, p_work, nb);
+        }
+
+        for (i = 0; i < nb; i += APP_AEAD_BLOCK)
+        {
+            APP_AeadCounterBlock(&p_ks[i], APP_AEAD_FLAGS_A, p_nonce, counter++);
+        }
+        APP_AeadEcb(p_ctx, p_ks, p_ks, nb);
+        for (i = 0; i < nb / 4U; i++)
+        {
+            p_ctx->work[i] ^= p_ctx->ks[i];
+        }
+
+        if (open)
+        {
+            memset(&p_work[n], 0, nb - n);
+            APP_AeadCbcMac(p_ctx, p_work, nb);
+        }
+        memcpy(&p_msg[off], p_work, n);
+    }
+
+    // Tag: the MAC encrypted with A_0
+    APP_AeadCounterBlock((uint8_t *)block, APP_AEAD_FLAGS_A, p_nonce, 0);
+    APP_AeadEcb(p_ctx, (uint8_t *)block, (uint8_t *)block, APP_AEAD_BLOCK);
+    for (i = 0; i < tagLen; i++)
+    {
+        p_tag[i] = ((uint8_t *)p_ctx->aes.reg)[i] ^ ((uint8_t *)block)[i];
+    }
+}
+
+/* Compare without stopping at the first difference */
+static bool APP_AeadTagEqual(const uint8_t *p_a, const uint8_t *p_b)
+{
+    uint8_t diff = 0;
+    uint8_t i;
+
+    for (i = 0; i < APP_AEAD_TAG_LEN; i++)
+    {
+        diff |= p_a[i] ^ p_b[i];
+    }
+    return diff == 0U;
+}
+
+/* CCM over the software AES, a block at a time, as APP_AeadCcm: for the
+ * benchmark, and for sessions when the engine failed its self test.
+ * BLE_DM_AesSw128Encrypt expands the key on every call. */
+static void APP_AeadSoftCcm(uint8_t *p_key, const uint8_t *p_nonce, const uint8_t *p_aad, uint8_t aadLen,
+                            uint8_t *p_msg, uint16_t length, bool open, uint8_t *p_tag, uint8_t tagLen)
+{
+    uint8_t mac[APP_AEAD_BLOCK];
+    uint8_t block[2U * APP_AEAD_BLOCK];
+    uint32_t off;
+    uint32_t n;
+    uint32_t i;
+    uint16_t counter = 1;
+
+    n = APP_AeadMacHeader(block, p_nonce, p_aad, aadLen, length, tagLen);
+    BLE_DM_AesSw128Encrypt(p_key, block, mac);
+    if (n > APP_AEAD_BLOCK)
+    {
+        for (i = 0; i < APP_AEAD_BLOCK; i++)
+        {
+            mac[i] ^= block[APP_AEAD_BLOCK + i];
+        }
+        BLE_DM_AesSw128Encrypt(p_key, mac, mac);
+    }
+    for (off = 0; off < length; off += n)
+    {
+        n = length - off;
+        if (n > APP_AEAD_BLOCK)
+        {
+            n = APP_AEAD_BLOCK;
+        }
+        APP_AeadCounterBlock(block, APP_AEAD_FLAGS_A, p_nonce, counter++);
+        BLE_DM_AesSw128Encrypt(p_key, block, block);
+        // The MAC covers the plaintext: before encrypting, after decrypting
+        for (i = 0; i < n; i++)
+        {
+            if (open)
+            {
+                p_msg[off + i] ^= block[i];
+            }
+            mac[i] ^= p_msg[off + i];
+            if (!open)
+            {
+                p_msg[off + i] ^= block[i];
+            }
+        }
+        BLE_DM_AesSw128Encrypt(p_key, mac, mac);
+    }
+    APP_AeadCounterBlock(block, APP_AEAD_FLAGS_A, p_nonce, 0);
+    BLE_DM_AesSw128Encrypt(p_key, block, block);
+    for (i = 0; i < tagLen; i++)
+    {
+        p_tag[i] = mac[i] ^ block[i];
+    }
+}
+
+/* Seal RFC 3610 packet vector #1 and open it again, on the engine with p_ctx
+ * or, when it is NULL, in software. Both have to give the published bytes. */
+static bool APP_AeadKnownAnswer(APP_AEAD_Ctx_T *p_ctx)
+{
+    uint8_t key[APP_AEAD_KEY_LEN];
+    uint8_t aad[APP_AEAD_KAT_AAD_LEN];
+    uint8_t msg[APP_AEAD_KAT_LEN + APP_AEAD_KAT_TAG_LEN];
+    uint8_t tag[APP_AEAD_KAT_TAG_LEN];
+    uint8_t diff = 0;
+    uint8_t i;
+
+    memcpy(key, s_katKey, sizeof(key));
+    for (i = 0; i < APP_AEAD_KAT_AAD_LEN; i++)
+    {
+        aad[i] = i;
+    }
+    for (i = 0; i < APP_AEAD_KAT_LEN; i++)
+    {
+        msg[i] = (uint8_t)(APP_AEAD_KAT_AAD_LEN + i);
+    }
+
+    if (p_ctx != NULL)
+    {
+        (void)wc_AesSetKey(&p_ctx->aes, key, APP_AEAD_KEY_LEN, NULL, AES_ENCRYPTION);
+        APP_AeadCcm(p_ctx, s_katNonce, aad, sizeof(aad), msg, APP_AEAD_KAT_LEN, false, &msg[APP_AEAD_KAT_LEN],
+                    APP_AEAD_KAT_TAG_LEN);
+    }
+    else
+    {
+        APP_AeadSoftCcm(key, s_katNonce, aad, sizeof(aad), msg, APP_AEAD_KAT_LEN, false, &msg[APP_AEAD_KAT_LEN],
+                        APP_AEAD_KAT_TAG_LEN);
+    }
+    for (i = 0; i < sizeof(msg); i++)
+    {
+        diff |= msg[i] ^ s_katSealed[i];
+    }
+
+    if (p_ctx != NULL)
+    {
+        APP_AeadCcm(p_ctx, s_katNonce, aad, sizeof(aad), msg, APP_AEAD_KAT_LEN, true, tag, APP_AEAD_KAT_TAG_LEN);
+    }
+    else
+    {
+        APP_AeadSoftCcm(key, s_katNonce, aad, sizeof(aad), msg, APP_AEAD_KAT_LEN, true, tag, APP_AEAD_KAT_TAG_LEN);
+    }
+    for (i = 0; i < APP_AEAD_KAT_TAG_LEN; i++)
+    {
+        diff |= tag[i] ^ s_katSealed[APP_AEAD_KAT_LEN + i];
+    }
+    for (i = 0; i < APP_AEAD_KAT_LEN; i++)
+    {
+        diff |= msg[i] ^ (uint8_t)(APP_AEAD_KAT_AAD_LEN + i);
+    }
+    return diff == 0U;
+}
+
+#if APP_AEAD_ENABLE
+static void APP_AeadRandom(uint8_t *p_out, uint8_t len)
+{
+    uint32_t word;
+    uint8_t n;
+
+    TRNG_REGS->TRNG_CTRLA = TRNG_CTRLA_ENABLE_Msk;
+    while (len > 0U)
+    {
+        while ((TRNG_REGS->TRNG_INTFLAG & TRNG_INTFLAG_DATARDY_Msk) == 0U)
+        {
+        }
+        word = TRNG_REGS->TRNG_DATA;
+        n = (len < 4U) ? len : 4U;
+        memcpy(p_out, &word, n);
+        p_out += n;
+        len -= n;
+    }
+    TRNG_REGS->TRNG_CTRLA = 0;
+}
+
+/* Queue the response; the random is already in place for APP_AEAD_STATUS_OK.
+ * Lost if the TX queue is full, the peer then sends its hello again. */
+static bool APP_AeadRespond(uint8_t status)
+{
+    memcpy(s_rsp, APP_AEAD_MAGIC, APP_AEAD_MAGIC_LEN);
+    s_rsp[APP_AEAD_MAGIC_LEN] = APP_AEAD_OP_RESPONSE;
+    s_rsp[APP_AEAD_HDR_LEN] = status;
+    if (status != APP_AEAD_STATUS_OK)
+    {
+        memset(&s_rsp[APP_AEAD_HDR_LEN + 1U], 0, APP_AEAD_RANDOM_LEN);
+    }
+    return BLECB_Pipe_SendPlain(s_rsp, APP_AEAD_RSP_LEN);
+}
+
+static void APP_AeadStart(const uint8_t *p_peerRandom)
+{
+    uint32_t block[APP_AEAD_BLOCK / 4U];
+    uint8_t *p_block = (uint8_t *)block;
+
+    if (!s_haveKey)
+    {
+        (void)APP_AeadRespond(APP_AEAD_STATUS_NO_KEY);
+        return;
+    }
+
+    APP_AeadRandom(&s_rsp[APP_AEAD_HDR_LEN + 1U], APP_AEAD_RANDOM_LEN);
+    memcpy(p_block, p_peerRandom, APP_AEAD_RANDOM_LEN);
+    memcpy(&p_block[APP_AEAD_RANDOM_LEN], &s_rsp[APP_AEAD_HDR_LEN + 1U], APP_AEAD_RANDOM_LEN);
+    if (s_engineOk)
+    {
+        (void)wc_AesSetKey(&s_rx.aes, s_key, APP_AEAD_KEY_LEN, NULL, AES_ENCRYPTION);
+        APP_AeadEcb(&s_rx, p_block, p_block, APP_AEAD_BLOCK);
+        (void)wc_AesSetKey(&s_tx.aes, p_block, APP_AEAD_KEY_LEN, NULL, AES_ENCRYPTION);
+        (void)wc_AesSetKey(&s_rx.aes, p_block, APP_AEAD_KEY_LEN, NULL, AES_ENCRYPTION);
+    }
+    else
+    {
+        BLE_DM_AesSw128Encrypt(s_key, p_block, s_sessionKey);
+    }
+    memset(block, 0, sizeof(block));
+    s_txCount = 0;
+    s_rxCount = 0;
+
+    if (!APP_AeadRespond(APP_AEAD_STATUS_OK))
+    {
+        return;
+    }
+    s_stats.sessions++;
+    s_session = true;
+}
+
+/* Seal or open on the engine, or in software when it failed its self test */
+static void APP_AeadSessionCcm(APP_AEAD_Ctx_T *p_ctx, const uint8_t *p_nonce, uint8_t *p_msg, uint16_t length,
+                               bool open, uint8_t *p_tag)
+{
+    if (s_engineOk)
+    {
+        APP_AeadCcm(p_ctx, p_nonce, NULL, 0, p_msg, length, open, p_tag, APP_AEAD_TAG_LEN);
+    }
+    else
+    {
+        APP_AeadSoftCcm(s_sessionKey, p_nonce, NULL, 0, p_msg, length, open, p_tag, APP_AEAD_TAG_LEN);
+    }
+}
+
+#endif
+
+/* One block through the device manager AES, engine against software, in
+ * cycles per call: the key is loaded (engine) or expanded (software) each
+ * time, as the device manager uses it. */
+static void APP_AeadBlockBenchmark(APP_AEAD_WRITE write, uint8_t *p_key)
+{
+    uint8_t plain[APP_AEAD_BLOCK];
+    uint8_t hw[APP_AEAD_BLOCK];
+    uint8_t sw[APP_AEAD_BLOCK];
+    uint32_t best[4] = { UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX };
+    uint32_t start;
+    uint32_t cycles[4];
+    uint32_t run;
+    uint8_t i;
+    bool ok = true;
+    char line[96];
+    int n;
+
+    for (i = 0; i < APP_AEAD_BLOCK; i++)
+    {
+        plain[i] = (uint8_t)(i * 0x11U);
+    }
+    for (run = 0; run < APP_AEAD_BENCH_RUNS; run++)
+    {
+        vTaskSuspendAll();
+        start = DWT->CYCCNT;
+        BLE_DM_Aes128Encrypt(p_key, plain, hw);
+        cycles[0] = DWT->CYCCNT - start;
+        start = DWT->CYCCNT;
+        BLE_DM_AesSw128Encrypt(p_key, plain, sw);
+        cycles[1] = DWT->CYCCNT - start;
+        ok = ok && memcmp(hw, sw, APP_AEAD_BLOCK) == 0;
+        start = DWT->CYCCNT;
+        BLE_DM_Aes128Decrypt(p_key, hw, sw);
+        cycles[2] = DWT->CYCCNT - start;
+        start = DWT->CYCCNT;
+        BLE_DM_AesSw128Decrypt(p_key, hw, sw);
+        cycles[3] = DWT->CYCCNT - start;
+        (void)xTaskResumeAll();
+        ok = ok && memcmp(hw, plain, APP_AEAD_BLOCK) == 0 && memcmp(sw, plain, APP_AEAD_BLOCK) == 0;
+        for (i = 0; i < 4U; i++)
+        {
+            best[i] = (cycles[i] < best[i]) ? cycles[i] : best[i];
+        }
+    }
+
+    n = sprintf(line, "block, cycles: encrypt hw %lu sw %lu, decrypt hw %lu sw %lu%s\n",
+                (unsigned long)best[0], (unsigned long)best[1], (unsigned long)best[2], (unsigned long)best[3],
+                ok ? "" : " MISMATCH");
+    write((uint8_t *)line, (uint16_t)n);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+#if APP_AEAD_ENABLE
+void APP_AeadInit(void)
+{
+    CLK_PMD3Enable(CFG_PMD3_RNGMD_Msk);
+
+    (void)wc_AesInit(&s_tx.aes, NULL, INVALID_DEVID);
+    (void)wc_AesInit(&s_rx.aes, NULL, INVALID_DEVID);
+    // The CCM run on the engine has to give the RFC 3610 bytes as well; its key is wiped by the reset
+    s_engineOk = BLE_DM_AesHwInit() && APP_AeadKnownAnswer(&s_rx);
+    APP_AeadSetKey(s_cfgKey);
+    APP_AeadReset();
+}
+
+void APP_AeadSetKey(const uint8_t *p_key)
+{
+    memcpy(s_key, p_key, APP_AEAD_KEY_LEN);
+    s_haveKey = true;
+}
+
+bool APP_AeadTxReady(void)
+{
+    if (!s_session)
+    {
+        s_stats.noSession++;
+    }
+    return s_session;
+}
+
+bool APP_AeadRxReady(void)
+{
+    if (!s_peerKeyed)
+    {
+        s_stats.noSession++;
+    }
+    return s_peerKeyed;
+}
+
+bool APP_AeadSeal(uint8_t *p_msg, uint16_t length)
+{
+    uint8_t nonce[APP_AEAD_NONCE_LEN];
+
+    if (!s_session)
+    {
+        return false;
+    }
+    APP_AeadNonce(nonce, APP_AEAD_DIR_TX, s_txCount++);
+    APP_AeadSessionCcm(&s_tx, nonce, p_msg, length, false, &p_msg[length]);
+    s_stats.sealed++;
+    s_stats.sealedBytes += length;
+    return true;
+}
+
+int32_t APP_AeadRxMessage(uint8_t *p_msg, uint16_t length)
+{
+    uint8_t nonce[APP_AEAD_NONCE_LEN];
+    uint8_t tag[APP_AEAD_TAG_LEN];
+    bool isHello = length == APP_AEAD_HELLO_LEN && memcmp(p_msg, APP_AEAD_MAGIC, APP_AEAD_MAGIC_LEN) == 0
+                   && p_msg[APP_AEAD_MAGIC_LEN] == APP_AEAD_OP_HELLO;
+
+    if (s_session)
+    {
+        // A sealed message may look like a hello: it is tried as sealed first
+        if (length >= APP_AEAD_TAG_LEN)
+        {
+            length -= APP_AEAD_TAG_LEN;
+            APP_AeadNonce(nonce, APP_AEAD_DIR_RX, s_rxCount);
+            APP_AeadSessionCcm(&s_rx, nonce, p_msg, length, true, tag);
+            if (APP_AeadTagEqual(tag, &p_msg[length]))
+            {
+                s_rxCount++;
+                s_peerKeyed = true;
+                s_stats.opened++;
+                s_stats.openedBytes += length;
+                return length;
+            }
+            memset(p_msg, 0, length);
+        }
+        if (isHello)
+        {
+            (void)APP_AeadRespond(APP_AEAD_STATUS_BAD_STATE);
+        }
+        else
+        {
+            s_stats.authFailures++;
+        }
+        return -1;
+    }
+
+    if (isHello)
+    {
+        APP_AeadStart(&p_msg[APP_AEAD_HDR_LEN]);
+    }
+    else if (length >= APP_AEAD_HDR_LEN && memcmp(p_msg, APP_AEAD_MAGIC, APP_AEAD_MAGIC_LEN) == 0)
+    {
+        (void)APP_AeadRespond(APP_AEAD_STATUS_BAD_SIZE);
+    }
+    else
+    {
+        s_stats.noSession++;
+    }
+    return -1;
+}
+
+void APP_AeadRxLost(void)
+{
+    if (s_session)
+    {
+        s_rxCount++;
+    }
+}
+
+void APP_AeadReset(void)
+{
+    vTaskSuspendAll();
+    s_session = false;
+    s_peerKeyed = false;
+    s_txCount = 0;
+    s_rxCount = 0;
+    memset(s_tx.aes.key, 0, sizeof(s_tx.aes.key));
+    memset(s_rx.aes.key, 0, sizeof(s_rx.aes.key));
+    memset(s_sessionKey, 0, sizeof(s_sessionKey));
+    (void)xTaskResumeAll();
+}
+
+void APP_AeadGetStats(APP_AEAD_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+#endif /* APP_AEAD_ENABLE */
+
+void APP_AeadBenchmark(APP_AEAD_WRITE write)
+{
+    APP_AEAD_Ctx_T *p_ctx = OSAL_Malloc(sizeof(APP_AEAD_Ctx_T));
+    uint8_t *p_hw = OSAL_Malloc(APP_AEAD_BENCH_MAX + APP_AEAD_TAG_LEN);
+    uint8_t *p_sw = OSAL_Malloc(APP_AEAD_BENCH_MAX + APP_AEAD_TAG_LEN);
+    uint8_t key[APP_AEAD_KEY_LEN];
+    uint8_t nonce[APP_AEAD_NONCE_LEN];
+    uint8_t tag[APP_AEAD_TAG_LEN];
+    uint32_t best[3];
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t run;
+    uint32_t i;
+    uint16_t size;
+    uint8_t s;
+    bool ok;
+    char line[96];
+    int n;
+
+    if (p_ctx == NULL || p_hw == NULL || p_sw == NULL)
+    {
+        write((uint8_t *)"\nAES-CCM benchmark: out of memory\n", 34);
+        OSAL_Free(p_ctx);
+        OSAL_Free(p_hw);
+        OSAL_Free(p_sw);
+        return;
+    }
+    if (!BLE_DM_AesHwInit())
+    {
+        write((uint8_t *)"\nAES-CCM benchmark: AES engine failed its self test\n", 52);
+        OSAL_Free(p_ctx);
+        OSAL_Free(p_hw);
+        OSAL_Free(p_sw);
+        return;
+    }
+    memcpy(key, s_katKey, sizeof(key));
+    (void)wc_AesInit(&p_ctx->aes, NULL, INVALID_DEVID);
+
+    n = sprintf(line, "\nAES-CCM benchmark, best of %u, cycles per byte at %lu MHz, tag %u\n",
+                (unsigned)APP_AEAD_BENCH_RUNS, (unsigned long)(configCPU_CLOCK_HZ / 1000000UL), (unsigned)APP_AEAD_TAG_LEN);
+    write((uint8_t *)line, (uint16_t)n);
+    n = sprintf(line, "RFC 3610 packet vector #1: hw %s, sw %s\n", APP_AeadKnownAnswer(p_ctx) ? "ok" : "FAIL",
+                APP_AeadKnownAnswer(NULL) ? "ok" : "FAIL");
+    write((uint8_t *)line, (uint16_t)n);
+    (void)wc_AesSetKey(&p_ctx->aes, key, APP_AEAD_KEY_LEN, NULL, AES_ENCRYPTION);
+    APP_AeadNonce(nonce, APP_AEAD_DIR_TX, 0x0706050403020100ULL);
+    APP_AeadBlockBenchmark(write, key);
+    n = sprintf(line, "%6s %9s %9s %9s %8s\n", "size", "hw seal", "hw open", "sw seal", "sw/hw");
+    write((uint8_t *)line, (uint16_t)n);
+
+    for (s = 0; s < sizeof(s_benchSizes) / sizeof(s_benchSizes[0]); s++)
+    {
+        size = s_benchSizes[s];
+        best[0] = UINT32_MAX;
+        best[1] = UINT32_MAX;
+        best[2] = UINT32_MAX;
+        ok = true;
+        for (run = 0; run < APP_AEAD_BENCH_RUNS; run++)
+        {
+            for (i = 0; i < size; i++)
+            {
+                p_hw[i] = (uint8_t)(i * 7U + 1U);
+            }
+            memcpy(p_sw, p_hw, size);
+
+            vTaskSuspendAll();
+            start = DWT->CYCCNT;
+            APP_AeadCcm(p_ctx, nonce, NULL, 0, p_hw, size, false, &p_hw[size], APP_AEAD_TAG_LEN);
+            cycles = DWT->CYCCNT - start;
+            (void)xTaskResumeAll();
+            best[0] = (cycles < best[0]) ? cycles : best[0];
+
+            vTaskSuspendAll();
+            start = DWT->CYCCNT;
+            APP_AeadSoftCcm(key, nonce, NULL, 0, p_sw, size, false, &p_sw[size], APP_AEAD_TAG_LEN);
+            cycles = DWT->CYCCNT - start;
+            (void)xTaskResumeAll();
+            best[2] = (cycles < best[2]) ? cycles : best[2];
+            ok = ok && memcmp(p_hw, p_sw, size + APP_AEAD_TAG_LEN) == 0;
+
+            vTaskSuspendAll();
+            start = DWT->CYCCNT;
+            APP_AeadCcm(p_ctx, nonce, NULL, 0, p_hw, size, true, tag, APP_AEAD_TAG_LEN);
+            cycles = DWT->CYCCNT - start;
+            (void)xTaskResumeAll();
+            best[1] = (cycles < best[1]) ? cycles : best[1];
+            ok = ok && APP_AeadTagEqual(tag, &p_hw[size]) && p_hw[size - 1U] == (uint8_t)((size - 1U) * 7U + 1U);
+        }
+
+        // Hundredths of a cycle per byte
+        for (i = 0; i < 3U; i++)
+        {
+            best[i] = (uint32_t)((uint64_t)best[i] * 100U / size);
+        }
+        n = sprintf(line, "%6u %6lu.%02lu %6lu.%02lu %6lu.%02lu %7lux%s\n", (unsigned)size,
+                    (unsigned long)(best[0] / 100U), (unsigned long)(best[0] % 100U),
+                    (unsigned long)(best[1] / 100U), (unsigned long)(best[1] % 100U),
+                    (unsigned long)(best[2] / 100U), (unsigned long)(best[2] % 100U),
+                    (unsigned long)(best[0] != 0U ? best[2] / best[0] : 0U), ok ? "" : " MISMATCH");
+        write((uint8_t *)line, (uint16_t)n);
+    }
+
+    n = sprintf(line, "chunk %u bytes, sw: ble_dm_aes, key expanded per block\n", (unsigned)APP_AEAD_CHUNK);
+    write((uint8_t *)line, (uint16_t)n);
+
+    memset(p_ctx, 0, sizeof(APP_AEAD_Ctx_T));
+    OSAL_Free(p_ctx);
+    OSAL_Free(p_hw);
+    OSAL_Free(p_sw);
+}
+
+/*******************************************************************************
+ End of File
+ */
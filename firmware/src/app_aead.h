@@ -0,0 +1,291 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_aead.h
+
+  Summary:
+    AES-128-CCM sealing of the pipe messages, on the AES engine.
+
+  Description:
+    With APP_AEAD_ENABLE (configuration.h) the pipe carries application data
+    only inside a session. The peer opens one per connection with a pipe
+    message starting with APP_AEAD_MAGIC and a random of its own; the board
+    answers with another, and both sides take
+        session key = AES-128(shared key, peer random | board random)
+    the way BLE pairing builds its STK. The shared key is APP_AEAD_KEY
+    (configuration.h) unless APP_AeadSetKey replaced it. A session ends
+    with the connection. tools/aead_peer.py is a host peer.
+
+    In a session each message given to BLECB_Pipe_SendData is encrypted in
+    place in its TX queue buffer and followed by an APP_AEAD_TAG_LEN byte
+    tag; the length field of the pipe counts the tag. Received messages are
+    checked and decrypted in place in the reassembly buffer before the
+    application sees them. The nonce is implicit: a direction byte and the
+    number of messages sent that way in the session, so nothing else goes
+    on the air and a replayed, dropped or reordered message fails its tag.
+
+    CCM needs a CBC-MAC and a CTR key stream. The engine runs both over
+    APP_AEAD_CHUNK bytes per start, chained through the wolfCrypt Aes
+    context, so its key and mode are loaded once per chunk rather than once
+    per block.
+
+    The firmware update and data log requests, recognised by their magic,
+    come in clear, but are taken only once the peer has shown it holds the
+    shared key: a session is up and a sealed message of the peer has opened
+    in it (it may be empty). A hello alone proves nothing, anyone can send
+    one. An update is authenticated by its own key (APP_DFU_KEY) as well.
+    What the board sends back, the responses and the log batches, goes
+    through BLECB_Pipe_SendProto and is sealed like any other message; a
+    log batch is copied to a TX queue buffer for it, so batches are capped
+    at APP_LOG_SEALED_BATCH_MAX. Only the session response
+    (BLECB_Pipe_SendPlain) stays in clear.
+*******************************************************************************/
+
+#ifndef _APP_AEAD_H
+#define _APP_AEAD_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Bytes the engine takes per start: a multiple of the 16 byte block. Two
+ * buffers of this size are kept per context. */
+#ifndef APP_AEAD_CHUNK
+#define APP_AEAD_CHUNK                  128
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Session messages, in clear, little endian:
+ *
+ *   magic      4   0x7E 'A' 'E' 'K'
+ *   op         1
+ *   'H' hello     peer random 8          peer to board
+ *   'R' response  status 1, board random 8
+ *
+ * The session is up once the response is queued. A hello in a session is
+ * answered with APP_AEAD_STATUS_BAD_STATE and changes nothing.
+ *
+ * CCM parameters: 13 byte nonce, 2 byte length field, no associated data.
+ * Nonce: direction 1 (0 board to peer, 1 peer to board), message counter
+ * 8, then 4 zero bytes.
+ */
+#define APP_AEAD_MAGIC                  "\x7E" "AEK"
+#define APP_AEAD_MAGIC_LEN              4
+#define APP_AEAD_HDR_LEN                (APP_AEAD_MAGIC_LEN + 1)
+#define APP_AEAD_RANDOM_LEN             8
+#define APP_AEAD_HELLO_LEN              (APP_AEAD_HDR_LEN + APP_AEAD_RANDOM_LEN)
+#define APP_AEAD_RSP_LEN                (APP_AEAD_HDR_LEN + 1 + APP_AEAD_RANDOM_LEN)
+#define APP_AEAD_KEY_LEN                16
+#define APP_AEAD_NONCE_LEN              13
+
+#define APP_AEAD_OP_HELLO               'H'
+#define APP_AEAD_OP_RESPONSE            'R'
+
+#define APP_AEAD_STATUS_OK              0x00
+#define APP_AEAD_STATUS_NO_KEY          0x01    /* No shared key */
+#define APP_AEAD_STATUS_BAD_STATE       0x02    /* A session is already up */
+#define APP_AEAD_STATUS_BAD_SIZE        0x03
+
+typedef struct APP_AEAD_Stats_T
+{
+    uint32_t    sessions;
+    uint32_t    sealed;                 /* Messages sent sealed */
+    uint32_t    sealedBytes;            /* Their plaintext bytes */
+    uint32_t    opened;                 /* Messages received that passed their tag */
+    uint32_t    openedBytes;
+    uint32_t    authFailures;           /* Dropped: wrong tag, or out of order */
+    uint32_t    noSession;              /* Refused or dropped outside a session, or before the peer's first sealed message */
+} APP_AEAD_Stats_T;
+
+/* Output for the benchmark table, as APP_SPILL_WRITE. */
+typedef void (*APP_AEAD_WRITE)(uint8_t *data, uint16_t length);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_AeadInit ( void )
+
+  Summary:
+     Turn on the TRNG, which the clock setup leaves off, and take
+     APP_AEAD_KEY as the shared key. BLE_DM_AesHwInit turns on the AES
+     engine and tests it; sessions fall back to the software AES of
+     ble_dm_aes.c unless it passes and also gives the bytes of RFC 3610
+     packet vector #1. Called by BLECB_Pipe_Init.
+*/
+void APP_AeadInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_AeadSetKey ( const uint8_t *p_key )
+
+  Summary:
+     Replace the APP_AEAD_KEY_LEN byte key shared with the peers, e.g. with
+     one provisioned per device. Sessions opened afterwards use it.
+*/
+void APP_AeadSetKey(const uint8_t *p_key);
+
+/*******************************************************************************
+  Function:
+    bool APP_AeadTxReady ( void )
+
+  Summary:
+     Whether a session is up, so that data may be queued. Counts a refusal
+     when not.
+*/
+bool APP_AeadTxReady(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_AeadRxReady ( void )
+
+  Summary:
+     Whether a message in clear of the firmware update or data log may be
+     taken: a message of the peer has opened in the session. Counts a
+     refusal when not.
+*/
+bool APP_AeadRxReady(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_AeadSeal ( uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Encrypt length bytes in place and write the tag right after them, in
+     the APP_AEAD_TAG_LEN bytes the caller left there. Each call takes the
+     next nonce, so messages must be sealed in the order they are sent.
+
+  Returns:
+    false outside a session; nothing was changed.
+*/
+bool APP_AeadSeal(uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    int32_t APP_AeadRxMessage ( uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Take a reassembled pipe message. Pipe task only.
+
+  Description:
+     A session request is answered; a sealed message is checked and
+     decrypted in place. A message that fails does not use up its nonce, so
+     the messages of the peer that follow it still open.
+
+  Returns:
+    The length of the plaintext now at p_msg, or -1 when there is nothing
+    for the application: a session message, a message outside a session or
+    one that failed its tag.
+*/
+int32_t APP_AeadRxMessage(uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_AeadRxLost ( void )
+
+  Summary:
+     Account for a received message dropped without a buffer: its nonce is
+     used all the same. Pipe task only.
+*/
+void APP_AeadRxLost(void);
+
+/*******************************************************************************
+  Function:
+    void APP_AeadReset ( void )
+
+  Summary:
+     End the session and wipe its key, on a disconnection.
+*/
+void APP_AeadReset(void);
+
+/*******************************************************************************
+  Function:
+    void APP_AeadGetStats ( APP_AEAD_Stats_T *p_stats )
+
+  Summary:
+     Copy the counters.
+*/
+void APP_AeadGetStats(APP_AEAD_Stats_T *p_stats);
+
+/*******************************************************************************
+  Function:
+    void APP_AeadBenchmark ( APP_AEAD_WRITE write )
+
+  Summary:
+     Time one block of the device manager AES (ble_dm_aes.c) on the engine
+     and in software, then sealing and opening on the engine against CCM
+     over that software AES, in cycles per byte, for a range of message
+     sizes, and print the results as text. Both CCM paths are first checked
+     against RFC 3610 packet vector #1, then against each other for every
+     size. From tasks only; built with or without APP_AEAD_ENABLE.
+*/
+void APP_AeadBenchmark(APP_AEAD_WRITE write);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_AEAD_H */
+
+/*******************************************************************************
+ End of File
+ */
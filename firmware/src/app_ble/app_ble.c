@@ -43,8 +43,13 @@
 #include "osal/osal_freertos_extend.h"
 #include "app_ble.h"
 #include "app_ble_handler.h"
+#include "app_ble_evt_pool.h"
+#include "app_ble_evt_router.h"
+#include "app_lat.h"
 
 #include "app_trcbps_handler.h"
+#include "ble_trcbs/ble_trcbs.h"
+#include "ble_trcbpc/ble_trcbpc.h"
 
 
 
@@ -70,6 +75,9 @@
 // *****************************************************************************
 // *****************************************************************************
 
+/* Entry time of the stack callback being dispatched; the sinks run inside it. */
+static uint32_t s_stackCbEntry;
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Function Prototypes
@@ -83,46 +91,22 @@
 // *****************************************************************************
 // *****************************************************************************
 
-void APP_BleStackCb(STACK_Event_T *p_stack)
+/* Router sink for everything the application handlers, BLE_DM and the
+ * profiles consume. Only the slot pointer and the callback entry time travel
+ * through the queue. */
+static bool APP_BleStackEvtSink(STACK_Event_T *p_stackEvt)
 {
-    STACK_Event_T stackEvent;
-    APP_Msg_T   appMsg;
-    APP_Msg_T   *p_appMsg;
-
-    memcpy((uint8_t *)&stackEvent, (uint8_t *)p_stack, sizeof(STACK_Event_T));
-    stackEvent.p_event=OSAL_Malloc(p_stack->evtLen);
-    if(stackEvent.p_event==NULL)
-    {
-        return;
-    }
-    memcpy(stackEvent.p_event, p_stack->p_event, p_stack->evtLen);
-    stackEvent.p_event=stackEvent.p_event;
-
-    if (p_stack->groupId==STACK_GRP_GATT)
-    {
-        GATT_Event_T *p_evtGatt = (GATT_Event_T *)stackEvent.p_event;
-
-        if (p_evtGatt->eventId == GATTS_EVT_CLIENT_CCCDLIST_CHANGE)
-        {
-            uint8_t *p_payload;
-
-            p_payload = (uint8_t *)OSAL_Malloc((p_evtGatt->eventField.onClientCccdListChange.numOfCccd*4));
-            if (p_payload != NULL)
-            {
-                memcpy(p_payload, (uint8_t *)p_evtGatt->eventField.onClientCccdListChange.p_cccdList, (p_evtGatt->eventField.onClientCccdListChange.numOfCccd*4));
-                p_evtGatt->eventField.onClientCccdListChange.p_cccdList = (GATTS_CccdList_T *)p_payload;
-            }
-        }
-    }
-
-    appMsg.msgId=APP_MSG_BLE_STACK_EVT;
+    APP_BLE_StackEvtMsg_T msg;
 
-    ((STACK_Event_T *)appMsg.msgData)->groupId=p_stack->groupId;
-    ((STACK_Event_T *)appMsg.msgData)->evtLen=p_stack->evtLen;
-    ((STACK_Event_T *)appMsg.msgData)->p_event=stackEvent.p_event;
+    msg.p_stackEvt = p_stackEvt;
+    msg.cbEntry = s_stackCbEntry;
+    return APP_MsgSend(APP_MSG_BLE_STACK_EVT, &msg, sizeof(msg));
+}
 
-    p_appMsg = &appMsg;
-    OSAL_QUEUE_Send(&appData.appQueue, p_appMsg, 0);
+void APP_BleStackCb(STACK_Event_T *p_stack)
+{
+    s_stackCbEntry = APP_LatNow();
+    APP_BleEvtRouterDispatch(p_stack);
 }
 
 void APP_BleStackEvtHandler(STACK_Event_T *p_stackEvt)
@@ -164,8 +148,8 @@ void APP_BleStackEvtHandler(STACK_Event_T *p_stackEvt)
     //Direct event to BLE profiles
 
     
-    /* Transparent Credit Based Profile */
-    BLE_TRCBPS_BleEventHandler(p_stackEvt);
+    /* Transparent Credit Based Profile: its events are routed to the pipe
+     * task, which drives the profile (see BLECB_Pipe_Init). */
 
 
 
@@ -175,7 +159,7 @@ void APP_BleStackEvtHandler(STACK_Event_T *p_stackEvt)
 
 
 
-    OSAL_Free(p_stackEvt->p_event);
+    APP_BleEvtPoolRelease(p_stackEvt);
 }
 
 
@@ -192,7 +176,9 @@ void APP_BleConfigBasic()
     BLE_GAP_AdvParams_T             advParam;
     uint8_t advData[]={0x02, 0x01, 0x04, 0x0B, 0x09, 0x70, 0x69, 0x63, 0x33, 0x32, 0x63, 0x78, 0x2D, 0x62, 0x7A};
     BLE_GAP_AdvDataParams_T         appAdvData;
-    uint8_t scanRspData[]={0x0B, 0x09, 0x70, 0x69, 0x63, 0x33, 0x32, 0x63, 0x78, 0x2D, 0x62, 0x7A};
+    /* Name, then the Transparent Credit Based service UUID a central pipe client scans for */
+    uint8_t scanRspData[]={0x0B, 0x09, 0x70, 0x69, 0x63, 0x33, 0x32, 0x63, 0x78, 0x2D, 0x62, 0x7A,
+                           0x11, 0x07, UUID_MCHP_PROPRIETARY_SERVICE_TRCB_16};
     BLE_GAP_AdvDataParams_T         appScanRspData;
 
     // Configure advertising parameters
@@ -217,6 +203,18 @@ void APP_BleConfigBasic()
     BLE_GAP_SetScanRspData(&appScanRspData);
 
     BLE_GAP_SetConnTxPowerLevel(15, &connTxPower);      /* Connection TX Power */
+
+#if APP_BLE_CENTRAL_ENABLE
+    BLE_GAP_ScanningParams_T        scanParam;
+
+    // Configure scanning parameters of the central pipe client
+    scanParam.type = BLE_GAP_SCAN_TYPE_ACTIVE_SCAN;          /* Active: the service UUID is in the scan response */
+    scanParam.interval = 96;                                 /* Scan Interval: 60 ms */
+    scanParam.window = 96;                                   /* Scan Window: 60 ms */
+    scanParam.filterPolicy = BLE_GAP_SCAN_FP_ACCEPT_ALL;     /* Scan Filter Policy */
+    scanParam.disChannel = 0;                                /* All Channels */
+    BLE_GAP_SetScanningParam(&scanParam);
+#endif
 }
 void APP_BleConfigAdvance()
 {
@@ -269,6 +267,12 @@ void APP_BleStackInitBasic()
     BLE_GAP_AdvInit();  /* Advertising */
 
     BLE_GAP_ConnPeripheralInit();   /* Peripheral */
+
+#if APP_BLE_CENTRAL_ENABLE
+    BLE_GAP_ScanInit();             /* Scanning */
+
+    BLE_GAP_ConnCentralInit();      /* Central */
+#endif
 }
 
 void APP_BleStackInitAdvance()
@@ -276,6 +280,14 @@ void APP_BleStackInitAdvance()
     uint16_t gattsInitParam=GATTS_CONFIG_NONE;
     
 
+    APP_BleEvtPoolInit();
+    APP_BleEvtRouterInit();
+
+    // The credit based data path (SDUs, credits, TX buffer available) bypasses the application queue
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_GAP, APP_BLE_EVT_MASK_ALL & ~APP_BLE_EVT_MASK(BLE_GAP_EVT_TX_BUF_AVAILABLE), APP_BleStackEvtSink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_L2CAP, APP_BLE_EVT_MASK_ALL & ~(APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_SDU_IND) | APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_ADD_CREDITS_IND)), APP_BleStackEvtSink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_SMP, APP_BLE_EVT_MASK_ALL, APP_BleStackEvtSink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_GATT, APP_BLE_EVT_MASK_ALL, APP_BleStackEvtSink);
     STACK_EventRegister(APP_BleStackCb);
     
 
@@ -286,6 +298,9 @@ void APP_BleStackInitAdvance()
     BLE_L2CAP_CbInit();     /* Credit Base Flow Control */
     
     GATTS_Init(gattsInitParam);
+#if APP_BLE_CENTRAL_ENABLE
+    GATTC_Init(GATTC_CONFIG_NONE);
+#endif
     
 
     BLE_SMP_Init();
@@ -305,6 +320,9 @@ void APP_BleStackInitAdvance()
     /* Transparent Credit Based Profile */
     BLE_TRCBPS_Init();                                  /* Enable Server Role */
     BLE_TRCBPS_EventRegister(APP_TrcbpsEvtHandler); /* Enable Server Role */
+#if APP_BLE_CENTRAL_ENABLE
+    BLE_TRCBPC_Init();                                  /* Enable Client Role, driven by the pipe */
+#endif
 
 
 
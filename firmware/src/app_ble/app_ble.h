@@ -76,6 +76,13 @@ extern "C" {
 // *****************************************************************************
 // *****************************************************************************
 
+/* Payload of an APP_MSG_BLE_STACK_EVT message. */
+typedef struct APP_BLE_StackEvtMsg_T
+{
+    STACK_Event_T   *p_stackEvt;        /* Pooled event slot, one reference */
+    uint32_t        cbEntry;            /* APP_LatNow() at APP_BleStackCb entry */
+} APP_BLE_StackEvtMsg_T;
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Application Callback Routines
@@ -0,0 +1,371 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+
+/*******************************************************************************
+  Application BLE Event Pool Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_ble_evt_pool.c
+
+  Summary:
+    Fixed pool of reference counted BLE stack event slots.
+
+  Description:
+    Each slot is a STACK_Event_T header followed by the event payload, so the
+    STACK_Event_T pointer handed to consumers is also the slot address. The
+    stack callback runs in the BLE task and consumers run in the application
+    and pipe tasks, so free lists and reference counts are only touched inside
+    short critical sections.
+ *******************************************************************************/
+
+
+/* Heap fallback slots are accounted separately from the stack's own blocks. */
+#define OSAL_MEM_TAG    OSAL_MEM_TAG_BLE_EVT
+
+#include <stddef.h>
+#include <string.h>
+#include "osal/osal_freertos.h"
+#include "ble_gap.h"
+#include "ble_l2cap.h"
+#include "ble_smp.h"
+#include "gatt.h"
+#include "app_ble_evt_pool.h"
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_BLE_EVT_GAP_SIZE            sizeof(BLE_GAP_Event_T)
+#define APP_BLE_EVT_L2CAP_SIZE          (offsetof(BLE_L2CAP_Event_T, eventField) + sizeof(BLE_L2CAP_EvtCbConnInd_T))
+#define APP_BLE_EVT_SDU_SIZE            sizeof(BLE_L2CAP_Event_T)
+#define APP_BLE_EVT_SMP_SIZE            sizeof(BLE_SMP_Event_T)
+#define APP_BLE_EVT_CCCD_OFFSET         ((sizeof(GATT_Event_T) + 3U) & ~3U)
+#define APP_BLE_EVT_GATT_SIZE           (APP_BLE_EVT_CCCD_OFFSET + (APP_BLE_EVT_POOL_MAX_CCCD * sizeof(GATTS_CccdList_T)))
+
+#define APP_BLE_EVT_SLOT_WORDS(size)    ((sizeof(APP_BLE_EvtSlot_T) + (size) + 3U) / 4U)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_BLE_EvtSlot_T
+{
+    STACK_Event_T               stackEvt;       /* Must stay first: consumers only see this member */
+    struct APP_BLE_EvtSlot_T    *p_next;        /* Free list link */
+    uint8_t                     refCnt;
+    uint8_t                     poolId;
+    uint32_t                    payload[];      /* Event payload, word aligned */
+} APP_BLE_EvtSlot_T;
+
+typedef struct APP_BLE_EvtPool_T
+{
+    uint32_t                    *p_mem;
+    uint16_t                    slotWords;
+    uint16_t                    slotSize;
+    uint8_t                     slots;
+    APP_BLE_EvtSlot_T           *p_free;
+    APP_BLE_EvtPoolStats_T      stats;
+} APP_BLE_EvtPool_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t s_gapPoolMem[APP_BLE_EVT_POOL_GAP_SLOTS * APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_GAP_SIZE)];
+static uint32_t s_l2capPoolMem[APP_BLE_EVT_POOL_L2CAP_SLOTS * APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_L2CAP_SIZE)];
+static uint32_t s_sduPoolMem[APP_BLE_EVT_POOL_SDU_SLOTS * APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_SDU_SIZE)];
+static uint32_t s_smpPoolMem[APP_BLE_EVT_POOL_SMP_SLOTS * APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_SMP_SIZE)];
+static uint32_t s_gattPoolMem[APP_BLE_EVT_POOL_GATT_SLOTS * APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_GATT_SIZE)];
+
+static APP_BLE_EvtPool_T s_evtPools[APP_BLE_EVT_POOL_NUM] =
+{
+    [APP_BLE_EVT_POOL_GAP]   = { s_gapPoolMem,   APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_GAP_SIZE),   APP_BLE_EVT_GAP_SIZE,   APP_BLE_EVT_POOL_GAP_SLOTS },
+    [APP_BLE_EVT_POOL_L2CAP] = { s_l2capPoolMem, APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_L2CAP_SIZE), APP_BLE_EVT_L2CAP_SIZE, APP_BLE_EVT_POOL_L2CAP_SLOTS },
+    [APP_BLE_EVT_POOL_SDU]   = { s_sduPoolMem,   APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_SDU_SIZE),   APP_BLE_EVT_SDU_SIZE,   APP_BLE_EVT_POOL_SDU_SLOTS },
+    [APP_BLE_EVT_POOL_SMP]   = { s_smpPoolMem,   APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_SMP_SIZE),   APP_BLE_EVT_SMP_SIZE,   APP_BLE_EVT_POOL_SMP_SLOTS },
+    [APP_BLE_EVT_POOL_GATT]  = { s_gattPoolMem,  APP_BLE_EVT_SLOT_WORDS(APP_BLE_EVT_GATT_SIZE),  APP_BLE_EVT_GATT_SIZE,  APP_BLE_EVT_POOL_GATT_SLOTS },
+};
+
+static APP_BLE_EvtPoolStats_T s_heapStats;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static APP_BLE_EvtPoolId_T app_ble_EvtPoolSelect(STACK_Event_T *p_stack)
+{
+    switch (p_stack->groupId)
+    {
+        case STACK_GRP_BLE_GAP:
+            return APP_BLE_EVT_POOL_GAP;
+
+        case STACK_GRP_BLE_L2CAP:
+            if (((BLE_L2CAP_Event_T *)p_stack->p_event)->eventId == BLE_L2CAP_EVT_CB_SDU_IND)
+                return APP_BLE_EVT_POOL_SDU;
+            return APP_BLE_EVT_POOL_L2CAP;
+
+        case STACK_GRP_BLE_SMP:
+            return APP_BLE_EVT_POOL_SMP;
+
+        case STACK_GRP_GATT:
+            return APP_BLE_EVT_POOL_GATT;
+
+        default:
+            return APP_BLE_EVT_POOL_HEAP;
+    }
+}
+
+/* Bytes of the event that carry information. Large fixed-size events are trimmed
+ * so only the used part is copied. */
+static uint16_t app_ble_EvtPoolCopyLen(APP_BLE_EvtPoolId_T poolId, STACK_Event_T *p_stack)
+{
+    uint16_t len = p_stack->evtLen;
+
+    if (poolId == APP_BLE_EVT_POOL_L2CAP && len > APP_BLE_EVT_L2CAP_SIZE)
+        len = APP_BLE_EVT_L2CAP_SIZE;
+
+    return len;
+}
+
+static uint16_t app_ble_EvtPoolCccdLen(STACK_Event_T *p_stack)
+{
+    GATT_Event_T *p_evtGatt = (GATT_Event_T *)p_stack->p_event;
+
+    if (p_stack->groupId == STACK_GRP_GATT && p_evtGatt->eventId == GATTS_EVT_CLIENT_CCCDLIST_CHANGE)
+        return p_evtGatt->eventField.onClientCccdListChange.numOfCccd * sizeof(GATTS_CccdList_T);
+
+    return 0;
+}
+
+static APP_BLE_EvtSlot_T *app_ble_EvtPoolTake(APP_BLE_EvtPoolId_T poolId)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    APP_BLE_EvtPool_T *p_pool = &s_evtPools[poolId];
+    APP_BLE_EvtSlot_T *p_slot;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    p_slot = p_pool->p_free;
+    if (p_slot != NULL)
+    {
+        p_pool->p_free = p_slot->p_next;
+        p_pool->stats.inUse++;
+        if (p_pool->stats.inUse > p_pool->stats.peak)
+            p_pool->stats.peak = p_pool->stats.inUse;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    return p_slot;
+}
+
+static void app_ble_EvtPoolCopy(APP_BLE_EvtSlot_T *p_slot, STACK_Event_T *p_stack, uint16_t len, uint16_t cccdLen, uint16_t cccdOffset)
+{
+    uint8_t *p_dst = (uint8_t *)p_slot->payload;
+    BLE_L2CAP_Event_T *p_l2cap = (BLE_L2CAP_Event_T *)p_stack->p_event;
+    GATT_Event_T *p_gatt;
+
+    p_slot->stackEvt.groupId = p_stack->groupId;
+    p_slot->stackEvt.evtLen = len;
+    p_slot->stackEvt.p_event = p_dst;
+
+    if (p_slot->poolId == APP_BLE_EVT_POOL_SDU && len == sizeof(BLE_L2CAP_Event_T)
+        && p_l2cap->eventField.evtCbSduInd.length <= BLE_L2CAP_MAX_PDU_SIZE)
+    {
+        /* Only the used part of the 1 KB payload array is copied. */
+        memcpy(p_dst, p_l2cap, offsetof(BLE_L2CAP_Event_T, eventField.evtCbSduInd.payload) + p_l2cap->eventField.evtCbSduInd.length);
+        ((BLE_L2CAP_Event_T *)p_dst)->eventField.evtCbSduInd.frames = p_l2cap->eventField.evtCbSduInd.frames;
+    }
+    else
+    {
+        memcpy(p_dst, p_stack->p_event, len);
+    }
+
+    if (cccdLen != 0)
+    {
+        p_gatt = (GATT_Event_T *)p_dst;
+        memcpy(p_dst + cccdOffset, p_gatt->eventField.onClientCccdListChange.p_cccdList, cccdLen);
+        p_gatt->eventField.onClientCccdListChange.p_cccdList = (GATTS_CccdList_T *)(p_dst + cccdOffset);
+    }
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_BleEvtPoolInit(void)
+{
+    APP_BLE_EvtPool_T *p_pool;
+    APP_BLE_EvtSlot_T *p_slot;
+    uint8_t poolId, i;
+
+    for (poolId = 0; poolId < APP_BLE_EVT_POOL_NUM; poolId++)
+    {
+        p_pool = &s_evtPools[poolId];
+        p_pool->p_free = NULL;
+        memset(&p_pool->stats, 0, sizeof(APP_BLE_EvtPoolStats_T));
+        p_pool->stats.slotSize = p_pool->slotSize;
+        p_pool->stats.slots = p_pool->slots;
+
+        for (i = p_pool->slots; i > 0; i--)
+        {
+            p_slot = (APP_BLE_EvtSlot_T *)&p_pool->p_mem[(i - 1U) * p_pool->slotWords];
+            p_slot->poolId = poolId;
+            p_slot->refCnt = 0;
+            p_slot->p_next = p_pool->p_free;
+            p_pool->p_free = p_slot;
+        }
+    }
+
+    memset(&s_heapStats, 0, sizeof(APP_BLE_EvtPoolStats_T));
+}
+
+STACK_Event_T *APP_BleEvtPoolCapture(STACK_Event_T *p_stack)
+{
+    APP_BLE_EvtPoolId_T poolId = app_ble_EvtPoolSelect(p_stack);
+    APP_BLE_EvtSlot_T *p_slot = NULL;
+    uint16_t len = p_stack->evtLen;
+    uint16_t cccdLen = app_ble_EvtPoolCccdLen(p_stack);
+    uint16_t cccdOffset = APP_BLE_EVT_CCCD_OFFSET;
+
+    if (poolId != APP_BLE_EVT_POOL_HEAP)
+    {
+        len = app_ble_EvtPoolCopyLen(poolId, p_stack);
+
+        if (len <= s_evtPools[poolId].slotSize
+            && (cccdLen == 0 || (len <= APP_BLE_EVT_CCCD_OFFSET && cccdLen <= APP_BLE_EVT_GATT_SIZE - APP_BLE_EVT_CCCD_OFFSET)))
+        {
+            p_slot = app_ble_EvtPoolTake(poolId);
+        }
+
+        if (p_slot != NULL)
+        {
+            s_evtPools[poolId].stats.captured++;
+        }
+        else
+        {
+#if APP_BLE_EVT_POOL_HEAP_FALLBACK
+            s_evtPools[poolId].stats.heapFallbacks++;
+#else
+            s_evtPools[poolId].stats.dropped++;
+            return NULL;
+#endif
+        }
+    }
+
+    if (p_slot == NULL)
+    {
+#if APP_BLE_EVT_POOL_HEAP_FALLBACK
+        /* Unknown group, oversized event or pool exhausted: one heap block holds the whole event. */
+        len = p_stack->evtLen;
+        cccdOffset = (len + 3U) & ~3U;
+        p_slot = (APP_BLE_EvtSlot_T *)OSAL_Malloc(sizeof(APP_BLE_EvtSlot_T) + cccdOffset + cccdLen);
+        if (p_slot == NULL)
+        {
+            s_heapStats.dropped++;
+            return NULL;
+        }
+        p_slot->poolId = APP_BLE_EVT_POOL_HEAP;
+        s_heapStats.captured++;
+#else
+        s_heapStats.dropped++;
+        return NULL;
+#endif
+    }
+
+    p_slot->refCnt = 1;
+    app_ble_EvtPoolCopy(p_slot, p_stack, len, cccdLen, cccdOffset);
+
+    return &p_slot->stackEvt;
+}
+
+void APP_BleEvtPoolRetain(STACK_Event_T *p_evt)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    APP_BLE_EvtSlot_T *p_slot = (APP_BLE_EvtSlot_T *)p_evt;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    p_slot->refCnt++;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+void APP_BleEvtPoolRelease(STACK_Event_T *p_evt)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    APP_BLE_EvtSlot_T *p_slot = (APP_BLE_EvtSlot_T *)p_evt;
+    APP_BLE_EvtPool_T *p_pool;
+    bool freeHeap = false;
+
+    if (p_evt == NULL)
+        return;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    if (p_slot->refCnt != 0 && --p_slot->refCnt == 0)
+    {
+        if (p_slot->poolId == APP_BLE_EVT_POOL_HEAP)
+        {
+            freeHeap = true;
+        }
+        else
+        {
+            p_pool = &s_evtPools[p_slot->poolId];
+            p_slot->p_next = p_pool->p_free;
+            p_pool->p_free = p_slot;
+            p_pool->stats.inUse--;
+        }
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    if (freeHeap)
+        OSAL_Free(p_slot);
+}
+
+void APP_BleEvtPoolGetStats(APP_BLE_EvtPoolId_T poolId, APP_BLE_EvtPoolStats_T *p_stats)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    if (poolId < APP_BLE_EVT_POOL_NUM)
+        memcpy(p_stats, &s_evtPools[poolId].stats, sizeof(APP_BLE_EvtPoolStats_T));
+    else
+        memcpy(p_stats, &s_heapStats, sizeof(APP_BLE_EvtPoolStats_T));
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,202 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_ble_evt_pool.h
+
+  Summary:
+    Fixed pool of reference counted BLE stack event slots.
+
+  Description:
+    BLE stack events are captured into statically allocated slots instead of
+    heap buffers. Each event group has its own pool so a burst of one kind of
+    event (e.g. L2CAP SDUs) cannot starve another (e.g. GAP disconnect). Slots
+    are handed around by pointer to their STACK_Event_T and returned to their
+    pool when the last reference is released.
+*******************************************************************************/
+
+#ifndef _APP_BLE_EVT_POOL_H
+#define _APP_BLE_EVT_POOL_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stack_mgr.h"
+#include "ble_trcbps/ble_trcbps.h"
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Number of slots per pool. L2CAP SDU indications are bounded by the credits
+ * granted to the peer, so that pool follows BLE_TRCBPS_DATA_MAX_CREDITS. */
+#ifndef APP_BLE_EVT_POOL_GAP_SLOTS
+#define APP_BLE_EVT_POOL_GAP_SLOTS          4
+#endif
+#ifndef APP_BLE_EVT_POOL_L2CAP_SLOTS
+#define APP_BLE_EVT_POOL_L2CAP_SLOTS        4
+#endif
+#ifndef APP_BLE_EVT_POOL_SDU_SLOTS
+#define APP_BLE_EVT_POOL_SDU_SLOTS          (BLE_TRCBPS_DATA_MAX_CREDITS + 2)
+#endif
+#ifndef APP_BLE_EVT_POOL_SMP_SLOTS
+#define APP_BLE_EVT_POOL_SMP_SLOTS          2
+#endif
+#ifndef APP_BLE_EVT_POOL_GATT_SLOTS
+#define APP_BLE_EVT_POOL_GATT_SLOTS         4
+#endif
+
+/* CCCD entries stored inline with a GATTS_EVT_CLIENT_CCCDLIST_CHANGE event. */
+#ifndef APP_BLE_EVT_POOL_MAX_CCCD
+#define APP_BLE_EVT_POOL_MAX_CCCD           8
+#endif
+
+/* Take a heap block when a pool is exhausted, or for an event no pool holds,
+ * instead of dropping the event. Off by default so the BLE task never calls
+ * OSAL_Malloc; the SDU pool already covers the credits, and the dropped
+ * counters show when a pool is too small. */
+#ifndef APP_BLE_EVT_POOL_HEAP_FALLBACK
+#define APP_BLE_EVT_POOL_HEAP_FALLBACK      0
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum APP_BLE_EvtPoolId_T
+{
+    APP_BLE_EVT_POOL_GAP,
+    APP_BLE_EVT_POOL_L2CAP,
+    APP_BLE_EVT_POOL_SDU,
+    APP_BLE_EVT_POOL_SMP,
+    APP_BLE_EVT_POOL_GATT,
+
+    APP_BLE_EVT_POOL_NUM,
+    APP_BLE_EVT_POOL_HEAP = APP_BLE_EVT_POOL_NUM    /* Heap blocks, and events of no pool */
+} APP_BLE_EvtPoolId_T;
+
+typedef struct APP_BLE_EvtPoolStats_T
+{
+    uint16_t    slotSize;           /* Payload bytes per slot */
+    uint8_t     slots;              /* Slots in the pool */
+    uint8_t     inUse;              /* Slots currently referenced */
+    uint8_t     peak;               /* Highest inUse since boot */
+    uint32_t    captured;           /* Events captured into this pool */
+    uint32_t    heapFallbacks;      /* Events that went to the heap because the pool was empty */
+    uint32_t    dropped;            /* Events lost: no slot, and no heap block or fallback off */
+} APP_BLE_EvtPoolStats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtPoolInit ( void )
+
+  Summary:
+     Build the free lists of all pools. Call before STACK_EventRegister.
+*/
+void APP_BleEvtPoolInit(void);
+
+/*******************************************************************************
+  Function:
+    STACK_Event_T *APP_BleEvtPoolCapture ( STACK_Event_T *p_stack )
+
+  Summary:
+     Copy a stack event out of the stack's transient buffer into a slot.
+
+  Description:
+     The returned event holds one reference. The CCCD list of a
+     GATTS_EVT_CLIENT_CCCDLIST_CHANGE event is stored in the same slot, so
+     consumers must not free it.
+
+  Returns:
+    The captured event, or NULL if the event was dropped.
+*/
+STACK_Event_T *APP_BleEvtPoolCapture(STACK_Event_T *p_stack);
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtPoolRetain ( STACK_Event_T *p_evt )
+
+  Summary:
+     Take an additional reference on a captured event.
+*/
+void APP_BleEvtPoolRetain(STACK_Event_T *p_evt);
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtPoolRelease ( STACK_Event_T *p_evt )
+
+  Summary:
+     Drop a reference; the slot returns to its pool with the last one.
+*/
+void APP_BleEvtPoolRelease(STACK_Event_T *p_evt);
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtPoolGetStats ( APP_BLE_EvtPoolId_T poolId, APP_BLE_EvtPoolStats_T *p_stats )
+
+  Summary:
+     Get the usage counters of one pool.
+*/
+void APP_BleEvtPoolGetStats(APP_BLE_EvtPoolId_T poolId, APP_BLE_EvtPoolStats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_BLE_EVT_POOL_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,246 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+
+/*******************************************************************************
+  Application BLE Event Router Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_ble_evt_router.c
+
+  Summary:
+    Subscription based routing of BLE stack events.
+
+  Description:
+    Dispatch runs in the BLE stack callback. The matching sinks are looked up
+    before anything is copied, so events nobody listens to cost one table scan
+    and no pool slot. Subscriptions are normally set up once at init, but the
+    table is still only read and written inside short critical sections.
+ *******************************************************************************/
+
+
+#include <stddef.h>
+#include <string.h>
+#include "osal/osal_freertos.h"
+#include "ble_gap.h"
+#include "ble_l2cap.h"
+#include "ble_smp.h"
+#include "gatt.h"
+#include "app_ble_evt_pool.h"
+#include "app_ble_evt_router.h"
+#include "app_trace.h"
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_BLE_EvtSub_T
+{
+    APP_BLE_EvtSink_T           sink;
+    uint32_t                    evtMask[STACK_GRP_END];
+} APP_BLE_EvtSub_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static APP_BLE_EvtSub_T s_evtSubs[APP_BLE_EVT_ROUTER_MAX_SINKS];
+static APP_BLE_EvtRouterStats_T s_routerStats;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Every group's event structure starts with its own eventId enumeration. */
+static uint32_t app_ble_EvtRouterEventId(STACK_Event_T *p_stack)
+{
+    switch (p_stack->groupId)
+    {
+        case STACK_GRP_BLE_GAP:
+            return ((BLE_GAP_Event_T *)p_stack->p_event)->eventId;
+
+        case STACK_GRP_BLE_L2CAP:
+            return ((BLE_L2CAP_Event_T *)p_stack->p_event)->eventId;
+
+        case STACK_GRP_BLE_SMP:
+            return ((BLE_SMP_Event_T *)p_stack->p_event)->eventId;
+
+        case STACK_GRP_GATT:
+            return ((GATT_Event_T *)p_stack->p_event)->eventId;
+
+        default:
+            return 0;
+    }
+}
+
+/* SDU and credit events of the credit based channels, recorded here rather
+ * than in the TRCBPS profile so the profile stays free of app headers. */
+static void app_ble_EvtRouterTraceL2cap(STACK_Event_T *p_stack)
+{
+    BLE_L2CAP_Event_T *p_event = (BLE_L2CAP_Event_T *)p_stack->p_event;
+
+    if (p_event->eventId == BLE_L2CAP_EVT_CB_SDU_IND)
+        APP_TRACE(APP_TRACE_EVT_SDU_RX, p_event->eventField.evtCbSduInd.leL2capId, p_event->eventField.evtCbSduInd.length);
+    else if (p_event->eventId == BLE_L2CAP_EVT_CB_ADD_CREDITS_IND)
+        APP_TRACE(APP_TRACE_EVT_CREDIT_RECV, p_event->eventField.evtCbAddCreditsInd.leL2capId, p_event->eventField.evtCbAddCreditsInd.credits);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_BleEvtRouterInit(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    memset(s_evtSubs, 0, sizeof(s_evtSubs));
+    memset(&s_routerStats, 0, sizeof(APP_BLE_EvtRouterStats_T));
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+bool APP_BleEvtRouterSubscribe(STACK_GroupId_T groupId, uint32_t evtMask, APP_BLE_EvtSink_T sink)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    APP_BLE_EvtSub_T *p_sub = NULL;
+    uint8_t i;
+
+    if (groupId <= STACK_GRP_NONE || groupId >= STACK_GRP_END || sink == NULL)
+        return false;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    for (i = 0; i < APP_BLE_EVT_ROUTER_MAX_SINKS; i++)
+    {
+        if (s_evtSubs[i].sink == sink)
+        {
+            p_sub = &s_evtSubs[i];
+            break;
+        }
+        if (p_sub == NULL && s_evtSubs[i].sink == NULL)
+            p_sub = &s_evtSubs[i];
+    }
+    if (p_sub != NULL)
+    {
+        p_sub->sink = sink;
+        p_sub->evtMask[groupId] |= evtMask;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    return (p_sub != NULL);
+}
+
+void APP_BleEvtRouterUnsubscribe(APP_BLE_EvtSink_T sink)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint8_t i;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    for (i = 0; i < APP_BLE_EVT_ROUTER_MAX_SINKS; i++)
+    {
+        if (s_evtSubs[i].sink == sink)
+            memset(&s_evtSubs[i], 0, sizeof(APP_BLE_EvtSub_T));
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+void APP_BleEvtRouterDispatch(STACK_Event_T *p_stack)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    APP_BLE_EvtSink_T sinks[APP_BLE_EVT_ROUTER_MAX_SINKS];
+    STACK_Event_T *p_evt;
+    uint32_t evtId;
+    uint32_t bit;
+    uint8_t numSinks = 0;
+    uint8_t i;
+
+    if (p_stack->groupId <= STACK_GRP_NONE || p_stack->groupId >= STACK_GRP_END)
+        return;
+
+    evtId = app_ble_EvtRouterEventId(p_stack);
+    APP_TRACE(APP_TRACE_EVT_STACK_EVT, p_stack->groupId, evtId);
+    if (p_stack->groupId == STACK_GRP_BLE_L2CAP)
+        app_ble_EvtRouterTraceL2cap(p_stack);
+    bit = APP_BLE_EVT_MASK(evtId & 0x1FU);
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    for (i = 0; i < APP_BLE_EVT_ROUTER_MAX_SINKS; i++)
+    {
+        if (s_evtSubs[i].sink != NULL && (s_evtSubs[i].evtMask[p_stack->groupId] & bit) != 0)
+            sinks[numSinks++] = s_evtSubs[i].sink;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    if (numSinks == 0)
+    {
+        s_routerStats.filtered++;
+        return;
+    }
+
+    p_evt = APP_BleEvtPoolCapture(p_stack);
+    if (p_evt == NULL)
+    {
+        s_routerStats.captureFails++;
+        return;
+    }
+    s_routerStats.routed++;
+
+    /* All references are taken before the first delivery, so a fast sink
+     * releasing its copy cannot free the slot under the remaining ones. */
+    for (i = 1; i < numSinks; i++)
+        APP_BleEvtPoolRetain(p_evt);
+
+    for (i = 0; i < numSinks; i++)
+    {
+        if (!sinks[i](p_evt))
+        {
+            s_routerStats.sinkRejects++;
+            APP_BleEvtPoolRelease(p_evt);
+        }
+    }
+}
+
+void APP_BleEvtRouterGetStats(APP_BLE_EvtRouterStats_T *p_stats)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    memcpy(p_stats, &s_routerStats, sizeof(APP_BLE_EvtRouterStats_T));
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+
+/*******************************************************************************
+ End of File
+ */
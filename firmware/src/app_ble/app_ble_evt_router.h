@@ -0,0 +1,175 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_ble_evt_router.h
+
+  Summary:
+    Subscription based routing of BLE stack events.
+
+  Description:
+    Modules subscribe a sink to the events they consume, per event group, with
+    a bit mask of event identifiers. A stack event is copied into the event
+    pool only if at least one sink subscribed to it, and the same copy is
+    handed to every matching sink with one reference each. This lets the data
+    path (L2CAP SDUs, credits, TX buffer available) go straight to the task
+    that moves the data instead of being serialized behind the application
+    queue.
+*******************************************************************************/
+
+#ifndef _APP_BLE_EVT_ROUTER_H
+#define _APP_BLE_EVT_ROUTER_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stack_mgr.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Number of distinct sinks that can be subscribed. */
+#ifndef APP_BLE_EVT_ROUTER_MAX_SINKS
+#define APP_BLE_EVT_ROUTER_MAX_SINKS        4
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+
+/* Event identifiers of every group are below 32, so a group mask is one word. */
+#define APP_BLE_EVT_MASK(eventId)           (1UL << (uint32_t)(eventId))
+#define APP_BLE_EVT_MASK_ALL                0xFFFFFFFFUL
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Receives one reference on a pooled event. A sink that returns true owns the
+ * reference and must hand it to APP_BleEvtPoolRelease when done; on false the
+ * router releases it. Sinks run in the BLE stack callback and must not block. */
+typedef bool (*APP_BLE_EvtSink_T)(STACK_Event_T *p_evt);
+
+typedef struct APP_BLE_EvtRouterStats_T
+{
+    uint32_t    routed;             /* Events copied and delivered to at least one sink */
+    uint32_t    filtered;           /* Events no sink subscribed to, never copied */
+    uint32_t    captureFails;       /* Subscribed events lost because the pool had no slot */
+    uint32_t    sinkRejects;        /* Deliveries refused by a sink (queue full) */
+} APP_BLE_EvtRouterStats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtRouterInit ( void )
+
+  Summary:
+     Drop all subscriptions and clear the counters.
+*/
+void APP_BleEvtRouterInit(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_BleEvtRouterSubscribe ( STACK_GroupId_T groupId, uint32_t evtMask, APP_BLE_EvtSink_T sink )
+
+  Summary:
+     Subscribe a sink to events of one group.
+
+  Description:
+     evtMask is built with APP_BLE_EVT_MASK(). Subscribing the same sink again
+     adds the new events to its mask. A sink gets each event at most once.
+
+  Returns:
+    false if the group is invalid or all sink entries are taken.
+*/
+bool APP_BleEvtRouterSubscribe(STACK_GroupId_T groupId, uint32_t evtMask, APP_BLE_EvtSink_T sink);
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtRouterUnsubscribe ( APP_BLE_EvtSink_T sink )
+
+  Summary:
+     Remove all subscriptions of a sink.
+*/
+void APP_BleEvtRouterUnsubscribe(APP_BLE_EvtSink_T sink);
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtRouterDispatch ( STACK_Event_T *p_stack )
+
+  Summary:
+     Route one event from the stack callback to its subscribers.
+*/
+void APP_BleEvtRouterDispatch(STACK_Event_T *p_stack);
+
+/*******************************************************************************
+  Function:
+    void APP_BleEvtRouterGetStats ( APP_BLE_EvtRouterStats_T *p_stats )
+
+  Summary:
+     Get the routing counters.
+*/
+void APP_BleEvtRouterGetStats(APP_BLE_EvtRouterStats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_BLE_EVT_ROUTER_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -369,7 +369,7 @@ void APP_GattEvtHandler(GATT_Event_T *p_event)
         case GATTS_EVT_CLIENT_CCCDLIST_CHANGE:
         {
             /* TODO: implement your application code.*/
-            OSAL_Free(p_event->eventField.onClientCccdListChange.p_cccdList);
+            /* The CCCD list lives in the event slot and is released with it. */
         }
         break;
 
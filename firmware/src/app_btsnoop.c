@@ -0,0 +1,401 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_btsnoop.c
+
+  Summary:
+    HCI capture ring, btsnoop conversion and drain task.
+
+  Description:
+    Ring record, one 32 bit word each unless noted:
+
+      header    bit 31 set, bits 24-26 BLE_LOG type, bits 12-23 stored
+                length, bits 0-11 original length
+      ts        DWT cycle counter at capture
+      drops     packets dropped on a full ring so far
+      packet    stored length bytes, padded to a word
+
+    The header is stored last, a zero header marks a record still being
+    written. The drain clears the words it consumed before it moves the tail.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "ble_log/ble_log.h"
+#include "app_btsnoop.h"
+#include "app_frame.h"
+#include "app_ring.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_BTSNOOP_HDR_VALID           0x80000000UL
+#define APP_BTSNOOP_HDR_TYPE_Pos        24
+#define APP_BTSNOOP_HDR_INCL_Pos        12
+#define APP_BTSNOOP_HDR_LEN_Msk         0xFFFUL
+
+/* Packets the pipe sink's own frames cause */
+#define APP_BTSNOOP_EVT_NUM_COMP_PKTS   0x13    /* Number Of Completed Packets event */
+#define APP_BTSNOOP_L2CAP_LE_SIG_CID    0x0005  /* LE signalling channel */
+#define APP_BTSNOOP_L2CAP_FLOW_CREDIT   0x16    /* LE Flow Control Credit packet */
+
+/* btsnoop timestamps count microseconds from 0 AD; this is 1970-01-01 */
+#define APP_BTSNOOP_EPOCH_US            0x00DCDDB30F2F8000ULL
+
+static uint32_t s_ring[APP_BTSNOOP_RING_WORDS];
+static volatile uint32_t s_head;        /* Words reserved by the capture path */
+static volatile uint32_t s_tail;        /* Words released by the drain */
+
+static volatile bool s_enabled;
+static volatile bool s_startPending;
+static bool s_logEnabled;
+static uint16_t s_aclSnapLen;
+static APP_BTSNOOP_WRITE s_write;
+
+static APP_BTSNOOP_Stats_T s_stats;
+
+/* Channel left out of the capture, see APP_BtSnoopExcludeChannel */
+static volatile uint16_t s_exclHandle;
+static volatile uint16_t s_exclCid;     /* Peer CID, 0: nothing left out */
+static uint16_t s_exclTxLeft;           /* Bytes of a left out PDU still to come in ACL continuations */
+
+/* Drain side time base */
+static bool s_timeValid;
+static uint32_t s_lastCycles;
+static uint64_t s_elapsedCycles;
+
+static uint8_t s_frame[APP_BTSNOOP_FRAME_MAX_SIZE];
+static TaskHandle_t xBTSNOOP_Task;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/* H4 packet type and btsnoop flags (bit 0 received, bit 1 command/event) */
+static void APP_BtSnoopTypeInfo(uint8_t logType, uint8_t *p_h4, uint32_t *p_flags)
+{
+    switch (logType)
+    {
+        case BLE_LOG_TYPE_HCI_COMMAND:
+            *p_h4 = 0x01;
+            *p_flags = 0x02;
+            break;
+        case BLE_LOG_TYPE_HCI_ACL_TX:
+            *p_h4 = 0x02;
+            *p_flags = 0x00;
+            break;
+        case BLE_LOG_TYPE_HCI_ACL_RX:
+            *p_h4 = 0x02;
+            *p_flags = 0x01;
+            break;
+        default:
+            *p_h4 = 0x04;
+            *p_flags = 0x03;
+            break;
+    }
+}
+
+/* True for a packet of the excluded channel: its outgoing PDUs, the credits
+ * the peer returns for them and the completed packet counts of the link. */
+static bool APP_BtSnoopExcluded(uint8_t logType, uint16_t logLength, const uint8_t *p_pkt)
+{
+    uint16_t cid = s_exclCid;
+    uint16_t aclLen;
+    uint16_t pduLen;
+
+    if (cid == 0U || logType == BLE_LOG_TYPE_HCI_COMMAND)
+    {
+        return false;
+    }
+    if (logType == BLE_LOG_TYPE_HCI_EVENT)
+    {
+        return logLength >= 7U && p_pkt[0] == APP_BTSNOOP_EVT_NUM_COMP_PKTS && p_pkt[2] == 1U &&
+               (APP_FrameGetLe16(&p_pkt[3]) & 0x0FFFU) == s_exclHandle;
+    }
+    if (logLength < 4U || (APP_FrameGetLe16(&p_pkt[0]) & 0x0FFFU) != s_exclHandle)
+    {
+        return false;
+    }
+    aclLen = APP_FrameGetLe16(&p_pkt[2]);
+    if (logType == BLE_LOG_TYPE_HCI_ACL_TX)
+    {
+        // A PDU longer than the ACL packet goes on in the next ones, which have no L2CAP header
+        if (s_exclTxLeft != 0U)
+        {
+            s_exclTxLeft = (aclLen < s_exclTxLeft) ? (uint16_t)(s_exclTxLeft - aclLen) : 0U;
+            return true;
+        }
+        if (logLength < 8U || APP_FrameGetLe16(&p_pkt[6]) != cid)
+        {
+            return false;
+        }
+        pduLen = (uint16_t)(APP_FrameGetLe16(&p_pkt[4]) + 4U);
+        s_exclTxLeft = (pduLen > aclLen) ? (uint16_t)(pduLen - aclLen) : 0U;
+        return true;
+    }
+    return logLength >= 16U && APP_FrameGetLe16(&p_pkt[6]) == APP_BTSNOOP_L2CAP_LE_SIG_CID &&
+           p_pkt[8] == APP_BTSNOOP_L2CAP_FLOW_CREDIT && APP_FrameGetLe16(&p_pkt[12]) == cid;
+}
+
+/* Append the record at the tail to the frame as a btsnoop record; returns
+ * the ring words it took. */
+static uint32_t APP_BtSnoopConvert(uint32_t tail, uint32_t hdr, uint8_t **pp_dst)
+{
+    uint8_t *p_dst = *pp_dst;
+    uint32_t origLen = hdr & APP_BTSNOOP_HDR_LEN_Msk;
+    uint32_t inclLen = (hdr >> APP_BTSNOOP_HDR_INCL_Pos) & APP_BTSNOOP_HDR_LEN_Msk;
+    uint32_t words = 3U + ((inclLen + 3U) / 4U);
+    uint32_t cycles = s_ring[(tail + 1U) & (APP_BTSNOOP_RING_WORDS - 1U)];
+    uint32_t drops = s_ring[(tail + 2U) & (APP_BTSNOOP_RING_WORDS - 1U)];
+    uint32_t pos = (tail + 3U) & (APP_BTSNOOP_RING_WORDS - 1U);
+    uint32_t first = (APP_BTSNOOP_RING_WORDS - pos) * 4U;
+    uint32_t flags;
+    uint64_t us;
+    uint8_t h4;
+
+    if (s_timeValid)
+    {
+        s_elapsedCycles += (uint32_t)(cycles - s_lastCycles);
+    }
+    s_timeValid = true;
+    s_lastCycles = cycles;
+    us = APP_BTSNOOP_EPOCH_US + (s_elapsedCycles / (configCPU_CLOCK_HZ / 1000000UL));
+
+    APP_BtSnoopTypeInfo((uint8_t)((hdr >> APP_BTSNOOP_HDR_TYPE_Pos) & 0x7U), &h4, &flags);
+    p_dst = APP_FramePutBe32(p_dst, origLen + 1U);
+    p_dst = APP_FramePutBe32(p_dst, inclLen + 1U);
+    p_dst = APP_FramePutBe32(p_dst, flags);
+    p_dst = APP_FramePutBe32(p_dst, drops);
+    p_dst = APP_FramePutBe32(p_dst, (uint32_t)(us >> 32));
+    p_dst = APP_FramePutBe32(p_dst, (uint32_t)us);
+    *p_dst++ = h4;
+
+    // The packet may wrap around the end of the ring
+    if (first >= inclLen)
+    {
+        memcpy(p_dst, &s_ring[pos], inclLen);
+    }
+    else
+    {
+        memcpy(p_dst, &s_ring[pos], first);
+        memcpy(&p_dst[first], &s_ring[0], inclLen - first);
+    }
+    *pp_dst = p_dst + inclLen;
+    return words;
+}
+
+/* Move committed records into s_frame. Returns the frame size, 0 if there
+ * was nothing to send. */
+static uint16_t APP_BtSnoopFillFrame(void)
+{
+    uint32_t tail = s_tail;
+    uint32_t hdr;
+    uint32_t words;
+    uint32_t i;
+    uint8_t *p_dst = &s_frame[APP_FRAME_HDR_LEN];
+    uint8_t flags;
+
+    while ((uint32_t)(p_dst - &s_frame[APP_FRAME_HDR_LEN]) < APP_BTSNOOP_CHUNK_SIZE && tail != s_head)
+    {
+        hdr = s_ring[tail & (APP_BTSNOOP_RING_WORDS - 1U)];
+        if (hdr == 0U)
+        {
+            break;      // Reserved, capture not done yet
+        }
+        __DMB();
+        words = APP_BtSnoopConvert(tail, hdr, &p_dst);
+        for (i = 0; i < words; i++)
+        {
+            s_ring[(tail + i) & (APP_BTSNOOP_RING_WORDS - 1U)] = 0U;
+        }
+        tail += words;
+    }
+    if (p_dst == &s_frame[APP_FRAME_HDR_LEN])
+    {
+        return 0;
+    }
+    __DMB();
+    s_tail = tail;
+
+    flags = s_startPending ? 0x01 : 0x00;
+    s_startPending = false;
+    return APP_FrameSeal(s_frame, "SNP", APP_BTSNOOP_FRAME_VERSION, flags, p_dst);
+}
+
+/**
+ * BTSNOOP DRAIN TASK
+ * @param pvParameters
+ */
+static void _BTSNOOP_Task(void *pvParameters)
+{
+    uint16_t size;
+
+    (void)pvParameters;
+    while (1)
+    {
+        size = APP_BtSnoopFillFrame();
+        if (size == 0U)
+        {
+            vTaskDelay(pdMS_TO_TICKS(APP_BTSNOOP_DRAIN_PERIOD_MS));
+        }
+        else
+        {
+            s_write(s_frame, size);
+        }
+    }
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_BtSnoopLogCb(uint8_t logType, uint16_t logLength, uint8_t *p_logPayload)
+{
+    uint32_t ts = DWT->CYCCNT;
+    uint32_t inclLen = logLength;
+    uint32_t words;
+    uint32_t idx;
+    uint32_t pos;
+    uint32_t first;
+
+    if (!s_enabled || logType < BLE_LOG_TYPE_HCI_COMMAND || logType > BLE_LOG_TYPE_HCI_EVENT)
+    {
+        return;
+    }
+    if (APP_BtSnoopExcluded(logType, logLength, p_logPayload))
+    {
+        s_stats.excluded++;
+        return;
+    }
+    if (inclLen > APP_BTSNOOP_PACKET_MAX)
+    {
+        inclLen = APP_BTSNOOP_PACKET_MAX;
+    }
+    if ((logType == BLE_LOG_TYPE_HCI_ACL_TX || logType == BLE_LOG_TYPE_HCI_ACL_RX) &&
+        s_aclSnapLen != 0U && inclLen > s_aclSnapLen)
+    {
+        inclLen = s_aclSnapLen;
+        s_stats.truncated++;
+    }
+
+    words = 3U + ((inclLen + 3U) / 4U);
+    if (!APP_RingReserve(&s_head, &s_tail, APP_BTSNOOP_RING_WORDS, words, &s_stats.dropped, &idx))
+    {
+        return;
+    }
+
+    s_ring[(idx + 1U) & (APP_BTSNOOP_RING_WORDS - 1U)] = ts;
+    s_ring[(idx + 2U) & (APP_BTSNOOP_RING_WORDS - 1U)] = s_stats.dropped;
+    pos = (idx + 3U) & (APP_BTSNOOP_RING_WORDS - 1U);
+    first = (APP_BTSNOOP_RING_WORDS - pos) * 4U;
+    if (first >= inclLen)
+    {
+        memcpy(&s_ring[pos], p_logPayload, inclLen);
+    }
+    else
+    {
+        memcpy(&s_ring[pos], p_logPayload, first);
+        memcpy(&s_ring[0], &p_logPayload[first], inclLen - first);
+    }
+    s_stats.packets++;
+    s_stats.bytes += inclLen;
+
+    __DMB();
+    s_ring[idx & (APP_BTSNOOP_RING_WORDS - 1U)] = APP_BTSNOOP_HDR_VALID |
+        ((uint32_t)logType << APP_BTSNOOP_HDR_TYPE_Pos) |
+        (inclLen << APP_BTSNOOP_HDR_INCL_Pos) |
+        ((uint32_t)logLength & APP_BTSNOOP_HDR_LEN_Msk);
+}
+
+void APP_BtSnoopInit(APP_BTSNOOP_WRITE write, uint16_t aclSnapLen)
+{
+    s_write = write;
+    s_aclSnapLen = aclSnapLen;
+    s_enabled = false;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    BLE_LOG_EventRegister(APP_BtSnoopLogCb);
+
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _BTSNOOP_Task,
+            "BTSNOOP_Task",
+            256,
+            NULL,
+            1,
+            &xBTSNOOP_Task);
+}
+
+void APP_BtSnoopStart(void)
+{
+    s_startPending = true;
+    s_enabled = true;
+    if (!s_logEnabled)
+    {
+        BT_SYS_LogEnable(BLE_LOG_StackLogHandler);
+        s_logEnabled = true;
+    }
+}
+
+void APP_BtSnoopStop(void)
+{
+    s_enabled = false;
+}
+
+void APP_BtSnoopExcludeChannel(uint16_t connHandle, uint16_t peerCid)
+{
+    s_exclCid = 0U;
+    s_exclTxLeft = 0U;
+    s_exclHandle = connHandle & 0x0FFFU;
+    s_exclCid = peerCid;
+}
+
+void APP_BtSnoopGetStats(APP_BTSNOOP_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+
+
+/*******************************************************************************
+ End of File
+ */
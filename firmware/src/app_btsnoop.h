@@ -0,0 +1,228 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_btsnoop.h
+
+  Summary:
+    HCI capture in btsnoop format.
+
+  Description:
+    The ble_stack reports every HCI command, event and ACL packet through
+    BT_SYS_LogEnable; the BLE_LOG middleware rebuilds the packets and hands
+    them to APP_BtSnoopLogCb. The capture path only copies the packet into
+    a word ring reserved with LDREX/STREX, so the stack is never held up by
+    the output: when the ring is full the packet is dropped and counted, and
+    the count goes into the cumulative drops field of the next record.
+
+    ACL packets can be truncated to a snap length; the btsnoop record keeps
+    the original length, so Wireshark shows them as cut short.
+
+    A low priority task turns the ring content into btsnoop records and sends
+    them in CRC protected frames to the sink given to APP_BtSnoopInit.
+    When the sink is the pipe, the frames travel on the link being captured.
+    APP_BtSnoopExcludeChannel leaves the pipe's data channel out: its
+    outgoing PDUs, the credits the peer returns for them and the completed
+    packet counts of its connection. Otherwise every frame would be captured
+    again and the stream would never go quiet.
+
+    tools/btsnoop_extract.py collects the records from a raw capture of the
+    sink into a .btsnoop file, or streams them as pcap to "wireshark -k -i -".
+
+    Timestamps are microseconds since the first packet, counted from the core
+    cycle counter, so periods in which the device slept appear compressed.
+*******************************************************************************/
+
+#ifndef _APP_BTSNOOP_H
+#define _APP_BTSNOOP_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Start capturing right after the BLE stack is initialized, so connection
+ * setup is captured. With 0 capture starts on "\nSNPON\n" over the pipe. */
+#ifndef APP_BTSNOOP_AUTOSTART
+#define APP_BTSNOOP_AUTOSTART           0
+#endif
+
+/* Ring size in 32 bit words, a power of two. 1024 words take 4 KB of RAM. */
+#ifndef APP_BTSNOOP_RING_WORDS
+#define APP_BTSNOOP_RING_WORDS          1024
+#endif
+
+/* ACL bytes kept per packet when streaming on the debug UART, 0 keeps all. */
+#ifndef APP_BTSNOOP_ACL_SNAPLEN
+#define APP_BTSNOOP_ACL_SNAPLEN         0
+#endif
+
+/* ACL bytes kept per packet when streaming over the pipe. The capture shares
+ * the link with the traffic it records; keeping only the ACL and L2CAP
+ * headers leaves the link to that traffic. */
+#ifndef APP_BTSNOOP_PIPE_ACL_SNAPLEN
+#define APP_BTSNOOP_PIPE_ACL_SNAPLEN    8
+#endif
+
+/* Record bytes per drained frame, at least one record always fits. */
+#ifndef APP_BTSNOOP_CHUNK_SIZE
+#define APP_BTSNOOP_CHUNK_SIZE          512
+#endif
+
+/* Drain task poll period while the ring is empty. */
+#ifndef APP_BTSNOOP_DRAIN_PERIOD_MS
+#define APP_BTSNOOP_DRAIN_PERIOD_MS     20
+#endif
+
+/* Largest HCI packet captured, without the H4 packet type byte. */
+#define APP_BTSNOOP_PACKET_MAX          260
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Drained frame:
+ *
+ *   sync       4   0x7E 'S' 'N' 'P'
+ *   version    1   APP_BTSNOOP_FRAME_VERSION
+ *   flags      1   bit 0: first frame since APP_BtSnoopStart
+ *   length     2   bytes from version up to the CRC, exclusive, little endian
+ *   records        btsnoop records (datalink 1002, HCI UART H4), big endian
+ *                  as in a btsnoop file
+ *   crc        2   CRC-16/CCITT-FALSE from version up to here, little endian
+ */
+#define APP_BTSNOOP_FRAME_VERSION       1
+#define APP_BTSNOOP_RECORD_HDR_SIZE     24
+#define APP_BTSNOOP_FRAME_MAX_SIZE      (8 + APP_BTSNOOP_CHUNK_SIZE + APP_BTSNOOP_RECORD_HDR_SIZE + 1 + APP_BTSNOOP_PACKET_MAX + 2)
+
+typedef struct APP_BTSNOOP_Stats_T
+{
+    uint32_t    packets;                /* Packets stored in the ring */
+    uint32_t    bytes;                  /* Packet bytes stored, after truncation */
+    uint32_t    truncated;              /* ACL packets cut to the snap length */
+    uint32_t    dropped;                /* Packets lost on a full ring */
+    uint32_t    excluded;               /* Packets of the excluded channel left out */
+} APP_BTSNOOP_Stats_T;
+
+typedef void (*APP_BTSNOOP_WRITE)(uint8_t *data, uint16_t length);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_BtSnoopInit ( APP_BTSNOOP_WRITE write, uint16_t aclSnapLen )
+
+  Summary:
+     Register with BLE_LOG and create the drain task. Capture stays off until
+     APP_BtSnoopStart. aclSnapLen 0 keeps ACL packets whole.
+*/
+void APP_BtSnoopInit(APP_BTSNOOP_WRITE write, uint16_t aclSnapLen);
+
+/*******************************************************************************
+  Function:
+    void APP_BtSnoopStart ( void )
+
+  Summary:
+     Start capturing. Call after the BLE stack is initialized.
+*/
+void APP_BtSnoopStart(void);
+
+/*******************************************************************************
+  Function:
+    void APP_BtSnoopStop ( void )
+
+  Summary:
+     Stop capturing; packets already in the ring are still sent.
+*/
+void APP_BtSnoopStop(void);
+
+/*******************************************************************************
+  Function:
+    void APP_BtSnoopLogCb ( uint8_t logType, uint16_t logLength, uint8_t *p_logPayload )
+
+  Summary:
+     BLE_LOG event callback; stores one packet. Runs in the stack's context.
+*/
+void APP_BtSnoopLogCb(uint8_t logType, uint16_t logLength, uint8_t *p_logPayload);
+
+/*******************************************************************************
+  Function:
+    void APP_BtSnoopExcludeChannel ( uint16_t connHandle, uint16_t peerCid )
+
+  Summary:
+     Leave the L2CAP channel the frames are sent on out of the capture.
+     peerCid 0 captures everything again.
+*/
+void APP_BtSnoopExcludeChannel(uint16_t connHandle, uint16_t peerCid);
+
+/*******************************************************************************
+  Function:
+    void APP_BtSnoopGetStats ( APP_BTSNOOP_Stats_T *p_stats )
+
+  Summary:
+     Copy the capture counters.
+*/
+void APP_BtSnoopGetStats(APP_BTSNOOP_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_BTSNOOP_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,753 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dfu.c
+
+  Summary:
+    Firmware update over the pipe, written to the inactive flash panel.
+
+  Description:
+    The update belongs to the pipe task. It takes the messages, hashes the
+    image, fills the row buffers and submits the erases and row writes of
+    the upper panel to the flash queue (app_flash.h), one at a time. The
+    completion callback, in the NVM interrupt, only records the result and
+    wakes the pipe task. A start or an abort bumps a generation, so the
+    result of an operation submitted for an older update is dropped; the
+    next operation still waits for it, as it may be reading a row buffer.
+
+    Panel layout, with the offsets of the running image:
+
+      0                     PDS, PDS journal and data log (app_log.h),
+                            copied over on activation
+      __rom_start           image, vectors first (WBZ451.ld)
+      __app_spill_start     pipe spill ring (app_spill.h), not copied
+      panel - page          bank record
+
+    With the layout the vectors no longer sit in boot flash: boot flash only
+    holds a fixed entry that loads the stack pointer and the reset vector
+    from the start of the image, so it is the same for every image.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_dfu.h"
+#include "app_frame.h"
+#include "blecb_pipe.h"
+#include "app_flash.h"
+#include "app_icm.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_DFU_PANEL_SIZE              (NVM_FLASH_SIZE / 2U)
+#define APP_DFU_ACTIVE_BASE             NVM_FLASH_START_ADDRESS
+#define APP_DFU_UPDATE_BASE             (NVM_FLASH_START_ADDRESS + APP_DFU_PANEL_SIZE)
+#define APP_DFU_RECORD_OFFSET           (APP_DFU_PANEL_SIZE - NVM_FLASH_PAGESIZE)
+#define APP_DFU_IMAGE_OFFSET            ((uint32_t)&__rom_start - NVM_FLASH_START_ADDRESS)
+#define APP_DFU_IMAGE_MAX               (APP_DFU_RECORD_OFFSET - APP_DFU_IMAGE_OFFSET)
+#define APP_DFU_RECORD_MAGIC            0x31554644U     /* "DFU1" */
+#define APP_DFU_ROWS                    2
+#define APP_DFU_ROW_WORDS               (NVM_FLASH_ROWSIZE / sizeof(uint32_t))
+#define APP_DFU_RSP_RETRY_MS            BLECB_Pipe_TX_RETRY_MS
+#define APP_DFU_FLASH_RETRY_MS          2       /* Flash queue full */
+
+#if defined(APP_DFU_KEY)
+static const uint8_t s_key[] = APP_DFU_KEY;
+#elif APP_DFU_ENABLE
+#error "APP_DFU_ENABLE needs APP_DFU_KEY, see configuration.h"
+#else
+static const uint8_t s_key[APP_DFU_MAC_LEN];    /* Update not built in */
+#endif
+
+extern uint32_t __rom_start;
+extern uint32_t __rom_end;
+extern uint32_t __ram_end;
+extern uint32_t __svectors;
+
+typedef enum APP_DFU_State_T
+{
+    APP_DFU_STATE_IDLE = 0,
+    APP_DFU_STATE_ERASE,                /* Erasing the update panel */
+    APP_DFU_STATE_RECEIVE,              /* Rows programmed as they fill */
+    APP_DFU_STATE_FINISH,               /* Digest matched, last rows being programmed */
+    APP_DFU_STATE_COPY_PDS,
+    APP_DFU_STATE_COMMIT,               /* Writing the bank record */
+    APP_DFU_STATE_DONE,
+} APP_DFU_State_T;
+
+/* Last row of a panel. sequenceInv makes a torn row write read as invalid. */
+typedef struct APP_DFU_Record_T
+{
+    uint32_t    magic;
+    uint32_t    sequence;
+    uint32_t    sequenceInv;
+    uint32_t    size;
+    uint8_t     digest[APP_DFU_DIGEST_LEN];
+} APP_DFU_Record_T;
+
+typedef struct APP_DFU_Ctrl_T
+{
+    APP_DFU_State_T state;
+    uint32_t        generation;         /* Bumped by a start or an abort */
+    bool            rowQueued[APP_DFU_ROWS];
+    uint32_t        rowAddr[APP_DFU_ROWS];
+    uint8_t         writeRow;
+    uint8_t         fillRow;
+    uint16_t        fillLen;
+    uint32_t        fillOffset;         /* Image offset of the row being filled */
+    bool            held;
+    bool            startAcked;
+    bool            doneAcked;
+    uint32_t        startTime;
+    uint32_t        transferStart;
+    uint32_t        rebootTime;
+    uint8_t         digest[APP_DFU_DIGEST_LEN];
+    uint8_t         rsp[APP_DFU_RSP_LEN];
+    bool            rspPending;
+
+    /* Flash operation submitted; opDone is set by the NVM interrupt */
+    bool            opBusy;
+    volatile bool   opDone;
+    volatile bool   opOk;
+    uint32_t        opGeneration;
+    uint32_t        eraseAddr;
+    uint32_t        eraseEnd;
+    uint32_t        copyOffset;
+
+    bool            layoutOk;
+    APP_DFU_Stats_T stats;
+} APP_DFU_Ctrl_T;
+
+static APP_DFU_Ctrl_T s_dfu;
+static uint32_t s_rows[APP_DFU_ROWS][APP_DFU_ROW_WORDS];
+static CRYPT_SHA256_CTX s_sha;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t APP_DfuNowMs(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static bool APP_DfuRecordValid(const APP_DFU_Record_T *p_rec)
+{
+    return p_rec->magic == APP_DFU_RECORD_MAGIC && p_rec->sequenceInv == ~p_rec->sequence;
+}
+
+/* The running image is linked for the panel layout: it ends below the bank
+ * record and its vectors open the image, where the boot entry looks. */
+static bool APP_DfuLayoutOk(void)
+{
+    return (uint32_t)&__rom_end <= APP_DFU_ACTIVE_BASE + APP_DFU_RECORD_OFFSET
+        && (uint32_t)&__svectors == APP_DFU_ACTIVE_BASE + APP_DFU_IMAGE_OFFSET;
+}
+
+/* Runs from RAM: the flash under the CPU changes with PFSWAP. Jumps to the
+ * reset vector of the image now mapped at the lower panel. */
+static void __attribute__((ramfunc, long_call, section(".ramfunc"), unique_section, noreturn, noinline)) APP_DfuSwapAndRestart(void)
+{
+    const volatile uint32_t *p_vectors = (const volatile uint32_t *)&__svectors;
+
+    __disable_irq();
+    CMCC_REGS->CMCC_CTRL &= ~(CMCC_CTRL_CEN_Msk);
+    while ((CMCC_REGS->CMCC_SR & CMCC_SR_CSTS_Msk) == CMCC_SR_CSTS_Msk)
+    {
+    }
+    CMCC_REGS->CMCC_MAINT0 = CMCC_MAINT0_INVALL_Msk;
+
+    NVM_REGS->NVM_NVMKEY = 0x0U;
+    NVM_REGS->NVM_NVMKEY = 0xAA996655U;
+    NVM_REGS->NVM_NVMKEY = 0x556699AAU;
+    if ((NVM_REGS->NVM_NVMCON & NVM_NVMCON_PFSWAP_Msk) != 0U)
+    {
+        NVM_REGS->NVM_NVMCONCLR = NVM_NVMCON_PFSWAP_Msk;
+    }
+    else
+    {
+        NVM_REGS->NVM_NVMCONSET = NVM_NVMCON_PFSWAP_Msk;
+    }
+    __DSB();
+    __ISB();
+
+    __set_MSP(p_vectors[0]);
+    ((void (*)(void))p_vectors[1])();
+    while (true)
+    {
+    }
+}
+
+#if APP_DFU_ENABLE
+/* Boot flash entry (.app_dfu_boot, WBZ451.ld): a two word vector table and a
+ * jump through the vectors at the start of the image. */
+static void __attribute__((naked, noreturn, used, section(".app_dfu_boot.entry"))) APP_DfuBootEntry(void)
+{
+    __asm volatile (
+        "ldr r0, =__svectors    \n"
+        "ldr r1, [r0]           \n"
+        "msr msp, r1            \n"
+        "ldr r1, [r0, #4]       \n"
+        "bx  r1                 \n"
+        ".ltorg                 \n"
+    );
+}
+
+const void * const APP_DfuBootVectors[2] __attribute__((used, section(".app_dfu_boot.vectors"))) =
+{
+    &__ram_end,
+    (const void *)APP_DfuBootEntry,
+};
+#endif
+
+static bool APP_DfuPageErased(uint32_t addr)
+{
+    const uint32_t *p_word = (const uint32_t *)addr;
+    uint32_t i;
+
+    for (i = 0; i < NVM_FLASH_PAGESIZE / sizeof(uint32_t); i++)
+    {
+        if (p_word[i] != 0xFFFFFFFFU)
+            return false;
+    }
+    return true;
+}
+
+/* The start message was sent with APP_DFU_KEY. Compares in constant time. */
+static bool APP_DfuStartAuthentic(const uint8_t *p_msg)
+{
+    uint8_t mac[APP_DFU_MAC_LEN];
+    uint8_t diff = 0;
+    uint32_t i;
+
+    APP_IcmHmacSha256(s_key, sizeof(s_key), p_msg, APP_DFU_START_LEN - APP_DFU_MAC_LEN, mac);
+    for (i = 0; i < APP_DFU_MAC_LEN; i++)
+        diff |= mac[i] ^ p_msg[APP_DFU_START_LEN - APP_DFU_MAC_LEN + i];
+    return diff == 0;
+}
+
+/* Pipe task: drop the update; an operation in flight still comes back */
+static void APP_DfuReset(APP_DFU_State_T state)
+{
+    s_dfu.generation++;
+    s_dfu.state = state;
+    s_dfu.rowQueued[0] = false;
+    s_dfu.rowQueued[1] = false;
+    s_dfu.writeRow = 0;
+    s_dfu.fillRow = 0;
+    s_dfu.fillLen = 0;
+    s_dfu.fillOffset = 0;
+    s_dfu.held = false;
+}
+
+static void APP_DfuRespond(uint8_t op, uint8_t status, uint32_t value)
+{
+    memcpy(s_dfu.rsp, APP_DFU_MAGIC, APP_DFU_MAGIC_LEN);
+    s_dfu.rsp[4] = APP_DFU_OP_RESPONSE;
+    s_dfu.rsp[5] = op;
+    s_dfu.rsp[6] = status;
+    s_dfu.rsp[7] = (uint8_t)value;
+    s_dfu.rsp[8] = (uint8_t)(value >> 8);
+    s_dfu.rsp[9] = (uint8_t)(value >> 16);
+    s_dfu.rsp[10] = (uint8_t)(value >> 24);
+    s_dfu.rspPending = !BLECB_Pipe_SendProto(s_dfu.rsp, APP_DFU_RSP_LEN, NULL, 0);
+}
+
+static void APP_DfuFail(uint8_t op, uint8_t status, uint32_t value)
+{
+    APP_DfuReset(APP_DFU_STATE_IDLE);
+    APP_DfuRespond(op, status, value);
+}
+
+/* NVM interrupt */
+static void APP_DfuFlashDone(bool ok, uintptr_t context)
+{
+    (void)context;
+
+    s_dfu.opOk = ok;
+    s_dfu.opDone = true;
+    BLECB_Pipe_WakeISR();
+}
+
+static bool APP_DfuSubmit(APP_FLASH_OpType_T type, uint32_t addr, const uint32_t *p_data)
+{
+    APP_FLASH_Op_T op;
+
+    op.type = type;
+    op.addr = addr;
+    op.p_data = p_data;
+    op.callback = APP_DfuFlashDone;
+    op.context = 0;
+
+    s_dfu.opDone = false;
+    if (!APP_FlashSubmit(&op))
+        return false;
+    s_dfu.opBusy = true;
+    s_dfu.opGeneration = s_dfu.generation;
+    return true;
+}
+
+/* Queue the row being filled for programming, padded with erased bytes */
+static void APP_DfuQueueRow(void)
+{
+    uint8_t row = s_dfu.fillRow;
+
+    if (s_dfu.fillLen < NVM_FLASH_ROWSIZE)
+    {
+        memset((uint8_t *)s_rows[row] + s_dfu.fillLen, 0xFF, NVM_FLASH_ROWSIZE - s_dfu.fillLen);
+    }
+    s_dfu.rowAddr[row] = APP_DFU_UPDATE_BASE + APP_DFU_IMAGE_OFFSET + s_dfu.fillOffset;
+    s_dfu.rowQueued[row] = true;
+    s_dfu.fillOffset += NVM_FLASH_ROWSIZE;
+    s_dfu.fillRow = row ^ 1U;
+    s_dfu.fillLen = 0;
+}
+
+static void APP_DfuStart(const uint8_t *p_msg, uint16_t length)
+{
+    uint32_t size;
+    uint32_t base;
+
+    if (length < APP_DFU_START_LEN)
+    {
+        APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_BAD_SIZE, APP_DFU_IMAGE_MAX);
+        return;
+    }
+    if (!s_dfu.layoutOk)
+    {
+        APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_LAYOUT, 0);
+        return;
+    }
+    if (!APP_DfuStartAuthentic(p_msg))
+    {
+        APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_AUTH, 0);
+        return;
+    }
+    if (s_dfu.state != APP_DFU_STATE_IDLE)
+    {
+        APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_BAD_STATE, 0);
+        return;
+    }
+    size = APP_FrameGetLe32(&p_msg[APP_DFU_HDR_LEN]);
+    if (size == 0 || size > APP_DFU_IMAGE_MAX)
+    {
+        APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_BAD_SIZE, APP_DFU_IMAGE_MAX);
+        return;
+    }
+    /* Linked elsewhere, the image would run with every address off */
+    base = APP_FrameGetLe32(&p_msg[APP_DFU_HDR_LEN + 4]);
+    if (base != (uint32_t)&__svectors)
+    {
+        APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_BAD_BASE, (uint32_t)&__svectors);
+        return;
+    }
+
+    memcpy(s_dfu.digest, &p_msg[APP_DFU_HDR_LEN + 8], APP_DFU_DIGEST_LEN);
+    APP_IcmSha256Init(&s_sha);
+    memset(&s_dfu.stats, 0, sizeof(s_dfu.stats));
+    s_dfu.stats.imageSize = size;
+    s_dfu.stats.sequence = APP_DfuRecordValid((const APP_DFU_Record_T *)(APP_DFU_ACTIVE_BASE + APP_DFU_RECORD_OFFSET)) ?
+                           ((const APP_DFU_Record_T *)(APP_DFU_ACTIVE_BASE + APP_DFU_RECORD_OFFSET))->sequence : 0;
+    s_dfu.startAcked = false;
+    s_dfu.doneAcked = false;
+    s_dfu.startTime = APP_DfuNowMs();
+
+    /* The bank record goes first, so a half written panel is never booted */
+    s_dfu.eraseAddr = APP_DFU_UPDATE_BASE + APP_DFU_RECORD_OFFSET;
+    s_dfu.eraseEnd = APP_DFU_UPDATE_BASE +
+                     ((APP_DFU_IMAGE_OFFSET + size + NVM_FLASH_PAGESIZE - 1U) & ~(NVM_FLASH_PAGESIZE - 1U));
+    APP_DfuReset(APP_DFU_STATE_ERASE);
+}
+
+static void APP_DfuData(const uint8_t *p_msg, uint16_t length)
+{
+    const uint8_t *p_data = &p_msg[APP_DFU_DATA_HDR_LEN];
+    uint32_t offset;
+    uint16_t len;
+    uint16_t n;
+
+    if (s_dfu.state != APP_DFU_STATE_RECEIVE)
+    {
+        APP_DfuRespond(APP_DFU_OP_DATA, APP_DFU_STATUS_BAD_STATE, s_dfu.stats.received);
+        return;
+    }
+    if (length <= APP_DFU_DATA_HDR_LEN || length - APP_DFU_DATA_HDR_LEN > APP_DFU_CHUNK_MAX)
+    {
+        APP_DfuRespond(APP_DFU_OP_DATA, APP_DFU_STATUS_BAD_SIZE, s_dfu.stats.received);
+        return;
+    }
+    len = length - APP_DFU_DATA_HDR_LEN;
+    offset = APP_FrameGetLe32(&p_msg[APP_DFU_HDR_LEN]);
+    if (offset != s_dfu.stats.received || len > s_dfu.stats.imageSize - offset)
+    {
+        APP_DfuRespond(APP_DFU_OP_DATA, APP_DFU_STATUS_BAD_OFFSET, s_dfu.stats.received);
+        return;
+    }
+
+    APP_IcmSha256Add(&s_sha, p_data, len);
+    s_dfu.stats.received += len;
+    while (len != 0)
+    {
+        n = NVM_FLASH_ROWSIZE - s_dfu.fillLen;
+        if (n > len)
+            n = len;
+        memcpy((uint8_t *)s_rows[s_dfu.fillRow] + s_dfu.fillLen, p_data, n);
+        s_dfu.fillLen += n;
+        p_data += n;
+        len -= n;
+        if (s_dfu.fillLen == NVM_FLASH_ROWSIZE)
+            APP_DfuQueueRow();
+    }
+}
+
+static void APP_DfuFinish(void)
+{
+    uint8_t digest[APP_DFU_DIGEST_LEN];
+
+    if (s_dfu.state != APP_DFU_STATE_RECEIVE)
+    {
+        APP_DfuRespond(APP_DFU_OP_FINISH, APP_DFU_STATUS_BAD_STATE, s_dfu.stats.received);
+        return;
+    }
+    if (s_dfu.stats.received != s_dfu.stats.imageSize)
+    {
+        APP_DfuRespond(APP_DFU_OP_FINISH, APP_DFU_STATUS_BAD_SIZE, s_dfu.stats.received);
+        return;
+    }
+
+    APP_IcmSha256Final(&s_sha, digest);
+    if (memcmp(digest, s_dfu.digest, APP_DFU_DIGEST_LEN) != 0)
+    {
+        APP_DfuFail(APP_DFU_OP_FINISH, APP_DFU_STATUS_DIGEST, s_dfu.stats.received);
+        return;
+    }
+
+    /* The fill row is never queued while it holds data */
+    if (s_dfu.fillLen != 0)
+        APP_DfuQueueRow();
+    s_dfu.state = APP_DFU_STATE_FINISH;
+}
+
+/* The image starts with its vectors: a stack in RAM and a reset handler
+ * inside the image, as mapped once the panels are swapped. */
+static bool APP_DfuImageVectorsOk(void)
+{
+    const uint32_t *p_vectors = (const uint32_t *)(APP_DFU_UPDATE_BASE + APP_DFU_IMAGE_OFFSET);
+    uint32_t imageStart = APP_DFU_ACTIVE_BASE + APP_DFU_IMAGE_OFFSET;
+
+    return p_vectors[0] > HSRAM_ADDR && p_vectors[0] <= (uint32_t)&__ram_end
+        && (p_vectors[1] & 1U) != 0U
+        && p_vectors[1] > imageStart && p_vectors[1] < imageStart + s_dfu.stats.imageSize;
+}
+
+/* Next page to erase, the bank record page first. Once past the image the
+ * start can be answered. */
+static bool APP_DfuEraseStep(void)
+{
+    s_dfu.eraseAddr = (s_dfu.eraseAddr == APP_DFU_UPDATE_BASE + APP_DFU_RECORD_OFFSET) ?
+                      APP_DFU_UPDATE_BASE : s_dfu.eraseAddr + NVM_FLASH_PAGESIZE;
+    if (s_dfu.eraseAddr < s_dfu.eraseEnd)
+        return true;
+
+    s_dfu.transferStart = APP_DfuNowMs();
+    s_dfu.state = APP_DFU_STATE_RECEIVE;
+    return false;
+}
+
+/* Result of the operation submitted for the current update */
+static void APP_DfuFlashResult(bool ok)
+{
+    uint8_t row = s_dfu.writeRow;
+
+    switch (s_dfu.state)
+    {
+        case APP_DFU_STATE_ERASE:
+            if (!ok)
+                APP_DfuFail(APP_DFU_OP_START, APP_DFU_STATUS_FLASH, s_dfu.eraseAddr - APP_DFU_UPDATE_BASE);
+            else
+                (void)APP_DfuEraseStep();
+            break;
+
+        case APP_DFU_STATE_RECEIVE:
+        case APP_DFU_STATE_FINISH:
+            if (!ok)
+            {
+                APP_DfuFail(APP_DFU_OP_DATA, APP_DFU_STATUS_FLASH,
+                            s_dfu.rowAddr[row] - APP_DFU_UPDATE_BASE - APP_DFU_IMAGE_OFFSET);
+                break;
+            }
+            s_dfu.rowQueued[row] = false;
+            s_dfu.writeRow = row ^ 1U;
+            s_dfu.stats.written += NVM_FLASH_ROWSIZE;
+            break;
+
+        case APP_DFU_STATE_COPY_PDS:
+            if (!ok)
+            {
+                APP_DfuFail(APP_DFU_OP_FINISH, APP_DFU_STATUS_FLASH, s_dfu.copyOffset);
+                break;
+            }
+            s_dfu.copyOffset += NVM_FLASH_ROWSIZE;
+            if (s_dfu.copyOffset >= APP_DFU_IMAGE_OFFSET)
+                s_dfu.state = APP_DFU_STATE_COMMIT;
+            break;
+
+        case APP_DFU_STATE_COMMIT:
+            if (!ok)
+                APP_DfuFail(APP_DFU_OP_FINISH, APP_DFU_STATUS_FLASH, APP_DFU_RECORD_OFFSET);
+            else
+                s_dfu.state = APP_DFU_STATE_DONE;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* Submit the next operation the update needs. Returns false if the flash
+ * queue had no room. */
+static bool APP_DfuFlashIssue(void)
+{
+    APP_DFU_Record_T *p_rec;
+    uint8_t row = s_dfu.writeRow;
+
+    switch (s_dfu.state)
+    {
+        case APP_DFU_STATE_ERASE:
+            /* Pages left erased by an earlier update cost no flash time */
+            while (APP_DfuPageErased(s_dfu.eraseAddr))
+            {
+                if (!APP_DfuEraseStep())
+                    return true;
+            }
+            return APP_DfuSubmit(APP_FLASH_OP_ERASE_PAGE, s_dfu.eraseAddr, NULL);
+
+        case APP_DFU_STATE_RECEIVE:
+        case APP_DFU_STATE_FINISH:
+            if (s_dfu.rowQueued[row])
+                return APP_DfuSubmit(APP_FLASH_OP_WRITE_ROW, s_dfu.rowAddr[row], s_rows[row]);
+            if (s_dfu.state == APP_DFU_STATE_RECEIVE)
+                return true;
+
+            s_dfu.stats.written = s_dfu.stats.imageSize;
+            s_dfu.stats.transferMs = APP_DfuNowMs() - s_dfu.transferStart;
+            if (!APP_DfuImageVectorsOk())
+            {
+                APP_DfuFail(APP_DFU_OP_FINISH, APP_DFU_STATUS_LAYOUT, 0);
+                return true;
+            }
+            s_dfu.copyOffset = 0;
+            s_dfu.state = APP_DFU_STATE_COPY_PDS;
+            return APP_DfuFlashIssue();
+
+        case APP_DFU_STATE_COPY_PDS:
+            /* Both row buffers are free once the image is written */
+            memcpy(s_rows[0], (const void *)(APP_DFU_ACTIVE_BASE + s_dfu.copyOffset), NVM_FLASH_ROWSIZE);
+            return APP_DfuSubmit(APP_FLASH_OP_WRITE_ROW, APP_DFU_UPDATE_BASE + s_dfu.copyOffset, s_rows[0]);
+
+        case APP_DFU_STATE_COMMIT:
+            memset(s_rows[0], 0xFF, NVM_FLASH_ROWSIZE);
+            p_rec = (APP_DFU_Record_T *)s_rows[0];
+            p_rec->magic = APP_DFU_RECORD_MAGIC;
+            p_rec->sequence = s_dfu.stats.sequence + 1U;
+            p_rec->sequenceInv = ~p_rec->sequence;
+            p_rec->size = s_dfu.stats.imageSize;
+            memcpy(p_rec->digest, s_dfu.digest, APP_DFU_DIGEST_LEN);
+            return APP_DfuSubmit(APP_FLASH_OP_WRITE_ROW, APP_DFU_UPDATE_BASE + APP_DFU_RECORD_OFFSET, s_rows[0]);
+
+        default:
+            return true;
+    }
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_DfuBootSelect(void)
+{
+    const APP_DFU_Record_T *p_active = (const APP_DFU_Record_T *)(APP_DFU_ACTIVE_BASE + APP_DFU_RECORD_OFFSET);
+    const APP_DFU_Record_T *p_update = (const APP_DFU_Record_T *)(APP_DFU_UPDATE_BASE + APP_DFU_RECORD_OFFSET);
+
+    if (!APP_DfuLayoutOk() || !APP_DfuRecordValid(p_update))
+        return;
+    if (APP_DfuRecordValid(p_active) && (int32_t)(p_update->sequence - p_active->sequence) <= 0)
+        return;
+
+    APP_DfuSwapAndRestart();
+}
+
+void APP_DfuInit(void)
+{
+    const APP_DFU_Record_T *p_active = (const APP_DFU_Record_T *)(APP_DFU_ACTIVE_BASE + APP_DFU_RECORD_OFFSET);
+
+    // The image digest runs on the ICM, which the clock setup leaves disabled
+    APP_IcmInit();
+    memset(&s_dfu, 0, sizeof(s_dfu));
+    s_dfu.layoutOk = APP_DfuLayoutOk();
+    s_dfu.stats.sequence = APP_DfuRecordValid(p_active) ? p_active->sequence : 0;
+}
+
+bool APP_DfuIsMessage(const uint8_t *p_data, uint16_t length)
+{
+    return length >= APP_DFU_HDR_LEN && memcmp(p_data, APP_DFU_MAGIC, APP_DFU_MAGIC_LEN) == 0;
+}
+
+bool APP_DfuRxReady(uint16_t length)
+{
+    uint16_t len = (length > APP_DFU_DATA_HDR_LEN) ? (uint16_t)(length - APP_DFU_DATA_HDR_LEN) : 0U;
+    bool ready;
+
+    if (s_dfu.state != APP_DFU_STATE_RECEIVE || len == 0)
+        return true;
+
+    if (s_dfu.rowQueued[s_dfu.fillRow])
+        ready = false;
+    else if (s_dfu.fillLen + len <= NVM_FLASH_ROWSIZE)
+        ready = true;
+    else
+        ready = !s_dfu.rowQueued[s_dfu.fillRow ^ 1U];
+
+    if (!ready && !s_dfu.held)
+        s_dfu.stats.rowsHeld++;
+    s_dfu.held = !ready;
+    return ready;
+}
+
+void APP_DfuRxMessage(const uint8_t *p_msg, uint16_t length)
+{
+    if (!APP_DfuIsMessage(p_msg, length))
+        return;
+
+    switch (p_msg[APP_DFU_MAGIC_LEN])
+    {
+        case APP_DFU_OP_START:
+            APP_DfuStart(p_msg, length);
+            break;
+
+        case APP_DFU_OP_DATA:
+            APP_DfuData(p_msg, length);
+            break;
+
+        case APP_DFU_OP_FINISH:
+            APP_DfuFinish();
+            break;
+
+        case APP_DFU_OP_ABORT:
+            if (s_dfu.state != APP_DFU_STATE_DONE)
+                APP_DfuReset(APP_DFU_STATE_IDLE);
+            APP_DfuRespond(APP_DFU_OP_ABORT, APP_DFU_STATUS_OK, s_dfu.stats.received);
+            break;
+
+        default:
+            APP_DfuRespond(p_msg[APP_DFU_MAGIC_LEN], APP_DFU_STATUS_BAD_STATE, 0);
+            break;
+    }
+}
+
+uint16_t APP_DfuTasks(void)
+{
+    uint16_t wait = OSAL_WAIT_FOREVER;
+    uint32_t now;
+
+    if (s_dfu.rspPending)
+    {
+        s_dfu.rspPending = !BLECB_Pipe_SendProto(s_dfu.rsp, APP_DFU_RSP_LEN, NULL, 0);
+        if (s_dfu.rspPending)
+            return APP_DFU_RSP_RETRY_MS;
+    }
+
+    if (s_dfu.opBusy && s_dfu.opDone)
+    {
+        s_dfu.opBusy = false;
+        if (s_dfu.opGeneration == s_dfu.generation)
+            APP_DfuFlashResult(s_dfu.opOk);
+    }
+    if (!s_dfu.opBusy && !APP_DfuFlashIssue())
+        wait = APP_DFU_FLASH_RETRY_MS;
+
+    switch (s_dfu.state)
+    {
+        case APP_DFU_STATE_RECEIVE:
+            if (!s_dfu.startAcked)
+            {
+                s_dfu.startAcked = true;
+                s_dfu.stats.startMs = APP_DfuNowMs() - s_dfu.startTime;
+                APP_DfuRespond(APP_DFU_OP_START, APP_DFU_STATUS_OK, APP_DFU_CHUNK_MAX);
+            }
+            break;
+
+        case APP_DFU_STATE_DONE:
+            now = APP_DfuNowMs();
+            if (!s_dfu.doneAcked)
+            {
+                s_dfu.doneAcked = true;
+                s_dfu.rebootTime = now + APP_DFU_REBOOT_DELAY_MS;
+                APP_DfuRespond(APP_DFU_OP_FINISH, APP_DFU_STATUS_OK, s_dfu.stats.sequence + 1U);
+            }
+            else if (!s_dfu.rspPending && (int32_t)(now - s_dfu.rebootTime) >= 0)
+            {
+                /* The boot selection swaps the panels on the way up */
+                NVIC_SystemReset();
+            }
+            return s_dfu.rspPending ? APP_DFU_RSP_RETRY_MS : APP_DFU_REBOOT_DELAY_MS;
+
+        default:
+            break;
+    }
+
+    return s_dfu.rspPending ? APP_DFU_RSP_RETRY_MS : wait;
+}
+
+void APP_DfuAbort(void)
+{
+    if (s_dfu.state != APP_DFU_STATE_DONE)
+        APP_DfuReset(APP_DFU_STATE_IDLE);
+    s_dfu.rspPending = false;
+}
+
+void APP_DfuGetStats(APP_DFU_Stats_T *p_stats)
+{
+    *p_stats = s_dfu.stats;
+}
@@ -0,0 +1,264 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dfu.h
+
+  Summary:
+    Firmware update over the pipe, written to the inactive flash panel.
+
+  Description:
+    With APP_DFU_ENABLE (configuration.h, and the linker macros) the flash
+    is used as two panels of NVM_FLASH_SIZE / 2. The application runs from
+    the lower one and is linked to fit in it; an update is written to the
+    upper one while the link keeps running, then the panels are swapped.
+
+    The update travels on the pipe as messages starting with APP_DFU_MAGIC.
+    The pipe hands them to this module instead of the receive callback, and
+    holds the following SDUs in TRCBPS, with their credits, while both row
+    buffers are in use: data is received into one 1 KB row while the other
+    is programmed. Erases and row writes go through the flash queue
+    (app_flash.h), which programs between radio events and completes in the
+    NVM interrupt, so the pipe keeps receiving while a row is written.
+    The data is hashed with the hardware SHA-256 (ICM, app_icm.h) as it
+    arrives, and each programmed row is read back and compared. The digest
+    comes in the start message, authenticated with an HMAC under
+    APP_DFU_KEY (configuration.h); a start with a wrong MAC is refused
+    before anything is erased, so only an image whose SHA-256 the key
+    holder vouched for gets a bank record.
+
+    Activation is atomic: once the digest matches, the PDS areas and the
+    data log of the live panel are copied over and a bank record holding a
+    sequence number is written as the last row of the new panel.
+    APP_DfuBootSelect runs first thing in main and swaps the panels (NVMCON
+    PFSWAP) when the upper panel holds the newer valid record, so a reset or
+    power loss at any earlier point boots the old image. The image starts at
+    ROM_ORIGIN, after the PDS areas and the data log. The start message
+    carries the address the image is linked at, and an image linked for
+    another layout is refused. tools/dfu_send.py reads that address from
+    the .map, cuts the image from the .hex and sends it.
+*******************************************************************************/
+
+#ifndef _APP_DFU_H
+#define _APP_DFU_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+#include "peripheral/nvm/plib_nvm.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Delay between the finish response and the reset into the new image, so the
+ * response leaves the radio first. */
+#ifndef APP_DFU_REBOOT_DELAY_MS
+#define APP_DFU_REBOOT_DELAY_MS         200
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Pipe messages, all little endian:
+ *
+ *   magic      4   0x7E 'D' 'F' 'U'
+ *   op         1
+ *   then per op, host to device:
+ *   'S' start  size 4, base 4, sha256 32 image size, link address of its
+ *              mac 32                    vectors (__svectors) and digest;
+ *                                        HMAC-SHA256 under APP_DFU_KEY of
+ *                                        the message up to the mac
+ *   'D' data   offset 4, data 1..1024    in order, no response unless refused
+ *   'F' finish                           verify, activate, then reset
+ *   'A' abort
+ *
+ *   and device to host, op 'R':
+ *   request    1   op answered
+ *   status     1   APP_DFU_STATUS_*
+ *   value      4   'S': largest image size, or with APP_DFU_STATUS_BAD_BASE
+ *                  the link address of this build; 'D', 'F': bytes received;
+ *                  'F' success: sequence number of the new image
+ *
+ * The start response comes once the space for the image is erased.
+ */
+#define APP_DFU_MAGIC                   "\x7E" "DFU"
+#define APP_DFU_MAGIC_LEN               4
+#define APP_DFU_HDR_LEN                 (APP_DFU_MAGIC_LEN + 1)
+#define APP_DFU_MAC_LEN                 32
+#define APP_DFU_START_LEN               (APP_DFU_HDR_LEN + 8 + APP_DFU_DIGEST_LEN + APP_DFU_MAC_LEN)
+#define APP_DFU_DATA_HDR_LEN            (APP_DFU_HDR_LEN + 4)
+#define APP_DFU_CHUNK_MAX               NVM_FLASH_ROWSIZE
+#define APP_DFU_DIGEST_LEN              32
+#define APP_DFU_RSP_LEN                 (APP_DFU_HDR_LEN + 6)
+
+#define APP_DFU_OP_START                'S'
+#define APP_DFU_OP_DATA                 'D'
+#define APP_DFU_OP_FINISH               'F'
+#define APP_DFU_OP_ABORT                'A'
+#define APP_DFU_OP_RESPONSE             'R'
+
+#define APP_DFU_STATUS_OK               0x00
+#define APP_DFU_STATUS_BAD_STATE        0x01    /* No update running, or one is being finished */
+#define APP_DFU_STATUS_BAD_SIZE         0x02    /* Image larger than a panel, or finish before the last byte */
+#define APP_DFU_STATUS_BAD_OFFSET       0x03    /* Data not at the next offset; value is the expected one */
+#define APP_DFU_STATUS_FLASH            0x04    /* Erase or program error, or read back mismatch */
+#define APP_DFU_STATUS_DIGEST           0x05    /* SHA-256 of the image does not match */
+#define APP_DFU_STATUS_LAYOUT           0x06    /* Image not linked for the panel layout (WBZ451.ld) */
+#define APP_DFU_STATUS_BAD_BASE         0x07    /* Image linked at another address; value is this build's */
+#define APP_DFU_STATUS_AUTH             0x08    /* Start message not sent with APP_DFU_KEY */
+
+typedef struct APP_DFU_Stats_T
+{
+    uint32_t    imageSize;              /* Of the update running or last done */
+    uint32_t    received;               /* Image bytes taken from the pipe */
+    uint32_t    written;                /* Image bytes programmed and hashed */
+    uint32_t    rowsHeld;               /* Times the pipe waited for a free row buffer */
+    uint32_t    startMs;                /* Start request to start response */
+    uint32_t    transferMs;             /* Start response to last row programmed */
+    uint32_t    sequence;               /* Bank record of the running image, 0 if none */
+} APP_DFU_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_DfuBootSelect ( void )
+
+  Summary:
+     Swap the flash panels and restart in the upper one when it holds the
+     newer image. Call first in main, before SYS_Initialize.
+*/
+void APP_DfuBootSelect(void);
+
+/*******************************************************************************
+  Function:
+    void APP_DfuInit ( void )
+
+  Summary:
+     Read the bank record of the running image. Called by BLECB_Pipe_Init.
+*/
+void APP_DfuInit(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_DfuIsMessage ( const uint8_t *p_data, uint16_t length )
+
+  Summary:
+     Whether a pipe message, of which p_data holds the first length bytes,
+     belongs to the update.
+*/
+bool APP_DfuIsMessage(const uint8_t *p_data, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    bool APP_DfuRxReady ( uint16_t length )
+
+  Summary:
+     Whether an update message of length bytes can be taken now. While it
+     cannot, the pipe leaves the SDUs in TRCBPS. Pipe task only.
+*/
+bool APP_DfuRxReady(uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_DfuRxMessage ( const uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Process a complete update message. Pipe task only.
+*/
+void APP_DfuRxMessage(const uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_DfuTasks ( void )
+
+  Summary:
+     Submit the next flash operation of the update, send the responses and
+     reset into a new image. Pipe task only.
+
+  Returns:
+    Longest time the pipe task may sleep, OSAL_WAIT_FOREVER when nothing
+    is pending; the flash completion wakes it with BLECB_Pipe_WakeISR.
+*/
+uint16_t APP_DfuTasks(void);
+
+/*******************************************************************************
+  Function:
+    void APP_DfuAbort ( void )
+
+  Summary:
+     Drop the update running, on a disconnection. Pipe task only.
+*/
+void APP_DfuAbort(void);
+
+/*******************************************************************************
+  Function:
+    void APP_DfuGetStats ( APP_DFU_Stats_T *p_stats )
+
+  Summary:
+     Copy the counters of the update running or last done.
+*/
+void APP_DfuGetStats(APP_DFU_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_DFU_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,318 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_digest.c
+
+  Summary:
+    SHA-256 integrity trailer on pipe transfers, on the ICM.
+
+  Description:
+    wolfCrypt's SHA-256 on this part is the ICM port (crypt_sha256_sam11105.c).
+    Every update it is given starts the ICM again: descriptor, intermediate
+    hash, then the run. Data that is not 64 byte aligned goes through one run
+    per block, and pipe payloads never are. Bytes are therefore collected in
+    an aligned buffer of each context and handed over APP_DIGEST_CHUNK at a
+    time, in a single run, and only the tail of a message is left to the
+    port's own buffer at the end.
+
+    The calls go through app_icm.c, which serializes them with the firmware
+    update's.
+
+    Per stream, the bytes of a received message go to a copy of the stream
+    context, kept only once the message is delivered as application data;
+    a firmware update or data log message in between leaves the stream as
+    it was.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include "definitions.h"
+#include "app_digest.h"
+#include "app_icm.h"
+
+#if APP_DIGEST_ENABLE
+
+#if APP_DIGEST_CHUNK == 0 || (APP_DIGEST_CHUNK % 64) != 0
+#error "APP_DIGEST_CHUNK must be a multiple of 64"
+#endif
+#if APP_DIGEST_LEN < 4 || APP_DIGEST_LEN > 32
+#error "APP_DIGEST_LEN must be 4 to 32"
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_DIGEST_SHA256_LEN       32U
+
+typedef struct APP_DIGEST_Ctx_T
+{
+    uint8_t             stage[APP_DIGEST_CHUNK] __attribute__((aligned(64)));   /* Read by the ICM */
+    uint16_t            staged;
+    CRYPT_SHA256_CTX    sha;
+} APP_DIGEST_Ctx_T;
+
+static APP_DIGEST_Ctx_T s_tx;
+static APP_DIGEST_Ctx_T s_rx;               /* Per stream: the messages delivered so far */
+static APP_DIGEST_Ctx_T s_rxMsg;            /* The message being received */
+
+static bool s_rxStarted;                    /* APP_DigestRxStart announced the message being received */
+static uint16_t s_rxLength;
+static uint16_t s_rxHashed;
+
+static APP_DIGEST_Stats_T s_stats;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_DigestStart(APP_DIGEST_Ctx_T *p_ctx)
+{
+    APP_IcmSha256Init(&p_ctx->sha);
+    p_ctx->staged = 0;
+}
+
+static void APP_DigestAdd(APP_DIGEST_Ctx_T *p_ctx, const uint8_t *p_data, uint32_t length)
+{
+    uint32_t n;
+
+    while (length > 0U)
+    {
+        // Whole chunks that are already aligned go straight to the ICM
+        if (p_ctx->staged == 0U && ((uint32_t)p_data & 63U) == 0U && length >= APP_DIGEST_CHUNK)
+        {
+            n = length - length % APP_DIGEST_CHUNK;
+            APP_IcmSha256Add(&p_ctx->sha, p_data, n);
+            p_data += n;
+            length -= n;
+            continue;
+        }
+        n = APP_DIGEST_CHUNK - p_ctx->staged;
+        if (n > length)
+        {
+            n = length;
+        }
+        memcpy(&p_ctx->stage[p_ctx->staged], p_data, n);
+        p_ctx->staged += n;
+        p_data += n;
+        length -= n;
+        if (p_ctx->staged == APP_DIGEST_CHUNK)
+        {
+            APP_IcmSha256Add(&p_ctx->sha, p_ctx->stage, APP_DIGEST_CHUNK);
+            p_ctx->staged = 0;
+        }
+    }
+}
+
+/* Digest of everything added, then start again */
+static void APP_DigestFinal(APP_DIGEST_Ctx_T *p_ctx, uint8_t *p_digest)
+{
+    if (p_ctx->staged != 0U)
+    {
+        APP_IcmSha256Add(&p_ctx->sha, p_ctx->stage, p_ctx->staged);
+    }
+    APP_IcmSha256Final(&p_ctx->sha, p_digest);
+    APP_DigestStart(p_ctx);
+}
+
+static void APP_DigestRxBegin(void)
+{
+#if APP_DIGEST_PER_STREAM
+    s_rxMsg = s_rx;
+#else
+    APP_DigestStart(&s_rxMsg);
+#endif
+    s_rxHashed = 0;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_DigestInit(void)
+{
+    APP_IcmInit();
+    APP_DigestReset();
+}
+
+void APP_DigestTx(uint8_t *p_msg, uint16_t length)
+{
+#if !APP_DIGEST_PER_STREAM
+    uint8_t digest[APP_DIGEST_SHA256_LEN];
+#endif
+
+    APP_DigestAdd(&s_tx, p_msg, length);
+#if !APP_DIGEST_PER_STREAM
+    APP_DigestFinal(&s_tx, digest);
+    memcpy(&p_msg[length], digest, APP_DIGEST_LEN);
+#endif
+    s_stats.txMessages++;
+    s_stats.txBytes += length;
+}
+
+void APP_DigestTxEnd(uint8_t *p_marker)
+{
+    uint8_t digest[APP_DIGEST_SHA256_LEN];
+
+    APP_DigestFinal(&s_tx, digest);
+    memcpy(p_marker, APP_DIGEST_MAGIC, APP_DIGEST_MAGIC_LEN);
+    memcpy(&p_marker[APP_DIGEST_MAGIC_LEN], digest, APP_DIGEST_LEN);
+    s_stats.streamsSent++;
+}
+
+void APP_DigestRxStart(uint16_t length)
+{
+    APP_DigestRxBegin();
+    s_rxStarted = true;
+    s_rxLength = length;
+}
+
+void APP_DigestRxData(const uint8_t *p_data, uint16_t length)
+{
+    // The trailer is not part of what it covers
+    uint16_t covered = (s_rxLength > APP_DIGEST_TRAILER_LEN) ? s_rxLength - APP_DIGEST_TRAILER_LEN : 0U;
+
+    if (!s_rxStarted || s_rxHashed >= covered)
+    {
+        return;
+    }
+    if (length > covered - s_rxHashed)
+    {
+        length = covered - s_rxHashed;
+    }
+    APP_DigestAdd(&s_rxMsg, p_data, length);
+    s_rxHashed += length;
+}
+
+int32_t APP_DigestRxMessage(uint8_t *p_msg, uint16_t length)
+{
+    uint8_t digest[APP_DIGEST_SHA256_LEN];
+    uint16_t covered;
+    bool started = s_rxStarted && s_rxLength == length;
+
+    s_rxStarted = false;
+#if APP_DIGEST_PER_STREAM
+    if (length == APP_DIGEST_MARKER_LEN && memcmp(p_msg, APP_DIGEST_MAGIC, APP_DIGEST_MAGIC_LEN) == 0)
+    {
+        APP_DigestFinal(&s_rx, digest);
+        if (memcmp(&p_msg[APP_DIGEST_MAGIC_LEN], digest, APP_DIGEST_LEN) == 0)
+        {
+            s_stats.streamsOk++;
+        }
+        else
+        {
+            s_stats.streamsFailed++;
+        }
+        return -1;
+    }
+    covered = length;
+#else
+    if (length < APP_DIGEST_LEN)
+    {
+        s_stats.rxFailures++;
+        return -1;
+    }
+    covered = length - APP_DIGEST_LEN;
+#endif
+
+    // Not seen in the RX queue (sealed there), or only in part
+    if (!started || s_rxHashed != covered)
+    {
+        APP_DigestRxBegin();
+        APP_DigestAdd(&s_rxMsg, p_msg, covered);
+    }
+#if APP_DIGEST_PER_STREAM
+    s_rx = s_rxMsg;
+#else
+    APP_DigestFinal(&s_rxMsg, digest);
+    if (memcmp(&p_msg[covered], digest, APP_DIGEST_LEN) != 0)
+    {
+        s_stats.rxFailures++;
+        return -1;
+    }
+#endif
+    s_stats.rxMessages++;
+    s_stats.rxBytes += covered;
+    return covered;
+}
+
+void APP_DigestReset(void)
+{
+    vTaskSuspendAll();
+    APP_DigestStart(&s_tx);
+    (void)xTaskResumeAll();
+    APP_DigestStart(&s_rx);
+    APP_DigestStart(&s_rxMsg);
+    s_rxStarted = false;
+}
+
+void APP_DigestGetStats(APP_DIGEST_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+
+void APP_DigestReport(APP_DIGEST_WRITE write)
+{
+    APP_DIGEST_Stats_T stats;
+    char line[192];
+    int len;
+
+    APP_DigestGetStats(&stats);
+    len = snprintf(line, sizeof(line),
+                   "#DIGEST %s len=%u tx=%lu/%luB rx=%lu/%luB failed=%lu streams sent=%lu ok=%lu failed=%lu\n",
+                   APP_DIGEST_PER_STREAM ? "stream" : "message", (unsigned)APP_DIGEST_LEN,
+                   (unsigned long)stats.txMessages, (unsigned long)stats.txBytes,
+                   (unsigned long)stats.rxMessages, (unsigned long)stats.rxBytes, (unsigned long)stats.rxFailures,
+                   (unsigned long)stats.streamsSent, (unsigned long)stats.streamsOk, (unsigned long)stats.streamsFailed);
+    if (len > (int)sizeof(line) - 1)
+    {
+        len = sizeof(line) - 1;
+    }
+    write((uint8_t *)line, (uint16_t)len);
+}
+
+#endif /* APP_DIGEST_ENABLE */
+
+/*******************************************************************************
+ End of File
+ */
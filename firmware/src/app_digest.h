@@ -0,0 +1,232 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_digest.h
+
+  Summary:
+    SHA-256 integrity trailer on pipe transfers, on the ICM.
+
+  Description:
+    With APP_DIGEST_ENABLE (configuration.h) the pipe hashes application
+    messages on their way through, so the data never has to be read again
+    to be checked:
+
+    - per message (APP_DIGEST_PER_STREAM 0): each message is followed by
+      the first APP_DIGEST_LEN bytes of its SHA-256, counted in the pipe
+      length field. A received message whose trailer does not match is
+      dropped and counted; the application gets it without the trailer.
+    - per stream (APP_DIGEST_PER_STREAM 1): messages carry nothing extra.
+      Each direction hashes all its messages, in order, until a stream end
+      marker, APP_DIGEST_MAGIC followed by the digest, which
+      BLECB_Pipe_SendDigest queues. A received marker is checked against
+      the messages since the previous one and counted, and is not
+      delivered.
+
+    Received messages are hashed as their SDUs are copied out of the RX
+    queue. With APP_AEAD_ENABLE the digest covers the plaintext and sits
+    under the CCM tag, so received messages are hashed once opened instead.
+    The firmware update, data log and BLECB_Pipe_SendPlain messages are not
+    hashed. Both streams restart with the connection.
+*******************************************************************************/
+
+#ifndef _APP_DIGEST_H
+#define _APP_DIGEST_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Bytes collected before each ICM run, a multiple of the 64 byte SHA-256
+ * block; every run reloads the descriptor and the intermediate hash. */
+#ifndef APP_DIGEST_CHUNK
+#define APP_DIGEST_CHUNK                128
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Stream end marker: magic 4, digest APP_DIGEST_LEN */
+#define APP_DIGEST_MAGIC                "\x7E" "DGS"
+#define APP_DIGEST_MAGIC_LEN            4
+#define APP_DIGEST_MARKER_LEN           (APP_DIGEST_MAGIC_LEN + APP_DIGEST_LEN)
+
+/* Bytes each sent message grows by */
+#if APP_DIGEST_PER_STREAM
+#define APP_DIGEST_TRAILER_LEN          0
+#else
+#define APP_DIGEST_TRAILER_LEN          APP_DIGEST_LEN
+#endif
+
+typedef struct APP_DIGEST_Stats_T
+{
+    uint32_t    txMessages;             /* Hashed on the way out */
+    uint32_t    txBytes;
+    uint32_t    rxMessages;             /* Hashed and, per message, checked */
+    uint32_t    rxBytes;
+    uint32_t    rxFailures;             /* Per message: trailer missing or wrong, dropped */
+    uint32_t    streamsSent;            /* Per stream: markers queued */
+    uint32_t    streamsOk;              /* Per stream: markers received that matched */
+    uint32_t    streamsFailed;
+} APP_DIGEST_Stats_T;
+
+/* Output for the report, as APP_SPILL_WRITE. */
+typedef void (*APP_DIGEST_WRITE)(uint8_t *data, uint16_t length);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_DigestInit ( void )
+
+  Summary:
+     Power the ICM on and start both streams. Called by BLECB_Pipe_Init.
+*/
+void APP_DigestInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestTx ( uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Hash a message as it is queued, and write its APP_DIGEST_TRAILER_LEN
+     byte trailer at p_msg[length]. The pipe calls it with the scheduler
+     suspended, so the stream order is the queue order.
+*/
+void APP_DigestTx(uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestTxEnd ( uint8_t *p_marker )
+
+  Summary:
+     Write the APP_DIGEST_MARKER_LEN byte stream end marker and start the
+     next stream. Per stream only; called like APP_DigestTx.
+*/
+void APP_DigestTxEnd(uint8_t *p_marker);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestRxStart ( uint16_t length )
+
+  Summary:
+     A message of length bytes starts in the RX queue; APP_DigestRxData
+     follows with its bytes as they are copied out. Pipe task only.
+*/
+void APP_DigestRxStart(uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestRxData ( const uint8_t *p_data, uint16_t length )
+
+  Summary:
+     Hash the next bytes of the message announced by APP_DigestRxStart.
+*/
+void APP_DigestRxData(const uint8_t *p_data, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    int32_t APP_DigestRxMessage ( uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Check a complete received message. What APP_DigestRxData did not hash
+     is hashed here. Pipe task only.
+
+  Returns:
+    Length of the message without its trailer, or -1 when it is not
+    delivered: a wrong trailer, or a stream end marker.
+*/
+int32_t APP_DigestRxMessage(uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestReset ( void )
+
+  Summary:
+     Start both streams again, on a disconnection.
+*/
+void APP_DigestReset(void);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestGetStats ( APP_DIGEST_Stats_T *p_stats )
+
+  Summary:
+     Copy the counters.
+*/
+void APP_DigestGetStats(APP_DIGEST_Stats_T *p_stats);
+
+/*******************************************************************************
+  Function:
+    void APP_DigestReport ( APP_DIGEST_WRITE write )
+
+  Summary:
+     Write the counters as one line of text.
+*/
+void APP_DigestReport(APP_DIGEST_WRITE write);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_DIGEST_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,195 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dlog.c
+
+  Summary:
+    Deferred binary logging: ring, drain task and text mode.
+
+  Description:
+    The recorder is inline in app_dlog.h. The drain task copies committed
+    records out of the ring, clears their words and only then releases them
+    to the writers by advancing the tail, so a writer never sees a stale
+    header in a slot it reserves.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "definitions.h"
+#include "app_dlog.h"
+#include "app_frame.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global Data
+// *****************************************************************************
+// *****************************************************************************
+
+APP_DLOG_Ring_T g_appDlogRing;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static APP_DLOG_WRITE s_write;
+
+#if APP_DLOG_ENABLE
+static uint8_t s_frame[APP_DLOG_FRAME_MAX_SIZE];
+static TaskHandle_t xDLOG_Task;
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+#if APP_DLOG_ENABLE
+/* Move committed records into s_frame. Returns the frame size, 0 if there
+ * was nothing to send. */
+static uint16_t APP_DlogFillFrame(void)
+{
+    uint32_t tail = g_appDlogRing.tail;
+    uint32_t taken = 0;
+    uint32_t hdr;
+    uint32_t words;
+    uint32_t i;
+    uint8_t *p_dst = &s_frame[APP_FRAME_HDR_LEN + 8];
+
+    while (taken < APP_DLOG_CHUNK_WORDS && tail != g_appDlogRing.head)
+    {
+        hdr = g_appDlogRing.word[tail & (APP_DLOG_RING_WORDS - 1U)];
+        if (hdr == 0U)
+        {
+            break;      // Reserved, writer not done yet
+        }
+        __DMB();
+        words = 2U + ((hdr >> APP_DLOG_HDR_NARGS_Pos) & 0x7U);
+        for (i = 0; i < words; i++)
+        {
+            p_dst = APP_FramePutLe32(p_dst, g_appDlogRing.word[(tail + i) & (APP_DLOG_RING_WORDS - 1U)]);
+            g_appDlogRing.word[(tail + i) & (APP_DLOG_RING_WORDS - 1U)] = 0U;
+        }
+        tail += words;
+        taken += words;
+    }
+    if (taken == 0U)
+    {
+        return 0;
+    }
+    __DMB();
+    g_appDlogRing.tail = tail;
+
+    (void)APP_FramePutLe32(&s_frame[APP_FRAME_HDR_LEN], configCPU_CLOCK_HZ);
+    (void)APP_FramePutLe32(&s_frame[APP_FRAME_HDR_LEN + 4], g_appDlogRing.dropped);
+    return APP_FrameSeal(s_frame, "DLG", APP_DLOG_FRAME_VERSION, 0, p_dst);
+}
+
+/**
+ * DEFERRED LOG DRAIN TASK
+ * @param pvParameters
+ */
+static void _DLOG_Task(void *pvParameters)
+{
+    uint16_t size;
+
+    (void)pvParameters;
+    while (1)
+    {
+        size = APP_DlogFillFrame();
+        if (size == 0U)
+        {
+            vTaskDelay(pdMS_TO_TICKS(APP_DLOG_DRAIN_PERIOD_MS));
+        }
+        else
+        {
+            s_write(s_frame, size);
+        }
+    }
+}
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_DlogPrintf(const char *fmt, ...)
+{
+    char text[APP_DLOG_TEXT_MAX];
+    va_list args;
+    int n;
+
+    if (s_write == NULL)
+    {
+        return;
+    }
+    va_start(args, fmt);
+    n = vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    if (n > 0)
+    {
+        s_write((uint8_t *)text, (n < (int)sizeof(text)) ? (uint16_t)n : (uint16_t)(sizeof(text) - 1U));
+    }
+}
+
+void APP_DlogInit(APP_DLOG_WRITE write)
+{
+    s_write = write;
+#if APP_DLOG_ENABLE
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _DLOG_Task,
+            "DLOG_Task",
+            256,
+            NULL,
+            1,
+            &xDLOG_Task);
+#endif
+}
+
+uint32_t APP_DlogDropped(void)
+{
+    return g_appDlogRing.dropped;
+}
+
+
+/*******************************************************************************
+ End of File
+ */
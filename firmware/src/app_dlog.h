@@ -0,0 +1,250 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dlog.h
+
+  Summary:
+    Deferred binary logging.
+
+  Description:
+    APP_DLOG("fmt", args...) does not format anything on the device. The
+    format string is placed in the .app_dlog_fmt section, which the linker
+    script keeps in the ELF but does not load into flash; its offset in that
+    section is the record id. A call stores the id, the DWT cycle counter and
+    up to APP_DLOG_ARGS_MAX 32 bit arguments in a word ring: an LDREX/STREX
+    reservation, a few stores and no lock, roughly 20 cycles for two
+    arguments. Tasks and interrupts of any priority may log.
+
+    A low priority task drains committed records in CRC protected frames to
+    the sink given to APP_DlogInit (the debug UART). tools/dlog_decoder.py
+    looks the format strings up in the ELF and prints the text.
+
+    Only integer arguments are stored (char, int, long, pointers cast to
+    uint32_t); %s and 64 bit values cannot be deferred. When the ring is full
+    new records are dropped and counted, old ones are never overwritten.
+
+    With APP_DLOG_ENABLE 0 the same calls are formatted right away and written
+    to the sink as text, as the debug output was before.
+*******************************************************************************/
+
+#ifndef _APP_DLOG_H
+#define _APP_DLOG_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device.h"
+#include "app_ring.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* 1: binary records decoded on the host. 0: text formatted at the call. */
+#ifndef APP_DLOG_ENABLE
+#define APP_DLOG_ENABLE                 1
+#endif
+
+/* Ring size in 32 bit words, a power of two. 1024 words take 4 KB of RAM. */
+#ifndef APP_DLOG_RING_WORDS
+#define APP_DLOG_RING_WORDS             1024
+#endif
+
+/* Most arguments one record carries. */
+#define APP_DLOG_ARGS_MAX               4
+
+/* Record words per drained frame. */
+#ifndef APP_DLOG_CHUNK_WORDS
+#define APP_DLOG_CHUNK_WORDS            64
+#endif
+
+/* Drain task poll period while the ring is empty. */
+#ifndef APP_DLOG_DRAIN_PERIOD_MS
+#define APP_DLOG_DRAIN_PERIOD_MS        20
+#endif
+
+/* Longest line of the text mode. */
+#define APP_DLOG_TEXT_MAX               96
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Record layout in the ring, one 32 bit word each:
+ *
+ *   header     bit 31 set, bits 24-26 argument count, bits 0-23 format id
+ *   ts         DWT cycle counter
+ *   args       argument count words
+ *
+ * The header is stored last; a zero header marks a record that is reserved
+ * but not filled yet, and the drain stops there.
+ */
+#define APP_DLOG_HDR_VALID              0x80000000UL
+#define APP_DLOG_HDR_NARGS_Pos          24
+#define APP_DLOG_HDR_ID_Msk             0x00FFFFFFUL
+
+/* Drained frame, all fields little endian:
+ *
+ *   sync       4   0x7E 'D' 'L' 'G'
+ *   version    1   APP_DLOG_FRAME_VERSION
+ *   flags      1   reserved, 0
+ *   length     2   bytes from version up to the CRC, exclusive
+ *   cpuHz      4   core clock
+ *   dropped    4   records dropped on a full ring since boot
+ *   records        record words as stored in the ring
+ *   crc        2   CRC-16/CCITT-FALSE from version up to here
+ */
+#define APP_DLOG_FRAME_VERSION          1
+#define APP_DLOG_FRAME_MAX_SIZE         (16 + (APP_DLOG_CHUNK_WORDS + 2 + APP_DLOG_ARGS_MAX) * 4 + 2)
+
+typedef struct APP_DLOG_Ring_T
+{
+    volatile uint32_t   head;           /* Words reserved by writers */
+    volatile uint32_t   tail;           /* Words released by the drain */
+    volatile uint32_t   dropped;
+    volatile uint32_t   word[APP_DLOG_RING_WORDS];
+} APP_DLOG_Ring_T;
+
+typedef void (*APP_DLOG_WRITE)(uint8_t *data, uint16_t length);
+
+extern APP_DLOG_Ring_T g_appDlogRing;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_DlogRecord ( uint32_t id, const uint32_t *p_args, uint32_t nargs )
+
+  Summary:
+     Store one record. Callable from any context. Use the APP_DLOG macro,
+     which supplies the id; with a constant nargs the copy loop unrolls.
+*/
+static inline void APP_DlogRecord(uint32_t id, const uint32_t *p_args, uint32_t nargs)
+{
+    uint32_t ts = DWT->CYCCNT;
+    uint32_t words;
+    uint32_t idx;
+    uint32_t i;
+
+    if (nargs > APP_DLOG_ARGS_MAX)
+    {
+        nargs = APP_DLOG_ARGS_MAX;
+    }
+    words = 2U + nargs;
+    if (!APP_RingReserve(&g_appDlogRing.head, &g_appDlogRing.tail, APP_DLOG_RING_WORDS, words,
+                         &g_appDlogRing.dropped, &idx))
+    {
+        return;
+    }
+
+    g_appDlogRing.word[(idx + 1U) & (APP_DLOG_RING_WORDS - 1U)] = ts;
+    for (i = 0; i < nargs; i++)
+    {
+        g_appDlogRing.word[(idx + 2U + i) & (APP_DLOG_RING_WORDS - 1U)] = p_args[i];
+    }
+    __DMB();
+    g_appDlogRing.word[idx & (APP_DLOG_RING_WORDS - 1U)] =
+        APP_DLOG_HDR_VALID | (nargs << APP_DLOG_HDR_NARGS_Pos) | (id & APP_DLOG_HDR_ID_Msk);
+}
+
+/*******************************************************************************
+  Function:
+    void APP_DlogPrintf ( const char *fmt, ... )
+
+  Summary:
+     Text mode of APP_DLOG: format now and write to the sink.
+*/
+void APP_DlogPrintf(const char *fmt, ...);
+
+#if APP_DLOG_ENABLE
+#define APP_DLOG(fmt, ...)                                                                  \
+    do                                                                                      \
+    {                                                                                       \
+        static const char s_appDlogFmt[] __attribute__((section(".app_dlog_fmt"), used)) = fmt; \
+        const uint32_t appDlogArgs[] = { 0U, ##__VA_ARGS__ };                               \
+        APP_DlogRecord((uint32_t)(uintptr_t)s_appDlogFmt, &appDlogArgs[1],                   \
+                       (sizeof(appDlogArgs) / sizeof(appDlogArgs[0])) - 1U);                \
+    } while (0)
+#else
+#define APP_DLOG(fmt, ...)              APP_DlogPrintf(fmt, ##__VA_ARGS__)
+#endif
+
+/*******************************************************************************
+  Function:
+    void APP_DlogInit ( APP_DLOG_WRITE write )
+
+  Summary:
+     Set the sink and, in binary mode, create the drain task. Call before the
+     scheduler; records logged earlier are kept.
+*/
+void APP_DlogInit(APP_DLOG_WRITE write);
+
+/*******************************************************************************
+  Function:
+    uint32_t APP_DlogDropped ( void )
+
+  Summary:
+     Records dropped because the ring was full, since boot.
+*/
+uint32_t APP_DlogDropped(void);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_DLOG_H */
+
+/*******************************************************************************
+ End of File
+ */
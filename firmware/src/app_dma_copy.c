@@ -0,0 +1,375 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dma_copy.c
+
+  Summary:
+    Memory to memory copies on a DMAC channel.
+
+  Description:
+    One copy is in flight at a time; s_busy is claimed with SERCOM and DMAC
+    interrupts masked and released by the completion interrupt. A task
+    waiting in APP_DmaCopy is woken through s_doneSem. Each wait has its own
+    sequence number so that a completion arriving after a timeout cannot
+    wake the next waiter early.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include "definitions.h"
+#include "app_dma_copy.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_DMA_COPY_CHANNEL        DMAC_CHANNEL_2
+
+#define APP_DMA_COPY_BENCH_MAX      2048U
+#define APP_DMA_COPY_BENCH_RUNS     8U
+
+static volatile bool s_busy;
+static APP_DMA_COPY_CALLBACK s_callback;
+static uintptr_t s_context;
+
+static OSAL_SEM_DECLARE(s_doneSem);
+static volatile uint32_t s_waitSeq;         /* Sequence of the copy APP_DmaCopy waits for, 0 if none */
+static uint32_t s_nextSeq;
+static volatile bool s_waitOk;
+
+static APP_DMA_COPY_Stats_T s_stats;
+
+static const uint16_t s_benchSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048 };
+static volatile bool s_benchDone;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_DmaCopyDmacDone(DMAC_TRANSFER_EVENT event, uintptr_t contextHandle)
+{
+    APP_DMA_COPY_CALLBACK callback = s_callback;
+    bool ok = (event == DMAC_TRANSFER_EVENT_COMPLETE);
+
+    (void)contextHandle;
+
+    if (!ok)
+    {
+        s_stats.errors++;
+    }
+    s_busy = false;
+    if (callback != NULL)
+    {
+        callback(ok, s_context);
+    }
+}
+
+static void APP_DmaCopyWake(bool ok, uintptr_t context)
+{
+    if ((uint32_t)context == s_waitSeq)
+    {
+        s_waitOk = ok;
+        (void)OSAL_SEM_PostISR(&s_doneSem);
+    }
+}
+
+static void APP_DmaCopyBenchDone(bool ok, uintptr_t context)
+{
+    (void)ok;
+    (void)context;
+    s_benchDone = true;
+}
+
+/* Cycles of the fastest of APP_DMA_COPY_BENCH_RUNS memcpy calls */
+static uint32_t APP_DmaCopyBenchCpu(uint8_t *p_dst, const uint8_t *p_src, uint16_t len)
+{
+    uint32_t best = UINT32_MAX;
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t run;
+
+    for (run = 0; run < APP_DMA_COPY_BENCH_RUNS; run++)
+    {
+        vTaskSuspendAll();
+        start = DWT->CYCCNT;
+        memcpy(p_dst, p_src, len);
+        cycles = DWT->CYCCNT - start;
+        (void)xTaskResumeAll();
+        if (cycles < best)
+        {
+            best = cycles;
+        }
+    }
+    return best;
+}
+
+/* Cycles of the fastest DMA copy until its callback ran, and the CPU cycles
+ * spent in APP_DmaCopyStart for it. Returns false if a copy was wrong. */
+static bool APP_DmaCopyBenchDma(uint8_t *p_dst, const uint8_t *p_src, uint16_t len,
+                                uint32_t *p_total, uint32_t *p_setup)
+{
+    uint32_t start;
+    uint32_t setup;
+    uint32_t total;
+    uint32_t run;
+    bool ok = true;
+
+    *p_total = UINT32_MAX;
+    *p_setup = UINT32_MAX;
+    for (run = 0; run < APP_DMA_COPY_BENCH_RUNS; run++)
+    {
+        memset(p_dst, 0, len);
+        s_benchDone = false;
+        vTaskSuspendAll();
+        start = DWT->CYCCNT;
+        if (!APP_DmaCopyStart(p_dst, p_src, len, APP_DmaCopyBenchDone, 0))
+        {
+            (void)xTaskResumeAll();
+            return false;
+        }
+        setup = DWT->CYCCNT - start;
+        while (!s_benchDone)
+        {
+        }
+        total = DWT->CYCCNT - start;
+        (void)xTaskResumeAll();
+
+        if (memcmp(p_dst, p_src, len) != 0)
+        {
+            ok = false;
+        }
+        if (total < *p_total)
+        {
+            *p_total = total;
+        }
+        if (setup < *p_setup)
+        {
+            *p_setup = setup;
+        }
+    }
+    return ok;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_DmaCopyInit(void)
+{
+    s_busy = false;
+    s_callback = NULL;
+    s_waitSeq = 0;
+    s_nextSeq = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    APP_STATIC_SEM_CREATE_BINARY(&s_doneSem);
+    DMAC_ChannelCallbackRegister(APP_DMA_COPY_CHANNEL, APP_DmaCopyDmacDone, 0);
+}
+
+bool APP_DmaCopyStart(void *p_dst, const void *p_src, uint16_t len,
+                      APP_DMA_COPY_CALLBACK callback, uintptr_t context)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint8_t *p_d = (uint8_t *)p_dst;
+    const uint8_t *p_s = (const uint8_t *)p_src;
+    uint32_t beat;
+    uint32_t head;
+    uint32_t body;
+    DMAC_CHANNEL_CONFIG setting;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    if (s_busy)
+    {
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+        return false;
+    }
+    s_busy = true;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    // Widest beat the relative alignment allows; the CPU aligns the source
+    switch (((uint32_t)p_d ^ (uint32_t)p_s) & 3U)
+    {
+        case 0:
+            beat = 4;
+            break;
+        case 2:
+            beat = 2;
+            break;
+        default:
+            beat = 1;
+            break;
+    }
+    head = (beat - ((uint32_t)p_s & (beat - 1U))) & (beat - 1U);
+    if (head > len)
+    {
+        head = len;
+    }
+    body = (len - head) & ~(beat - 1U);
+    memcpy(p_d, p_s, head);
+    memcpy(&p_d[head + body], &p_s[head + body], len - head - body);
+
+    if (body == 0U)
+    {
+        s_busy = false;
+        if (callback != NULL)
+        {
+            callback(true, context);
+        }
+        return true;
+    }
+
+    s_callback = callback;
+    s_context = context;
+    s_stats.dmaCopies++;
+    s_stats.dmaBytes += body;
+
+    setting = DMAC_ChannelSettingsGet(APP_DMA_COPY_CHANNEL) & ~(DMAC_CHANNEL_CONFIG)DMAC_BTCTRL_BEATSIZE_Msk;
+    (void)DMAC_ChannelSettingsSet(APP_DMA_COPY_CHANNEL, setting | DMAC_BTCTRL_BEATSIZE(beat / 2U));
+    (void)DMAC_ChannelTransfer(APP_DMA_COPY_CHANNEL, &p_s[head], &p_d[head], body);
+    return true;
+}
+
+void APP_DmaCopy(void *p_dst, const void *p_src, uint16_t len)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint32_t seq;
+
+    if (APP_DMA_COPY_THRESHOLD == 0 || len < APP_DMA_COPY_THRESHOLD || len < 4U)
+    {
+        memcpy(p_dst, p_src, len);
+        s_stats.cpuCopies++;
+        return;
+    }
+
+    seq = ++s_nextSeq;
+    if (seq == 0U)
+    {
+        seq = ++s_nextSeq;
+    }
+    s_waitSeq = seq;
+    if (!APP_DmaCopyStart(p_dst, p_src, len, APP_DmaCopyWake, (uintptr_t)seq))
+    {
+        s_waitSeq = 0;
+        memcpy(p_dst, p_src, len);
+        s_stats.channelBusy++;
+        return;
+    }
+
+    if (OSAL_SEM_Pend(&s_doneSem, APP_DMA_COPY_TIMEOUT_MS) != OSAL_RESULT_TRUE || !s_waitOk)
+    {
+        // Stop listening first, then drop a completion that came in meanwhile
+        critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+        s_waitSeq = 0;
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+        (void)OSAL_SEM_Pend(&s_doneSem, 0);
+
+        DMAC_ChannelDisable(APP_DMA_COPY_CHANNEL);
+        s_busy = false;
+        s_stats.errors++;
+        memcpy(p_dst, p_src, len);
+    }
+}
+
+void APP_DmaCopyGetStats(APP_DMA_COPY_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+
+void APP_DmaCopyBenchmark(APP_DMA_COPY_WRITE write)
+{
+    uint8_t *p_src = OSAL_Malloc(APP_DMA_COPY_BENCH_MAX + 4U);
+    uint8_t *p_dst = OSAL_Malloc(APP_DMA_COPY_BENCH_MAX + 4U);
+    char line[96];
+    int n;
+    uint32_t i;
+    uint32_t cpu;
+    uint32_t cpuOdd;
+    uint32_t dma;
+    uint32_t dmaOdd;
+    uint32_t setup;
+    uint32_t setupOdd;
+    bool ok;
+
+    if (p_src == NULL || p_dst == NULL)
+    {
+        write((uint8_t *)"\nDMA copy benchmark: out of memory\n", 35);
+        OSAL_Free(p_src);
+        OSAL_Free(p_dst);
+        return;
+    }
+    for (i = 0; i < APP_DMA_COPY_BENCH_MAX + 4U; i++)
+    {
+        p_src[i] = (uint8_t)(i * 7U + 1U);
+    }
+
+    n = sprintf(line, "\nDMA copy benchmark, best of %u, cycles at %lu MHz (+2: source offset by 2)\n",
+                (unsigned)APP_DMA_COPY_BENCH_RUNS, (unsigned long)(configCPU_CLOCK_HZ / 1000000UL));
+    write((uint8_t *)line, (uint16_t)n);
+    n = sprintf(line, "%6s %8s %8s %8s %8s %8s %8s\n", "size", "memcpy", "memcpy+2", "dma", "dma+2", "setup", "setup+2");
+    write((uint8_t *)line, (uint16_t)n);
+
+    for (i = 0; i < sizeof(s_benchSizes) / sizeof(s_benchSizes[0]); i++)
+    {
+        cpu = APP_DmaCopyBenchCpu(p_dst, p_src, s_benchSizes[i]);
+        cpuOdd = APP_DmaCopyBenchCpu(p_dst, &p_src[2], s_benchSizes[i]);
+        ok = APP_DmaCopyBenchDma(p_dst, p_src, s_benchSizes[i], &dma, &setup);
+        ok = APP_DmaCopyBenchDma(p_dst, &p_src[2], s_benchSizes[i], &dmaOdd, &setupOdd) && ok;
+
+        n = sprintf(line, "%6u %8lu %8lu %8lu %8lu %8lu %8lu%s\n", (unsigned)s_benchSizes[i],
+                    (unsigned long)cpu, (unsigned long)cpuOdd, (unsigned long)dma, (unsigned long)dmaOdd,
+                    (unsigned long)setup, (unsigned long)setupOdd, ok ? "" : " ERROR");
+        write((uint8_t *)line, (uint16_t)n);
+    }
+
+    n = sprintf(line, "threshold %u bytes\n", (unsigned)APP_DMA_COPY_THRESHOLD);
+    write((uint8_t *)line, (uint16_t)n);
+
+    OSAL_Free(p_src);
+    OSAL_Free(p_dst);
+}
+
+
+/*******************************************************************************
+ End of File
+ */
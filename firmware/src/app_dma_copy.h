@@ -0,0 +1,181 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_dma_copy.h
+
+  Summary:
+    Memory to memory copies on a DMAC channel.
+
+  Description:
+    Copies run on DMAC channel 2. The DMA moves the largest beats that the
+    relative alignment of source and destination allows, and the CPU copies
+    the few bytes at either end. Copies shorter than APP_DMA_COPY_THRESHOLD
+    cost less with memcpy than the channel setup and completion interrupt,
+    so APP_DmaCopy does those on the CPU. The benchmark prints both costs for
+    a range of block sizes, which is what the threshold should be tuned from.
+*******************************************************************************/
+
+#ifndef _APP_DMA_COPY_H
+#define _APP_DMA_COPY_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Smallest copy APP_DmaCopy hands to the DMA. 0 keeps every copy on the CPU. */
+#ifndef APP_DMA_COPY_THRESHOLD
+#define APP_DMA_COPY_THRESHOLD              128
+#endif
+
+/* Longest wait for a DMA copy before APP_DmaCopy gives up on the channel. */
+#ifndef APP_DMA_COPY_TIMEOUT_MS
+#define APP_DMA_COPY_TIMEOUT_MS             10
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Completion callback; runs in the DMAC interrupt unless the copy was done
+ * by the CPU right away. ok is false after a DMA transfer error. */
+typedef void (*APP_DMA_COPY_CALLBACK)(bool ok, uintptr_t context);
+
+typedef void (*APP_DMA_COPY_WRITE)(uint8_t *data, uint16_t length);
+
+typedef struct APP_DMA_COPY_Stats_T
+{
+    uint32_t    dmaCopies;              /* Copies done by the DMA */
+    uint32_t    dmaBytes;               /* Bytes moved by the DMA */
+    uint32_t    cpuCopies;              /* APP_DmaCopy calls done with memcpy */
+    uint32_t    channelBusy;            /* Copies done with memcpy because the channel was busy */
+    uint32_t    errors;                 /* DMA transfer errors and timeouts, redone with memcpy */
+} APP_DMA_COPY_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_DmaCopyInit ( void )
+
+  Summary:
+     Take the memory to memory DMAC channel. Call after DMAC_Initialize.
+*/
+void APP_DmaCopyInit(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_DmaCopyStart ( void *p_dst, const void *p_src, uint16_t len,
+                            APP_DMA_COPY_CALLBACK callback, uintptr_t context )
+
+  Summary:
+     Start an asynchronous copy of non overlapping buffers.
+
+  Description:
+     Neither buffer may be touched until the callback has run. A copy too
+     short for the DMA is done before returning and its callback runs in the
+     caller's context.
+
+  Returns:
+    false if another copy is still running; nothing was copied then.
+*/
+bool APP_DmaCopyStart(void *p_dst, const void *p_src, uint16_t len,
+                      APP_DMA_COPY_CALLBACK callback, uintptr_t context);
+
+/*******************************************************************************
+  Function:
+    void APP_DmaCopy ( void *p_dst, const void *p_src, uint16_t len )
+
+  Summary:
+     Copy and return when done. From tasks only.
+
+  Description:
+     Copies of APP_DMA_COPY_THRESHOLD bytes or more go to the DMA and the
+     calling task blocks until the completion interrupt, so other tasks run
+     meanwhile. Shorter copies, and copies while the channel is in use, are
+     done with memcpy.
+*/
+void APP_DmaCopy(void *p_dst, const void *p_src, uint16_t len);
+
+/*******************************************************************************
+  Function:
+    void APP_DmaCopyGetStats ( APP_DMA_COPY_Stats_T *p_stats )
+
+  Summary:
+     Get the copy counters.
+*/
+void APP_DmaCopyGetStats(APP_DMA_COPY_Stats_T *p_stats);
+
+/*******************************************************************************
+  Function:
+    void APP_DmaCopyBenchmark ( APP_DMA_COPY_WRITE write )
+
+  Summary:
+     Time memcpy against DMA copies for a range of block sizes and print the
+     results as text. From tasks only; takes a few milliseconds.
+*/
+void APP_DmaCopyBenchmark(APP_DMA_COPY_WRITE write);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_DMA_COPY_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,247 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_flash.c
+
+  Summary:
+    Queue of flash erases and writes completed by the NVM interrupt.
+
+  Description:
+    The queue is a ring; the operation at its head is the one in flight.
+    Submitters append with interrupts masked, since completion callbacks
+    submit from the NVM interrupt. s_flash.busy is set by the idle task when
+    it starts the head and cleared by the NVM interrupt, which also removes
+    the head and ends the RF suspend before running the callback, so the
+    radio is given back as early as possible.
+
+    Nothing else registers an NVM callback. The interrupt also fires for
+    the writes PDS polls for; those come while busy is clear and are ignored.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_flash.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_FLASH_QUAD_SIZE             16U
+#define APP_FLASH_ERASE_DEFER_TICKS     pdMS_TO_TICKS(APP_FLASH_ERASE_DEFER_MS)
+
+typedef struct APP_FLASH_Ctrl_T
+{
+    APP_FLASH_Op_T      queue[APP_FLASH_QUEUE_LEN];
+    volatile uint8_t    head;
+    volatile uint8_t    count;
+    volatile bool       busy;               /* Head started, RF suspended until the NVM interrupt */
+    bool                eraseWaiting;
+    TickType_t          eraseWaitTick;
+    APP_FLASH_Stats_T   stats;
+} APP_FLASH_Ctrl_T;
+
+static APP_FLASH_Ctrl_T s_flash;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t APP_FlashOpSize(APP_FLASH_OpType_T type)
+{
+    switch (type)
+    {
+        case APP_FLASH_OP_ERASE_PAGE:
+            return NVM_FLASH_PAGESIZE;
+        case APP_FLASH_OP_WRITE_ROW:
+            return NVM_FLASH_ROWSIZE;
+        case APP_FLASH_OP_WRITE_QUAD:
+            return APP_FLASH_QUAD_SIZE;
+        default:
+            return 0;
+    }
+}
+
+static void APP_FlashNvmDone(uintptr_t context)
+{
+    APP_FLASH_Op_T op;
+    uint32_t primask;
+    bool ok;
+
+    (void)context;
+
+    if (!s_flash.busy || NVM_IsBusy())
+        return;
+
+    op = s_flash.queue[s_flash.head];
+    ok = (NVM_ErrorGet() == NVM_ERROR_NONE);
+    if (ok && op.type != APP_FLASH_OP_ERASE_PAGE)
+        ok = (memcmp((const void *)op.addr, op.p_data, APP_FlashOpSize(op.type)) == 0);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    s_flash.head = (uint8_t)((s_flash.head + 1U) % APP_FLASH_QUEUE_LEN);
+    s_flash.count--;
+    s_flash.busy = false;
+    __set_PRIMASK(primask);
+
+    (void)BT_SYS_RfSuspendReq(0);
+
+    if (ok)
+        s_flash.stats.done++;
+    else
+        s_flash.stats.failed++;
+    if (op.callback != NULL)
+        op.callback(ok, op.context);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_FlashInit(void)
+{
+    memset(&s_flash, 0, sizeof(s_flash));
+    NVM_CallbackRegister(APP_FlashNvmDone, 0);
+}
+
+bool APP_FlashSubmit(const APP_FLASH_Op_T *p_op)
+{
+    uint32_t size = APP_FlashOpSize(p_op->type);
+    uint32_t primask;
+    uint8_t tail;
+
+    if (size == 0 || (p_op->addr & (size - 1U)) != 0U
+        || p_op->addr < NVM_FLASH_START_ADDRESS || p_op->addr - NVM_FLASH_START_ADDRESS >= NVM_FLASH_SIZE
+        || (p_op->type != APP_FLASH_OP_ERASE_PAGE && p_op->p_data == NULL))
+    {
+        return false;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_flash.count == APP_FLASH_QUEUE_LEN)
+    {
+        s_flash.stats.queueFull++;
+        __set_PRIMASK(primask);
+        return false;
+    }
+    tail = (uint8_t)((s_flash.head + s_flash.count) % APP_FLASH_QUEUE_LEN);
+    s_flash.queue[tail] = *p_op;
+    s_flash.count++;
+    s_flash.stats.submitted++;
+    if (s_flash.count > s_flash.stats.depthMax)
+        s_flash.stats.depthMax = s_flash.count;
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+bool APP_FlashIsWorkPending(void)
+{
+    return !s_flash.busy && s_flash.count != 0;
+}
+
+bool APP_FlashIsBusy(void)
+{
+    return s_flash.busy;
+}
+
+bool APP_FlashTaskHandler(uint8_t rfSuspendStatus)
+{
+    const APP_FLASH_Op_T *p_op;
+    TickType_t now;
+
+    if (s_flash.busy || s_flash.count == 0 || NVM_IsBusy())
+        return false;
+
+    /* Only this task and the interrupt, which needs busy set, move the head */
+    p_op = &s_flash.queue[s_flash.head];
+
+    if (p_op->type == APP_FLASH_OP_ERASE_PAGE)
+    {
+        /* A page erase is the longest blackout; prefer a window where the BLE sleeps, but do not starve. */
+        now = xTaskGetTickCount();
+        if (!s_flash.eraseWaiting)
+        {
+            s_flash.eraseWaiting = true;
+            s_flash.eraseWaitTick = now;
+        }
+        if (rfSuspendStatus != BT_SYS_RF_SUSPENDED_WITH_SLEEP
+            && (now - s_flash.eraseWaitTick) < APP_FLASH_ERASE_DEFER_TICKS)
+        {
+            s_flash.stats.eraseDeferred++;
+            return false;
+        }
+        s_flash.eraseWaiting = false;
+    }
+
+    s_flash.busy = true;
+    switch (p_op->type)
+    {
+        case APP_FLASH_OP_ERASE_PAGE:
+            s_flash.stats.erases++;
+            (void)NVM_PageErase(p_op->addr);
+            break;
+
+        case APP_FLASH_OP_WRITE_ROW:
+            s_flash.stats.rows++;
+            (void)NVM_RowWrite((uint32_t *)p_op->p_data, p_op->addr);
+            break;
+
+        default:
+            s_flash.stats.quads++;
+            (void)NVM_QuadWordWrite((uint32_t *)p_op->p_data, p_op->addr);
+            break;
+    }
+
+    return true;
+}
+
+void APP_FlashGetStats(APP_FLASH_Stats_T *p_stats)
+{
+    *p_stats = s_flash.stats;
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,219 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_flash.h
+
+  Summary:
+    Queue of flash erases and writes completed by the NVM interrupt.
+
+  Description:
+    APP_FlashSubmit queues a page erase, row write or quad word write and
+    returns at once; the callback of the operation runs in the NVM interrupt
+    when it is done. The idle task starts the queued operations one at a
+    time in a BLE RF suspend window (BT_SYS_RfSuspendReq), like PDS, but
+    does not wait for them: the window stays open until the NVM interrupt,
+    which ends it, so the operation falls between two radio events while
+    the tasks keep running. Page erases prefer a window where the BLE
+    sleeps, for up to APP_FLASH_ERASE_DEFER_MS.
+
+    The PDS journal queues its writes and erases here. PDS still programs
+    flash from the idle task and waits for it; the idle task does not run it
+    while a queued operation is in flight. Code running from the panel being
+    programmed stalls until the operation ends, so the overlap is largest
+    for writes to the other panel.
+*******************************************************************************/
+
+#ifndef _APP_FLASH_H
+#define _APP_FLASH_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Operations waiting or in flight. */
+#ifndef APP_FLASH_QUEUE_LEN
+#define APP_FLASH_QUEUE_LEN             8
+#endif
+
+/* Longest a page erase waits for a window where the BLE sleeps; 0 erases in
+ * the first window. */
+#ifndef APP_FLASH_ERASE_DEFER_MS
+#define APP_FLASH_ERASE_DEFER_MS        20
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum APP_FLASH_OpType_T
+{
+    APP_FLASH_OP_ERASE_PAGE = 0,        /* NVM_FLASH_PAGESIZE at a page address */
+    APP_FLASH_OP_WRITE_ROW,             /* NVM_FLASH_ROWSIZE at a row address, source in RAM */
+    APP_FLASH_OP_WRITE_QUAD,            /* 16 bytes at a quad word address */
+} APP_FLASH_OpType_T;
+
+/* Completion callback, in the NVM interrupt. ok is false after a write or
+ * low voltage error, or when the written data does not read back. */
+typedef void (*APP_FLASH_CALLBACK)(bool ok, uintptr_t context);
+
+typedef struct APP_FLASH_Op_T
+{
+    APP_FLASH_OpType_T  type;
+    uint32_t            addr;
+    const uint32_t      *p_data;        /* Write source, untouched until the callback */
+    APP_FLASH_CALLBACK  callback;       /* May be NULL */
+    uintptr_t           context;
+} APP_FLASH_Op_T;
+
+typedef struct APP_FLASH_Stats_T
+{
+    uint32_t    submitted;
+    uint32_t    done;                   /* Completed without error */
+    uint32_t    failed;
+    uint32_t    erases;
+    uint32_t    rows;
+    uint32_t    quads;
+    uint32_t    queueFull;              /* Submissions refused for lack of room */
+    uint32_t    eraseDeferred;          /* Windows an erase let pass waiting for the BLE to sleep */
+    uint8_t     depthMax;               /* Most operations queued at once */
+} APP_FLASH_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_FlashInit ( void )
+
+  Summary:
+     Empty the queue and take the NVM interrupt callback. Call after
+     SYS_Initialize.
+*/
+void APP_FlashInit(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_FlashSubmit ( const APP_FLASH_Op_T *p_op )
+
+  Summary:
+     Queue an operation. From tasks, or from a completion callback.
+
+  Description:
+     Operations run in the order submitted. The operation is copied; a write
+     source stays in use until its callback.
+
+  Returns:
+    false if the queue is full or the address is not aligned for the
+    operation; nothing was queued then.
+*/
+bool APP_FlashSubmit(const APP_FLASH_Op_T *p_op);
+
+/*******************************************************************************
+  Function:
+    bool APP_FlashIsWorkPending ( void )
+
+  Summary:
+     Whether operations wait to be started.
+*/
+bool APP_FlashIsWorkPending(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_FlashIsBusy ( void )
+
+  Summary:
+     Whether an operation is in flight. The NVM and the RF suspend belong to
+     it until its interrupt; the idle task leaves both alone meanwhile.
+*/
+bool APP_FlashIsBusy(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_FlashTaskHandler ( uint8_t rfSuspendStatus )
+
+  Summary:
+     Start the next queued operation. Idle task only, with the BLE RF
+     suspended.
+
+  Parameters:
+    rfSuspendStatus - Return value of BT_SYS_RfSuspendReq(1).
+
+  Returns:
+    true if an operation was started: its interrupt ends the RF suspend and
+    the caller must not. false if nothing was started.
+*/
+bool APP_FlashTaskHandler(uint8_t rfSuspendStatus);
+
+/*******************************************************************************
+  Function:
+    void APP_FlashGetStats ( APP_FLASH_Stats_T *p_stats )
+
+  Summary:
+     Copy the queue counters.
+*/
+void APP_FlashGetStats(APP_FLASH_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_FLASH_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,167 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_frame.h
+
+  Summary:
+    Byte order helpers and the CRC protected frame shared by the binary
+    report streams.
+
+  Description:
+    The profiler, trace, deferred log, btsnoop, gateway and latency reports
+    all send the same frame:
+
+      sync       4   0x7E and a three letter tag, e.g. 'T' 'R' 'C'
+      version    1   format version of the stream
+      flags      1   stream specific
+      length     2   bytes from version up to the CRC, exclusive
+      payload
+      crc        2   CRC-16/CCITT-FALSE from version up to here
+
+    Multi byte fields are little endian unless noted. The host decoders in
+    tools/ share the same layout. The SPI host frame has its own header but
+    uses the same CRC.
+*******************************************************************************/
+
+#ifndef _APP_FRAME_H
+#define _APP_FRAME_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Bytes before the payload and after it. */
+#define APP_FRAME_HDR_LEN               8
+#define APP_FRAME_CRC_LEN               2
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static inline uint8_t *APP_FramePutLe16(uint8_t *p_dst, uint16_t value)
+{
+    p_dst[0] = (uint8_t)value;
+    p_dst[1] = (uint8_t)(value >> 8);
+    return p_dst + 2;
+}
+
+static inline uint8_t *APP_FramePutLe32(uint8_t *p_dst, uint32_t value)
+{
+    p_dst[0] = (uint8_t)value;
+    p_dst[1] = (uint8_t)(value >> 8);
+    p_dst[2] = (uint8_t)(value >> 16);
+    p_dst[3] = (uint8_t)(value >> 24);
+    return p_dst + 4;
+}
+
+static inline uint8_t *APP_FramePutLe64(uint8_t *p_dst, uint64_t value)
+{
+    p_dst = APP_FramePutLe32(p_dst, (uint32_t)value);
+    return APP_FramePutLe32(p_dst, (uint32_t)(value >> 32));
+}
+
+static inline uint8_t *APP_FramePutBe32(uint8_t *p_dst, uint32_t value)
+{
+    p_dst[0] = (uint8_t)(value >> 24);
+    p_dst[1] = (uint8_t)(value >> 16);
+    p_dst[2] = (uint8_t)(value >> 8);
+    p_dst[3] = (uint8_t)value;
+    return p_dst + 4;
+}
+
+static inline uint16_t APP_FrameGetLe16(const uint8_t *p_src)
+{
+    return (uint16_t)((uint16_t)p_src[0] | ((uint16_t)p_src[1] << 8));
+}
+
+static inline uint32_t APP_FrameGetLe32(const uint8_t *p_src)
+{
+    return (uint32_t)p_src[0] | ((uint32_t)p_src[1] << 8) | ((uint32_t)p_src[2] << 16) | ((uint32_t)p_src[3] << 24);
+}
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_FrameCrc16 ( const uint8_t *p_data, uint16_t len )
+
+  Summary:
+     CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF), table
+     driven.
+*/
+uint16_t APP_FrameCrc16(const uint8_t *p_data, uint16_t len);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_FrameSeal ( uint8_t *p_frame, const char *p_tag, uint8_t version,
+                             uint8_t flags, const uint8_t *p_end )
+
+  Summary:
+     Write the header of a frame whose payload starts at
+     p_frame[APP_FRAME_HDR_LEN] and ends before p_end, and the CRC after it.
+     p_tag gives the three tag letters.
+
+  Returns:
+    Frame size, header and CRC included.
+*/
+uint16_t APP_FrameSeal(uint8_t *p_frame, const char *p_tag, uint8_t version,
+                       uint8_t flags, const uint8_t *p_end);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_FRAME_H */
+
+/*******************************************************************************
+ End of File
+ */
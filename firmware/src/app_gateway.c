@@ -0,0 +1,665 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_gateway.c
+
+  Summary:
+    Central gateway merging the pipes of several sensor nodes into one uplink.
+
+  Description:
+    The gateway task owns every stack event TRCBPS and TRCBPC need, the same
+    way the pipe task does for a single link, and runs both profiles itself.
+    Only one link is being created at a time: scanning stops on the first
+    report of a new node and resumes when its link is up or has failed,
+    as long as a node slot is free.
+
+    A node queue holds records of [length LE16][SDU]. The SDU of a record
+    is sent as one uplink frame, only once the uplink has room for all of
+    it, so frames of different nodes never interleave.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_gateway.h"
+#include "app_frame.h"
+#include "app_ble_handler.h"
+#include "app_ble_evt_pool.h"
+#include "app_ble_evt_router.h"
+#include "app_static.h"
+#include "ble_trcbps/ble_trcbps.h"
+#include "ble_trcbpc/ble_trcbpc.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_GATEWAY_EVENT_QUEUE_LENGTH  (APP_BLE_EVT_POOL_SDU_SLOTS + 8)
+#define APP_GATEWAY_SCAN_INTERVAL       96      /* 0.625 ms units */
+#define APP_GATEWAY_SUPERVISION_TIMEOUT 200     /* 10 ms units */
+#define APP_GATEWAY_REC_HDR_LEN         2
+#define APP_GATEWAY_HDR_LEN             8       /* sync, version, node, length */
+#define APP_GATEWAY_QUEUE_MASK          (APP_GATEWAY_NODE_QUEUE_SIZE - 1U)
+#define APP_GATEWAY_SDU_FRAME_SIZE      (APP_GATEWAY_FRAME_OVERHEAD + BLE_TRCBPS_DATA_MTU)
+#define APP_GATEWAY_STATS_FRAME_SIZE    (APP_GATEWAY_FRAME_OVERHEAD + 4 + \
+                                         (APP_GATEWAY_MAX_NODES * APP_GATEWAY_STATS_NODE_SIZE))
+#define APP_GATEWAY_FRAME_MAX_SIZE      ((APP_GATEWAY_SDU_FRAME_SIZE > APP_GATEWAY_STATS_FRAME_SIZE) ? \
+                                         APP_GATEWAY_SDU_FRAME_SIZE : APP_GATEWAY_STATS_FRAME_SIZE)
+
+#if (APP_GATEWAY_NODE_QUEUE_SIZE & APP_GATEWAY_QUEUE_MASK) != 0
+#error "APP_GATEWAY_NODE_QUEUE_SIZE must be a power of two"
+#endif
+#if APP_GATEWAY_MAX_NODES > BLE_GAP_MAX_LINK_NBR
+#error "APP_GATEWAY_MAX_NODES is above BLE_GAP_MAX_LINK_NBR"
+#endif
+
+typedef struct APP_GATEWAY_Node_T
+{
+    uint8_t     queue[APP_GATEWAY_NODE_QUEUE_SIZE];
+    uint32_t    head;                   /* Free running, bytes written */
+    uint32_t    tail;                   /* Free running, bytes sent */
+    uint32_t    deficit;                /* Deficit round robin credit in bytes */
+    bool        inTurn;                 /* Quantum already added for the current turn */
+    bool        held;                   /* SDUs left in TRCBPS for lack of room */
+    uint32_t    lastRxBytes;            /* Counters at the previous stats frame */
+    uint32_t    lastUpBytes;
+    APP_GATEWAY_NodeStats_T stats;
+} APP_GATEWAY_Node_T;
+
+static APP_GATEWAY_Node_T s_nodes[APP_GATEWAY_MAX_NODES];
+static uint8_t s_turn;                  /* Node whose turn it is */
+
+static APP_GATEWAY_Stats_T s_stats;
+static uint32_t s_lastRxBytes;
+static uint32_t s_lastUpBytes;
+static uint32_t s_statsTime;
+
+static bool s_scanning;
+static bool s_connecting;
+
+static APP_GATEWAY_WRITE s_write;
+static APP_GATEWAY_SPACE s_space;
+
+static uint8_t s_sdu[BLE_TRCBPS_DATA_MTU];
+static uint8_t s_frame[APP_GATEWAY_FRAME_MAX_SIZE];
+
+static OSAL_QUEUE_HANDLE_TYPE s_eventQueue;
+static TaskHandle_t xGATEWAY_Task;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t APP_GatewayNowMs(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+/* Header and CRC around a payload already at s_frame[APP_GATEWAY_HDR_LEN] */
+static uint16_t APP_GatewayFinishFrame(uint8_t node, uint16_t payloadLen)
+{
+    return APP_FrameSeal(s_frame, "GWY", APP_GATEWAY_FRAME_VERSION, node, &s_frame[APP_GATEWAY_HDR_LEN + payloadLen]);
+}
+
+static void APP_GatewayQueueRead(APP_GATEWAY_Node_T *p_node, uint32_t pos, uint8_t *p_dst, uint16_t len)
+{
+    uint32_t idx = pos & APP_GATEWAY_QUEUE_MASK;
+    uint32_t first = APP_GATEWAY_NODE_QUEUE_SIZE - idx;
+
+    if (first >= len)
+    {
+        memcpy(p_dst, &p_node->queue[idx], len);
+    }
+    else
+    {
+        memcpy(p_dst, &p_node->queue[idx], first);
+        memcpy(&p_dst[first], p_node->queue, len - first);
+    }
+}
+
+static void APP_GatewayQueueWrite(APP_GATEWAY_Node_T *p_node, const uint8_t *p_src, uint16_t len)
+{
+    uint32_t idx = p_node->head & APP_GATEWAY_QUEUE_MASK;
+    uint32_t first = APP_GATEWAY_NODE_QUEUE_SIZE - idx;
+
+    if (first >= len)
+    {
+        memcpy(&p_node->queue[idx], p_src, len);
+    }
+    else
+    {
+        memcpy(&p_node->queue[idx], p_src, first);
+        memcpy(p_node->queue, &p_src[first], len - first);
+    }
+    p_node->head += len;
+}
+
+static APP_GATEWAY_Node_T *APP_GatewayFindNode(uint16_t connHandle)
+{
+    uint8_t i;
+
+    for (i = 0; i < APP_GATEWAY_MAX_NODES; i++)
+    {
+        if (s_nodes[i].stats.connected && s_nodes[i].stats.connHandle == connHandle)
+        {
+            return &s_nodes[i];
+        }
+    }
+    return NULL;
+}
+
+static bool APP_GatewayIsNodeAddr(const BLE_GAP_Addr_T *p_addr)
+{
+    uint8_t i;
+
+    for (i = 0; i < APP_GATEWAY_MAX_NODES; i++)
+    {
+        if (s_nodes[i].stats.connected && s_nodes[i].stats.addr.addrType == p_addr->addrType &&
+            memcmp(s_nodes[i].stats.addr.addr, p_addr->addr, GAP_MAX_BD_ADDRESS_LEN) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Scan while a node slot is free and no link is being created */
+static void APP_GatewayUpdateScan(void)
+{
+    bool scan = !s_connecting && s_stats.nodes < APP_GATEWAY_MAX_NODES;
+
+    if (scan != s_scanning)
+    {
+        if (BLE_GAP_SetScanningEnable(scan, BLE_GAP_SCAN_FD_ENABLE, BLE_GAP_SCAN_MODE_OBSERVER, 0) == MBA_RES_SUCCESS)
+        {
+            s_scanning = scan;
+        }
+    }
+}
+
+static void APP_GatewayProcessGapEvent(BLE_GAP_Event_T *p_event)
+{
+    APP_GATEWAY_Node_T *p_node;
+    uint8_t i;
+
+    switch (p_event->eventId)
+    {
+        case BLE_GAP_EVT_ADV_REPORT:
+        {
+            BLE_GAP_EvtAdvReport_T *p_report = &p_event->eventField.evtAdvReport;
+            BLE_GAP_CreateConnParams_T createConnParam;
+
+            if (s_connecting || !s_scanning)
+            {
+                break;
+            }
+            if (p_report->eventType != BLE_GAP_ADV_REPORT_EVT_TYPE_ADV_IND &&
+                p_report->eventType != BLE_GAP_ADV_REPORT_EVT_TYPE_SCAN_RSP)
+            {
+                break;
+            }
+            if (!BLE_TRCBPC_IsServiceAdvertised(p_report->length, p_report->advData) ||
+                APP_GatewayIsNodeAddr(&p_report->addr))
+            {
+                break;
+            }
+
+            /* Connecting and scanning at once is not supported */
+            BLE_GAP_SetScanningEnable(false, BLE_GAP_SCAN_FD_ENABLE, BLE_GAP_SCAN_MODE_OBSERVER, 0);
+            s_scanning = false;
+            memset(&createConnParam, 0, sizeof(createConnParam));
+            createConnParam.scanInterval = APP_GATEWAY_SCAN_INTERVAL;
+            createConnParam.scanWindow = APP_GATEWAY_SCAN_INTERVAL;
+            createConnParam.filterPolicy = BLE_GAP_INIT_FP_FILTER_ACCEPT_LIST_NOT_USED;
+            createConnParam.peerAddr = p_report->addr;
+            createConnParam.connParams.intervalMin = APP_GATEWAY_CONN_INTERVAL;
+            createConnParam.connParams.intervalMax = APP_GATEWAY_CONN_INTERVAL;
+            createConnParam.connParams.latency = 0;
+            createConnParam.connParams.supervisionTimeout = APP_GATEWAY_SUPERVISION_TIMEOUT;
+            s_connecting = (BLE_GAP_CreateConnection(&createConnParam) == MBA_RES_SUCCESS);
+            APP_GatewayUpdateScan();
+        }
+        break;
+
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            BLE_GAP_EvtConnect_T *p_conn = &p_event->eventField.evtConnect;
+
+            if (p_conn->role != BLE_GAP_ROLE_CENTRAL)
+            {
+                break;
+            }
+            s_connecting = false;
+            if (p_conn->status == GAP_STATUS_SUCCESS)
+            {
+                for (i = 0; i < APP_GATEWAY_MAX_NODES && s_nodes[i].stats.connected; i++)
+                {
+                }
+                if (i == APP_GATEWAY_MAX_NODES)
+                {
+                    BLE_GAP_Disconnect(p_conn->connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+                }
+                else
+                {
+                    p_node = &s_nodes[i];
+                    memset(p_node, 0, sizeof(*p_node));
+                    p_node->stats.connected = true;
+                    p_node->stats.connHandle = p_conn->connHandle;
+                    p_node->stats.addr = p_conn->remoteAddr;
+                    s_stats.nodes++;
+                    s_stats.connects++;
+
+                    BLE_GAP_SetPhy(p_conn->connHandle, BLE_GAP_PHY_OPTION_2M, BLE_GAP_PHY_OPTION_2M, 0);
+                    if (BLE_TRCBPC_ConnReq(p_conn->connHandle) != MBA_RES_SUCCESS)
+                    {
+                        BLE_GAP_Disconnect(p_conn->connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+                    }
+                }
+            }
+            APP_GatewayUpdateScan();
+        }
+        break;
+
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            p_node = APP_GatewayFindNode(p_event->eventField.evtDisconnect.connHandle);
+            if (p_node != NULL)
+            {
+                /* Queued data of the node is dropped, the stats keep the address */
+                p_node->stats.connected = false;
+                p_node->stats.queued = 0;
+                p_node->tail = p_node->head;
+                p_node->deficit = 0;
+                p_node->inTurn = false;
+                p_node->held = false;
+                s_stats.nodes--;
+            }
+            APP_GatewayUpdateScan();
+        }
+        break;
+
+        default:
+        break;
+    }
+}
+
+static void APP_GatewayProcessStackEvent(STACK_Event_T *p_stackEvt)
+{
+    if (p_stackEvt->groupId == STACK_GRP_BLE_GAP)
+    {
+        APP_GatewayProcessGapEvent((BLE_GAP_Event_T *)p_stackEvt->p_event);
+    }
+    BLE_TRCBPS_BleEventHandler(p_stackEvt);
+    BLE_TRCBPC_BleEventHandler(p_stackEvt);
+    APP_BleEvtPoolRelease(p_stackEvt);
+}
+
+static bool APP_GatewayEventSink(STACK_Event_T *p_stackEvt)
+{
+    return (OSAL_QUEUE_Send(&s_eventQueue, &p_stackEvt, 0) == OSAL_RESULT_TRUE);
+}
+
+static void APP_GatewayTrcbpsEvent(BLE_TRCBPS_Event_T *p_event)
+{
+    /* Received SDUs are pulled by the task loop after every event */
+    (void)p_event;
+}
+
+static void APP_GatewayTrcbpcEvent(BLE_TRCBPC_Event_T *p_event)
+{
+    if (p_event->eventId == BLE_TRCBPC_EVT_DISC_FAIL)
+    {
+        BLE_GAP_Disconnect(p_event->eventField.onDiscFail.connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+    }
+    else if (p_event->eventField.onPsmRead.result != MBA_RES_SUCCESS)
+    {
+        BLE_GAP_Disconnect(p_event->eventField.onPsmRead.connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+    }
+}
+
+/* Move SDUs from TRCBPS into the node queues. Returns true if any were left
+ * behind, they are retried on the next poll. */
+static bool APP_GatewayPull(void)
+{
+    APP_GATEWAY_Node_T *p_node;
+    uint16_t dataLength;
+    uint8_t hdr[APP_GATEWAY_REC_HDR_LEN];
+    bool held = false;
+    uint8_t i;
+
+    for (i = 0; i < APP_GATEWAY_MAX_NODES; i++)
+    {
+        p_node = &s_nodes[i];
+        if (!p_node->stats.connected)
+        {
+            continue;
+        }
+        while (1)
+        {
+            BLE_TRCBPS_GetDataLength(p_node->stats.connHandle, &dataLength);
+            if (dataLength == 0U || dataLength > sizeof(s_sdu))
+            {
+                break;
+            }
+            if ((p_node->head - p_node->tail) + APP_GATEWAY_REC_HDR_LEN + dataLength > APP_GATEWAY_NODE_QUEUE_SIZE)
+            {
+                /* Credits stay with the SDU, the node slows down */
+                if (!p_node->held)
+                {
+                    p_node->held = true;
+                    p_node->stats.held++;
+                }
+                held = true;
+                break;
+            }
+            p_node->held = false;
+            BLE_TRCBPS_GetData(p_node->stats.connHandle, s_sdu);
+            hdr[0] = (uint8_t)dataLength;
+            hdr[1] = (uint8_t)(dataLength >> 8);
+            APP_GatewayQueueWrite(p_node, hdr, APP_GATEWAY_REC_HDR_LEN);
+            APP_GatewayQueueWrite(p_node, s_sdu, dataLength);
+            p_node->stats.rxSdus++;
+            p_node->stats.rxBytes += dataLength;
+            s_stats.rxBytes += dataLength;
+        }
+        p_node->stats.queued = (uint16_t)(p_node->head - p_node->tail);
+    }
+    return held;
+}
+
+/* Send the SDU at the front of a node queue if the uplink has room for it */
+static bool APP_GatewaySendRecord(APP_GATEWAY_Node_T *p_node, uint8_t nodeNum, uint16_t len)
+{
+    uint16_t size;
+
+    if (s_space() < (uint16_t)(APP_GATEWAY_FRAME_OVERHEAD + len))
+    {
+        s_stats.uplinkFull++;
+        return false;
+    }
+    APP_GatewayQueueRead(p_node, p_node->tail + APP_GATEWAY_REC_HDR_LEN, &s_frame[APP_GATEWAY_HDR_LEN], len);
+    size = APP_GatewayFinishFrame(nodeNum, len);
+    s_write(s_frame, size);
+    p_node->tail += APP_GATEWAY_REC_HDR_LEN + len;
+    p_node->stats.queued = (uint16_t)(p_node->head - p_node->tail);
+    p_node->stats.upBytes += len;
+    s_stats.upBytes += len;
+    s_stats.upFrames++;
+    return true;
+}
+
+/* Deficit round robin over the node queues until they are empty or the
+ * uplink is full. A turn cut short by the uplink resumes with what is left
+ * of its deficit. Returns true while data is waiting. */
+static bool APP_GatewaySchedule(void)
+{
+    APP_GATEWAY_Node_T *p_node;
+    uint8_t hdr[APP_GATEWAY_REC_HDR_LEN];
+    uint16_t len;
+    uint8_t idle = 0;
+
+    while (idle < APP_GATEWAY_MAX_NODES)
+    {
+        p_node = &s_nodes[s_turn];
+        if (p_node->head == p_node->tail)
+        {
+            p_node->deficit = 0;
+            p_node->inTurn = false;
+            idle++;
+        }
+        else
+        {
+            idle = 0;
+            if (!p_node->inTurn)
+            {
+                p_node->deficit += APP_GATEWAY_QUANTUM;
+                p_node->inTurn = true;
+            }
+            while (p_node->head != p_node->tail)
+            {
+                APP_GatewayQueueRead(p_node, p_node->tail, hdr, APP_GATEWAY_REC_HDR_LEN);
+                len = (uint16_t)(hdr[0] | ((uint16_t)hdr[1] << 8));
+                if (len > p_node->deficit)
+                {
+                    break;
+                }
+                if (!APP_GatewaySendRecord(p_node, s_turn, len))
+                {
+                    return true;
+                }
+                p_node->deficit -= len;
+            }
+            if (p_node->head == p_node->tail)
+            {
+                p_node->deficit = 0;
+            }
+            p_node->inTurn = false;
+        }
+        s_turn = (uint8_t)((s_turn + 1U) % APP_GATEWAY_MAX_NODES);
+    }
+    return false;
+}
+
+static void APP_GatewaySendStats(uint32_t now)
+{
+    APP_GATEWAY_Node_T *p_node;
+    uint8_t *p_dst = &s_frame[APP_GATEWAY_HDR_LEN];
+    uint32_t elapsed = now - s_statsTime;
+    uint8_t i;
+
+    if (elapsed == 0U)
+    {
+        return;
+    }
+    s_stats.rxBps = (uint32_t)(((uint64_t)(s_stats.rxBytes - s_lastRxBytes) * 8000U) / elapsed);
+    s_stats.upBps = (uint32_t)(((uint64_t)(s_stats.upBytes - s_lastUpBytes) * 8000U) / elapsed);
+    s_lastRxBytes = s_stats.rxBytes;
+    s_lastUpBytes = s_stats.upBytes;
+
+    p_dst = APP_FramePutLe32(p_dst, now);
+    for (i = 0; i < APP_GATEWAY_MAX_NODES; i++)
+    {
+        p_node = &s_nodes[i];
+        p_node->stats.rxBps = (uint32_t)(((uint64_t)(p_node->stats.rxBytes - p_node->lastRxBytes) * 8000U) / elapsed);
+        p_node->stats.upBps = (uint32_t)(((uint64_t)(p_node->stats.upBytes - p_node->lastUpBytes) * 8000U) / elapsed);
+        p_node->lastRxBytes = p_node->stats.rxBytes;
+        p_node->lastUpBytes = p_node->stats.upBytes;
+        if (!p_node->stats.connected)
+        {
+            continue;
+        }
+        *p_dst++ = i;
+        *p_dst++ = p_node->stats.addr.addrType;
+        memcpy(p_dst, p_node->stats.addr.addr, GAP_MAX_BD_ADDRESS_LEN);
+        p_dst += GAP_MAX_BD_ADDRESS_LEN;
+        p_dst = APP_FramePutLe32(p_dst, p_node->stats.rxBytes);
+        p_dst = APP_FramePutLe32(p_dst, p_node->stats.upBytes);
+        p_dst = APP_FramePutLe32(p_dst, p_node->stats.held);
+        *p_dst++ = (uint8_t)p_node->stats.queued;
+        *p_dst++ = (uint8_t)(p_node->stats.queued >> 8);
+        p_dst = APP_FramePutLe32(p_dst, p_node->stats.rxBps);
+    }
+    s_statsTime = now;
+
+    /* Skipped, not waited for, when the uplink is full: the next one has
+     * the same counters */
+    if (s_space() >= (uint16_t)(p_dst - s_frame + 2))
+    {
+        s_write(s_frame, APP_GatewayFinishFrame(APP_GATEWAY_NODE_STATS, (uint16_t)(p_dst - &s_frame[APP_GATEWAY_HDR_LEN])));
+    }
+}
+
+/**
+ * GATEWAY TASK
+ * @param pvParameters
+ */
+static void _GATEWAY_Task(void *pvParameters)
+{
+    STACK_Event_T *p_stackEvt;
+    uint16_t wait = OSAL_WAIT_FOREVER;
+    uint32_t now;
+    bool held;
+    bool busy;
+
+    (void)pvParameters;
+    while (1)
+    {
+        while (OSAL_QUEUE_Receive(&s_eventQueue, &p_stackEvt, wait) == OSAL_RESULT_TRUE)
+        {
+            if (p_stackEvt != NULL)
+            {
+                APP_GatewayProcessStackEvent(p_stackEvt);
+            }
+            wait = 0;
+        }
+
+        (void)APP_GatewayPull();
+        (void)APP_GatewaySchedule();
+        /* Room the uplink made in the node queues takes more SDUs at once */
+        held = APP_GatewayPull();
+        busy = APP_GatewaySchedule() || held;
+
+        wait = busy ? APP_GATEWAY_POLL_MS : OSAL_WAIT_FOREVER;
+#if APP_GATEWAY_STATS_PERIOD_MS
+        now = APP_GatewayNowMs();
+        if ((now - s_statsTime) >= APP_GATEWAY_STATS_PERIOD_MS)
+        {
+            APP_GatewaySendStats(now);
+        }
+        if (s_statsTime + APP_GATEWAY_STATS_PERIOD_MS - now < wait)
+        {
+            wait = (uint16_t)(s_statsTime + APP_GATEWAY_STATS_PERIOD_MS - now);
+        }
+#else
+        (void)now;
+#endif
+    }
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_GatewayInit(APP_GATEWAY_WRITE write, APP_GATEWAY_SPACE space)
+{
+    s_write = write;
+    s_space = space;
+    memset(s_nodes, 0, sizeof(s_nodes));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_turn = 0;
+    s_scanning = false;
+    s_connecting = false;
+
+    APP_STATIC_QUEUE_CREATE(&s_eventQueue, APP_GATEWAY_EVENT_QUEUE_LENGTH, sizeof(STACK_Event_T *));
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _GATEWAY_Task,
+            "GATEWAY_Task",
+            512,
+            NULL,
+            1,
+            &xGATEWAY_Task);
+}
+
+void APP_GatewayStart(void)
+{
+    STACK_Event_T *p_wake = NULL;
+    BLE_DM_ConnSchedConfig_T schedConfig;
+
+    BLE_TRCBPS_EventRegister(APP_GatewayTrcbpsEvent);
+    BLE_TRCBPC_EventRegister(APP_GatewayTrcbpcEvent);
+
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_GAP,
+                              APP_BLE_EVT_MASK(BLE_GAP_EVT_CONNECTED) | APP_BLE_EVT_MASK(BLE_GAP_EVT_DISCONNECTED) |
+                              APP_BLE_EVT_MASK(BLE_GAP_EVT_ADV_REPORT) | APP_BLE_EVT_MASK(BLE_GAP_EVT_PHY_UPDATE) |
+                              APP_BLE_EVT_MASK(BLE_GAP_EVT_ENCRYPT_STATUS) | APP_BLE_EVT_MASK(BLE_GAP_EVT_TX_BUF_AVAILABLE),
+                              APP_GatewayEventSink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_L2CAP,
+                              APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_CONN_IND) | APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_CONN_FAIL_IND) |
+                              APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_SDU_IND) | APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_ADD_CREDITS_IND) |
+                              APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_DISC_IND),
+                              APP_GatewayEventSink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_GATT,
+                              APP_BLE_EVT_MASK(GATTC_EVT_ERROR_RESP) | APP_BLE_EVT_MASK(GATTC_EVT_DISC_PRIM_SERV_BY_UUID_RESP) |
+                              APP_BLE_EVT_MASK(GATTC_EVT_DISC_CHAR_BY_UUID_RESP) | APP_BLE_EVT_MASK(GATTC_EVT_READ_RESP) |
+                              APP_BLE_EVT_MASK(GATTC_EVT_PROTOCOL_AVAILABLE) | APP_BLE_EVT_MASK(ATT_EVT_TIMEOUT) |
+                              APP_BLE_EVT_MASK(ATT_EVT_UPDATE_MTU) | APP_BLE_EVT_MASK(GATTS_EVT_WRITE),
+                              APP_GatewayEventSink);
+
+    /* Node links start at APP_GATEWAY_CONN_INTERVAL, the scheduler then fits
+     * the intervals to the number of nodes */
+    schedConfig.enable = true;
+    schedConfig.eventLength = APP_GATEWAY_EVENT_LENGTH;
+    schedConfig.minInterval = BLE_GAP_CP_MIN_CONN_INTVAL_MIN;
+    schedConfig.maxInterval = APP_GATEWAY_CONN_INTERVAL * 4U;
+    schedConfig.timeout = APP_GATEWAY_SUPERVISION_TIMEOUT;
+    BLE_DM_ConnSchedConfig(&schedConfig);
+
+    s_statsTime = APP_GatewayNowMs();
+    APP_GatewayUpdateScan();
+    OSAL_QUEUE_Send(&s_eventQueue, &p_wake, 0);
+}
+
+void APP_GatewayGetStats(APP_GATEWAY_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+
+bool APP_GatewayGetNodeStats(uint8_t node, APP_GATEWAY_NodeStats_T *p_stats)
+{
+    BLE_DM_ConnShare_T share;
+
+    if (node >= APP_GATEWAY_MAX_NODES)
+    {
+        return false;
+    }
+    *p_stats = s_nodes[node].stats;
+    if (p_stats->connected && BLE_DM_ConnSchedGetShare(p_stats->connHandle, &share) == MBA_RES_SUCCESS)
+    {
+        p_stats->interval = share.interval;
+        p_stats->share = share.share;
+    }
+    return true;
+}
+
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,249 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_gateway.h
+
+  Summary:
+    Central gateway merging the pipes of several sensor nodes into one uplink.
+
+  Description:
+    With APP_GATEWAY_ENABLE (configuration.h) the board does not run the
+    single link pipe. It scans for nodes advertising the Transparent Credit
+    Based service and connects to up to APP_GATEWAY_MAX_NODES of them with
+    BLE_GAP_CreateConnection; on each link TRCBPC reads the PSM and opens the
+    data channel, which then sits in the TRCBPS connection list next to the
+    others.
+
+    The gateway task pulls the SDUs of every node from TRCBPS into a queue
+    per node. An SDU stays in TRCBPS, with its credits, while the queue of
+    its node is full, so a node the uplink cannot keep up with is slowed
+    down by flow control without holding back the others. The queues are
+    drained into the uplink by deficit round robin: each node with data may
+    send APP_GATEWAY_QUANTUM bytes per turn, so nodes share the uplink
+    evenly whatever their SDU sizes.
+
+    Each SDU goes out as one frame tagged with the node number; every
+    APP_GATEWAY_STATS_PERIOD_MS a stats frame (node APP_GATEWAY_NODE_STATS)
+    reports the address and counters of each node. tools/gateway_demux.py
+    splits a capture of the uplink into one file per node and prints the
+    throughput.
+*******************************************************************************/
+
+#ifndef _APP_GATEWAY_H
+#define _APP_GATEWAY_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+#include "ble_gap.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Links to sensor nodes, at most BLE_GAP_MAX_LINK_NBR. */
+#ifndef APP_GATEWAY_MAX_NODES
+#define APP_GATEWAY_MAX_NODES           BLE_GAP_MAX_LINK_NBR
+#endif
+
+/* Queue of each node in bytes, a power of two. An SDU takes its length plus
+ * a 2 byte header. */
+#ifndef APP_GATEWAY_NODE_QUEUE_SIZE
+#define APP_GATEWAY_NODE_QUEUE_SIZE     1024
+#endif
+
+/* Bytes a node may send per round robin turn. At least the largest SDU, so
+ * every turn sends something. */
+#ifndef APP_GATEWAY_QUANTUM
+#define APP_GATEWAY_QUANTUM             256
+#endif
+
+/* Connection interval of the node links (1.25 ms units). Six links share
+ * the radio, so it is longer than the single link one. */
+#ifndef APP_GATEWAY_CONN_INTERVAL
+#define APP_GATEWAY_CONN_INTERVAL       24
+#endif
+
+/* Air time of one connection event (1.25 ms units). Once connected, the
+ * BLE_DM multi-link scheduler (BLE_DM_ConnSchedConfig) sets the interval of
+ * all node links to one event per node, so anchors do not collide. */
+#ifndef APP_GATEWAY_EVENT_LENGTH
+#define APP_GATEWAY_EVENT_LENGTH        4
+#endif
+
+/* Period of the stats frame, 0 for none. */
+#ifndef APP_GATEWAY_STATS_PERIOD_MS
+#define APP_GATEWAY_STATS_PERIOD_MS     1000
+#endif
+
+/* Poll period while data waits for room on the uplink. */
+#ifndef APP_GATEWAY_POLL_MS
+#define APP_GATEWAY_POLL_MS             2
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Uplink frame:
+ *
+ *   sync       4   0x7E 'G' 'W' 'Y'
+ *   version    1   APP_GATEWAY_FRAME_VERSION
+ *   node       1   node number, APP_GATEWAY_NODE_STATS for a stats frame
+ *   length     2   bytes from version up to the CRC, exclusive, little endian
+ *   payload        one SDU of the node, or the stats record below
+ *   crc        2   CRC-16/CCITT-FALSE from version up to here, little endian
+ *
+ * Stats record, all little endian:
+ *
+ *   time       4   ms since boot
+ *   then per connected node:
+ *   node       1
+ *   addr       7   address type, then the address as in BLE_GAP_Addr_T
+ *   rxBytes    4   bytes pulled from TRCBPS
+ *   upBytes    4   bytes sent on the uplink
+ *   held       4   times the node queue was full and SDUs were left in TRCBPS
+ *   queued     2   bytes waiting in the node queue
+ *   rxBps      4   receive throughput over the last period, bit/s
+ */
+#define APP_GATEWAY_FRAME_VERSION       1
+#define APP_GATEWAY_NODE_STATS          0xFF
+#define APP_GATEWAY_FRAME_OVERHEAD      10
+#define APP_GATEWAY_STATS_NODE_SIZE     26
+
+typedef struct APP_GATEWAY_NodeStats_T
+{
+    bool            connected;          /* Link up and data channel requested */
+    uint16_t        connHandle;
+    BLE_GAP_Addr_T  addr;
+    uint32_t        rxSdus;             /* SDUs pulled from TRCBPS */
+    uint32_t        rxBytes;
+    uint32_t        upBytes;            /* Payload bytes sent on the uplink */
+    uint32_t        held;               /* Times the queue was full with SDUs waiting in TRCBPS */
+    uint16_t        queued;             /* Bytes in the node queue */
+    uint32_t        rxBps;              /* Over the last stats period */
+    uint32_t        upBps;
+    uint16_t        interval;           /* Connection interval in use, 1.25 ms units */
+    uint16_t        share;              /* Share of the connection events of all links, 1/1000 */
+} APP_GATEWAY_NodeStats_T;
+
+typedef struct APP_GATEWAY_Stats_T
+{
+    uint8_t     nodes;                  /* Nodes connected */
+    uint32_t    connects;               /* Links established since start */
+    uint32_t    rxBytes;                /* Totals over all nodes */
+    uint32_t    upBytes;
+    uint32_t    upFrames;
+    uint32_t    uplinkFull;             /* Times a frame waited for room on the uplink */
+    uint32_t    rxBps;                  /* Over the last stats period */
+    uint32_t    upBps;
+} APP_GATEWAY_Stats_T;
+
+/* Uplink: write returns the bytes taken, space the bytes it can take now. */
+typedef uint16_t (*APP_GATEWAY_WRITE)(const uint8_t *p_data, uint16_t length);
+typedef uint16_t (*APP_GATEWAY_SPACE)(void);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_GatewayInit ( APP_GATEWAY_WRITE write, APP_GATEWAY_SPACE space )
+
+  Summary:
+     Set the uplink and create the gateway task. Nothing is scanned for until
+     APP_GatewayStart.
+*/
+void APP_GatewayInit(APP_GATEWAY_WRITE write, APP_GATEWAY_SPACE space);
+
+/*******************************************************************************
+  Function:
+    void APP_GatewayStart ( void )
+
+  Summary:
+     Take over the TRCBPS and TRCBPC events and start scanning for nodes.
+     Call after APP_BleStackInit, in place of BLECB_Pipe_Init.
+*/
+void APP_GatewayStart(void);
+
+/*******************************************************************************
+  Function:
+    void APP_GatewayGetStats ( APP_GATEWAY_Stats_T *p_stats )
+
+  Summary:
+     Copy the aggregate counters.
+*/
+void APP_GatewayGetStats(APP_GATEWAY_Stats_T *p_stats);
+
+/*******************************************************************************
+  Function:
+    bool APP_GatewayGetNodeStats ( uint8_t node, APP_GATEWAY_NodeStats_T *p_stats )
+
+  Summary:
+     Copy the counters of one node.
+
+  Returns:
+    false if node is not below APP_GATEWAY_MAX_NODES.
+*/
+bool APP_GatewayGetNodeStats(uint8_t node, APP_GATEWAY_NodeStats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_GATEWAY_H */
+
+/*******************************************************************************
+ End of File
+ */
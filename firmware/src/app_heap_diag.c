@@ -0,0 +1,130 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_heap_diag.c
+
+  Summary:
+    Text dump of the OSAL heap accounting.
+
+  Description:
+    All counters are read before anything is written, so the allocations the
+    pipe makes to send the dump do not show up in the snapshot it is sending.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdio.h>
+#include "definitions.h"
+#include "app_heap_diag.h"
+#include "app_uart_tx.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_HeapDiagUartWrite(uint8_t *data, uint16_t length)
+{
+    APP_UartTxWriteAll(data, length);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_HeapDiagDump(APP_HEAP_DIAG_WRITE write)
+{
+    OSAL_MEM_HEAP_STATS heap;
+    OSAL_MEM_TAG_STATS tags[OSAL_MEM_TAG_NUM];
+    uint32_t timeMs;
+    char line[192];
+    int len;
+    uint8_t tag;
+
+    timeMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    OSAL_MemGetHeapStats(&heap);
+    for (tag = 0; tag < OSAL_MEM_TAG_NUM; tag++)
+    {
+        OSAL_MemGetTagStats(tag, &tags[tag]);
+    }
+
+    len = snprintf(line, sizeof(line),
+                   "#HEAP t=%lu size=%lu free=%lu minfree=%lu largest=%lu smallest=%lu blocks=%lu tracked=%lu foreign=%lu fail=%s:%lu\n",
+                   (unsigned long)timeMs, (unsigned long)heap.heapSize, (unsigned long)heap.freeBytes,
+                   (unsigned long)heap.minEverFreeBytes, (unsigned long)heap.largestFreeBlock,
+                   (unsigned long)heap.smallestFreeBlock, (unsigned long)heap.freeBlocks,
+                   (unsigned long)heap.trackedBytes, (unsigned long)heap.foreignFrees,
+                   OSAL_MemTagName(heap.lastFailTag), (unsigned long)heap.lastFailSize);
+    if (len > (int)sizeof(line) - 1)
+    {
+        len = sizeof(line) - 1;
+    }
+    write((uint8_t *)line, (uint16_t)len);
+
+    for (tag = 0; tag < OSAL_MEM_TAG_NUM; tag++)
+    {
+        len = snprintf(line, sizeof(line),
+                       "#MOD %s live=%lu peak=%lu allocs=%lu frees=%lu fails=%lu maxreq=%lu\n",
+                       OSAL_MemTagName(tag), (unsigned long)tags[tag].liveBytes,
+                       (unsigned long)tags[tag].peakBytes, (unsigned long)tags[tag].allocCount,
+                       (unsigned long)tags[tag].freeCount, (unsigned long)tags[tag].failCount,
+                       (unsigned long)tags[tag].largestRequest);
+        write((uint8_t *)line, (uint16_t)len);
+    }
+
+#if APP_STATIC_ALLOC
+    APP_StaticArenaDump(write);
+#endif
+
+    write((uint8_t *)"#END\n", 5);
+}
+
+void APP_HeapDiagMallocFailed(void)
+{
+    APP_HeapDiagUartWrite((uint8_t *)"\n-> Out of heap\n", 16);
+    APP_HeapDiagDump(APP_HeapDiagUartWrite);
+    // The caller halts right after this, get the dump out of the ring first
+    APP_UartTxFlush();
+}
+
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,123 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_heap_diag.h
+
+  Summary:
+    Text dump of the OSAL heap accounting.
+
+  Description:
+    Formats the heap totals and the per module counters kept by OSAL_Malloc
+    (see osal_freertos.h) as lines of text, one "#HEAP" line, one "#MOD" line
+    per module and a closing "#END" line:
+
+      #HEAP t=<ms> size=<B> free=<B> minfree=<B> largest=<B> smallest=<B> blocks=<n> tracked=<B> foreign=<n> fail=<tag>:<B>
+      #MOD <tag> live=<B> peak=<B> allocs=<n> frees=<n> fails=<n> maxreq=<B>
+      #ARENA <name> size=<B> used=<B> peak=<B> fails=<n>
+      #END
+
+    The "#ARENA" lines, one per data arena, only appear in the static
+    allocation build (APP_STATIC_ALLOC, see app_static.h).
+
+    The same text goes to the debug UART or back over the pipe, and
+    tools/heap_analyzer.py turns a capture of one or more dumps into
+    fragmentation figures, allocation rates and leak candidates.
+*******************************************************************************/
+
+#ifndef _APP_HEAP_DIAG_H
+#define _APP_HEAP_DIAG_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Output for the dump; Debug_Uart_Write_blocking and BLECB_Pipe_SendData fit. */
+typedef void (*APP_HEAP_DIAG_WRITE)(uint8_t *data, uint16_t length);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_HeapDiagDump ( APP_HEAP_DIAG_WRITE write )
+
+  Summary:
+     Write one heap snapshot, line by line.
+*/
+void APP_HeapDiagDump(APP_HEAP_DIAG_WRITE write);
+
+/*******************************************************************************
+  Function:
+    void APP_HeapDiagMallocFailed ( void )
+
+  Summary:
+     Dump the heap on the debug UART from vApplicationMallocFailedHook.
+
+  Description:
+     The "fail=" field of this dump names the module and the size of the
+     request that could not be served. Interrupts must still be enabled, the
+     UART driver is interrupt driven.
+*/
+void APP_HeapDiagMallocFailed(void);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_HEAP_DIAG_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,126 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_icm.c
+
+  Summary:
+    SHA-256 on the ICM, one caller at a time.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_icm.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_IcmInit(void)
+{
+    CLK_PMD3Enable(CFG_PMD3_ICMMD_Msk);
+}
+
+void APP_IcmSha256Init(CRYPT_SHA256_CTX *p_ctx)
+{
+    vTaskSuspendAll();
+    (void)CRYPT_SHA256_Initialize(p_ctx);
+    (void)xTaskResumeAll();
+}
+
+void APP_IcmSha256Add(CRYPT_SHA256_CTX *p_ctx, const uint8_t *p_data, uint32_t length)
+{
+    vTaskSuspendAll();
+    (void)CRYPT_SHA256_DataAdd(p_ctx, p_data, length);
+    (void)xTaskResumeAll();
+}
+
+void APP_IcmSha256Final(CRYPT_SHA256_CTX *p_ctx, uint8_t *p_digest)
+{
+    vTaskSuspendAll();
+    (void)CRYPT_SHA256_Finalize(p_ctx, p_digest);
+    (void)xTaskResumeAll();
+}
+
+void APP_IcmHmacSha256(const uint8_t *p_key, uint32_t keyLen,
+                       const uint8_t *p_data, uint32_t length, uint8_t *p_mac)
+{
+    CRYPT_SHA256_CTX sha;
+    uint8_t key[APP_ICM_SHA256_BLOCK];
+    uint8_t pad[APP_ICM_SHA256_BLOCK];
+    uint8_t inner[APP_ICM_SHA256_LEN];
+    uint32_t i;
+
+    // A key longer than a block is replaced by its hash
+    memset(key, 0, sizeof(key));
+    if (keyLen > APP_ICM_SHA256_BLOCK)
+    {
+        APP_IcmSha256Init(&sha);
+        APP_IcmSha256Add(&sha, p_key, keyLen);
+        APP_IcmSha256Final(&sha, key);
+    }
+    else
+    {
+        memcpy(key, p_key, keyLen);
+    }
+
+    for (i = 0; i < APP_ICM_SHA256_BLOCK; i++)
+    {
+        pad[i] = key[i] ^ 0x36U;
+    }
+    APP_IcmSha256Init(&sha);
+    APP_IcmSha256Add(&sha, pad, APP_ICM_SHA256_BLOCK);
+    APP_IcmSha256Add(&sha, p_data, length);
+    APP_IcmSha256Final(&sha, inner);
+
+    for (i = 0; i < APP_ICM_SHA256_BLOCK; i++)
+    {
+        pad[i] = key[i] ^ 0x5CU;
+    }
+    APP_IcmSha256Init(&sha);
+    APP_IcmSha256Add(&sha, pad, APP_ICM_SHA256_BLOCK);
+    APP_IcmSha256Add(&sha, inner, APP_ICM_SHA256_LEN);
+    APP_IcmSha256Final(&sha, p_mac);
+
+    memset(key, 0, sizeof(key));
+    memset(pad, 0, sizeof(pad));
+}
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,144 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_icm.h
+
+  Summary:
+    SHA-256 on the ICM, shared by the pipe digest and the firmware update.
+
+  Description:
+    wolfCrypt's SHA-256 on this part is the ICM port (crypt_sha256_sam11105.c),
+    which runs every update through one descriptor, one block buffer and one
+    result buffer, all statics. Two tasks hashing at once would overwrite
+    each other's run. Every ICM user goes through these calls instead of
+    CRYPT_SHA256_*: each runs with the scheduler suspended, like the AES
+    engine users, and the context keeps the intermediate hash in between, so
+    several hashes can be in progress.
+
+    The clock setup leaves the ICM disabled in CFG_PMD3, and the port waits
+    on it forever then. APP_IcmInit enables it; each user calls it from its
+    own init.
+*******************************************************************************/
+
+#ifndef _APP_ICM_H
+#define _APP_ICM_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include "crypto/crypto.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_ICM_SHA256_LEN              32
+#define APP_ICM_SHA256_BLOCK            64
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_IcmInit ( void )
+
+  Summary:
+     Enable the ICM in CFG_PMD3. Calling it again does no harm.
+*/
+void APP_IcmInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_IcmSha256Init ( CRYPT_SHA256_CTX *p_ctx )
+
+  Summary:
+     Start a hash.
+*/
+void APP_IcmSha256Init(CRYPT_SHA256_CTX *p_ctx);
+
+/*******************************************************************************
+  Function:
+    void APP_IcmSha256Add ( CRYPT_SHA256_CTX *p_ctx, const uint8_t *p_data, uint32_t length )
+
+  Summary:
+     Hash the next bytes. Data at a 64 byte boundary, in whole blocks, takes
+     a single ICM run; anything else takes one run per block.
+*/
+void APP_IcmSha256Add(CRYPT_SHA256_CTX *p_ctx, const uint8_t *p_data, uint32_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_IcmSha256Final ( CRYPT_SHA256_CTX *p_ctx, uint8_t *p_digest )
+
+  Summary:
+     Write the 32 byte digest of everything added.
+*/
+void APP_IcmSha256Final(CRYPT_SHA256_CTX *p_ctx, uint8_t *p_digest);
+
+/*******************************************************************************
+  Function:
+    void APP_IcmHmacSha256 ( const uint8_t *p_key, uint32_t keyLen,
+                             const uint8_t *p_data, uint32_t length, uint8_t *p_mac )
+
+  Summary:
+     Write the 32 byte HMAC-SHA256 (RFC 2104) of the data under the key.
+*/
+void APP_IcmHmacSha256(const uint8_t *p_key, uint32_t keyLen,
+                       const uint8_t *p_data, uint32_t length, uint8_t *p_mac);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_ICM_H */
+
+/*******************************************************************************
+ End of File
+ */
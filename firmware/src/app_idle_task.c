@@ -38,15 +38,36 @@
 // DOM-IGNORE-END
 
 #include "definitions.h"
+#include "app_flash.h"
 
 
 void app_idle_task( void )
 {
-    uint8_t PDS_Items_Pending = PDS_GetPendingItemsCount();
-    bool RF_Cal_Needed = RF_NeedCal(); // device_support library API
+    uint8_t PDS_Items_Pending;
+    bool Flash_Pending;
+    bool Flash_Started = false;
+    bool RF_Cal_Needed;
     uint8_t BT_RF_Suspended = 0;
 
-    if (PDS_Items_Pending || RF_Cal_Needed)
+    //a queued flash operation is in flight: the NVM and the RF suspend are
+    //its own until the NVM interrupt
+    if (APP_FlashIsBusy())
+    {
+        return;
+    }
+
+    //the journal only queues its flash work, which runs below like any other
+    //queued operation
+    if (PDS_JNL_IsWorkPending())
+    {
+        PDS_JNL_TaskHandler();
+    }
+
+    PDS_Items_Pending = PDS_GetPendingItemsCount();
+    Flash_Pending = APP_FlashIsWorkPending();
+    RF_Cal_Needed = RF_NeedCal(); // device_support library API
+
+    if (PDS_Items_Pending || Flash_Pending || RF_Cal_Needed)
     {
         OSAL_CRITSECT_DATA_TYPE IntState;
         IntState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
@@ -62,11 +83,21 @@ void app_idle_task( void )
             {
                 PDS_StoreItemTaskHandler();
             }
+            else if (Flash_Pending)
+            {
+                //start one queued flash operation without waiting for it
+                Flash_Started = APP_FlashTaskHandler(BT_RF_Suspended);
+            }
             else if ((RF_Cal_Needed) && (BT_RF_Suspended == BT_SYS_RF_SUSPENDED_NO_SLEEP))
             {
                 RF_Timer_Cal(WSS_ENABLE_BLE);
             }
-            BT_SYS_RfSuspendReq(0);
+
+            //once started, the operation's interrupt ends the suspend window
+            if (!Flash_Started)
+            {
+                BT_SYS_RfSuspendReq(0);
+            }
         }
     }
 }
@@ -0,0 +1,209 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_lat.c
+
+  Summary:
+    Log bucketed latency histograms.
+
+  Description:
+    Bucket index of a value v >= 4 with most significant bit m is
+    4 * (m - 1) + the two bits below m, so every power of two is split into
+    four equal parts; values 0 to 3 have a bucket each.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_lat.h"
+#include "app_frame.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_LAT_Hist_T
+{
+    uint32_t    bucket[APP_LAT_BUCKETS];
+    uint32_t    count;
+    uint32_t    maxCycles;
+} APP_LAT_Hist_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static APP_LAT_Hist_T s_hist[APP_LAT_STAGE_NUM];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint8_t APP_LatBucket(uint32_t cycles)
+{
+    uint32_t msb;
+
+    if (cycles < 4U)
+    {
+        return (uint8_t)cycles;
+    }
+    msb = 31U - __CLZ(cycles);
+    return (uint8_t)(((msb - 1U) << 2) | ((cycles >> (msb - 2U)) & 3U));
+}
+
+/* Largest value that falls into a bucket */
+static uint32_t APP_LatBucketTop(uint8_t idx)
+{
+    uint32_t msb;
+    uint32_t sub;
+
+    if (idx < 4U)
+    {
+        return idx;
+    }
+    msb = (idx >> 2) + 1U;
+    sub = idx & 3U;
+    return ((4U + sub + 1U) << (msb - 2U)) - 1U;
+}
+
+static uint32_t APP_LatCyclesToUs(uint32_t cycles)
+{
+    return cycles / (configCPU_CLOCK_HZ / 1000000U);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_LatInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    APP_LatReset();
+}
+
+void APP_LatRecord(APP_LAT_Stage_T stage, uint32_t start)
+{
+    APP_LAT_Hist_T *p_hist = &s_hist[stage];
+    uint32_t cycles = DWT->CYCCNT - start;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    p_hist->bucket[APP_LatBucket(cycles)]++;
+    p_hist->count++;
+    if (cycles > p_hist->maxCycles)
+    {
+        p_hist->maxCycles = cycles;
+    }
+    __set_PRIMASK(primask);
+}
+
+void APP_LatReset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(s_hist, 0, sizeof(s_hist));
+    __set_PRIMASK(primask);
+}
+
+void APP_LatGetSummary(APP_LAT_Stage_T stage, APP_LAT_Summary_T *p_summary)
+{
+    static APP_LAT_Hist_T hist;
+    uint32_t primask = __get_PRIMASK();
+    uint32_t rank50;
+    uint32_t rank99;
+    uint32_t seen = 0;
+    uint32_t p50 = 0;
+    uint32_t p99 = 0;
+    uint8_t i;
+
+    __disable_irq();
+    memcpy(&hist, &s_hist[stage], sizeof(hist));
+    __set_PRIMASK(primask);
+
+    // Rank of the sample at each percentile, rounded up
+    rank50 = (hist.count + 1U) / 2U;
+    rank99 = hist.count - (hist.count / 100U);
+    for (i = 0; i < APP_LAT_BUCKETS && seen < rank99; i++)
+    {
+        seen += hist.bucket[i];
+        if (p50 == 0 && seen >= rank50 && rank50 != 0)
+        {
+            p50 = APP_LatBucketTop(i);
+        }
+        if (seen >= rank99)
+        {
+            p99 = APP_LatBucketTop(i);
+        }
+    }
+
+    // A bucket bound may lie above the largest sample seen
+    p_summary->count = hist.count;
+    p_summary->p50Us = APP_LatCyclesToUs((p50 < hist.maxCycles) ? p50 : hist.maxCycles);
+    p_summary->p99Us = APP_LatCyclesToUs((p99 < hist.maxCycles) ? p99 : hist.maxCycles);
+    p_summary->maxUs = APP_LatCyclesToUs(hist.maxCycles);
+}
+
+uint8_t APP_LatBuildReport(APP_LAT_Stage_T stage, uint8_t *p_buf)
+{
+    APP_LAT_Summary_T summary;
+    uint8_t *p_dst = p_buf;
+
+    APP_LatGetSummary(stage, &summary);
+    *p_dst++ = (uint8_t)stage;
+    p_dst = APP_FramePutLe32(p_dst, summary.count);
+    p_dst = APP_FramePutLe32(p_dst, summary.p50Us);
+    p_dst = APP_FramePutLe32(p_dst, summary.p99Us);
+    p_dst = APP_FramePutLe32(p_dst, summary.maxUs);
+
+    return (uint8_t)(p_dst - p_buf);
+}
+
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,190 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_lat.h
+
+  Summary:
+    Always-on latency histograms for the stages of the data path.
+
+  Description:
+    Each stage keeps a histogram of its latency in DWT cycles with four
+    buckets per power of two, i.e. a worst case error of 25 %, in 512 bytes
+    of RAM. Recording a sample is a subtraction, a CLZ and an increment.
+    Percentiles are read out by the peer with the vendor command
+    APP_LAT_VENDOR_OPCODE on the TRCBPS control channel.
+
+    The cycle counter does not advance while the device sleeps; stages that
+    wait across a sleep period (e.g. a TX waiting for credits) are measured
+    short by the time spent asleep.
+*******************************************************************************/
+
+#ifndef _APP_LAT_H
+#define _APP_LAT_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include "device.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* TRCBPS vendor opcode of the latency command. The byte after the opcode
+ * selects the action (APP_LAT_CMD_xxx). Each report notification carries one
+ * stage: stage(1) count(4) p50Us(4) p99Us(4) maxUs(4), little endian, which
+ * fits the default 23 byte ATT MTU. */
+#define APP_LAT_VENDOR_OPCODE           0x70
+
+#define APP_LAT_CMD_REPORT              0x00    /* Report all stages */
+#define APP_LAT_CMD_RESET               0x01    /* Clear all stages */
+#define APP_LAT_CMD_REPORT_RESET        0x02    /* Report, then clear */
+
+#define APP_LAT_REPORT_SIZE             17
+
+/* Buckets per histogram: 4 per power of two over the 32 bit cycle range. */
+#define APP_LAT_BUCKETS                 128
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum APP_LAT_Stage_T
+{
+    APP_LAT_STAGE_STACK_TO_APP,         /* APP_BleStackCb entry to APP_Tasks dequeue */
+    APP_LAT_STAGE_SDU_TO_RX_CB,         /* TRCBPS receive event in the pipe to the pipe receive callback */
+    APP_LAT_STAGE_TX_TO_SDU,            /* BLECB_Pipe_SendData to BLE_L2CAP_CbSendSdu acceptance */
+
+    APP_LAT_STAGE_NUM
+} APP_LAT_Stage_T;
+
+typedef struct APP_LAT_Summary_T
+{
+    uint32_t    count;                  /* Samples since the last reset */
+    uint32_t    p50Us;                  /* Median, upper bound of its bucket */
+    uint32_t    p99Us;                  /* 99th percentile, upper bound of its bucket */
+    uint32_t    maxUs;                  /* Exact maximum */
+} APP_LAT_Summary_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    uint32_t APP_LatNow ( void )
+
+  Summary:
+     Start timestamp of a sample, to be passed to APP_LatRecord later.
+*/
+static inline uint32_t APP_LatNow(void)
+{
+    return DWT->CYCCNT;
+}
+
+/*******************************************************************************
+  Function:
+    void APP_LatInit ( void )
+
+  Summary:
+     Start the cycle counter and clear all histograms.
+*/
+void APP_LatInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_LatRecord ( APP_LAT_Stage_T stage, uint32_t start )
+
+  Summary:
+     Add the time elapsed since start (an APP_LatNow value) to a stage.
+*/
+void APP_LatRecord(APP_LAT_Stage_T stage, uint32_t start);
+
+/*******************************************************************************
+  Function:
+    void APP_LatReset ( void )
+
+  Summary:
+     Clear all histograms.
+*/
+void APP_LatReset(void);
+
+/*******************************************************************************
+  Function:
+    void APP_LatGetSummary ( APP_LAT_Stage_T stage, APP_LAT_Summary_T *p_summary )
+
+  Summary:
+     Compute the percentiles of a stage.
+*/
+void APP_LatGetSummary(APP_LAT_Stage_T stage, APP_LAT_Summary_T *p_summary);
+
+/*******************************************************************************
+  Function:
+    uint8_t APP_LatBuildReport ( APP_LAT_Stage_T stage, uint8_t *p_buf )
+
+  Summary:
+     Serialize the summary of a stage into the vendor command report format.
+
+  Returns:
+    APP_LAT_REPORT_SIZE.
+*/
+uint8_t APP_LatBuildReport(APP_LAT_Stage_T stage, uint8_t *p_buf);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_LAT_H */
+
+/*******************************************************************************
+ End of File
+ */
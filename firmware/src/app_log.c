@@ -0,0 +1,812 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_log.c
+
+  Summary:
+    Time indexed data log in flash, offloaded in bulk over the pipe.
+
+  Description:
+    The write side runs from APP_LogAppend and from the flash completions in
+    the NVM interrupt, with interrupts masked. One record is programmed at a
+    time, its quad words submitted to the flash queue header last; the
+    completion of the header commits it to the index. A program error drops
+    the record and closes the page, as the rest of it may not be clean.
+
+    Pages from s_log.tail to s_log.wrPage hold the log, in order. Opening a
+    page submits the erase of the next one, so a page is erased well before
+    it is written; when the ring is full that next page is the oldest one,
+    dropped from the index at that point. An offload holds the pages of its
+    batch, and opening a page that would drop one of them waits.
+
+    The offload belongs to the pipe task. It only reads flash behind the
+    index, so it needs no lock but to take a batch and give it back.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_log.h"
+#include "app_frame.h"
+#include "app_flash.h"
+#include "blecb_pipe.h"
+
+#if APP_LOG_ENABLE
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_LOG_QUAD_SIZE               16U
+#define APP_LOG_QUADS                   (APP_LOG_RECORD_SIZE / APP_LOG_QUAD_SIZE)
+#define APP_LOG_PAGES                   (APP_LOG_LENGTH / NVM_FLASH_PAGESIZE)
+#define APP_LOG_SLOTS                   (NVM_FLASH_PAGESIZE / APP_LOG_RECORD_SIZE)
+#if APP_AEAD_ENABLE
+/* A sealed batch is copied to a TX queue buffer and sealed there */
+#define APP_LOG_BATCH_RECORDS           (APP_LOG_SEALED_BATCH_MAX / APP_LOG_RECORD_SIZE)
+#else
+#define APP_LOG_BATCH_RECORDS           (APP_LOG_BATCH_MAX / APP_LOG_RECORD_SIZE)
+#endif
+#define APP_LOG_ERASED                  0xFFFFFFFFU
+
+#if (APP_LOG_RECORD_SIZE % 16) != 0 || (4096 % APP_LOG_RECORD_SIZE) != 0
+#error APP_LOG_RECORD_SIZE must be a multiple of 16 that divides a flash page
+#endif
+#if (APP_LOG_LENGTH % 4096) != 0 || APP_LOG_LENGTH < 3 * 4096 || APP_LOG_LENGTH > 255 * 4096
+#error APP_LOG_LENGTH must be 3 to 255 flash pages
+#endif
+#if APP_LOG_BATCH_MAX < APP_LOG_RECORD_SIZE || APP_LOG_BATCH_MAX > 0xFFFF - APP_LOG_HDR_LEN
+#error APP_LOG_BATCH_MAX does not fit a pipe message
+#endif
+#if APP_AEAD_ENABLE && (APP_LOG_SEALED_BATCH_MAX < APP_LOG_RECORD_SIZE || APP_LOG_SEALED_BATCH_MAX > APP_LOG_BATCH_MAX)
+#error APP_LOG_SEALED_BATCH_MAX must hold a record and be at most APP_LOG_BATCH_MAX
+#endif
+
+extern uint32_t __app_log_start;
+extern uint32_t __app_log_end;
+
+typedef struct APP_LOG_Page_T
+{
+    uint32_t            firstSeq;
+    uint32_t            firstTime;      /* Set when opened, so empty pages keep the index sorted */
+    volatile uint16_t   count;          /* Records programmed, from the first slot */
+} APP_LOG_Page_T;
+
+typedef struct APP_LOG_Ctrl_T
+{
+    bool                ready;
+    uint32_t            base;
+    APP_LOG_Page_T      page[APP_LOG_PAGES];
+    uint8_t             tail;           /* Oldest page */
+    uint8_t             used;           /* Pages from tail to wrPage, at most APP_LOG_PAGES - 1 */
+    uint8_t             wrPage;
+    uint16_t            wrSlot;         /* APP_LOG_SLOTS: full, the next record opens a page */
+    bool                aheadErased;    /* Erase of the page after wrPage submitted */
+    uint32_t            nextSeq;
+    uint32_t            lastTime;
+
+    /* Records waiting; the one at pendHead is being programmed */
+    APP_LOG_Record_T    pend[APP_LOG_PENDING];
+    uint8_t             pendHead;
+    uint8_t             pendCount;
+    uint8_t             quadsSubmitted;
+    bool                recFailed;
+
+    /* Pages of the batch being offloaded */
+    uint8_t             pinPage;
+    uint8_t             pinPages;
+
+    APP_LOG_Stats_T     stats;
+} APP_LOG_Ctrl_T;
+
+typedef struct APP_LOG_Offload_T
+{
+    bool            active;
+    uint32_t        firstSeq;
+    uint32_t        nextSeq;            /* First record of the batch being sent, or of the next one */
+    uint32_t        endSeq;
+    uint32_t        batchRecords;
+    const uint8_t   *p_next;            /* Flash of the batch still to send */
+    uint32_t        left;
+    bool            hdrSent;
+    uint8_t         hdr[2 + APP_LOG_HDR_LEN];
+    uint32_t        startTime;
+    uint8_t         rsp[APP_LOG_RSP_LEN];
+    bool            rspPending;
+} APP_LOG_Offload_T;
+
+static APP_LOG_Ctrl_T s_log;
+static APP_LOG_Offload_T s_off;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_LogPump(void);
+
+static uint32_t APP_LogLock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    return primask;
+}
+
+static void APP_LogUnlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+static uint32_t APP_LogNowMs(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static uint8_t APP_LogPageNext(uint8_t page)
+{
+    return (uint8_t)((page + 1U) % APP_LOG_PAGES);
+}
+
+/* Page k places after the oldest */
+static uint8_t APP_LogPageAt(uint32_t k)
+{
+    return (uint8_t)((s_log.tail + k) % APP_LOG_PAGES);
+}
+
+static uint32_t APP_LogPageAddr(uint8_t page)
+{
+    return s_log.base + (uint32_t)page * NVM_FLASH_PAGESIZE;
+}
+
+static const APP_LOG_Record_T *APP_LogSlot(uint8_t page, uint32_t slot)
+{
+    return (const APP_LOG_Record_T *)(APP_LogPageAddr(page) + slot * APP_LOG_RECORD_SIZE);
+}
+
+static bool APP_LogBlank(uint32_t addr, uint32_t size)
+{
+    const uint32_t *p_word = (const uint32_t *)addr;
+    uint32_t i;
+
+    for (i = 0; i < size / sizeof(uint32_t); i++)
+    {
+        if (p_word[i] != APP_LOG_ERASED)
+            return false;
+    }
+    return true;
+}
+
+static bool APP_LogPinned(uint8_t page)
+{
+    return s_log.pinPages != 0U
+        && (uint8_t)((page + APP_LOG_PAGES - s_log.pinPage) % APP_LOG_PAGES) < s_log.pinPages;
+}
+
+/* NVM interrupt */
+static void APP_LogQuadDone(bool ok, uintptr_t context)
+{
+    uint32_t primask = APP_LogLock();
+
+    if (!ok)
+        s_log.recFailed = true;
+    if (context == 0U)
+    {
+        /* The header, programmed last */
+        if (s_log.recFailed)
+        {
+            s_log.stats.failed++;
+            s_log.wrSlot = APP_LOG_SLOTS;
+        }
+        else
+        {
+            s_log.page[s_log.wrPage].count++;
+            s_log.wrSlot++;
+            s_log.nextSeq++;
+        }
+        s_log.recFailed = false;
+        s_log.quadsSubmitted = 0;
+        s_log.pendHead = (uint8_t)((s_log.pendHead + 1U) % APP_LOG_PENDING);
+        s_log.pendCount--;
+        APP_LogPump();
+    }
+    APP_LogUnlock(primask);
+}
+
+/* NVM interrupt */
+static void APP_LogEraseDone(bool ok, uintptr_t context)
+{
+    uint32_t primask;
+
+    if (ok)
+        return;
+
+    primask = APP_LogLock();
+    s_log.stats.eraseFailed++;
+    /* Once the page is opened, its writes fail and close it instead */
+    if ((uint8_t)context == APP_LogPageNext(s_log.wrPage))
+    {
+        s_log.aheadErased = false;
+        APP_LogPump();
+    }
+    APP_LogUnlock(primask);
+}
+
+/* Interrupts masked. Submit as much of the write side as the flash queue
+ * takes; what it refuses is submitted on the next append or completion. */
+static void APP_LogPump(void)
+{
+    APP_FLASH_Op_T op;
+    APP_LOG_Record_T *p_rec;
+    uint8_t next;
+    uint8_t q;
+
+    if (!s_log.aheadErased)
+    {
+        next = APP_LogPageNext(s_log.wrPage);
+        op.type = APP_FLASH_OP_ERASE_PAGE;
+        op.addr = APP_LogPageAddr(next);
+        op.p_data = NULL;
+        op.callback = APP_LogEraseDone;
+        op.context = next;
+        if (!APP_FlashSubmit(&op))
+            return;
+        s_log.aheadErased = true;
+    }
+    if (s_log.pendCount == 0U)
+        return;
+    p_rec = &s_log.pend[s_log.pendHead];
+
+    if (s_log.wrSlot == APP_LOG_SLOTS)
+    {
+        next = APP_LogPageNext(s_log.wrPage);
+        if (s_log.used == APP_LOG_PAGES - 1U)
+        {
+            /* Full: the oldest page becomes the one kept erased */
+            if (APP_LogPinned(s_log.tail))
+            {
+                s_log.stats.heldByOffload++;
+                return;
+            }
+            s_log.tail = APP_LogPageNext(s_log.tail);
+            s_log.used--;
+        }
+        if (s_log.used == 0U)
+            s_log.tail = next;
+        s_log.page[next].firstSeq = s_log.nextSeq;
+        s_log.page[next].firstTime = p_rec->time;
+        s_log.page[next].count = 0;
+        s_log.used++;
+        s_log.wrPage = next;
+        s_log.wrSlot = 0;
+        s_log.aheadErased = false;
+        APP_LogPump();
+        return;
+    }
+
+    p_rec->seq = s_log.nextSeq;
+    while (s_log.quadsSubmitted < APP_LOG_QUADS)
+    {
+        /* Header quad word last */
+        q = (uint8_t)((s_log.quadsSubmitted + 1U) % APP_LOG_QUADS);
+        op.type = APP_FLASH_OP_WRITE_QUAD;
+        op.addr = (uint32_t)APP_LogSlot(s_log.wrPage, s_log.wrSlot) + q * APP_LOG_QUAD_SIZE;
+        op.p_data = (const uint32_t *)p_rec + q * (APP_LOG_QUAD_SIZE / sizeof(uint32_t));
+        op.callback = APP_LogQuadDone;
+        op.context = q;
+        if (!APP_FlashSubmit(&op))
+            return;
+        s_log.quadsSubmitted++;
+    }
+}
+
+/* Interrupts masked. Sequence number of the first record whose time is at
+ * least t, or above t when after is set; nextSeq if there is none. */
+static uint32_t APP_LogSeqAtTime(uint32_t t, bool after)
+{
+    const APP_LOG_Page_T *p_page;
+    uint32_t lo = 0;
+    uint32_t hi = s_log.used;
+    uint32_t mid;
+    uint32_t time;
+
+    /* First page starting at or past t */
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2U;
+        time = s_log.page[APP_LogPageAt(mid)].firstTime;
+        if (after ? time > t : time >= t)
+            hi = mid;
+        else
+            lo = mid + 1U;
+    }
+    if (lo != 0U)
+    {
+        /* Then the record in the page before it */
+        p_page = &s_log.page[APP_LogPageAt(lo - 1U)];
+        hi = p_page->count;
+        mid = 0;
+        while (mid < hi)
+        {
+            uint32_t slot = (mid + hi) / 2U;
+
+            time = APP_LogSlot(APP_LogPageAt(lo - 1U), slot)->time;
+            if (after ? time > t : time >= t)
+                hi = slot;
+            else
+                mid = slot + 1U;
+        }
+        if (mid < p_page->count)
+            return p_page->firstSeq + mid;
+    }
+    if (lo < s_log.used)
+        return s_log.page[APP_LogPageAt(lo)].firstSeq;
+    return s_log.nextSeq;
+}
+
+/* Interrupts masked. Records from fromSeq up to endSeq. */
+static uint32_t APP_LogCount(uint32_t fromSeq, uint32_t endSeq)
+{
+    const APP_LOG_Page_T *p_page;
+    uint32_t count = 0;
+    uint32_t first;
+    uint32_t end;
+    uint32_t k;
+
+    for (k = 0; k < s_log.used; k++)
+    {
+        p_page = &s_log.page[APP_LogPageAt(k)];
+        first = (p_page->firstSeq > fromSeq) ? p_page->firstSeq : fromSeq;
+        end = p_page->firstSeq + p_page->count;
+        if (end > endSeq)
+            end = endSeq;
+        if (end > first)
+            count += end - first;
+    }
+    return count;
+}
+
+/* Interrupts masked. Find the record *p_seq, or the first one after it still
+ * in the log; false if there is none. */
+static bool APP_LogLocate(uint32_t *p_seq, uint32_t *p_k, uint32_t *p_slot)
+{
+    const APP_LOG_Page_T *p_page;
+    uint32_t seq = *p_seq;
+    uint32_t lo = 0;
+    uint32_t hi = s_log.used;
+    uint32_t mid;
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2U;
+        if (s_log.page[APP_LogPageAt(mid)].firstSeq <= seq)
+            lo = mid + 1U;
+        else
+            hi = mid;
+    }
+    for (lo = (lo != 0U) ? lo - 1U : 0U; lo < s_log.used; lo++)
+    {
+        p_page = &s_log.page[APP_LogPageAt(lo)];
+        if (seq < p_page->firstSeq)
+            seq = p_page->firstSeq;
+        if (seq - p_page->firstSeq < p_page->count)
+        {
+            *p_seq = seq;
+            *p_k = lo;
+            *p_slot = seq - p_page->firstSeq;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void APP_LogRespond(uint8_t op, uint8_t status, uint32_t firstSeq, uint32_t count)
+{
+    memcpy(s_off.rsp, APP_LOG_MAGIC, APP_LOG_MAGIC_LEN);
+    s_off.rsp[4] = APP_LOG_OP_RESPONSE;
+    s_off.rsp[5] = op;
+    s_off.rsp[6] = status;
+    (void)APP_FramePutLe32(&s_off.rsp[7], firstSeq);
+    (void)APP_FramePutLe32(&s_off.rsp[11], count);
+    s_off.rspPending = !BLECB_Pipe_SendProto(s_off.rsp, APP_LOG_RSP_LEN, NULL, 0);
+}
+
+/* Take the next batch: records in consecutive flash, from one page on into
+ * the following ones while each is full and continues the last. */
+static bool APP_LogBatchStart(void)
+{
+    const APP_LOG_Page_T *p_page;
+    uint32_t primask;
+    uint32_t seq = s_off.nextSeq;
+    uint32_t k;
+    uint32_t slot;
+    uint32_t firstSlot;
+    uint32_t take;
+    uint32_t n = 0;
+    uint8_t page;
+    uint8_t pages = 0;
+    bool whole;
+
+    primask = APP_LogLock();
+    if (!APP_LogLocate(&seq, &k, &slot) || seq >= s_off.endSeq)
+    {
+        APP_LogUnlock(primask);
+        return false;
+    }
+    page = APP_LogPageAt(k);
+    firstSlot = slot;
+    do
+    {
+        p_page = &s_log.page[page + pages];
+        take = p_page->count - slot;
+        if (take > s_off.endSeq - (seq + n))
+            take = s_off.endSeq - (seq + n);
+        if (take > APP_LOG_BATCH_RECORDS - n)
+            take = APP_LOG_BATCH_RECORDS - n;
+        whole = (slot + take == APP_LOG_SLOTS);
+        n += take;
+        pages++;
+        slot = 0;
+    } while (whole && n < APP_LOG_BATCH_RECORDS && seq + n < s_off.endSeq
+             && k + pages < s_log.used && page + pages < APP_LOG_PAGES
+             && s_log.page[page + pages].firstSeq == seq + n);
+    s_log.pinPage = page;
+    s_log.pinPages = pages;
+    APP_LogUnlock(primask);
+
+    s_off.nextSeq = seq;
+    s_off.batchRecords = n;
+    s_off.p_next = (const uint8_t *)APP_LogSlot(page, firstSlot);
+    s_off.left = n * APP_LOG_RECORD_SIZE;
+    s_off.hdr[0] = (uint8_t)(APP_LOG_HDR_LEN + s_off.left);
+    s_off.hdr[1] = (uint8_t)((APP_LOG_HDR_LEN + s_off.left) >> 8);
+    memcpy(&s_off.hdr[2], APP_LOG_MAGIC, APP_LOG_MAGIC_LEN);
+    s_off.hdr[2 + APP_LOG_MAGIC_LEN] = APP_LOG_OP_BATCH;
+    s_off.hdrSent = false;
+    return true;
+}
+
+static void APP_LogBatchRelease(void)
+{
+    uint32_t primask = APP_LogLock();
+
+    s_log.pinPages = 0;
+    APP_LogPump();
+    APP_LogUnlock(primask);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_LogInit(void)
+{
+    bool valid[APP_LOG_PAGES];
+    const APP_LOG_Record_T *p_first;
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t mid;
+    uint8_t head = APP_LOG_PAGES;
+    uint8_t page;
+    uint8_t prev;
+
+    memset(&s_log, 0, sizeof(s_log));
+    memset(&s_off, 0, sizeof(s_off));
+    s_log.base = (uint32_t)&__app_log_start;
+    if ((uint32_t)&__app_log_end - s_log.base != APP_LOG_LENGTH || (s_log.base & (NVM_FLASH_PAGESIZE - 1U)) != 0U)
+        return;
+
+    for (page = 0; page < APP_LOG_PAGES; page++)
+    {
+        p_first = APP_LogSlot(page, 0);
+        valid[page] = (p_first->seq != APP_LOG_ERASED);
+        if (!valid[page])
+            continue;
+
+        /* Records go in slot order, header last, so the valid ones are the
+         * first ones of the page */
+        lo = 1U;
+        hi = APP_LOG_SLOTS;
+        while (lo < hi)
+        {
+            mid = (lo + hi + 1U) / 2U;
+            if (APP_LogSlot(page, mid - 1U)->seq == p_first->seq + mid - 1U)
+                lo = mid;
+            else
+                hi = mid - 1U;
+        }
+        s_log.page[page].firstSeq = p_first->seq;
+        s_log.page[page].firstTime = p_first->time;
+        s_log.page[page].count = (uint16_t)lo;
+        if (head == APP_LOG_PAGES || p_first->seq > s_log.page[head].firstSeq)
+            head = page;
+    }
+
+    if (head == APP_LOG_PAGES)
+    {
+        /* Empty: the first record opens page 0 */
+        s_log.wrPage = APP_LOG_PAGES - 1U;
+        s_log.wrSlot = APP_LOG_SLOTS;
+    }
+    else
+    {
+        /* Back from the newest page while the pages keep going back in sequence */
+        s_log.tail = head;
+        s_log.used = 1;
+        while (s_log.used < APP_LOG_PAGES - 1U)
+        {
+            prev = (uint8_t)((s_log.tail + APP_LOG_PAGES - 1U) % APP_LOG_PAGES);
+            if (!valid[prev] || s_log.page[prev].firstSeq >= s_log.page[s_log.tail].firstSeq)
+                break;
+            s_log.tail = prev;
+            s_log.used++;
+        }
+        s_log.wrPage = head;
+        s_log.wrSlot = s_log.page[head].count;
+        s_log.nextSeq = s_log.page[head].firstSeq + s_log.page[head].count;
+        s_log.lastTime = APP_LogSlot(head, s_log.wrSlot - 1U)->time;
+        /* A record cut short leaves the rest of the page unusable */
+        if (s_log.wrSlot < APP_LOG_SLOTS
+            && !APP_LogBlank((uint32_t)APP_LogSlot(head, s_log.wrSlot), (APP_LOG_SLOTS - s_log.wrSlot) * APP_LOG_RECORD_SIZE))
+        {
+            s_log.wrSlot = APP_LOG_SLOTS;
+        }
+    }
+    s_log.aheadErased = APP_LogBlank(APP_LogPageAddr(APP_LogPageNext(s_log.wrPage)), NVM_FLASH_PAGESIZE);
+    s_log.ready = true;
+}
+
+bool APP_LogAppend(uint32_t time, const void *p_data, uint8_t length)
+{
+    APP_LOG_Record_T *p_rec;
+    uint32_t primask;
+
+    if (!s_log.ready || length > APP_LOG_DATA_LEN)
+        return false;
+
+    primask = APP_LogLock();
+    if (s_log.pendCount == APP_LOG_PENDING)
+    {
+        s_log.stats.dropped++;
+        APP_LogUnlock(primask);
+        return false;
+    }
+    if (time < s_log.lastTime)
+        time = s_log.lastTime;
+    s_log.lastTime = time;
+    p_rec = &s_log.pend[(s_log.pendHead + s_log.pendCount) % APP_LOG_PENDING];
+    p_rec->time = time;
+    memcpy(p_rec->data, p_data, length);
+    memset(&p_rec->data[length], 0, APP_LOG_DATA_LEN - length);
+    s_log.pendCount++;
+    s_log.stats.appended++;
+    APP_LogPump();
+    APP_LogUnlock(primask);
+
+    return true;
+}
+
+uint32_t APP_LogFind(uint32_t t0, uint32_t t1, uint32_t *p_firstSeq)
+{
+    uint32_t primask;
+    uint32_t first;
+    uint32_t end;
+
+    primask = APP_LogLock();
+    first = APP_LogSeqAtTime(t0, false);
+    end = (t1 >= t0) ? APP_LogSeqAtTime(t1, true) : first;
+    *p_firstSeq = first;
+    end = (end > first) ? APP_LogCount(first, end) : 0U;
+    APP_LogUnlock(primask);
+
+    return end;
+}
+
+bool APP_LogIsMessage(const uint8_t *p_msg, uint16_t length)
+{
+    return length >= APP_LOG_HDR_LEN && memcmp(p_msg, APP_LOG_MAGIC, APP_LOG_MAGIC_LEN) == 0;
+}
+
+void APP_LogRxMessage(const uint8_t *p_msg, uint16_t length)
+{
+    uint8_t op = p_msg[APP_LOG_MAGIC_LEN];
+    uint32_t primask;
+    uint32_t t0;
+    uint32_t t1;
+    uint32_t first;
+    uint32_t count;
+
+    if (!s_log.ready)
+    {
+        APP_LogRespond(op, APP_LOG_STATUS_BAD_STATE, 0, 0);
+        return;
+    }
+
+    switch (op)
+    {
+        case APP_LOG_OP_QUERY:
+        case APP_LOG_OP_OFFLOAD:
+            if (length != APP_LOG_HDR_LEN + 8)
+            {
+                APP_LogRespond(op, APP_LOG_STATUS_BAD_SIZE, 0, 0);
+                break;
+            }
+            if (op == APP_LOG_OP_OFFLOAD && s_off.active)
+            {
+                APP_LogRespond(op, APP_LOG_STATUS_BAD_STATE, s_off.firstSeq, s_log.stats.offloaded);
+                break;
+            }
+            t0 = APP_FrameGetLe32(&p_msg[APP_LOG_HDR_LEN]);
+            t1 = APP_FrameGetLe32(&p_msg[APP_LOG_HDR_LEN + 4]);
+            count = APP_LogFind(t0, t1, &first);
+            if (op == APP_LOG_OP_QUERY || count == 0U)
+            {
+                APP_LogRespond(op, APP_LOG_STATUS_OK, first, count);
+                break;
+            }
+            primask = APP_LogLock();
+            s_off.endSeq = (t1 >= t0) ? APP_LogSeqAtTime(t1, true) : first;
+            APP_LogUnlock(primask);
+            s_off.active = true;
+            s_off.firstSeq = first;
+            s_off.nextSeq = first;
+            s_off.left = 0;
+            s_off.startTime = APP_LogNowMs();
+            s_log.stats.offloaded = 0;
+            s_log.stats.offloadBytes = 0;
+            s_log.stats.offloadSdus = 0;
+            s_log.stats.offloadStalls = 0;
+            s_log.stats.offloadMs = 0;
+            break;
+
+        case APP_LOG_OP_CANCEL:
+            if (s_off.active)
+                s_off.endSeq = s_off.nextSeq + ((s_off.left != 0U) ? s_off.batchRecords : 0U);
+            APP_LogRespond(op, APP_LOG_STATUS_OK, s_off.firstSeq, s_log.stats.offloaded);
+            break;
+
+        default:
+            APP_LogRespond(op, APP_LOG_STATUS_BAD_STATE, 0, 0);
+            break;
+    }
+}
+
+bool APP_LogTasks(void)
+{
+#if !APP_AEAD_ENABLE
+    uint16_t sduMax;
+    uint16_t size;
+#endif
+
+    if (s_off.rspPending)
+    {
+        s_off.rspPending = !BLECB_Pipe_SendProto(s_off.rsp, APP_LOG_RSP_LEN, NULL, 0);
+        if (s_off.rspPending)
+            return true;
+    }
+    if (!s_off.active)
+        return false;
+
+    if (s_off.left == 0U && !APP_LogBatchStart())
+    {
+        s_off.active = false;
+        s_log.stats.offloadMs = APP_LogNowMs() - s_off.startTime;
+        APP_LogRespond(APP_LOG_OP_OFFLOAD, APP_LOG_STATUS_OK, s_off.firstSeq, s_log.stats.offloaded);
+        return s_off.rspPending;
+    }
+
+#if APP_AEAD_ENABLE
+    /* One sealed TX queue message, so its nonce follows the queue order */
+    if (!BLECB_Pipe_SendProto(&s_off.hdr[2], APP_LOG_HDR_LEN, s_off.p_next, (uint16_t)s_off.left))
+    {
+        s_log.stats.offloadStalls++;
+        return true;
+    }
+    s_log.stats.offloadBytes += s_off.left;
+    s_off.left = 0;
+#else
+    if (!s_off.hdrSent)
+    {
+        if (!BLECB_Pipe_SendSdu(s_off.hdr, sizeof(s_off.hdr)))
+        {
+            s_log.stats.offloadStalls++;
+            return true;
+        }
+        s_off.hdrSent = true;
+        s_log.stats.offloadSdus++;
+    }
+
+    /* The stack copies each SDU, so it is given the flash itself */
+    sduMax = BLECB_Pipe_GetSduMax();
+    while (s_off.left != 0U)
+    {
+        size = (s_off.left < sduMax) ? (uint16_t)s_off.left : sduMax;
+        if (!BLECB_Pipe_SendSdu((uint8_t *)s_off.p_next, size))
+        {
+            s_log.stats.offloadStalls++;
+            return true;
+        }
+        s_off.p_next += size;
+        s_off.left -= size;
+        s_log.stats.offloadBytes += size;
+        s_log.stats.offloadSdus++;
+    }
+#endif
+
+    APP_LogBatchRelease();
+    s_off.nextSeq += s_off.batchRecords;
+    s_log.stats.offloaded += s_off.batchRecords;
+
+    /* The TX queue gets a turn between batches */
+    return true;
+}
+
+bool APP_LogIsSending(void)
+{
+    return s_off.hdrSent && s_off.left != 0U;
+}
+
+void APP_LogAbort(void)
+{
+    if (s_off.left != 0U)
+        APP_LogBatchRelease();
+    s_off.active = false;
+    s_off.left = 0;
+    s_off.hdrSent = false;
+    s_off.rspPending = false;
+}
+
+void APP_LogGetStats(APP_LOG_Stats_T *p_stats)
+{
+    uint32_t primask = APP_LogLock();
+
+    s_log.stats.records = APP_LogCount(0, s_log.nextSeq);
+    s_log.stats.firstSeq = (s_log.used != 0U) ? s_log.page[s_log.tail].firstSeq : s_log.nextSeq;
+    s_log.stats.nextSeq = s_log.nextSeq;
+    *p_stats = s_log.stats;
+    APP_LogUnlock(primask);
+}
+
+#endif /* APP_LOG_ENABLE */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,295 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_log.h
+
+  Summary:
+    Time indexed data log in flash, offloaded in bulk over the pipe.
+
+  Description:
+    With APP_LOG_ENABLE (configuration.h, and the linker macros) the
+    APP_LOG_LENGTH bytes after the PDS journal hold a ring of fixed size
+    records, each with a sequence number and a time given by the caller.
+    APP_LogAppend keeps the record in RAM and programs it through the flash
+    queue (app_flash.h), so the caller does not wait for the flash. The ring
+    advances a page at a time: the page after the one being written is
+    kept erased, and the oldest page is dropped when the ring is full.
+
+    RAM holds one index entry per page: its first sequence number and time
+    and how many records it holds. A time is found with a binary search of
+    the index and one of the records of a page, O(log n) flash reads. The
+    index is rebuilt from flash at start up.
+
+    A phone asks for a time range with a pipe message starting with
+    APP_LOG_MAGIC. The records are sent as batches, each one pipe message of
+    up to APP_LOG_BATCH_MAX bytes: a small header SDU, then SDUs pointing
+    straight into the flash, as many as the credits of the peer allow. The
+    pages of the batch being sent are kept from being erased; records
+    appended meanwhile wait in RAM. With APP_AEAD_ENABLE a batch is instead
+    copied to the TX queue and sealed there like the responses, so it is
+    capped at APP_LOG_SEALED_BATCH_MAX bytes of RAM. tools/log_offload.py
+    asks for and decodes them.
+*******************************************************************************/
+
+#ifndef _APP_LOG_H
+#define _APP_LOG_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+#include "peripheral/nvm/plib_nvm.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Bytes per record, header included: a multiple of the 16 byte quad word
+ * that divides a page. */
+#ifndef APP_LOG_RECORD_SIZE
+#define APP_LOG_RECORD_SIZE             32
+#endif
+
+/* Records held in RAM until the flash queue takes them. */
+#ifndef APP_LOG_PENDING
+#define APP_LOG_PENDING                 8
+#endif
+
+/* Largest offload batch in bytes, at most 64 KB less the header. */
+#ifndef APP_LOG_BATCH_MAX
+#define APP_LOG_BATCH_MAX               (4U * NVM_FLASH_PAGESIZE)
+#endif
+
+/* Largest batch with APP_AEAD_ENABLE, where each batch is copied to a TX
+ * queue buffer to be sealed, at most APP_LOG_BATCH_MAX. */
+#ifndef APP_LOG_SEALED_BATCH_MAX
+#define APP_LOG_SEALED_BATCH_MAX        512U
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Pipe messages, all little endian:
+ *
+ *   magic      4   0x7E 'L' 'O' 'G'
+ *   op         1
+ *   then per op, host to device:
+ *   'Q' query    t0 4, t1 4     count the records with t0 <= time <= t1
+ *   'O' offload  t0 4, t1 4     send them
+ *   'C' cancel                  stop the offload after the batch being sent
+ *
+ *   and device to host:
+ *   'B' batch    records, oldest first, APP_LOG_RECORD_SIZE bytes each
+ *   'R' response request 1, status 1, first sequence 4, count 4
+ *
+ * The offload is answered after its last batch, with the records sent;
+ * records dropped from the ring while it runs are skipped.
+ */
+#define APP_LOG_MAGIC                   "\x7E" "LOG"
+#define APP_LOG_MAGIC_LEN               4
+#define APP_LOG_HDR_LEN                 (APP_LOG_MAGIC_LEN + 1)
+#define APP_LOG_RSP_LEN                 (APP_LOG_HDR_LEN + 10)
+#define APP_LOG_DATA_LEN                (APP_LOG_RECORD_SIZE - 8)
+
+#define APP_LOG_OP_QUERY                'Q'
+#define APP_LOG_OP_OFFLOAD              'O'
+#define APP_LOG_OP_CANCEL               'C'
+#define APP_LOG_OP_BATCH                'B'
+#define APP_LOG_OP_RESPONSE             'R'
+
+#define APP_LOG_STATUS_OK               0x00
+#define APP_LOG_STATUS_BAD_STATE        0x01    /* Log not reserved, or an offload is running */
+#define APP_LOG_STATUS_BAD_SIZE         0x02    /* Message length does not fit the op */
+
+/* A record as it sits in flash. The header quad word is programmed last, so
+ * a record cut short by a reset reads as erased. */
+typedef struct APP_LOG_Record_T
+{
+    uint32_t    seq;
+    uint32_t    time;
+    uint8_t     data[APP_LOG_DATA_LEN];
+} APP_LOG_Record_T;
+
+typedef struct APP_LOG_Stats_T
+{
+    uint32_t    records;                /* Records in the log */
+    uint32_t    firstSeq;               /* Sequence number of the oldest */
+    uint32_t    nextSeq;                /* Of the next record programmed */
+    uint32_t    appended;               /* Taken by APP_LogAppend */
+    uint32_t    dropped;                /* Refused, no room in RAM */
+    uint32_t    failed;                 /* Lost to a program error */
+    uint32_t    eraseFailed;
+    uint32_t    heldByOffload;          /* Times the ring waited for a page being sent */
+    uint32_t    offloaded;              /* Records sent by the last offload */
+    uint32_t    offloadBytes;
+    uint32_t    offloadSdus;            /* 0 with APP_AEAD_ENABLE: batches go through the TX queue */
+    uint32_t    offloadStalls;          /* Times it waited for credits, or for TX queue room */
+    uint32_t    offloadMs;
+} APP_LOG_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_LogInit ( void )
+
+  Summary:
+     Rebuild the index from flash. Call after APP_FlashInit.
+
+  Description:
+     The log stays off when the linker script did not reserve APP_LOG_LENGTH
+     bytes for it.
+*/
+void APP_LogInit(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_LogAppend ( uint32_t time, const void *p_data, uint8_t length )
+
+  Summary:
+     Add a record. From tasks or interrupts.
+
+  Parameters:
+    time   - In units of the caller's choice. The index needs times that do
+             not go back; an earlier time is stored as the last one.
+    p_data - Up to APP_LOG_DATA_LEN bytes, padded with zeros.
+
+  Returns:
+    false if the log is off, length is too large or APP_LOG_PENDING records
+    already wait for the flash.
+*/
+bool APP_LogAppend(uint32_t time, const void *p_data, uint8_t length);
+
+/*******************************************************************************
+  Function:
+    uint32_t APP_LogFind ( uint32_t t0, uint32_t t1, uint32_t *p_firstSeq )
+
+  Summary:
+     Count the records with t0 <= time <= t1.
+
+  Parameters:
+    p_firstSeq - Receives the sequence number of the first one.
+*/
+uint32_t APP_LogFind(uint32_t t0, uint32_t t1, uint32_t *p_firstSeq);
+
+/*******************************************************************************
+  Function:
+    bool APP_LogIsMessage ( const uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Whether a pipe message is a log request.
+*/
+bool APP_LogIsMessage(const uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_LogRxMessage ( const uint8_t *p_msg, uint16_t length )
+
+  Summary:
+     Process a log request. Pipe task only.
+*/
+void APP_LogRxMessage(const uint8_t *p_msg, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    bool APP_LogTasks ( void )
+
+  Summary:
+     Send offload SDUs until the credits run out, or with APP_AEAD_ENABLE
+     queue the next sealed batch, and the responses. Pipe task only.
+
+  Returns:
+    true while there is more to send; the pipe task then waits for credits
+    as for its TX queue.
+*/
+bool APP_LogTasks(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_LogIsSending ( void )
+
+  Summary:
+     Whether a batch is partly sent: the pipe holds its TX queue meanwhile,
+     since the batch is one message.
+*/
+bool APP_LogIsSending(void);
+
+/*******************************************************************************
+  Function:
+    void APP_LogAbort ( void )
+
+  Summary:
+     Drop the offload running, on a disconnection. Pipe task only.
+*/
+void APP_LogAbort(void);
+
+/*******************************************************************************
+  Function:
+    void APP_LogGetStats ( APP_LOG_Stats_T *p_stats )
+
+  Summary:
+     Copy the counters of the log and of the last offload.
+*/
+void APP_LogGetStats(APP_LOG_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_LOG_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,334 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_prof.c
+
+  Summary:
+    Cycle accurate CPU profiler for tasks and interrupts.
+
+  Description:
+    Bookkeeping is done in 32 bit cycle deltas, which is safe as long as no
+    single task run or interrupt lasts longer than one wrap of the counter
+    (67 s at 64 MHz), and accumulated in 64 bits. The hooks run with PRIMASK
+    set for a handful of instructions, because the BLE interrupts sit above
+    configMAX_SYSCALL_INTERRUPT_PRIORITY and may preempt the context switch.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_prof.h"
+#include "app_frame.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_PROF_Acc_T
+{
+    uint64_t    cycles;
+    uint32_t    count;
+    uint32_t    maxCycles;
+} APP_PROF_Acc_T;
+
+typedef struct APP_PROF_Task_T
+{
+    void            *p_task;
+    char            name[configMAX_TASK_NAME_LEN];
+    APP_PROF_Acc_T  acc;
+} APP_PROF_Task_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static const char * const s_isrNames[APP_PROF_ISR_NUM] =
+{
+    "SysTick", "SERCOM0", "SERCOM1", "NVM", "BT_INT0", "BT_INT1", "BT_LC", "BT_RC"
+};
+
+static APP_PROF_Task_T s_tasks[APP_PROF_MAX_TASKS];
+static APP_PROF_Acc_T s_isrs[APP_PROF_ISR_NUM];
+
+static APP_PROF_Task_T *s_p_curTask;
+static uint32_t s_sliceStart;
+static uint32_t s_sliceIsrCycles;
+
+static uint32_t s_isrStart[APP_PROF_MAX_ISR_NESTING];
+static uint32_t s_isrChildCycles[APP_PROF_MAX_ISR_NESTING];
+static uint8_t s_isrDepth;
+
+static TickType_t s_windowStartTick;
+static uint8_t s_report[APP_PROF_REPORT_MAX_SIZE];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_ProfAccumulate(APP_PROF_Acc_T *p_acc, uint32_t cycles)
+{
+    p_acc->cycles += cycles;
+    if (cycles > p_acc->maxCycles)
+    {
+        p_acc->maxCycles = cycles;
+    }
+}
+
+static uint8_t *APP_ProfPutRecord(uint8_t *p_dst, uint8_t kind, const char *p_name, const APP_PROF_Acc_T *p_acc)
+{
+    uint8_t nameLen = (uint8_t)strnlen(p_name, configMAX_TASK_NAME_LEN);
+
+    *p_dst++ = kind;
+    *p_dst++ = nameLen;
+    memcpy(p_dst, p_name, nameLen);
+    p_dst += nameLen;
+    p_dst = APP_FramePutLe64(p_dst, p_acc->cycles);
+    p_dst = APP_FramePutLe32(p_dst, p_acc->count);
+    return APP_FramePutLe32(p_dst, p_acc->maxCycles);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Hooks
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_ProfTaskSwitchedIn(uint32_t taskNumber, void *p_task)
+{
+    APP_PROF_Task_T *p_slot;
+    uint32_t primask = __get_PRIMASK();
+    const char *p_name;
+    uint8_t i;
+
+    __disable_irq();
+    p_slot = &s_tasks[(taskNumber < APP_PROF_MAX_TASKS) ? taskNumber : (APP_PROF_MAX_TASKS - 1)];
+    if (p_slot->p_task != p_task)
+    {
+        // First run of this task: keep a copy of its name for the report
+        p_slot->p_task = p_task;
+        p_name = pcTaskGetName((TaskHandle_t)p_task);
+        for (i = 0; i < configMAX_TASK_NAME_LEN - 1 && p_name[i] != '\0'; i++)
+        {
+            p_slot->name[i] = p_name[i];
+        }
+        p_slot->name[i] = '\0';
+    }
+    p_slot->acc.count++;
+    s_p_curTask = p_slot;
+    s_sliceIsrCycles = 0;
+    s_sliceStart = DWT->CYCCNT;
+    __set_PRIMASK(primask);
+}
+
+void APP_ProfTaskSwitchedOut(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+
+    __disable_irq();
+    now = DWT->CYCCNT;
+    if (s_p_curTask != NULL)
+    {
+        APP_ProfAccumulate(&s_p_curTask->acc, now - s_sliceStart - s_sliceIsrCycles);
+        s_p_curTask = NULL;
+    }
+    __set_PRIMASK(primask);
+}
+
+void APP_ProfIsrEnter(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (s_isrDepth < APP_PROF_MAX_ISR_NESTING)
+    {
+        s_isrChildCycles[s_isrDepth] = 0;
+        s_isrStart[s_isrDepth] = DWT->CYCCNT;
+    }
+    s_isrDepth++;
+    __set_PRIMASK(primask);
+}
+
+void APP_ProfIsrExit(APP_PROF_IsrId_T isrId)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t cycles;
+
+    __disable_irq();
+    s_isrDepth--;
+    if (s_isrDepth < APP_PROF_MAX_ISR_NESTING)
+    {
+        cycles = DWT->CYCCNT - s_isrStart[s_isrDepth];
+        APP_ProfAccumulate(&s_isrs[isrId], cycles - s_isrChildCycles[s_isrDepth]);
+        s_isrs[isrId].count++;
+
+        // Charge the whole interrupt, nested ones included, to whatever it preempted
+        if (s_isrDepth > 0)
+        {
+            s_isrChildCycles[s_isrDepth - 1] += cycles;
+        }
+        else
+        {
+            s_sliceIsrCycles += cycles;
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+#define APP_PROF_ISR_WRAPPER(wrapper, isrId, handler)   \
+    extern void handler(void);                          \
+    void wrapper(void)                                  \
+    {                                                   \
+        APP_ProfIsrEnter();                             \
+        handler();                                      \
+        APP_ProfIsrExit(isrId);                         \
+    }
+
+APP_PROF_ISR_WRAPPER(APP_PROF_SysTick_Handler, APP_PROF_ISR_SYSTICK, xPortSysTickHandler)
+APP_PROF_ISR_WRAPPER(APP_PROF_SERCOM0_Handler, APP_PROF_ISR_SERCOM0, SERCOM0_USART_InterruptHandler)
+#if APP_SPI_HOST_ENABLE
+APP_PROF_ISR_WRAPPER(APP_PROF_SERCOM1_Handler, APP_PROF_ISR_SERCOM1, SERCOM1_SPI_InterruptHandler)
+#endif
+APP_PROF_ISR_WRAPPER(APP_PROF_NVM_Handler,     APP_PROF_ISR_NVM,     NVM_InterruptHandler)
+APP_PROF_ISR_WRAPPER(APP_PROF_BT_INT0_Handler, APP_PROF_ISR_BT_INT0, BT_INT0_Handler)
+APP_PROF_ISR_WRAPPER(APP_PROF_BT_INT1_Handler, APP_PROF_ISR_BT_INT1, BT_INT1_Handler)
+APP_PROF_ISR_WRAPPER(APP_PROF_BT_LC_Handler,   APP_PROF_ISR_BT_LC,   BT_LC_Handler)
+APP_PROF_ISR_WRAPPER(APP_PROF_BT_RC_Handler,   APP_PROF_ISR_BT_RC,   BT_RC_Handler)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_ProfInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    memset(s_tasks, 0, sizeof(s_tasks));
+    s_p_curTask = NULL;
+    s_isrDepth = 0;
+    APP_ProfReset();
+}
+
+void APP_ProfReset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint8_t i;
+
+    __disable_irq();
+    for (i = 0; i < APP_PROF_MAX_TASKS; i++)
+    {
+        memset(&s_tasks[i].acc, 0, sizeof(APP_PROF_Acc_T));
+    }
+    memset(s_isrs, 0, sizeof(s_isrs));
+    s_sliceIsrCycles = 0;
+    s_sliceStart = DWT->CYCCNT;
+    s_windowStartTick = xTaskGetTickCount();
+    __set_PRIMASK(primask);
+}
+
+uint16_t APP_ProfBuildReport(uint8_t *p_buf, uint16_t bufSize)
+{
+    APP_PROF_Task_T tasks[APP_PROF_MAX_TASKS];
+    APP_PROF_Acc_T isrs[APP_PROF_ISR_NUM];
+    APP_PROF_Task_T *p_cur;
+    uint32_t primask;
+    uint32_t wallMs;
+    uint8_t *p_dst;
+    uint8_t records = 0;
+    uint8_t i;
+
+    if (bufSize < APP_PROF_REPORT_MAX_SIZE)
+    {
+        return 0;
+    }
+
+    // Consistent copy; the caller's own run so far is closed as if it switched out now
+    primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(tasks, s_tasks, sizeof(tasks));
+    memcpy(isrs, s_isrs, sizeof(isrs));
+    p_cur = s_p_curTask;
+    if (p_cur != NULL)
+    {
+        APP_ProfAccumulate(&tasks[p_cur - s_tasks].acc, DWT->CYCCNT - s_sliceStart - s_sliceIsrCycles);
+    }
+    wallMs = (xTaskGetTickCount() - s_windowStartTick) * portTICK_PERIOD_MS;
+    __set_PRIMASK(primask);
+
+    p_dst = &p_buf[APP_FRAME_HDR_LEN];
+    p_dst = APP_FramePutLe32(p_dst, configCPU_CLOCK_HZ);
+    p_dst = APP_FramePutLe32(p_dst, wallMs);
+    for (i = 0; i < APP_PROF_MAX_TASKS; i++)
+    {
+        if (tasks[i].p_task != NULL)
+        {
+            p_dst = APP_ProfPutRecord(p_dst, 0, tasks[i].name, &tasks[i].acc);
+            records++;
+        }
+    }
+    for (i = 0; i < APP_PROF_ISR_NUM; i++)
+    {
+        p_dst = APP_ProfPutRecord(p_dst, 1, s_isrNames[i], &isrs[i]);
+        records++;
+    }
+
+    return APP_FrameSeal(p_buf, "PRF", APP_PROF_REPORT_VERSION, records, p_dst);
+}
+
+void APP_ProfSendReport(APP_PROF_WRITE write)
+{
+    uint16_t len = APP_ProfBuildReport(s_report, sizeof(s_report));
+
+    if (len != 0)
+    {
+        write(s_report, len);
+    }
+}
+
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,202 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_prof.h
+
+  Summary:
+    Cycle accurate CPU profiler for tasks and interrupts.
+
+  Description:
+    The DWT cycle counter is read on every FreeRTOS context switch (through
+    the traceTASK_SWITCHED_IN/OUT hooks in freertos_trace_hooks.h) and on
+    entry and exit of the instrumented interrupt handlers (wrappers placed in
+    the vector table in interrupts.c). Interrupt time is subtracted from the task it
+    interrupted and nested interrupts from their parent, so every cycle is
+    charged exactly once.
+
+    The cycle counter stops while the device sleeps in the idle task, so CPU
+    load is computed against wall clock time (tick count), not against the
+    sum of counted cycles.
+
+    The report is a compact binary frame, see APP_ProfBuildReport, decoded on
+    the host by tools/prof_decoder.py.
+*******************************************************************************/
+
+#ifndef _APP_PROF_H
+#define _APP_PROF_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include "freertos_trace_hooks.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* APP_PROF_ENABLE is defaulted in freertos_trace_hooks.h, next to the
+ * context switch hooks it controls. */
+
+/* Tasks tracked individually, by creation order. Later ones share the last entry. */
+#ifndef APP_PROF_MAX_TASKS
+#define APP_PROF_MAX_TASKS              8
+#endif
+
+/* Deepest interrupt nesting accounted separately. */
+#define APP_PROF_MAX_ISR_NESTING        4
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum APP_PROF_IsrId_T
+{
+    APP_PROF_ISR_SYSTICK,
+    APP_PROF_ISR_SERCOM0,
+    APP_PROF_ISR_SERCOM1,
+    APP_PROF_ISR_NVM,
+    APP_PROF_ISR_BT_INT0,
+    APP_PROF_ISR_BT_INT1,
+    APP_PROF_ISR_BT_LC,
+    APP_PROF_ISR_BT_RC,
+
+    APP_PROF_ISR_NUM
+} APP_PROF_IsrId_T;
+
+/* Report frame, all fields little endian:
+ *
+ *   sync       4   0x7E 'P' 'R' 'F'
+ *   version    1   APP_PROF_REPORT_VERSION
+ *   records    1   number of records
+ *   length     2   bytes from version up to the CRC, exclusive
+ *   cpuHz      4   core clock
+ *   wallMs     4   time covered by the report
+ *   records        kind(1: 0 task, 1 isr) nameLen(1) name cycles(8) count(4) maxCycles(4)
+ *   crc        2   CRC-16/CCITT-FALSE from version up to here
+ *
+ * For tasks count is the number of times the task was switched in and
+ * maxCycles the longest single run; for interrupts they are the number of
+ * calls and the longest call. */
+#define APP_PROF_REPORT_VERSION         1
+#define APP_PROF_REPORT_MAX_SIZE        (16 + (APP_PROF_MAX_TASKS + APP_PROF_ISR_NUM) * 34)
+
+typedef void (*APP_PROF_WRITE)(uint8_t *data, uint16_t length);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_ProfInit ( void )
+
+  Summary:
+     Start the DWT cycle counter and clear the statistics. Call before the
+     scheduler starts.
+*/
+void APP_ProfInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_ProfReset ( void )
+
+  Summary:
+     Clear the statistics and start a new measurement window.
+*/
+void APP_ProfReset(void);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_ProfBuildReport ( uint8_t *p_buf, uint16_t bufSize )
+
+  Summary:
+     Serialize the statistics of the current window into a report frame.
+
+  Returns:
+    Frame length, 0 if the buffer is too small.
+*/
+uint16_t APP_ProfBuildReport(uint8_t *p_buf, uint16_t bufSize);
+
+/*******************************************************************************
+  Function:
+    void APP_ProfSendReport ( APP_PROF_WRITE write )
+
+  Summary:
+     Build a report frame in a static buffer and pass it to write, e.g.
+     Debug_Uart_Write_blocking or BLECB_Pipe_SendData.
+*/
+void APP_ProfSendReport(APP_PROF_WRITE write);
+
+/* Hooks, called from the interrupt wrappers only. The context switch hooks
+ * are declared in freertos_trace_hooks.h. */
+void APP_ProfIsrEnter(void);
+void APP_ProfIsrExit(APP_PROF_IsrId_T isrId);
+
+/* Instrumented interrupt handlers referenced by the vector table. */
+void APP_PROF_SysTick_Handler(void);
+void APP_PROF_SERCOM0_Handler(void);
+void APP_PROF_SERCOM1_Handler(void);
+void APP_PROF_NVM_Handler(void);
+void APP_PROF_BT_INT0_Handler(void);
+void APP_PROF_BT_INT1_Handler(void);
+void APP_PROF_BT_LC_Handler(void);
+void APP_PROF_BT_RC_Handler(void);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_PROF_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,160 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_ring.h
+
+  Summary:
+    Lock-free slot reservation for the capture rings.
+
+  Description:
+    The trace, deferred log and btsnoop rings are written from tasks and from
+    every interrupt level, including the BLE interrupts above the syscall
+    priority, so no writer can take a lock. A writer reserves its slots by
+    moving the free running head with LDREX/STREX and then fills them at its
+    own pace; an interrupt between the load and the store makes the store
+    fail and the reservation is retried.
+
+    APP_RingClaim always succeeds and lets the ring overwrite its oldest
+    slots. APP_RingReserve refuses a reservation that would overrun the
+    reader's tail and counts it as dropped instead.
+*******************************************************************************/
+
+#ifndef _APP_RING_H
+#define _APP_RING_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_RingAtomicInc ( volatile uint32_t *p_count )
+
+  Summary:
+     Increment a counter shared with writers at any interrupt level.
+*/
+static inline void APP_RingAtomicInc(volatile uint32_t *p_count)
+{
+    uint32_t n;
+
+    do
+    {
+        n = __LDREXW(p_count);
+    } while (__STREXW(n + 1U, p_count) != 0U);
+}
+
+/*******************************************************************************
+  Function:
+    uint32_t APP_RingClaim ( volatile uint32_t *p_head, uint32_t slots )
+
+  Summary:
+     Reserve slots at the head of an overwriting ring.
+
+  Returns:
+    Free running index of the first reserved slot.
+*/
+static inline uint32_t APP_RingClaim(volatile uint32_t *p_head, uint32_t slots)
+{
+    uint32_t idx;
+
+    do
+    {
+        idx = __LDREXW(p_head);
+    } while (__STREXW(idx + slots, p_head) != 0U);
+    return idx;
+}
+
+/*******************************************************************************
+  Function:
+    bool APP_RingReserve ( volatile uint32_t *p_head, const volatile uint32_t *p_tail,
+                           uint32_t size, uint32_t slots,
+                           volatile uint32_t *p_dropped, uint32_t *p_idx )
+
+  Summary:
+     Reserve slots at the head of a ring of size slots, unless they would
+     overrun the tail. A refused reservation increments *p_dropped.
+
+  Returns:
+    true with the free running index of the first slot in *p_idx.
+*/
+static inline bool APP_RingReserve(volatile uint32_t *p_head, const volatile uint32_t *p_tail,
+                                   uint32_t size, uint32_t slots,
+                                   volatile uint32_t *p_dropped, uint32_t *p_idx)
+{
+    uint32_t idx;
+
+    do
+    {
+        idx = __LDREXW(p_head);
+        if ((idx + slots - *p_tail) > size)
+        {
+            __CLREX();
+            APP_RingAtomicInc(p_dropped);
+            return false;
+        }
+    } while (__STREXW(idx + slots, p_head) != 0U);
+
+    *p_idx = idx;
+    return true;
+}
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_RING_H */
+
+/*******************************************************************************
+ End of File
+ */
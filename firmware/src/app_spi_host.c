@@ -0,0 +1,420 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_spi_host.c
+
+  Summary:
+    SPI slave host interface to the BLECB pipe.
+
+  Description:
+    Every transfer is armed from the end of the previous one, in the SERCOM1
+    interrupt, so the SERCOM never waits for the task. Slave frames are built
+    by the task into two buffers: one is on the wire while the other is being
+    filled. A slave frame stays armed until the host has taken it. Host
+    frames are received into a ring of buffers that the task empties into the
+    pipe; the ISR only checks the header, the CRC is checked by the task.
+
+    The frame counters are free running: s_txPut and s_rxGet are only moved
+    by the task, s_txGet and s_rxPut only by the interrupt.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "peripheral/sercom/spi_slave/plib_sercom1_spi_slave.h"
+#include "blecb_pipe.h"
+#include "app_spi_host.h"
+#include "app_frame.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_SPI_HOST_TX_MASK        (APP_SPI_HOST_TX_RING_SIZE - 1U)
+#define APP_SPI_HOST_IDLE_SIZE      (APP_SPI_HOST_HDR_SIZE + APP_SPI_HOST_CRC_SIZE)
+#define APP_SPI_HOST_TX_FRAMES      2U
+
+/* Pipe data waiting for a slave frame */
+static uint8_t s_txRing[APP_SPI_HOST_TX_RING_SIZE];
+static volatile uint32_t s_txRingHead;
+static volatile uint32_t s_txRingTail;
+
+/* Slave frames */
+static uint8_t s_txFrame[APP_SPI_HOST_TX_FRAMES][APP_SPI_HOST_XFER_SIZE];
+static uint16_t s_txFrameLen[APP_SPI_HOST_TX_FRAMES];
+static uint8_t s_txIdle[APP_SPI_HOST_IDLE_SIZE];
+static volatile uint8_t s_txPut;
+static volatile uint8_t s_txGet;
+
+/* Host frames; s_rxScratch takes the host frame of a transfer that has no buffer */
+static uint8_t s_rxFrame[APP_SPI_HOST_RX_BUFFERS][APP_SPI_HOST_XFER_SIZE];
+static uint8_t s_rxScratch[APP_SPI_HOST_XFER_SIZE];
+static volatile uint8_t s_rxPut;
+static volatile uint8_t s_rxGet;
+
+/* The transfer armed in SERCOM1 */
+static uint16_t s_armedTxLen;
+static volatile bool s_armedData;
+static bool s_armedRx;
+static volatile bool s_hostWaiting;         /* A host frame was refused */
+
+static OSAL_SEM_DECLARE(s_sem);
+static APP_SPI_HOST_Stats_T s_stats;
+static TaskHandle_t xSPI_HOST_Task;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_SpiHostSetDrdy(bool ready)
+{
+#if APP_SPI_HOST_DRDY_PIN != GPIO_PIN_NONE
+    if (ready)
+    {
+        GPIO_PinSet(APP_SPI_HOST_DRDY_PIN);
+    }
+    else
+    {
+        GPIO_PinClear(APP_SPI_HOST_DRDY_PIN);
+    }
+#else
+    (void)ready;
+#endif
+}
+
+/* Arm the next transfer. Runs in the transfer callback or before SERCOM1 is live. */
+static void APP_SpiHostArm(void)
+{
+    uint8_t *p_tx;
+    uint8_t *p_rx;
+    uint8_t flags = 0;
+
+    s_armedData = (s_txPut != s_txGet);
+    if (s_armedData)
+    {
+        p_tx = s_txFrame[s_txGet % APP_SPI_HOST_TX_FRAMES];
+        s_armedTxLen = s_txFrameLen[s_txGet % APP_SPI_HOST_TX_FRAMES];
+    }
+    else
+    {
+        p_tx = s_txIdle;
+        s_armedTxLen = APP_SPI_HOST_IDLE_SIZE;
+    }
+
+    s_armedRx = ((uint8_t)(s_rxPut - s_rxGet) < APP_SPI_HOST_RX_BUFFERS);
+    if (s_armedRx)
+    {
+        p_rx = s_rxFrame[s_rxPut % APP_SPI_HOST_RX_BUFFERS];
+        flags |= APP_SPI_HOST_FLAG_RX_READY;
+    }
+    else
+    {
+        p_rx = s_rxScratch;
+    }
+
+    if ((uint8_t)(s_txPut - s_txGet) > 1U || s_txRingHead != s_txRingTail)
+    {
+        flags |= APP_SPI_HOST_FLAG_PENDING;
+    }
+    p_tx[1] = flags;
+    p_tx[2] = (uint8_t)~flags;
+
+    (void)SERCOM1_SPI_WriteRead(p_tx, s_armedTxLen, p_rx, APP_SPI_HOST_XFER_SIZE);
+    APP_SpiHostSetDrdy(s_armedData || (s_armedRx && s_hostWaiting));
+}
+
+static void APP_SpiHostTransferDone(uintptr_t context)
+{
+    size_t count = SERCOM1_SPI_ReadCountGet();
+    uint8_t *p_rx = s_armedRx ? s_rxFrame[s_rxPut % APP_SPI_HOST_RX_BUFFERS] : s_rxScratch;
+    bool hdrOk;
+    bool post = false;
+    uint16_t len;
+
+    (void)context;
+
+    s_stats.transfers++;
+    if (SERCOM1_SPI_ErrorGet() != SPI_SLAVE_ERROR_NONE)
+    {
+        s_stats.overruns++;
+    }
+
+    hdrOk = (count >= APP_SPI_HOST_HDR_SIZE && p_rx[0] == APP_SPI_HOST_SYNC && (uint8_t)(p_rx[1] ^ p_rx[2]) == 0xFFU);
+    if (!hdrOk && count != 0U)
+    {
+        s_stats.hdrErrors++;
+    }
+
+    // Slave frame: taken unless cut short or held by the host
+    if (s_armedData)
+    {
+        if (count >= s_armedTxLen && !(hdrOk && (p_rx[1] & APP_SPI_HOST_FLAG_HOLD) != 0U))
+        {
+            s_stats.txFrames++;
+            s_stats.txBytes += (uint32_t)s_armedTxLen - APP_SPI_HOST_IDLE_SIZE;
+            s_txGet++;
+            post = true;
+        }
+        else
+        {
+            s_stats.txRetries++;
+        }
+    }
+
+    // Host frame: queued for the task if complete, an empty one is just a poll
+    if (hdrOk)
+    {
+        len = (uint16_t)p_rx[4] | ((uint16_t)p_rx[5] << 8);
+        if (len > APP_SPI_HOST_PAYLOAD_MAX || count < (size_t)len + APP_SPI_HOST_IDLE_SIZE)
+        {
+            s_stats.hdrErrors++;
+        }
+        else if (len == 0U)
+        {
+            // Poll
+        }
+        else if (s_armedRx)
+        {
+            s_rxPut++;
+            s_hostWaiting = false;
+            post = true;
+        }
+        else
+        {
+            s_stats.rxRefused++;
+            s_hostWaiting = true;
+        }
+    }
+
+    APP_SpiHostArm();
+
+    if (post)
+    {
+        (void)OSAL_SEM_PostISR(&s_sem);
+    }
+}
+
+/* Hand queued host frames to the pipe. Returns true if the pipe was full. */
+static bool APP_SpiHostProcessRx(void)
+{
+    uint8_t *p_frame;
+    uint16_t len;
+    uint16_t crc;
+
+    while (s_rxGet != s_rxPut)
+    {
+        p_frame = s_rxFrame[s_rxGet % APP_SPI_HOST_RX_BUFFERS];
+        len = (uint16_t)p_frame[4] | ((uint16_t)p_frame[5] << 8);
+        crc = (uint16_t)p_frame[APP_SPI_HOST_HDR_SIZE + len] | ((uint16_t)p_frame[APP_SPI_HOST_HDR_SIZE + len + 1U] << 8);
+
+        if (crc != APP_FrameCrc16(&p_frame[3], len + 3U))
+        {
+            s_stats.crcErrors++;
+        }
+        else if (p_frame[3] != APP_SPI_HOST_LANE_PIPE)
+        {
+            s_stats.laneDrops++;
+        }
+        else if (!BLECB_Pipe_SendData(&p_frame[APP_SPI_HOST_HDR_SIZE], len))
+        {
+            // Keep the frame; the host is refused once all buffers are waiting
+            s_stats.pipeBusy++;
+            return true;
+        }
+        else
+        {
+            s_stats.rxFrames++;
+            s_stats.rxBytes += len;
+        }
+        s_rxGet++;
+    }
+    return false;
+}
+
+/* Build slave frames from the pipe data while a frame buffer is free. */
+static void APP_SpiHostFillTx(void)
+{
+    uint8_t *p_frame;
+    uint32_t avail;
+    uint32_t offset;
+    uint32_t first;
+    uint16_t len;
+    uint16_t crc;
+
+    while ((uint8_t)(s_txPut - s_txGet) < APP_SPI_HOST_TX_FRAMES && (avail = s_txRingHead - s_txRingTail) != 0U)
+    {
+        p_frame = s_txFrame[s_txPut % APP_SPI_HOST_TX_FRAMES];
+        len = (uint16_t)((avail > APP_SPI_HOST_PAYLOAD_MAX) ? APP_SPI_HOST_PAYLOAD_MAX : avail);
+
+        offset = s_txRingTail & APP_SPI_HOST_TX_MASK;
+        first = APP_SPI_HOST_TX_RING_SIZE - offset;
+        if (first > len)
+        {
+            first = len;
+        }
+        memcpy(&p_frame[APP_SPI_HOST_HDR_SIZE], &s_txRing[offset], first);
+        memcpy(&p_frame[APP_SPI_HOST_HDR_SIZE + first], s_txRing, len - first);
+
+        p_frame[0] = APP_SPI_HOST_SYNC;
+        p_frame[3] = APP_SPI_HOST_LANE_PIPE;
+        p_frame[4] = (uint8_t)len;
+        p_frame[5] = (uint8_t)(len >> 8);
+        crc = APP_FrameCrc16(&p_frame[3], len + 3U);
+        p_frame[APP_SPI_HOST_HDR_SIZE + len] = (uint8_t)crc;
+        p_frame[APP_SPI_HOST_HDR_SIZE + len + 1U] = (uint8_t)(crc >> 8);
+        s_txFrameLen[s_txPut % APP_SPI_HOST_TX_FRAMES] = len + APP_SPI_HOST_IDLE_SIZE;
+
+        s_txRingTail += len;
+        s_txPut++;
+    }
+}
+
+/* Raise data ready for work that appeared after the current transfer was armed. */
+static void APP_SpiHostSignal(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    if ((!s_armedData && s_txPut != s_txGet) ||
+        (s_hostWaiting && (uint8_t)(s_rxPut - s_rxGet) < APP_SPI_HOST_RX_BUFFERS))
+    {
+        APP_SpiHostSetDrdy(true);
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+/**
+ * SPI HOST TASK
+ * @param pvParameters
+ */
+static void _SPI_HOST_Task(void *pvParameters)
+{
+    uint16_t wait = OSAL_WAIT_FOREVER;
+
+    (void)pvParameters;
+
+    while (1)
+    {
+        (void)OSAL_SEM_Pend(&s_sem, wait);
+
+        wait = APP_SpiHostProcessRx() ? APP_SPI_HOST_RETRY_MS : OSAL_WAIT_FOREVER;
+        APP_SpiHostFillTx();
+        APP_SpiHostSignal();
+    }
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_SpiHostInit(void)
+{
+    uint16_t crc;
+
+    s_txRingHead = 0;
+    s_txRingTail = 0;
+    s_txPut = 0;
+    s_txGet = 0;
+    s_rxPut = 0;
+    s_rxGet = 0;
+    s_hostWaiting = false;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    // Empty frame armed when there is nothing to send; the ISR sets the flags
+    s_txIdle[0] = APP_SPI_HOST_SYNC;
+    s_txIdle[3] = APP_SPI_HOST_LANE_PIPE;
+    s_txIdle[4] = 0;
+    s_txIdle[5] = 0;
+    crc = APP_FrameCrc16(&s_txIdle[3], 3);
+    s_txIdle[6] = (uint8_t)crc;
+    s_txIdle[7] = (uint8_t)(crc >> 8);
+
+#if APP_SPI_HOST_DRDY_PIN != GPIO_PIN_NONE
+    GPIO_PinClear(APP_SPI_HOST_DRDY_PIN);
+    GPIO_PinOutputEnable(APP_SPI_HOST_DRDY_PIN);
+#endif
+
+    APP_STATIC_SEM_CREATE_BINARY(&s_sem);
+    SERCOM1_SPI_Initialize();
+    SERCOM1_SPI_CallbackRegister(APP_SpiHostTransferDone, 0);
+    APP_SpiHostArm();
+
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _SPI_HOST_Task,
+            "SPI_HOST_Task",
+            256,
+            NULL,
+            1,
+            &xSPI_HOST_Task);
+}
+
+void APP_SpiHostPipeRx(uint8_t *p_data, uint16_t length)
+{
+    uint32_t offset = s_txRingHead & APP_SPI_HOST_TX_MASK;
+    uint32_t first = APP_SPI_HOST_TX_RING_SIZE - offset;
+
+    // The pipe only delivers once APP_SpiHostTxSpace covers the message
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(&s_txRing[offset], p_data, first);
+    memcpy(s_txRing, &p_data[first], length - first);
+    s_txRingHead += length;
+
+    (void)OSAL_SEM_Post(&s_sem);
+}
+
+uint16_t APP_SpiHostTxSpace(void)
+{
+    return (uint16_t)(APP_SPI_HOST_TX_RING_SIZE - (s_txRingHead - s_txRingTail));
+}
+
+void APP_SpiHostGetStats(APP_SPI_HOST_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+
+
+/*******************************************************************************
+ End of File
+ */
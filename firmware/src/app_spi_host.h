@@ -0,0 +1,203 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_spi_host.h
+
+  Summary:
+    SPI slave host interface to the BLECB pipe.
+
+  Description:
+    An external host drives SERCOM1 as SPI master and exchanges one frame in
+    each direction per transfer (slave select low to high):
+
+      [0xA5][flags][~flags][lane][len lo][len hi][payload (len)][crc lo][crc hi]
+
+    The CRC is CRC-16/CCITT-FALSE over lane, len and payload. The flags are
+    outside the CRC so the slave can set them when it arms the transfer.
+
+    Slave flags: RX_READY means the host frame of this same transfer will be
+    accepted; without it the host resends its frame later. PENDING means the
+    slave has more data queued. Host flags: HOLD asks the slave to send its
+    frame again because the host had no room for it. A slave frame the host
+    did not clock out completely is sent again as well.
+
+    Lane 0 carries pipe data, other lanes are reserved. The host should clock
+    APP_SPI_HOST_XFER_SIZE bytes per transfer, or at least as many as both
+    frames need, and start a transfer whenever it has data or the data ready
+    pin is high. The data ready pin also rises when a refused host frame can
+    be taken; the frame clocked right then may still be empty or refused.
+*******************************************************************************/
+
+#ifndef _APP_SPI_HOST_H
+#define _APP_SPI_HOST_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* APP_SPI_HOST_ENABLE is set in configuration.h, where the interrupt setup
+ * sees it as well. */
+
+/* Largest payload of a frame: one pipe message. */
+#ifndef APP_SPI_HOST_PAYLOAD_MAX
+#define APP_SPI_HOST_PAYLOAD_MAX            (BLE_TRCBPS_DATA_MTU - 2)
+#endif
+
+/* Host frame buffers, a power of two; host frames are refused while all of
+ * them wait for the pipe. */
+#ifndef APP_SPI_HOST_RX_BUFFERS
+#define APP_SPI_HOST_RX_BUFFERS             4
+#endif
+
+/* Pipe data waiting for the host, in bytes. A power of two. */
+#ifndef APP_SPI_HOST_TX_RING_SIZE
+#define APP_SPI_HOST_TX_RING_SIZE           2048
+#endif
+
+/* Data ready output to the host (active high). GPIO_PIN_NONE to poll instead. */
+#ifndef APP_SPI_HOST_DRDY_PIN
+#define APP_SPI_HOST_DRDY_PIN               GPIO_PIN_NONE
+#endif
+
+/* Retry period while the pipe TX queue is full. */
+#ifndef APP_SPI_HOST_RETRY_MS
+#define APP_SPI_HOST_RETRY_MS               5
+#endif
+
+/* Frame layout */
+#define APP_SPI_HOST_SYNC                   0xA5U
+#define APP_SPI_HOST_HDR_SIZE               6U
+#define APP_SPI_HOST_CRC_SIZE               2U
+#define APP_SPI_HOST_XFER_SIZE              (APP_SPI_HOST_HDR_SIZE + APP_SPI_HOST_PAYLOAD_MAX + APP_SPI_HOST_CRC_SIZE)
+
+#define APP_SPI_HOST_FLAG_RX_READY          0x01U       /* Slave: host frame accepted */
+#define APP_SPI_HOST_FLAG_PENDING           0x02U       /* Slave: more data queued */
+#define APP_SPI_HOST_FLAG_HOLD              0x01U       /* Host: resend the slave frame */
+
+#define APP_SPI_HOST_LANE_PIPE              0U
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_SPI_HOST_Stats_T
+{
+    uint32_t    transfers;              /* Slave select cycles */
+    uint32_t    rxFrames;               /* Host frames handed to the pipe */
+    uint32_t    rxBytes;                /* Host payload bytes handed to the pipe */
+    uint32_t    txFrames;               /* Slave frames delivered to the host */
+    uint32_t    txBytes;                /* Slave payload bytes delivered to the host */
+    uint32_t    txRetries;              /* Slave frames sent again */
+    uint32_t    rxRefused;              /* Host frames refused for lack of a buffer */
+    uint32_t    crcErrors;              /* Host frames dropped on a CRC mismatch */
+    uint32_t    hdrErrors;              /* Transfers without a valid host header */
+    uint32_t    laneDrops;              /* Host frames on an unknown lane */
+    uint32_t    overruns;               /* Transfers longer than the RX buffer */
+    uint32_t    pipeBusy;               /* Host frames held back by a full pipe */
+} APP_SPI_HOST_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_SpiHostInit ( void )
+
+  Summary:
+     Set up SERCOM1 as SPI slave, arm the first transfer and create the host
+     interface task.
+*/
+void APP_SpiHostInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_SpiHostPipeRx ( uint8_t *p_data, uint16_t length )
+
+  Summary:
+     Pipe receive callback of the host interface; queues the message for the
+     host. Register APP_SpiHostTxSpace as the pipe sink space.
+*/
+void APP_SpiHostPipeRx(uint8_t *p_data, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_SpiHostTxSpace ( void )
+
+  Summary:
+     Free bytes in the queue towards the host.
+*/
+uint16_t APP_SpiHostTxSpace(void);
+
+/*******************************************************************************
+  Function:
+    void APP_SpiHostGetStats ( APP_SPI_HOST_Stats_T *p_stats )
+
+  Summary:
+     Get the host interface counters.
+*/
+void APP_SpiHostGetStats(APP_SPI_HOST_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_SPI_HOST_H */
+
+/*******************************************************************************
+ End of File
+ */
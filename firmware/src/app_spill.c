@@ -0,0 +1,548 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_spill.c
+
+  Summary:
+    Flash overflow tier behind the pipe TX and RX queues.
+
+  Description:
+    Each FIFO is a byte stream laid over its half of the ring. Positions
+    count bytes since APP_SpillInit and the flash address is the position
+    modulo the FIFO length (4 GB of traffic, well past the endurance of the
+    ring). Rows below programmed are in flash; the rows from there to wr are
+    in the RAM rows, row n in buffer n % APP_SPILL_ROW_BUFFERS, the one
+    holding wr still filling unless wr sits on a row boundary. Pages below
+    erased are erased, or will be before any write to them is run, as the
+    flash queue keeps the order of its operations.
+
+    A record goes at wr, or at the next row when it does not fit in the
+    rest of the current one, which stays 0xFF. It may only open a row with
+    a free RAM buffer, in a page erased or holding nothing still to read,
+    so the ring never overwrites unread data: a full ring refuses records.
+
+    Put runs from any task and the completions in the NVM interrupt, with
+    interrupts masked; Peek, Pop and the recovery from a flash error belong
+    to the pipe task. A flash error drops the whole FIFO rather than hand
+    back a record that may not read as written.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include "definitions.h"
+#include "app_spill.h"
+#include "app_flash.h"
+#include "blecb_pipe.h"
+
+#if APP_SPILL_ENABLE
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_SPILL_ROW                   NVM_FLASH_ROWSIZE
+#define APP_SPILL_PAGE                  NVM_FLASH_PAGESIZE
+#define APP_SPILL_FIFO_LENGTH           (APP_SPILL_LENGTH / APP_SPILL_FIFOS)
+#define APP_SPILL_END_OF_ROW            0xFFFFU
+
+#if (APP_SPILL_LENGTH % (2 * 4096)) != 0 || APP_SPILL_LENGTH < 4 * 4096
+#error APP_SPILL_LENGTH must be an even number of flash pages, 4 or more
+#endif
+#if APP_SPILL_ROW_BUFFERS < 2
+#error APP_SPILL_ROW_BUFFERS must be 2 or more
+#endif
+
+extern uint32_t __app_spill_start;
+extern uint32_t __app_spill_end;
+
+typedef struct APP_SPILL_Ctrl_T
+{
+    uint32_t            base;
+    uint32_t            rd;             /* Oldest record, or a padding before it */
+    uint32_t            wr;             /* End of the records taken */
+    uint32_t            submitted;      /* Rows handed to the flash queue */
+    volatile uint32_t   programmed;     /* Rows completed, in order */
+    uint32_t            erased;
+    uint32_t            records;        /* Between rd and wr */
+    bool                failed;
+
+    /* Current episode, from the first record taken to the FIFO empty again */
+    uint32_t            putFirstMs;
+    uint32_t            putLastMs;
+    uint32_t            readFirstMs;
+    uint32_t            readLastMs;
+    bool                readStarted;
+
+    APP_SPILL_Stats_T   stats;
+    uint32_t            row[APP_SPILL_ROW_BUFFERS][APP_SPILL_ROW / sizeof(uint32_t)];
+} APP_SPILL_Ctrl_T;
+
+static APP_SPILL_Ctrl_T s_spill[APP_SPILL_FIFOS];
+static bool s_spillReady;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t APP_SpillLock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    return primask;
+}
+
+static void APP_SpillUnlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+static uint32_t APP_SpillNowMs(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+static uint32_t APP_SpillRowCeil(uint32_t pos)
+{
+    return (pos + APP_SPILL_ROW - 1U) & ~(APP_SPILL_ROW - 1U);
+}
+
+static uint32_t APP_SpillAddr(const APP_SPILL_Ctrl_T *p_fifo, uint32_t pos)
+{
+    return p_fifo->base + pos % APP_SPILL_FIFO_LENGTH;
+}
+
+static uint8_t *APP_SpillRowBuffer(APP_SPILL_Ctrl_T *p_fifo, uint32_t pos)
+{
+    return (uint8_t *)p_fifo->row[(pos / APP_SPILL_ROW) % APP_SPILL_ROW_BUFFERS];
+}
+
+/* Whether the page at erased holds nothing still to read */
+static bool APP_SpillCanErase(const APP_SPILL_Ctrl_T *p_fifo)
+{
+    return p_fifo->erased + APP_SPILL_PAGE - p_fifo->rd <= APP_SPILL_FIFO_LENGTH;
+}
+
+static void APP_SpillEndEpisode(APP_SPILL_Ctrl_T *p_fifo)
+{
+    p_fifo->stats.spillMs += p_fifo->putLastMs - p_fifo->putFirstMs;
+    if (p_fifo->readStarted)
+        p_fifo->stats.readBackMs += p_fifo->readLastMs - p_fifo->readFirstMs;
+    p_fifo->readStarted = false;
+}
+
+/* Interrupts masked. Drop the records; the rows being filled or programmed
+ * still go to flash, behind the new read position. */
+static void APP_SpillDiscard(APP_SPILL_Ctrl_T *p_fifo)
+{
+    p_fifo->wr = APP_SpillRowCeil(p_fifo->wr);
+    p_fifo->rd = p_fifo->wr;
+    if (p_fifo->records != 0U)
+    {
+        p_fifo->stats.lost += p_fifo->records;
+        p_fifo->records = 0;
+        APP_SpillEndEpisode(p_fifo);
+    }
+    p_fifo->failed = false;
+}
+
+static bool APP_SpillPump(APP_SPILL_Ctrl_T *p_fifo, APP_SPILL_Fifo_T fifo);
+
+/* NVM interrupt */
+static void APP_SpillRowDone(bool ok, uintptr_t context)
+{
+    APP_SPILL_Ctrl_T *p_fifo = &s_spill[context];
+    uint32_t primask = APP_SpillLock();
+
+    p_fifo->programmed += APP_SPILL_ROW;
+    if (ok)
+    {
+        p_fifo->stats.rowsWritten++;
+    }
+    else
+    {
+        p_fifo->stats.flashErrors++;
+        p_fifo->failed = true;
+    }
+    (void)APP_SpillPump(p_fifo, (APP_SPILL_Fifo_T)context);
+    APP_SpillUnlock(primask);
+    BLECB_Pipe_WakeISR();
+}
+
+/* NVM interrupt */
+static void APP_SpillEraseDone(bool ok, uintptr_t context)
+{
+    uint32_t primask;
+
+    if (ok)
+        return;
+
+    /* The rows written to that page fail as well, or read back wrong */
+    primask = APP_SpillLock();
+    s_spill[context].stats.flashErrors++;
+    s_spill[context].failed = true;
+    APP_SpillUnlock(primask);
+    BLECB_Pipe_WakeISR();
+}
+
+/* Interrupts masked. Submit the erases and the closed rows, as far as the
+ * flash queue takes them; false if it refused one. */
+static bool APP_SpillPump(APP_SPILL_Ctrl_T *p_fifo, APP_SPILL_Fifo_T fifo)
+{
+    APP_FLASH_Op_T op;
+    uint32_t closed = p_fifo->wr & ~(APP_SPILL_ROW - 1U);
+
+    while (true)
+    {
+        /* Keep the page after the writer erased, so a burst finds it ready */
+        if ((int32_t)(p_fifo->erased - p_fifo->wr) < (int32_t)APP_SPILL_PAGE && APP_SpillCanErase(p_fifo))
+        {
+            op.type = APP_FLASH_OP_ERASE_PAGE;
+            op.addr = APP_SpillAddr(p_fifo, p_fifo->erased);
+            op.p_data = NULL;
+            op.callback = APP_SpillEraseDone;
+            op.context = fifo;
+            if (!APP_FlashSubmit(&op))
+                return false;
+            p_fifo->erased += APP_SPILL_PAGE;
+            p_fifo->stats.pagesErased++;
+            continue;
+        }
+        /* Rows of a page the reader still holds wait for the next Pop */
+        if (p_fifo->submitted == closed || (int32_t)(p_fifo->erased - p_fifo->submitted) <= 0)
+            return true;
+
+        op.type = APP_FLASH_OP_WRITE_ROW;
+        op.addr = APP_SpillAddr(p_fifo, p_fifo->submitted);
+        op.p_data = (const uint32_t *)APP_SpillRowBuffer(p_fifo, p_fifo->submitted);
+        op.callback = APP_SpillRowDone;
+        op.context = fifo;
+        if (!APP_FlashSubmit(&op))
+            return false;
+        p_fifo->submitted += APP_SPILL_ROW;
+    }
+}
+
+/* Interrupts masked. Position of a record of length bytes, with room for it
+ * checked; false if there is none. */
+static bool APP_SpillPlace(const APP_SPILL_Ctrl_T *p_fifo, uint16_t length, uint32_t *p_pos)
+{
+    uint32_t pos = p_fifo->wr;
+    uint32_t row;
+
+    if (pos % APP_SPILL_ROW + APP_SPILL_HDR_LEN + length > APP_SPILL_ROW)
+        pos = APP_SpillRowCeil(pos);
+    row = pos & ~(APP_SPILL_ROW - 1U);
+
+    /* Its RAM row programmed, or the one filling */
+    if ((row - p_fifo->programmed) / APP_SPILL_ROW >= APP_SPILL_ROW_BUFFERS)
+        return false;
+    /* and its page erased, or free to erase */
+    if ((int32_t)(row - p_fifo->erased) >= 0 && !APP_SpillCanErase(p_fifo))
+        return false;
+    *p_pos = pos;
+    return true;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_SpillInit(void)
+{
+    uint32_t base = (uint32_t)&__app_spill_start;
+    uint8_t fifo;
+
+    memset(s_spill, 0, sizeof(s_spill));
+    s_spillReady = false;
+    if ((uint32_t)&__app_spill_end - base != APP_SPILL_LENGTH || (base & (APP_SPILL_PAGE - 1U)) != 0U)
+        return;
+
+    for (fifo = 0; fifo < APP_SPILL_FIFOS; fifo++)
+    {
+        s_spill[fifo].base = base + fifo * APP_SPILL_FIFO_LENGTH;
+    }
+    s_spillReady = true;
+}
+
+bool APP_SpillIsEmpty(APP_SPILL_Fifo_T fifo)
+{
+    return s_spill[fifo].records == 0U;
+}
+
+bool APP_SpillRoom(APP_SPILL_Fifo_T fifo, uint16_t length)
+{
+    uint32_t primask;
+    uint32_t pos;
+    bool room;
+
+    if (!s_spillReady || length == 0U || length > APP_SPILL_RECORD_MAX)
+        return false;
+
+    primask = APP_SpillLock();
+    room = APP_SpillPlace(&s_spill[fifo], length, &pos);
+    APP_SpillUnlock(primask);
+    return room;
+}
+
+bool APP_SpillPut(APP_SPILL_Fifo_T fifo, const uint8_t *p_data, uint16_t length, uint32_t timestamp)
+{
+    APP_SPILL_Ctrl_T *p_fifo = &s_spill[fifo];
+    uint32_t nowMs = APP_SpillNowMs();
+    uint32_t primask;
+    uint32_t pos;
+    uint8_t *p_rec;
+
+    if (!s_spillReady || length == 0U || length > APP_SPILL_RECORD_MAX)
+    {
+        p_fifo->stats.refused++;
+        return false;
+    }
+
+    primask = APP_SpillLock();
+    if (!APP_SpillPlace(p_fifo, length, &pos))
+    {
+        p_fifo->stats.refused++;
+        APP_SpillUnlock(primask);
+        return false;
+    }
+
+    /* A row starts erased in RAM too, so what is left of it ends it */
+    if (pos % APP_SPILL_ROW == 0U)
+        memset(APP_SpillRowBuffer(p_fifo, pos), 0xFF, APP_SPILL_ROW);
+    p_rec = APP_SpillRowBuffer(p_fifo, pos) + pos % APP_SPILL_ROW;
+    p_rec[0] = (uint8_t)length;
+    p_rec[1] = (uint8_t)(length >> 8);
+    p_rec[2] = (uint8_t)timestamp;
+    p_rec[3] = (uint8_t)(timestamp >> 8);
+    p_rec[4] = (uint8_t)(timestamp >> 16);
+    p_rec[5] = (uint8_t)(timestamp >> 24);
+    memcpy(&p_rec[APP_SPILL_HDR_LEN], p_data, length);
+    p_fifo->wr = pos + APP_SPILL_HDR_LEN + length;
+    if (APP_SPILL_ROW - p_fifo->wr % APP_SPILL_ROW <= APP_SPILL_HDR_LEN)
+        p_fifo->wr = APP_SpillRowCeil(p_fifo->wr);
+
+    if (p_fifo->records == 0U)
+    {
+        p_fifo->stats.episodes++;
+        p_fifo->putFirstMs = nowMs;
+    }
+    p_fifo->putLastMs = nowMs;
+    p_fifo->records++;
+    p_fifo->stats.spilled++;
+    p_fifo->stats.spilledBytes += length;
+    if (p_fifo->wr - p_fifo->rd > p_fifo->stats.peakBytes)
+        p_fifo->stats.peakBytes = p_fifo->wr - p_fifo->rd;
+
+    (void)APP_SpillPump(p_fifo, fifo);
+    APP_SpillUnlock(primask);
+    return true;
+}
+
+const uint8_t *APP_SpillPeek(APP_SPILL_Fifo_T fifo, uint16_t *p_length, uint32_t *p_timestamp)
+{
+    APP_SPILL_Ctrl_T *p_fifo = &s_spill[fifo];
+    const uint8_t *p_rec = NULL;
+    const uint8_t *p_hdr;
+    uint32_t primask = APP_SpillLock();
+    uint16_t length;
+
+    while (p_fifo->records != 0U)
+    {
+        if (APP_SPILL_ROW - p_fifo->rd % APP_SPILL_ROW <= APP_SPILL_HDR_LEN)
+        {
+            p_fifo->rd = APP_SpillRowCeil(p_fifo->rd);
+            continue;
+        }
+        if ((int32_t)(p_fifo->programmed - p_fifo->rd) <= 0)
+        {
+            /* Still in RAM: the row being filled is programmed as it is, so
+             * the read back does not wait for more data to fill it */
+            if (p_fifo->wr % APP_SPILL_ROW != 0U
+                && (p_fifo->wr & ~(APP_SPILL_ROW - 1U)) == (p_fifo->rd & ~(APP_SPILL_ROW - 1U)))
+            {
+                p_fifo->wr = APP_SpillRowCeil(p_fifo->wr);
+                p_fifo->stats.rowsClosedEarly++;
+                (void)APP_SpillPump(p_fifo, fifo);
+            }
+            break;
+        }
+        p_hdr = (const uint8_t *)APP_SpillAddr(p_fifo, p_fifo->rd);
+        length = (uint16_t)(p_hdr[0] | (p_hdr[1] << 8));
+        if (length == APP_SPILL_END_OF_ROW)
+        {
+            p_fifo->rd = APP_SpillRowCeil(p_fifo->rd);
+            continue;
+        }
+        *p_length = length;
+        *p_timestamp = (uint32_t)p_hdr[2] | ((uint32_t)p_hdr[3] << 8) | ((uint32_t)p_hdr[4] << 16) | ((uint32_t)p_hdr[5] << 24);
+        p_rec = &p_hdr[APP_SPILL_HDR_LEN];
+        break;
+    }
+    APP_SpillUnlock(primask);
+    return p_rec;
+}
+
+void APP_SpillPop(APP_SPILL_Fifo_T fifo)
+{
+    APP_SPILL_Ctrl_T *p_fifo = &s_spill[fifo];
+    uint32_t nowMs = APP_SpillNowMs();
+    const uint8_t *p_hdr;
+    uint32_t primask = APP_SpillLock();
+    uint16_t length;
+
+    if (p_fifo->records == 0U)
+    {
+        APP_SpillUnlock(primask);
+        return;
+    }
+
+    p_hdr = (const uint8_t *)APP_SpillAddr(p_fifo, p_fifo->rd);
+    length = (uint16_t)(p_hdr[0] | (p_hdr[1] << 8));
+    p_fifo->rd += APP_SPILL_HDR_LEN + length;
+    p_fifo->records--;
+    p_fifo->stats.readBack++;
+    p_fifo->stats.readBackBytes += length;
+    if (!p_fifo->readStarted)
+    {
+        p_fifo->readStarted = true;
+        p_fifo->readFirstMs = nowMs;
+    }
+    p_fifo->readLastMs = nowMs;
+    if (p_fifo->records == 0U)
+        APP_SpillEndEpisode(p_fifo);
+
+    /* The page left behind may be erased now */
+    (void)APP_SpillPump(p_fifo, fifo);
+    APP_SpillUnlock(primask);
+}
+
+uint16_t APP_SpillTasks(void)
+{
+    uint16_t wait = OSAL_WAIT_FOREVER;
+    uint32_t primask;
+    uint8_t fifo;
+
+    if (!s_spillReady)
+        return wait;
+
+    for (fifo = 0; fifo < APP_SPILL_FIFOS; fifo++)
+    {
+        primask = APP_SpillLock();
+        if (s_spill[fifo].failed)
+            APP_SpillDiscard(&s_spill[fifo]);
+        /* The flash queue was full: try again shortly */
+        if (!APP_SpillPump(&s_spill[fifo], (APP_SPILL_Fifo_T)fifo))
+            wait = 1;
+        APP_SpillUnlock(primask);
+    }
+    return wait;
+}
+
+void APP_SpillReset(void)
+{
+    uint32_t primask;
+    uint8_t fifo;
+
+    for (fifo = 0; fifo < APP_SPILL_FIFOS; fifo++)
+    {
+        primask = APP_SpillLock();
+        APP_SpillDiscard(&s_spill[fifo]);
+        APP_SpillUnlock(primask);
+    }
+}
+
+void APP_SpillGetStats(APP_SPILL_Fifo_T fifo, APP_SPILL_Stats_T *p_stats)
+{
+    const APP_SPILL_Ctrl_T *p_fifo = &s_spill[fifo];
+    uint32_t primask = APP_SpillLock();
+
+    *p_stats = p_fifo->stats;
+    if (p_fifo->records != 0U)
+    {
+        p_stats->usedBytes = p_fifo->wr - p_fifo->rd;
+        p_stats->spillMs += p_fifo->putLastMs - p_fifo->putFirstMs;
+        if (p_fifo->readStarted)
+            p_stats->readBackMs += p_fifo->readLastMs - p_fifo->readFirstMs;
+    }
+    APP_SpillUnlock(primask);
+}
+
+void APP_SpillReport(APP_SPILL_WRITE write)
+{
+    static const char * const s_fifoName[APP_SPILL_FIFOS] = { "TX", "RX" };
+    APP_SPILL_Stats_T stats;
+    uint32_t spillRate;
+    uint32_t readRate;
+    char line[224];
+    int len;
+    uint8_t fifo;
+
+    for (fifo = 0; fifo < APP_SPILL_FIFOS; fifo++)
+    {
+        APP_SpillGetStats((APP_SPILL_Fifo_T)fifo, &stats);
+        spillRate = (stats.spillMs != 0U) ? (uint32_t)((uint64_t)stats.spilledBytes * 1000U / stats.spillMs) : 0U;
+        readRate = (stats.readBackMs != 0U) ? (uint32_t)((uint64_t)stats.readBackBytes * 1000U / stats.readBackMs) : 0U;
+        len = snprintf(line, sizeof(line),
+                       "#SPILL %s %s spilled=%lu/%luB %luB/s readback=%lu/%luB %luB/s used=%lu peak=%lu episodes=%lu refused=%lu lost=%lu rows=%lu early=%lu erases=%lu errors=%lu\n",
+                       s_fifoName[fifo], s_spillReady ? "on" : "off",
+                       (unsigned long)stats.spilled, (unsigned long)stats.spilledBytes, (unsigned long)spillRate,
+                       (unsigned long)stats.readBack, (unsigned long)stats.readBackBytes, (unsigned long)readRate,
+                       (unsigned long)stats.usedBytes, (unsigned long)stats.peakBytes, (unsigned long)stats.episodes,
+                       (unsigned long)stats.refused, (unsigned long)stats.lost, (unsigned long)stats.rowsWritten,
+                       (unsigned long)stats.rowsClosedEarly, (unsigned long)stats.pagesErased,
+                       (unsigned long)stats.flashErrors);
+        if (len > (int)sizeof(line) - 1)
+        {
+            len = sizeof(line) - 1;
+        }
+        write((uint8_t *)line, (uint16_t)len);
+    }
+    write((uint8_t *)"#END\n", 5);
+}
+
+#endif /* APP_SPILL_ENABLE */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,245 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_spill.h
+
+  Summary:
+    Flash overflow tier behind the pipe TX and RX queues.
+
+  Description:
+    With APP_SPILL_ENABLE (configuration.h, and the linker macros) the pipe
+    keeps taking data once a queue is past its RAM watermark: a message
+    given to BLECB_Pipe_SendData while the TX queue is full, or an SDU
+    pulled from TRCBPS while the RX queue is at BLECB_Pipe_RX_PULL_WATERMARK,
+    goes to a FIFO in flash instead, and so does everything after it until
+    that FIFO is empty again. The pipe reads the FIFO back into the queue,
+    oldest first, as the queue drains, so the order is kept end to end.
+
+    Records are collected in RAM, one 1 KB row at a time, and programmed
+    through the flash queue (app_flash.h); a row is also closed early when
+    the read back has caught up with it. Nothing is kept across a reset or
+    a disconnection. Each lap of a FIFO erases its pages once, so a link
+    that spills continuously wears the ring; size it for bursts.
+*******************************************************************************/
+
+#ifndef _APP_SPILL_H
+#define _APP_SPILL_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "configuration.h"
+#include "peripheral/nvm/plib_nvm.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* RAM rows per FIFO: one being filled while the others are programmed. */
+#ifndef APP_SPILL_ROW_BUFFERS
+#define APP_SPILL_ROW_BUFFERS           2
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Record header: length 2, timestamp 4, little endian. A record never
+ * crosses a row, and a length of 0xFFFF (erased) ends the row. */
+#define APP_SPILL_HDR_LEN               6
+#define APP_SPILL_RECORD_MAX            (NVM_FLASH_ROWSIZE - APP_SPILL_HDR_LEN)
+
+typedef enum APP_SPILL_Fifo_T
+{
+    APP_SPILL_TX,                       /* Pipe messages, without the length field */
+    APP_SPILL_RX,                       /* SDUs as TRCBPS gives them */
+    APP_SPILL_FIFOS
+} APP_SPILL_Fifo_T;
+
+typedef struct APP_SPILL_Stats_T
+{
+    uint32_t    spilled;                /* Records taken */
+    uint32_t    spilledBytes;
+    uint32_t    readBack;               /* Records given back */
+    uint32_t    readBackBytes;
+    uint32_t    refused;                /* Ring or RAM rows full: left to the caller */
+    uint32_t    lost;                   /* Dropped on a flash error or a disconnection */
+    uint32_t    usedBytes;              /* Of the ring, now */
+    uint32_t    peakBytes;              /* Most of the ring in use */
+    uint32_t    episodes;               /* Times the FIFO went from empty to used */
+    uint32_t    spillMs;                /* First to last record taken, summed over the episodes */
+    uint32_t    readBackMs;             /* First to last record given back, likewise */
+    uint32_t    rowsWritten;
+    uint32_t    rowsClosedEarly;        /* Programmed before full, for the read back */
+    uint32_t    pagesErased;
+    uint32_t    flashErrors;
+} APP_SPILL_Stats_T;
+
+/* Output for the report; Debug_Uart_Write_blocking and BLECB_Pipe_SendData fit. */
+typedef void (*APP_SPILL_WRITE)(uint8_t *data, uint16_t length);
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_SpillInit ( void )
+
+  Summary:
+     Empty both FIFOs. Called by BLECB_Pipe_Init, after APP_FlashInit.
+*/
+void APP_SpillInit(void);
+
+/*******************************************************************************
+  Function:
+    bool APP_SpillIsEmpty ( APP_SPILL_Fifo_T fifo )
+
+  Summary:
+     Whether nothing is waiting in the FIFO. While something is, the data
+     that follows has to go in it too.
+*/
+bool APP_SpillIsEmpty(APP_SPILL_Fifo_T fifo);
+
+/*******************************************************************************
+  Function:
+    bool APP_SpillRoom ( APP_SPILL_Fifo_T fifo, uint16_t length )
+
+  Summary:
+     Whether APP_SpillPut would take a record of length bytes now.
+*/
+bool APP_SpillRoom(APP_SPILL_Fifo_T fifo, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    bool APP_SpillPut ( APP_SPILL_Fifo_T fifo, const uint8_t *p_data,
+                        uint16_t length, uint32_t timestamp )
+
+  Summary:
+     Add a record of 1 to APP_SPILL_RECORD_MAX bytes. From any task.
+
+  Returns:
+    false if there is no room; the caller keeps the data or drops it.
+*/
+bool APP_SpillPut(APP_SPILL_Fifo_T fifo, const uint8_t *p_data, uint16_t length, uint32_t timestamp);
+
+/*******************************************************************************
+  Function:
+    const uint8_t *APP_SpillPeek ( APP_SPILL_Fifo_T fifo, uint16_t *p_length,
+                                   uint32_t *p_timestamp )
+
+  Summary:
+     The oldest record, in flash, or NULL while none is programmed yet; the
+     flash completion wakes the pipe task. Pipe task only.
+*/
+const uint8_t *APP_SpillPeek(APP_SPILL_Fifo_T fifo, uint16_t *p_length, uint32_t *p_timestamp);
+
+/*******************************************************************************
+  Function:
+    void APP_SpillPop ( APP_SPILL_Fifo_T fifo )
+
+  Summary:
+     Drop the record returned by APP_SpillPeek, once copied. Pipe task only.
+*/
+void APP_SpillPop(APP_SPILL_Fifo_T fifo);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_SpillTasks ( void )
+
+  Summary:
+     Submit the writes and erases the flash queue refused, and drop the
+     FIFO contents after a flash error. Pipe task only.
+
+  Returns:
+    Longest time the pipe task may sleep, OSAL_WAIT_FOREVER when nothing
+    is left to submit.
+*/
+uint16_t APP_SpillTasks(void);
+
+/*******************************************************************************
+  Function:
+    void APP_SpillReset ( void )
+
+  Summary:
+     Drop the contents of both FIFOs, on a disconnection. Pipe task only.
+*/
+void APP_SpillReset(void);
+
+/*******************************************************************************
+  Function:
+    void APP_SpillGetStats ( APP_SPILL_Fifo_T fifo, APP_SPILL_Stats_T *p_stats )
+
+  Summary:
+     Copy the counters of a FIFO, the episode running included.
+*/
+void APP_SpillGetStats(APP_SPILL_Fifo_T fifo, APP_SPILL_Stats_T *p_stats);
+
+/*******************************************************************************
+  Function:
+    void APP_SpillReport ( APP_SPILL_WRITE write )
+
+  Summary:
+     Write one line per FIFO with its counters and the spill and read back
+     rates, in bytes per second of the time spent at each.
+*/
+void APP_SpillReport(APP_SPILL_WRITE write);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_SPILL_H */
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,234 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_static.c
+
+  Summary:
+    FIFO block arenas for the static allocation build.
+
+  Description:
+    Each block starts with a header word holding the block size in bytes,
+    header included, and APP_STATIC_ARENA_FREED once it is freed. A block
+    that does not fit before the end of the ring is placed at offset 0. The
+    gap it leaves gets a header already marked free, so the tail steps over
+    it like any other freed block. head == tail means an empty arena when
+    used is 0 and a full one otherwise. Arenas are shared between tasks, so
+    every update is made inside a short critical section.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdio.h>
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_STATIC_ARENA_HDR        4U
+#define APP_STATIC_ARENA_FREED      0x80000000UL
+
+static APP_STATIC_Arena_T *sp_arenaList;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t *APP_StaticArenaHdr(APP_STATIC_Arena_T *p_arena, uint32_t offset)
+{
+    return (uint32_t *)(void *)&p_arena->p_mem[offset];
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_StaticArenaInit(APP_STATIC_Arena_T *p_arena, const char *p_name, uint8_t *p_mem, uint32_t size)
+{
+    OSAL_CRITSECT_DATA_TYPE critStatus;
+    bool listed = (p_arena->p_mem != NULL);
+
+    p_arena->p_name = p_name;
+    p_arena->p_mem = p_mem;
+    p_arena->size = size & ~3UL;
+    p_arena->head = 0;
+    p_arena->tail = 0;
+    p_arena->used = 0;
+    p_arena->peak = 0;
+    p_arena->fails = 0;
+
+    if (!listed)
+    {
+        critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+        p_arena->p_next = sp_arenaList;
+        sp_arenaList = p_arena;
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critStatus);
+    }
+}
+
+void *APP_StaticArenaAlloc(APP_STATIC_Arena_T *p_arena, uint32_t length)
+{
+    OSAL_CRITSECT_DATA_TYPE critStatus;
+    uint32_t need;
+    uint32_t gap = 0;
+    uint32_t offset;
+    bool fits;
+
+    need = ((length + 3UL) & ~3UL) + APP_STATIC_ARENA_HDR;
+
+    critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+
+    if (p_arena->used == 0U)
+    {
+        // Restart at 0 so that large blocks are not split by the wrap
+        p_arena->head = 0;
+        p_arena->tail = 0;
+    }
+
+    if (p_arena->used == p_arena->size)
+    {
+        fits = false;
+    }
+    else if (p_arena->head >= p_arena->tail)
+    {
+        if (need <= p_arena->size - p_arena->head)
+        {
+            fits = true;
+        }
+        else
+        {
+            gap = p_arena->size - p_arena->head;
+            fits = (need <= p_arena->tail);
+        }
+    }
+    else
+    {
+        fits = (need <= p_arena->tail - p_arena->head);
+    }
+
+    if (!fits)
+    {
+        p_arena->fails++;
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critStatus);
+        return NULL;
+    }
+
+    if (gap != 0U)
+    {
+        *APP_StaticArenaHdr(p_arena, p_arena->head) = gap | APP_STATIC_ARENA_FREED;
+        p_arena->used += gap;
+        p_arena->head = 0;
+    }
+
+    offset = p_arena->head;
+    *APP_StaticArenaHdr(p_arena, offset) = need;
+    p_arena->head += need;
+    if (p_arena->head == p_arena->size)
+    {
+        p_arena->head = 0;
+    }
+    p_arena->used += need;
+    if (p_arena->used > p_arena->peak)
+    {
+        p_arena->peak = p_arena->used;
+    }
+
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critStatus);
+
+    return &p_arena->p_mem[offset + APP_STATIC_ARENA_HDR];
+}
+
+void APP_StaticArenaFree(APP_STATIC_Arena_T *p_arena, void *p_block)
+{
+    OSAL_CRITSECT_DATA_TYPE critStatus;
+    uint32_t hdr;
+
+    if (p_block == NULL)
+    {
+        return;
+    }
+
+    critStatus = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+
+    *((uint32_t *)p_block - 1) |= APP_STATIC_ARENA_FREED;
+
+    while (p_arena->used != 0U)
+    {
+        hdr = *APP_StaticArenaHdr(p_arena, p_arena->tail);
+        if ((hdr & APP_STATIC_ARENA_FREED) == 0U)
+        {
+            break;
+        }
+        hdr &= ~APP_STATIC_ARENA_FREED;
+        p_arena->used -= hdr;
+        p_arena->tail += hdr;
+        if (p_arena->tail == p_arena->size)
+        {
+            p_arena->tail = 0;
+        }
+    }
+
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critStatus);
+}
+
+void APP_StaticArenaDump(APP_STATIC_WRITE write)
+{
+    APP_STATIC_Arena_T *p_arena;
+    char line[96];
+    int len;
+
+    for (p_arena = sp_arenaList; p_arena != NULL; p_arena = p_arena->p_next)
+    {
+        len = snprintf(line, sizeof(line), "#ARENA %s size=%lu used=%lu peak=%lu fails=%lu\n",
+                       p_arena->p_name, (unsigned long)p_arena->size, (unsigned long)p_arena->used,
+                       (unsigned long)p_arena->peak, (unsigned long)p_arena->fails);
+        if (len > (int)sizeof(line) - 1)
+        {
+            len = sizeof(line) - 1;
+        }
+        write((uint8_t *)line, (uint16_t)len);
+    }
+}
+
+
+/*******************************************************************************
+ End of File
+ */
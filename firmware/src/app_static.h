@@ -0,0 +1,242 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_static.h
+
+  Summary:
+    Static allocation of the application tasks, queues and data buffers.
+
+  Description:
+    With APP_STATIC_ALLOC set in configuration.h, the tasks, queues and
+    semaphores of the application and the pipe are created with the FreeRTOS
+    ...Static() calls on storage reserved at link time. The pipe and TRCBPS
+    data buffers come from fixed arenas instead of the heap. With
+    APP_STATIC_ALLOC at 0 the create macros expand to the dynamic calls, so
+    callers are written once for both builds.
+
+    The storage goes into one linker output section per group:
+
+      .app_static_tasks     task stacks
+      .app_static_queues    queue and message buffer storage
+      .app_static_pipe      pipe TX/RX arenas and message reassembly buffer
+      .app_static_trcbps    TRCBPS receive arena
+
+    WBZ451.ld fails the link when a group exceeds its budget, and the memory
+    usage report of the link lists each group. tools/mem_budget.py
+    summarizes a map file against the budgets. These sections are not zeroed
+    at startup. Kernel control blocks and arena descriptors stay in .bss.
+
+    An arena hands out blocks in FIFO order from a ring. Blocks may be freed
+    in any order, but space is only reclaimed up to the oldest block still
+    in use. That fits queues, which free mostly in order.
+*******************************************************************************/
+
+#ifndef _APP_STATIC_H
+#define _APP_STATIC_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include "configuration.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "message_buffer.h"
+#include "osal/osal_freertos_extend.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef void (*APP_STATIC_WRITE)(uint8_t *data, uint16_t length);
+
+typedef struct APP_STATIC_Arena_T
+{
+    const char                  *p_name;
+    uint8_t                     *p_mem;
+    uint32_t                    size;       /* Multiple of 4 */
+    uint32_t                    head;       /* Offset of the next block */
+    uint32_t                    tail;       /* Offset of the oldest block */
+    uint32_t                    used;       /* Bytes between tail and head, headers and wrap gap included */
+    uint32_t                    peak;
+    uint32_t                    fails;
+    struct APP_STATIC_Arena_T   *p_next;
+} APP_STATIC_Arena_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Storage Macros
+// *****************************************************************************
+// *****************************************************************************
+
+/* Place a zero initialised object in the group's linker section */
+#define APP_STATIC_SECTION(group) \
+    __attribute__((section(".bss.app_static_" #group), aligned(8)))
+
+/* Arena descriptor plus its storage; pass it to APP_StaticArenaInit */
+#define APP_STATIC_ARENA_DEFINE(arena, group, size) \
+    static uint8_t arena##_mem[((size) + 3U) & ~3U] APP_STATIC_SECTION(group); \
+    static APP_STATIC_Arena_T arena
+
+#if APP_STATIC_ALLOC
+
+/* Each expansion owns its storage: call these once per object. They return
+ * pdPASS / OSAL_RESULT_TRUE / the handle like the calls they replace. */
+#define APP_STATIC_TASK_CREATE(fn, name, depth, param, prio, p_handle) \
+    ({  static StackType_t s_appStaticStack[(depth)] APP_STATIC_SECTION(tasks); \
+        static StaticTask_t s_appStaticTcb; \
+        TaskHandle_t *p_appStaticHandle = (p_handle); \
+        TaskHandle_t appStaticHandle = xTaskCreateStatic((fn), (name), (depth), (param), (prio), \
+                                                         s_appStaticStack, &s_appStaticTcb); \
+        if (p_appStaticHandle != NULL) { *p_appStaticHandle = appStaticHandle; } \
+        (appStaticHandle != NULL) ? pdPASS : pdFAIL; })
+
+#define APP_STATIC_QUEUE_CREATE(p_queue, length, itemSize) \
+    ({  static uint8_t s_appStaticQueueMem[(length) * (itemSize)] APP_STATIC_SECTION(queues); \
+        static StaticQueue_t s_appStaticQueue; \
+        *(p_queue) = xQueueCreateStatic((length), (itemSize), s_appStaticQueueMem, &s_appStaticQueue); \
+        (*(p_queue) != NULL) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE; })
+
+/* Binary semaphore created empty */
+#define APP_STATIC_SEM_CREATE_BINARY(p_sem) \
+    ({  static StaticSemaphore_t s_appStaticSem; \
+        *(p_sem) = xSemaphoreCreateBinaryStatic(&s_appStaticSem); \
+        (*(p_sem) != NULL) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE; })
+
+#define APP_STATIC_MUTEX_CREATE(p_mutex) \
+    ({  static StaticSemaphore_t s_appStaticMutex; \
+        *(p_mutex) = xSemaphoreCreateMutexStatic(&s_appStaticMutex); \
+        (*(p_mutex) != NULL) ? OSAL_RESULT_TRUE : OSAL_RESULT_FALSE; })
+
+#define APP_STATIC_MSGBUF_CREATE(size) \
+    ({  static uint8_t s_appStaticMsgBufMem[(size) + 1U] APP_STATIC_SECTION(queues); \
+        static StaticMessageBuffer_t s_appStaticMsgBuf; \
+        xMessageBufferCreateStatic((size), s_appStaticMsgBufMem, &s_appStaticMsgBuf); })
+
+#else
+
+#define APP_STATIC_TASK_CREATE(fn, name, depth, param, prio, p_handle) \
+    xTaskCreate((fn), (name), (depth), (param), (prio), (p_handle))
+
+#define APP_STATIC_QUEUE_CREATE(p_queue, length, itemSize) \
+    OSAL_QUEUE_Create((p_queue), (length), (itemSize))
+
+#define APP_STATIC_SEM_CREATE_BINARY(p_sem) \
+    OSAL_SEM_Create((p_sem), OSAL_SEM_TYPE_BINARY, 1, 0)
+
+#define APP_STATIC_MUTEX_CREATE(p_mutex) \
+    OSAL_MUTEX_Create((p_mutex))
+
+#define APP_STATIC_MSGBUF_CREATE(size) \
+    xMessageBufferCreate((size))
+
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_StaticArenaInit ( APP_STATIC_Arena_T *p_arena, const char *p_name,
+                               uint8_t *p_mem, uint32_t size )
+
+  Summary:
+     Set up an empty arena on p_mem and add it to the APP_StaticArenaDump
+     list. size is rounded down to a multiple of 4. Blocks still taken from
+     the arena are lost when it is initialised again.
+*/
+void APP_StaticArenaInit(APP_STATIC_Arena_T *p_arena, const char *p_name, uint8_t *p_mem, uint32_t size);
+
+/*******************************************************************************
+  Function:
+    void *APP_StaticArenaAlloc ( APP_STATIC_Arena_T *p_arena, uint32_t length )
+
+  Summary:
+     Take a 4 byte aligned block of length bytes.
+
+  Description:
+     Safe from any task. The block costs length rounded up to 4, plus a 4
+     byte header. A block that does not fit before the end of the ring
+     leaves the rest of the ring unused until the tail passes it.
+
+  Returns:
+    NULL when the arena has no room; the fail counter is incremented.
+*/
+void *APP_StaticArenaAlloc(APP_STATIC_Arena_T *p_arena, uint32_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_StaticArenaFree ( APP_STATIC_Arena_T *p_arena, void *p_block )
+
+  Summary:
+     Return a block taken from p_arena. NULL is ignored.
+*/
+void APP_StaticArenaFree(APP_STATIC_Arena_T *p_arena, void *p_block);
+
+/*******************************************************************************
+  Function:
+    void APP_StaticArenaDump ( APP_STATIC_WRITE write )
+
+  Summary:
+     Write one "#ARENA <name> size=<B> used=<B> peak=<B> fails=<n>" line per
+     initialised arena.
+*/
+void APP_StaticArenaDump(APP_STATIC_WRITE write);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_STATIC_H */
+
+/*******************************************************************************
+ End of File
+ */
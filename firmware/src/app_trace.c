@@ -0,0 +1,202 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_trace.c
+
+  Summary:
+    Binary event trace ring: payload events, control and drain.
+
+  Description:
+    The single event recorder is inline in app_trace.h. This file holds the
+    ring itself, the multi slot payload recorder used for the BT system
+    traces and the framing of the drained events.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_trace.h"
+#include "app_frame.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global Data
+// *****************************************************************************
+// *****************************************************************************
+
+APP_TRACE_Ring_T g_appTraceRing;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static uint8_t s_frame[APP_TRACE_FRAME_MAX_SIZE];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static void APP_TraceBtSysCb(uint8_t length, uint8_t *p_tracePayload)
+{
+    APP_TraceRecordData(APP_TRACE_EVT_BT_SYS, p_tracePayload, length);
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_TraceRecordData(uint8_t id, const uint8_t *p_data, uint8_t len)
+{
+    APP_TRACE_Evt_T *p_evt;
+    uint8_t chunk[8];
+    uint32_t idx;
+    uint32_t slots;
+    uint32_t i;
+    uint8_t pos;
+
+    if (!g_appTraceRing.enabled)
+    {
+        return;
+    }
+    if (len > APP_TRACE_DATA_MAX)
+    {
+        len = APP_TRACE_DATA_MAX;
+    }
+
+    // First slot carries the length and two bytes, every continuation seven more
+    slots = 1U + ((len > 2U) ? ((len - 2U + 6U) / 7U) : 0U);
+    idx = APP_RingClaim(&g_appTraceRing.head, slots);
+
+    p_evt = &g_appTraceRing.evt[idx & (APP_TRACE_RING_EVENTS - 1U)];
+    p_evt->ts = DWT->CYCCNT;
+    p_evt->info = (uint32_t)id | ((uint32_t)len << 8) |
+                  ((len > 0U) ? ((uint32_t)p_data[0] << 16) : 0U) |
+                  ((len > 1U) ? ((uint32_t)p_data[1] << 24) : 0U);
+
+    pos = 2;
+    for (i = 1; i < slots; i++)
+    {
+        memset(chunk, 0, sizeof(chunk));
+        memcpy(chunk, &p_data[pos], ((len - pos) < 7U) ? (len - pos) : 7U);
+        pos += 7;
+
+        p_evt = &g_appTraceRing.evt[(idx + i) & (APP_TRACE_RING_EVENTS - 1U)];
+        p_evt->ts = (uint32_t)chunk[0] | ((uint32_t)chunk[1] << 8) | ((uint32_t)chunk[2] << 16) | ((uint32_t)chunk[3] << 24);
+        p_evt->info = (uint32_t)APP_TRACE_EVT_DATA | ((uint32_t)chunk[4] << 8) | ((uint32_t)chunk[5] << 16) | ((uint32_t)chunk[6] << 24);
+    }
+}
+
+void APP_TraceInit(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    g_appTraceRing.head = 0;
+    g_appTraceRing.enabled = (APP_TRACE_ENABLE != 0);
+}
+
+void APP_TraceStart(void)
+{
+    g_appTraceRing.enabled = (APP_TRACE_ENABLE != 0);
+#if (APP_TRACE_BT_SYS_MASK != 0)
+    BT_SYS_TraceEnable(APP_TRACE_BT_SYS_MASK, APP_TraceBtSysCb);
+#else
+    (void)APP_TraceBtSysCb;
+#endif
+}
+
+void APP_TraceStop(void)
+{
+    g_appTraceRing.enabled = false;
+#if (APP_TRACE_BT_SYS_MASK != 0)
+    BT_SYS_TraceEnable(0, APP_TraceBtSysCb);
+#endif
+}
+
+void APP_TraceDrain(APP_TRACE_WRITE write)
+{
+    bool wasEnabled = g_appTraceRing.enabled;
+    uint32_t head;
+    uint32_t seq;
+    uint32_t n;
+    uint32_t i;
+    uint8_t *p_dst;
+    uint16_t len;
+
+    g_appTraceRing.enabled = false;
+    __DMB();
+    head = g_appTraceRing.head;
+    seq = (head > APP_TRACE_RING_EVENTS) ? (head - APP_TRACE_RING_EVENTS) : 0U;
+
+    do
+    {
+        n = head - seq;
+        if (n > APP_TRACE_CHUNK_EVENTS)
+        {
+            n = APP_TRACE_CHUNK_EVENTS;
+        }
+
+        p_dst = APP_FramePutLe32(&s_frame[APP_FRAME_HDR_LEN], configCPU_CLOCK_HZ);
+        p_dst = APP_FramePutLe32(p_dst, seq);
+        p_dst = APP_FramePutLe32(p_dst, head);
+        for (i = 0; i < n; i++)
+        {
+            const APP_TRACE_Evt_T *p_evt = &g_appTraceRing.evt[(seq + i) & (APP_TRACE_RING_EVENTS - 1U)];
+
+            p_dst = APP_FramePutLe32(p_dst, p_evt->ts);
+            p_dst = APP_FramePutLe32(p_dst, p_evt->info);
+        }
+        seq += n;
+
+        len = APP_FrameSeal(s_frame, "TRC", APP_TRACE_FRAME_VERSION, (seq == head) ? 0x01 : 0x00, p_dst);
+        write(s_frame, len);
+    } while (seq != head);
+
+    g_appTraceRing.head = 0;
+    g_appTraceRing.enabled = wasEnabled;
+}
+
+
+/*******************************************************************************
+ End of File
+ */
@@ -0,0 +1,263 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_trace.h
+
+  Summary:
+    Binary event trace ring for the data path.
+
+  Description:
+    Events are 8 bytes: the DWT cycle counter and a packed id/aux/arg word.
+    Recording one takes about 10 cycles and no lock: the slot is reserved by
+    an LDREX/STREX increment of the write index (APP_RingClaim in app_ring.h),
+    so tasks and interrupts of any priority, including the BLE interrupts
+    above configMAX_SYSCALL_INTERRUPT_PRIORITY, can record concurrently. The ring
+    overwrites its oldest events; the write index keeps counting, so the host
+    sees how many were lost.
+
+    The ring is drained on request over the debug UART or the pipe in CRC
+    protected frames (see APP_TraceDrain) and converted to Chrome trace /
+    Perfetto JSON by tools/trace_to_json.py.
+
+    Timestamps are core cycles. The counter does not advance while the device
+    sleeps, so gaps in which the idle task slept appear compressed.
+*******************************************************************************/
+
+#ifndef _APP_TRACE_H
+#define _APP_TRACE_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "device.h"
+#include "app_ring.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Build the trace points in. With 0 APP_TRACE() compiles to nothing. */
+#ifndef APP_TRACE_ENABLE
+#define APP_TRACE_ENABLE                1
+#endif
+
+/* Ring size in events, a power of two. 512 events take 4 KB of RAM. */
+#ifndef APP_TRACE_RING_EVENTS
+#define APP_TRACE_RING_EVENTS           512
+#endif
+
+/* Events per drained frame; keeps a frame within one pipe message. */
+#ifndef APP_TRACE_CHUNK_EVENTS
+#define APP_TRACE_CHUNK_EVENTS          64
+#endif
+
+/* BT_SYS_TRACE_MASK bits enabled by APP_TraceStart; 0 leaves stack traces off. */
+#ifndef APP_TRACE_BT_SYS_MASK
+#define APP_TRACE_BT_SYS_MASK           0
+#endif
+
+/* Longest BT system trace payload recorded, longer ones are truncated. */
+#define APP_TRACE_DATA_MAX              128
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Event identifiers. Values are part of the drain format, append only. */
+typedef enum APP_TRACE_EvtId_T
+{
+    APP_TRACE_EVT_NONE = 0,
+    APP_TRACE_EVT_PIPE_TX_ENQ,          /* arg: length, aux: free TX queue slots */
+    APP_TRACE_EVT_PIPE_TX_DEQ,          /* arg: length, aux: free TX queue slots */
+    APP_TRACE_EVT_PIPE_RX_ENQ,          /* arg: length, aux: free RX queue slots */
+    APP_TRACE_EVT_PIPE_RX_DEQ,          /* arg: length, aux: free RX queue slots */
+    APP_TRACE_EVT_SDU_TX,               /* arg: length, aux: 0 sent, 1 rejected by the stack */
+    APP_TRACE_EVT_SDU_RX,               /* arg: length, aux: L2CAP instance */
+    APP_TRACE_EVT_CREDIT_GRANT,         /* arg: length of the SDU taken from TRCBPS, whose credits go back to the peer, aux: 0 */
+    APP_TRACE_EVT_CREDIT_RECV,          /* arg: credits received from the peer, aux: L2CAP instance */
+    APP_TRACE_EVT_STACK_EVT,            /* arg: event id, aux: STACK_GRP_xxx */
+    APP_TRACE_EVT_HEAP_ALLOC,           /* arg: size, aux: OSAL_MEM_TAG_xxx */
+    APP_TRACE_EVT_HEAP_FREE,            /* arg: size, aux: OSAL_MEM_TAG_xxx, 0xFF if unknown */
+    APP_TRACE_EVT_HEAP_FAIL,            /* arg: size, aux: OSAL_MEM_TAG_xxx */
+    APP_TRACE_EVT_BT_SYS,               /* arg: payload bytes 0-1, aux: payload length */
+    APP_TRACE_EVT_DATA,                 /* continuation of the previous event, 7 payload bytes */
+    APP_TRACE_EVT_MARK,                 /* arg/aux: free for ad hoc markers */
+} APP_TRACE_EvtId_T;
+
+typedef struct APP_TRACE_Evt_T
+{
+    uint32_t            ts;             /* DWT cycle counter */
+    uint32_t            info;           /* id | aux << 8 | arg << 16 */
+} APP_TRACE_Evt_T;
+
+typedef struct APP_TRACE_Ring_T
+{
+    volatile uint32_t   head;           /* Events recorded since the last drain */
+    volatile bool       enabled;
+    APP_TRACE_Evt_T     evt[APP_TRACE_RING_EVENTS];
+} APP_TRACE_Ring_T;
+
+/* Drained frame, all fields little endian:
+ *
+ *   sync       4   0x7E 'T' 'R' 'C'
+ *   version    1   APP_TRACE_FRAME_VERSION
+ *   flags      1   bit 0: last frame of the drain
+ *   length     2   bytes from version up to the CRC, exclusive
+ *   cpuHz      4   core clock
+ *   seq        4   sequence number of the first event in the frame
+ *   head       4   events recorded in the drained window, lost ones included
+ *   events         APP_TRACE_Evt_T, 8 bytes each
+ *   crc        2   CRC-16/CCITT-FALSE from version up to here
+ */
+#define APP_TRACE_FRAME_VERSION         1
+#define APP_TRACE_FRAME_MAX_SIZE        (20 + APP_TRACE_CHUNK_EVENTS * 8 + 2)
+
+typedef void (*APP_TRACE_WRITE)(uint8_t *data, uint16_t length);
+
+extern APP_TRACE_Ring_T g_appTraceRing;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_TraceRecord ( uint8_t id, uint8_t aux, uint16_t arg )
+
+  Summary:
+     Record one event. Callable from any context. Use the APP_TRACE macro so
+     the call disappears with APP_TRACE_ENABLE 0.
+*/
+static inline void APP_TraceRecord(uint8_t id, uint8_t aux, uint16_t arg)
+{
+    APP_TRACE_Evt_T *p_evt;
+    uint32_t idx;
+
+    if (!g_appTraceRing.enabled)
+    {
+        return;
+    }
+    idx = APP_RingClaim(&g_appTraceRing.head, 1U);
+    p_evt = &g_appTraceRing.evt[idx & (APP_TRACE_RING_EVENTS - 1U)];
+    p_evt->ts = DWT->CYCCNT;
+    p_evt->info = (uint32_t)id | ((uint32_t)aux << 8) | ((uint32_t)arg << 16);
+}
+
+#if APP_TRACE_ENABLE
+#define APP_TRACE(id, aux, arg)         APP_TraceRecord((uint8_t)(id), (uint8_t)(aux), (uint16_t)(arg))
+#else
+#define APP_TRACE(id, aux, arg)
+#endif
+
+/*******************************************************************************
+  Function:
+    void APP_TraceRecordData ( uint8_t id, const uint8_t *p_data, uint8_t len )
+
+  Summary:
+     Record an event with a payload, spread over APP_TRACE_EVT_DATA slots
+     reserved in one go so they stay contiguous.
+*/
+void APP_TraceRecordData(uint8_t id, const uint8_t *p_data, uint8_t len);
+
+/*******************************************************************************
+  Function:
+    void APP_TraceInit ( void )
+
+  Summary:
+     Start the cycle counter and start recording. Call before the scheduler.
+*/
+void APP_TraceInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_TraceStart ( void )
+
+  Summary:
+     Resume recording and enable the BT system traces selected by
+     APP_TRACE_BT_SYS_MASK.
+*/
+void APP_TraceStart(void);
+
+/*******************************************************************************
+  Function:
+    void APP_TraceStop ( void )
+
+  Summary:
+     Stop recording, e.g. right after the event of interest so it is not
+     overwritten before the ring is drained.
+*/
+void APP_TraceStop(void);
+
+/*******************************************************************************
+  Function:
+    void APP_TraceDrain ( APP_TRACE_WRITE write )
+
+  Summary:
+     Send the recorded events as frames and empty the ring.
+
+  Description:
+     Recording is paused while the ring is copied out and resumes afterwards
+     if it was running. An event whose writer was preempted between reserving
+     its slot and filling it may show up stale.
+*/
+void APP_TraceDrain(APP_TRACE_WRITE write);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_TRACE_H */
+
+/*******************************************************************************
+ End of File
+ */
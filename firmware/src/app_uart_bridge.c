@@ -0,0 +1,319 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_uart_bridge.c
+
+  Summary:
+    Transparent UART to BLECB pipe bridge.
+
+  Description:
+    s_rxHead counts the bytes of finished reads and is only moved by the read
+    callback; s_rxTail counts the bytes handed to the pipe and is only moved
+    by the bridge task. The bytes of the read in progress are stable as soon
+    as the plib has stored them, so the task also sends those when the line
+    goes idle. While the line is idle a 1 byte read is armed instead of a
+    full segment, so the first byte of the next burst wakes the task and it
+    can otherwise block without a timeout.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "blecb_pipe.h"
+#include "app_uart_tx.h"
+#include "app_uart_bridge.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_UART_BRIDGE_RX_MASK     (APP_UART_BRIDGE_RX_RING_SIZE - 1U)
+
+static uint8_t s_rxRing[APP_UART_BRIDGE_RX_RING_SIZE];
+static volatile uint32_t s_rxHead;
+static volatile uint32_t s_rxTail;
+static volatile uint16_t s_rxSegLen;        /* Size of the armed read, 0 when none is armed */
+static volatile bool s_rtsDeasserted;
+static OSAL_SEM_DECLARE(s_rxSem);
+static APP_UART_BRIDGE_Stats_T s_stats;
+static TaskHandle_t xUART_BRIDGE_Task;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Arm the next read at s_rxHead. Runs in the read callback or with SERCOM0 masked. */
+static void APP_UartBridgeArmRead(uint32_t maxLen)
+{
+    uint32_t room = APP_UART_BRIDGE_RX_RING_SIZE - (s_rxHead - s_rxTail);
+    uint32_t offset = s_rxHead & APP_UART_BRIDGE_RX_MASK;
+    uint32_t len = APP_UART_BRIDGE_RX_RING_SIZE - offset;
+
+    if (len > room)
+    {
+        len = room;
+    }
+    if (len > maxLen)
+    {
+        len = maxLen;
+    }
+
+#if APP_UART_BRIDGE_RTS_PIN != GPIO_PIN_NONE
+    if (room < APP_UART_BRIDGE_RTS_HEADROOM && !s_rtsDeasserted)
+    {
+        GPIO_PinSet(APP_UART_BRIDGE_RTS_PIN);
+        s_rtsDeasserted = true;
+        s_stats.rtsDeasserts++;
+    }
+#endif
+
+    s_rxSegLen = (uint16_t)len;
+    if (len == 0U)
+    {
+        // Ring full: leave the bytes in the SERCOM, whose RTS now stops the host
+        s_stats.rxStalls++;
+        return;
+    }
+    (void)SERCOM0_USART_Read(&s_rxRing[offset], len);
+}
+
+static void APP_UartBridgeReadDone(uintptr_t context)
+{
+    (void)context;
+
+    if (SERCOM0_USART_ErrorGet() != USART_ERROR_NONE)
+    {
+        s_stats.rxErrors++;
+    }
+    // Also right after an error: the bytes stored before it are valid
+    s_rxHead += SERCOM0_USART_ReadCountGet();
+    APP_UartBridgeArmRead(APP_UART_BRIDGE_RX_SEG_SIZE);
+    (void)OSAL_SEM_PostISR(&s_rxSem);
+}
+
+/* Bytes received so far, including those of the read in progress. */
+static uint32_t APP_UartBridgeRxCount(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint32_t count;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    count = s_rxHead;
+    if (s_rxSegLen != 0U)
+    {
+        count += SERCOM0_USART_ReadCountGet();
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    return count;
+}
+
+/* Hand received bytes up to rxCount to the pipe. Short frames only go out when idle. */
+static void APP_UartBridgeSendFrames(uint32_t rxCount, bool idle)
+{
+    uint32_t pending;
+    uint32_t offset;
+    uint32_t len;
+
+    while ((pending = rxCount - s_rxTail) != 0U)
+    {
+        offset = s_rxTail & APP_UART_BRIDGE_RX_MASK;
+        len = APP_UART_BRIDGE_RX_RING_SIZE - offset;
+        if (len > pending)
+        {
+            len = pending;
+        }
+        if (len > APP_UART_BRIDGE_FRAME_MAX)
+        {
+            len = APP_UART_BRIDGE_FRAME_MAX;
+        }
+        // A frame cut by the end of the ring is sent right away, the rest follows
+        if (len == pending && len < APP_UART_BRIDGE_FRAME_MAX && !idle)
+        {
+            return;
+        }
+        if (!BLECB_Pipe_SendData(&s_rxRing[offset], (uint16_t)len))
+        {
+            s_stats.pipeBusy++;
+            return;
+        }
+        s_rxTail += len;
+        s_stats.rxBytes += len;
+        s_stats.rxFrames++;
+    }
+}
+
+/* Resume reception after the ring was full and reassert RTS once it has drained. */
+static void APP_UartBridgeResume(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint32_t room;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    room = APP_UART_BRIDGE_RX_RING_SIZE - (s_rxHead - s_rxTail);
+    if (s_rxSegLen == 0U && room != 0U)
+    {
+        APP_UartBridgeArmRead(APP_UART_BRIDGE_RX_SEG_SIZE);
+    }
+#if APP_UART_BRIDGE_RTS_PIN != GPIO_PIN_NONE
+    if (s_rtsDeasserted && room >= APP_UART_BRIDGE_RTS_RESUME)
+    {
+        GPIO_PinClear(APP_UART_BRIDGE_RTS_PIN);
+        s_rtsDeasserted = false;
+    }
+#endif
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+/* Swap the armed segment for a 1 byte read. Returns false if bytes came in meanwhile. */
+static bool APP_UartBridgeArmWakeup(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    bool armed = false;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    if (s_rxSegLen == 1U)
+    {
+        armed = true;
+    }
+    else if (s_rxSegLen != 0U && SERCOM0_USART_ReadCountGet() == 0U)
+    {
+        (void)SERCOM0_USART_ReadAbort();
+        APP_UartBridgeArmRead(1);
+        armed = true;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    return armed;
+}
+
+/**
+ * UART BRIDGE TASK
+ * @param pvParameters
+ */
+static void _UART_BRIDGE_Task(void *pvParameters)
+{
+    uint32_t lastCount = 0;
+    uint32_t rxCount;
+    uint16_t wait = OSAL_WAIT_FOREVER;
+    bool idle;
+
+    (void)pvParameters;
+
+    while (1)
+    {
+        (void)OSAL_SEM_Pend(&s_rxSem, wait);
+
+        rxCount = APP_UartBridgeRxCount();
+        idle = (rxCount == lastCount);
+        lastCount = rxCount;
+
+        APP_UartBridgeSendFrames(rxCount, idle);
+        APP_UartBridgeResume();
+
+        if (rxCount != s_rxTail || !idle)
+        {
+            // Data waiting for the idle gap or for the pipe
+            wait = APP_UART_BRIDGE_IDLE_MS;
+        }
+        else
+        {
+            wait = APP_UartBridgeArmWakeup() ? OSAL_WAIT_FOREVER : APP_UART_BRIDGE_IDLE_MS;
+        }
+    }
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_UartBridgeInit(void)
+{
+    USART_SERIAL_SETUP setup;
+
+    s_rxHead = 0;
+    s_rxTail = 0;
+    s_rxSegLen = 0;
+    s_rtsDeasserted = false;
+    memset(&s_stats, 0, sizeof(s_stats));
+
+    setup.baudRate = APP_UART_BRIDGE_BAUD;
+    setup.parity = USART_PARITY_NONE;
+    setup.dataWidth = USART_DATA_8_BIT;
+    setup.stopBits = USART_STOP_1_BIT;
+    (void)SERCOM0_USART_SerialSetup(&setup, SERCOM0_USART_FrequencyGet());
+
+#if APP_UART_BRIDGE_RTS_PIN != GPIO_PIN_NONE
+    GPIO_PinClear(APP_UART_BRIDGE_RTS_PIN);
+    GPIO_PinOutputEnable(APP_UART_BRIDGE_RTS_PIN);
+#endif
+
+    APP_STATIC_SEM_CREATE_BINARY(&s_rxSem);
+    SERCOM0_USART_ReadCallbackRegister(APP_UartBridgeReadDone, 0);
+    APP_UartBridgeArmRead(1);
+
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _UART_BRIDGE_Task,
+            "UART_BRIDGE_Task",
+            256,
+            NULL,
+            1,
+            &xUART_BRIDGE_Task);
+}
+
+void APP_UartBridgePipeRx(uint8_t *p_data, uint16_t length)
+{
+    // The pipe only delivers once APP_UartTxSpace covers the message
+    APP_UartTxWriteAll(p_data, length);
+    s_stats.txBytes += length;
+}
+
+void APP_UartBridgeGetStats(APP_UART_BRIDGE_Stats_T *p_stats)
+{
+    *p_stats = s_stats;
+}
+
+
+/*******************************************************************************
+ End of File
+ */
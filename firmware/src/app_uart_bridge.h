@@ -0,0 +1,185 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_uart_bridge.h
+
+  Summary:
+    Transparent UART to BLECB pipe bridge with end to end flow control.
+
+  Description:
+    With APP_UART_BRIDGE_ENABLE the debug UART stops being a console and
+    becomes a wire replacement for the pipe:
+
+    - UART RX lands in a RAM ring filled by back to back SERCOM0 reads. The
+      bridge task sends it to the pipe when a full frame is available or the
+      line has been idle for APP_UART_BRIDGE_IDLE_MS.
+    - Pipe messages are written to the UART TX ring (app_uart_tx.c), which the
+      DMAC sends to SERCOM0 a segment at a time. The pipe holds a message while
+      the ring has no room for it, stops taking SDUs from TRCBPS and so stops
+      returning credits: a host that deasserts CTS ends up stopping the peer.
+    - When the pipe refuses data (no credits, TX queue full) the RX ring fills
+      up; RTS is deasserted APP_UART_BRIDGE_RTS_HEADROOM bytes before it is
+      full and reasserted once it has drained below the resume level.
+
+    CTS is handled by the SERCOM itself: the plib sets TXPO to 2 (TxD on PAD0,
+    RTS on PAD2, CTS on PAD3), which also makes the SERCOM drive its own RTS
+    when its receive buffer is full. APP_UART_BRIDGE_RTS_PIN adds an earlier,
+    software driven RTS on a GPIO for hosts that keep sending a few bytes after
+    RTS drops.
+*******************************************************************************/
+
+#ifndef _APP_UART_BRIDGE_H
+#define _APP_UART_BRIDGE_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Bridge mode; the UART carries no console output while it is enabled. */
+#ifndef APP_UART_BRIDGE_ENABLE
+#define APP_UART_BRIDGE_ENABLE              0
+#endif
+
+#ifndef APP_UART_BRIDGE_BAUD
+#define APP_UART_BRIDGE_BAUD                1000000UL
+#endif
+
+/* RX ring size in bytes, a power of two, and the size of each read in it. */
+#ifndef APP_UART_BRIDGE_RX_RING_SIZE
+#define APP_UART_BRIDGE_RX_RING_SIZE        4096
+#endif
+#ifndef APP_UART_BRIDGE_RX_SEG_SIZE
+#define APP_UART_BRIDGE_RX_SEG_SIZE         64
+#endif
+
+/* Largest pipe message: one SDU of the data channel with the pipe length field. */
+#ifndef APP_UART_BRIDGE_FRAME_MAX
+#define APP_UART_BRIDGE_FRAME_MAX           (BLE_TRCBPS_DATA_MTU - 2)
+#endif
+
+/* Line idle time that ends a frame. */
+#ifndef APP_UART_BRIDGE_IDLE_MS
+#define APP_UART_BRIDGE_IDLE_MS             1
+#endif
+
+/* Software RTS (active low). GPIO_PIN_NONE leaves RTS to the SERCOM. */
+#ifndef APP_UART_BRIDGE_RTS_PIN
+#define APP_UART_BRIDGE_RTS_PIN             GPIO_PIN_NONE
+#endif
+#ifndef APP_UART_BRIDGE_RTS_HEADROOM
+#define APP_UART_BRIDGE_RTS_HEADROOM        256
+#endif
+#ifndef APP_UART_BRIDGE_RTS_RESUME
+#define APP_UART_BRIDGE_RTS_RESUME          (APP_UART_BRIDGE_RX_RING_SIZE / 2)
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_UART_BRIDGE_Stats_T
+{
+    uint32_t    rxBytes;                /* UART bytes handed to the pipe */
+    uint32_t    txBytes;                /* Pipe bytes queued to the UART */
+    uint32_t    rxFrames;               /* Pipe messages sent */
+    uint32_t    rxErrors;               /* Framing, parity or overrun errors */
+    uint32_t    rxStalls;               /* Times the RX ring was full */
+    uint32_t    rtsDeasserts;           /* Times the software RTS was dropped */
+    uint32_t    pipeBusy;               /* Frames refused by the pipe and retried */
+} APP_UART_BRIDGE_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_UartBridgeInit ( void )
+
+  Summary:
+     Set the bridge baud rate, start receiving and create the bridge task.
+     Call after APP_UartTxInit.
+*/
+void APP_UartBridgeInit(void);
+
+/*******************************************************************************
+  Function:
+    void APP_UartBridgePipeRx ( uint8_t *p_data, uint16_t length )
+
+  Summary:
+     Pipe receive callback of the bridge; writes the message to the UART.
+*/
+void APP_UartBridgePipeRx(uint8_t *p_data, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_UartBridgeGetStats ( APP_UART_BRIDGE_Stats_T *p_stats )
+
+  Summary:
+     Get the bridge counters.
+*/
+void APP_UartBridgeGetStats(APP_UART_BRIDGE_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_UART_BRIDGE_H */
+
+/*******************************************************************************
+ End of File
+ */
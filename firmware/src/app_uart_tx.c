@@ -0,0 +1,285 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_uart_tx.c
+
+  Summary:
+    Ring buffered console output on SERCOM0.
+
+  Description:
+    head is only moved by writers and tail only by the DMA completion
+    callback, both free running. Each segment is one DMAC transfer from the
+    ring to the SERCOM0 data register, paced by its DRE trigger, so the CPU
+    is interrupted once per segment instead of once per byte. Writers hold a
+    kernel critical section while copying; it masks the DMAC interrupt
+    (priority 6) but not the BLE interrupts. A segment never wraps, so a
+    wrapping ring content goes out as two transfers. A task waiting for
+    ring space or for the ring to drain pends on s_spaceSem, given by the
+    callback when a segment ends; before the scheduler runs, with it
+    suspended or from an interrupt the wait spins instead.
+ *******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <string.h>
+#include "definitions.h"
+#include "app_uart_tx.h"
+#include "app_static.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+#define APP_UART_TX_DMAC_CHANNEL    DMAC_CHANNEL_3
+/* Longest pend between two looks at the ring, should a wake be missed */
+#define APP_UART_TX_WAIT_MS         10U
+
+static uint8_t s_ring[APP_UART_TX_RING_SIZE];
+static volatile uint32_t s_head;
+static volatile uint32_t s_tail;
+static volatile uint16_t s_segLen;          /* Bytes handed to the DMA, 0 when idle */
+static volatile uint8_t s_waiters;          /* Tasks pending on s_spaceSem */
+static OSAL_SEM_DECLARE(s_spaceSem);
+static APP_UART_TX_Stats_T s_stats;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/* Start the next segment. Called with the DMAC interrupt masked or from it. */
+static void APP_UartTxKick(void)
+{
+    uint32_t pending = s_head - s_tail;
+    uint32_t offset = s_tail & (APP_UART_TX_RING_SIZE - 1U);
+    uint32_t seg;
+
+    if (s_segLen != 0U || pending == 0U)
+    {
+        return;
+    }
+
+    seg = APP_UART_TX_RING_SIZE - offset;
+    if (seg > pending)
+    {
+        seg = pending;
+    }
+    s_segLen = (uint16_t)seg;
+    (void)DMAC_ChannelTransfer(APP_UART_TX_DMAC_CHANNEL, &s_ring[offset],
+                               (const void *)&SERCOM0_REGS->USART_INT.SERCOM_DATA, seg);
+}
+
+static void APP_UartTxDone(DMAC_TRANSFER_EVENT event, uintptr_t context)
+{
+    (void)context;
+
+    // A segment that ends in a transfer error is counted as dropped, not retried
+    if (event == DMAC_TRANSFER_EVENT_ERROR)
+    {
+        s_stats.dropped += s_segLen;
+    }
+    s_tail += s_segLen;
+    s_segLen = 0;
+    APP_UartTxKick();
+    if (s_waiters != 0U)
+    {
+        (void)OSAL_SEM_PostISR(&s_spaceSem);
+    }
+}
+
+/* Whether the caller may pend: a task, with the scheduler running. */
+static bool APP_UartTxCanBlock(void)
+{
+    return __get_IPSR() == 0U && __get_PRIMASK() == 0U
+        && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+/* Wait for the next segment to end, the caller having counted itself in
+ * s_waiters with the DMAC interrupt masked. */
+static void APP_UartTxWait(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+
+    (void)OSAL_SEM_Pend(&s_spaceSem, APP_UART_TX_WAIT_MS);
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    s_waiters--;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+static uint16_t APP_UartTxCopy(const uint8_t *p_data, uint16_t length)
+{
+    uint32_t used = s_head - s_tail;
+    uint32_t offset = s_head & (APP_UART_TX_RING_SIZE - 1U);
+    uint32_t first;
+    uint16_t n = length;
+
+    if (n > APP_UART_TX_RING_SIZE - used)
+    {
+        n = (uint16_t)(APP_UART_TX_RING_SIZE - used);
+    }
+
+    first = APP_UART_TX_RING_SIZE - offset;
+    if (first > n)
+    {
+        first = n;
+    }
+    memcpy(&s_ring[offset], p_data, first);
+    memcpy(s_ring, &p_data[first], n - first);
+    s_head += n;
+
+    used += n;
+    if (used > s_stats.peak)
+    {
+        s_stats.peak = (uint16_t)used;
+    }
+    s_stats.written += n;
+    return n;
+}
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void APP_UartTxInit(void)
+{
+    s_head = 0;
+    s_tail = 0;
+    s_segLen = 0;
+    s_waiters = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+    APP_STATIC_SEM_CREATE_BINARY(&s_spaceSem);
+    DMAC_ChannelCallbackRegister(APP_UART_TX_DMAC_CHANNEL, APP_UartTxDone, 0);
+}
+
+uint16_t APP_UartTxWrite(const uint8_t *p_data, uint16_t length)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint16_t n;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    n = APP_UartTxCopy(p_data, length);
+    if (n < length)
+    {
+        s_stats.dropped += (uint32_t)(length - n);
+        s_stats.overflows++;
+    }
+    APP_UartTxKick();
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+    return n;
+}
+
+void APP_UartTxWriteAll(const uint8_t *p_data, uint16_t length)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    bool canBlock = APP_UartTxCanBlock();
+    bool wait;
+    uint16_t n;
+
+    while (length != 0U)
+    {
+        critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+        n = APP_UartTxCopy(p_data, length);
+        APP_UartTxKick();
+        wait = canBlock && n < length;
+        if (wait)
+        {
+            s_waiters++;
+        }
+        OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+
+        p_data += n;
+        length -= n;
+        if (wait)
+        {
+            APP_UartTxWait();
+        }
+    }
+}
+
+uint16_t APP_UartTxSpace(void)
+{
+    return (uint16_t)(APP_UART_TX_RING_SIZE - (s_head - s_tail));
+}
+
+void APP_UartTxFlush(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    bool canBlock = APP_UartTxCanBlock();
+    bool wait;
+
+    while (s_head != s_tail)
+    {
+        if (canBlock)
+        {
+            critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+            wait = s_head != s_tail;
+            if (wait)
+            {
+                s_waiters++;
+            }
+            OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+            if (wait)
+            {
+                APP_UartTxWait();
+            }
+        }
+    }
+    // At most the last character is left in the shift register
+    while (!SERCOM0_USART_TransmitComplete())
+    {
+    }
+}
+
+void APP_UartTxGetStats(APP_UART_TX_Stats_T *p_stats)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_HIGH);
+    *p_stats = s_stats;
+    p_stats->used = (uint16_t)(s_head - s_tail);
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_HIGH, critState);
+}
+
+
+/*******************************************************************************
+ End of File
+ */
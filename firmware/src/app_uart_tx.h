@@ -0,0 +1,174 @@
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+/*******************************************************************************
+  MPLAB Harmony Application Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    app_uart_tx.h
+
+  Summary:
+    Non-blocking, ring buffered console output on SERCOM0.
+
+  Description:
+    Writers copy into a RAM ring and return at once; DMAC channel 3 moves
+    the ring content to SERCOM0 in contiguous segments, triggered by its data
+    register empty flag, and the completion interrupt starts the next segment.
+    No task ever waits for the UART line, so a slow console no longer
+    throttles the pipe.
+
+    When the ring is full the bytes that do not fit are dropped and counted,
+    see APP_UartTxGetStats. Writers that must not lose output (diagnostic
+    dumps) use APP_UartTxWriteAll, which waits for ring space instead.
+*******************************************************************************/
+
+#ifndef _APP_UART_TX_H
+#define _APP_UART_TX_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Configuration
+// *****************************************************************************
+// *****************************************************************************
+
+/* Ring size in bytes, a power of two. */
+#ifndef APP_UART_TX_RING_SIZE
+#define APP_UART_TX_RING_SIZE           2048
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Type Definitions
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct APP_UART_TX_Stats_T
+{
+    uint32_t    written;                /* Bytes accepted into the ring */
+    uint32_t    dropped;                /* Bytes dropped because the ring was full */
+    uint32_t    overflows;              /* Writes that lost at least one byte */
+    uint16_t    used;                   /* Bytes waiting in the ring */
+    uint16_t    peak;                   /* Highest fill level since boot */
+} APP_UART_TX_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+  Function:
+    void APP_UartTxInit ( void )
+
+  Summary:
+     Take over DMAC channel 3 and create the semaphore writers wait on. Call
+     after SERCOM0_USART_Initialize and DMAC_Initialize.
+*/
+void APP_UartTxInit(void);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_UartTxWrite ( const uint8_t *p_data, uint16_t length )
+
+  Summary:
+     Copy data into the ring and return immediately. Callable from any task.
+
+  Returns:
+    Number of bytes accepted; the rest is dropped and counted.
+*/
+uint16_t APP_UartTxWrite(const uint8_t *p_data, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    void APP_UartTxWriteAll ( const uint8_t *p_data, uint16_t length )
+
+  Summary:
+     Copy all data into the ring, waiting for space when it is full: a task
+     pends until the DMA frees some, elsewhere the wait spins. Returns once
+     the data is queued, not when it has been sent.
+*/
+void APP_UartTxWriteAll(const uint8_t *p_data, uint16_t length);
+
+/*******************************************************************************
+  Function:
+    uint16_t APP_UartTxSpace ( void )
+
+  Summary:
+     Free bytes in the ring, i.e. what APP_UartTxWrite would accept now.
+*/
+uint16_t APP_UartTxSpace(void);
+
+/*******************************************************************************
+  Function:
+    void APP_UartTxFlush ( void )
+
+  Summary:
+     Wait until the ring is empty and the last byte has left the shift
+     register, e.g. before halting in a fault handler. A task pends while
+     the ring drains; with the scheduler suspended or in a handler it spins.
+*/
+void APP_UartTxFlush(void);
+
+/*******************************************************************************
+  Function:
+    void APP_UartTxGetStats ( APP_UART_TX_Stats_T *p_stats )
+
+  Summary:
+     Get the ring usage and overflow counters.
+*/
+void APP_UartTxGetStats(APP_UART_TX_Stats_T *p_stats);
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif /* _APP_UART_TX_H */
+
+/*******************************************************************************
+ End of File
+ */
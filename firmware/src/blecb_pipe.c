@@ -47,14 +47,12 @@
                     APP_BleStackInit();
                 ------>BLECB_Pipe_Init(BLERXCallback);
  
-    STEP7: Add BLECB_Pipe_Event_Handler before the default ble stack handler in app.c
-    APP_STATE_SERVICE_TASKS - APP_MSG_BLE_STACK_EVT. To make the handler intercept messages
-    and exit correctly from the task, you can check the returned value of this function that
-    will report if the event has been consumed. If it has been consumed you can exit the function 
-    preventing the default handler to process the event again. E.G.:
-                    bool eventconsumed = BLECB_Pipe_Event_Handler((STACK_Event_T *)p_appMsg->msgData);
-                    if(eventconsumed) return;
-                    APP_BleStackEvtHandler((STACK_Event_T *)p_appMsg->msgData);
+    STEP7: Nothing to add to app.c for BLE stack events. BLECB_Pipe_Init subscribes
+    the pipe to the GAP, L2CAP and GATT events it and the TRCBPS profile need
+    (see app_ble_evt_router.h). They are delivered straight to the pipe task,
+    which runs BLE_TRCBPS_BleEventHandler itself, so SDUs and credits never
+    wait behind the application queue. APP_BleStackEvtHandler must therefore
+    not call BLE_TRCBPS_BleEventHandler again.
  
     STEP8: You are pretty much done. If you want to send data on the pipe you can use the BLECB_Pipe_SendData
     API that takes as input the pointer to the buffer you want to send and its length
@@ -67,6 +65,7 @@
 /* ************************************************************************** */
 /* ************************************************************************** */
 
+#define OSAL_MEM_TAG    OSAL_MEM_TAG_PIPE       // Heap accounting tag for the data queues
 #include <stddef.h>                     // Defines NULL
 #include <stdbool.h>                    // Defines true
 #include <stdlib.h>                     // Defines EXIT_FAILURE
@@ -74,17 +73,34 @@
 #include "definitions.h"                // SYS function prototypes
 #include "configuration.h"
 #include "app_ble_handler.h"
+#include "app_ble_evt_pool.h"
+#include "app_ble_evt_router.h"
 #include "blecb_pipe.h"
+#include "app_trace.h"
+#include "app_lat.h"
+#include "app_dma_copy.h"
+#include "app_dlog.h"
+#include "app_static.h"
+#include "app_dfu.h"
+#include "app_log.h"
+#include "app_spill.h"
+#include "app_aead.h"
+#include "app_digest.h"
 #include "ble_gap.h"
+#include "ble_trcbpc/ble_trcbpc.h"
 
 //--- DATA QUEUE TASK HANDLER
 TaskHandle_t xblecb_pipe_QUEUE_Tasks;
 
+//--- STACK EVENTS ROUTED TO THE PIPE TASK (NULL ENTRIES ONLY WAKE THE TASK)
+OSAL_QUEUE_HANDLE_TYPE BLECB_Pipe_EventQueue;
+
 //--- DATA QUEUE GLOBALS
 uint16_t    MESSAGE_L;
 uint8_t *   MESSAGE_BUFFER;
 uint16_t    MESSAGE_PARTIAL_L;
 uint8_t *   MESSAGE_INCOMPLETE;
+bool        MESSAGE_DFU;                // message being reassembled belongs to the firmware update
 long start;
 long edgestart;
 long edgeamount;
@@ -93,14 +109,124 @@ long reck;
 BLECB_Pipe_DATA_QUEUE_CircQueue BLEDATA_RECEIVEQUEUE;
 BLECB_Pipe_DATA_QUEUE_CircQueue BLEDATA_TRANSMITQUEUE;
 pipedatarecived_callback BLECB_Pipe_ReceivedDataCallback;
+uint32_t    BLECB_Pipe_RxDropped;       // messages not delivered: no buffer for them
+
+//--- STATIC BUILD: QUEUE DATA AND THE MESSAGE BEING REASSEMBLED COME FROM FIXED ARENAS
+#if APP_STATIC_ALLOC
+APP_STATIC_ARENA_DEFINE(s_pipeTxArena, pipe, APP_STATIC_PIPE_TX_ARENA_SIZE);
+APP_STATIC_ARENA_DEFINE(s_pipeRxArena, pipe, APP_STATIC_PIPE_RX_ARENA_SIZE);
+static uint8_t s_pipeMessage[APP_STATIC_PIPE_MSG_MAX] APP_STATIC_SECTION(pipe);
+#endif
+
+//--- RX FLOW CONTROL: SDUs STAY IN TRCBPS (AND THEIR CREDITS WITH THE PEER) WHILE THE SINK IS FULL
+pipesinkspace_callback BLECB_Pipe_SinkSpaceCallback;
+uint16_t    BLECB_Pipe_SinkSize;
+bool        BLECB_Pipe_RxHeld;
+uint32_t    BLECB_Pipe_RxTimes[BLE_TRCBPS_DATA_MAX_BUF_IN];    // rxTime of the SDUs not pulled yet, in order
+uint8_t     BLECB_Pipe_RxTimesRd;
+uint8_t     BLECB_Pipe_RxTimesNum;
+
+//--- TX: SDU REJECTED FOR LACK OF CREDITS OR BUFFERS, RETRIED ON THE NEXT STACK EVENT
+bool        BLECB_Pipe_TxStalled;
+uint16_t    BLECB_Pipe_PeerMtu;         // SDU size limit of the peer, from the data channel connection
+uint16_t    BLECB_Pipe_PeerCid;         // L2CAP CID of the peer's end of the data channel, 0 while it is closed
+
+//--- FLASH SPILL: AN SDU PULLED PAST THE RX WATERMARK IS TAKEN HERE ON ITS WAY TO THE FLASH RING
+#if APP_SPILL_ENABLE
+static uint8_t BLECB_Pipe_SpillSdu[BLE_TRCBPS_DATA_MTU];
+static bool    BLECB_Pipe_ReadBackNoBuffer;     // the last read back stopped for lack of heap or arena
+#endif
 
 //--- CONNECTION HANDLE
 uint16_t ActiveConnectionHandle;
 
+//--- WHAT THE TX QUEUE DOES TO A MESSAGE ON ITS WAY IN
+#define BLECB_Pipe_TX_SEAL          0x01    // APP_AEAD_ENABLE: encrypted, tag appended
+#define BLECB_Pipe_TX_DIGEST        0x02    // APP_DIGEST_ENABLE: hashed, trailer appended per message
+#define BLECB_Pipe_TX_DIGEST_END    0x04    // APP_DIGEST_ENABLE: the stream end marker, written in the queue buffer
+#define BLECB_Pipe_TX_PROTECT       (BLECB_Pipe_TX_SEAL | BLECB_Pipe_TX_DIGEST)
+#define BLECB_Pipe_TX_LOCKED        (APP_AEAD_ENABLE || APP_DIGEST_ENABLE)
+
 //--- BLE PHY
 #define DEFAULTPHY  BLE_GAP_PHY_OPTION_2M
 uint8_t phyInUse;
 
+//--- CENTRAL ROLE: SCAN FOR A PEER PIPE, CONNECT, LET TRCBPC OPEN THE DATA CHANNEL
+#if APP_TRCBPC_ENABLE
+#define BLECB_Pipe_SCAN_INTERVAL        96      // Scan interval while connecting (0.625 ms units)
+#define BLECB_Pipe_SUPERVISION_TIMEOUT  200     // Supervision timeout (10 ms units)
+bool BLECB_Pipe_Connecting;
+static void BLECB_Pipe_Process_TRCBPC_Event(BLE_TRCBPC_Event_T *p_event);
+#endif
+
+//--- STACK EVENT ROUTING
+static void BLECB_Pipe_Process_Stack_Event(STACK_Event_T * p_stackEvt);
+static bool BLECB_Pipe_Event_Sink(STACK_Event_T * p_stackEvt);
+static void BLECB_Pipe_Process_Vendor_Cmd(BLE_TRCBPS_EvtVendorCmd_T *p_cmd);
+
+/**
+ * BLECB PIPE Data Queue buffer for an element of the queue
+ * @param p_circQueue_t
+ * @param size
+ * @return NULL when the heap or the queue arena is full
+ */
+static uint8_t * BLECB_Pipe_DATA_QUEUE_Alloc(BLECB_Pipe_DATA_QUEUE_CircQueue *p_circQueue_t, uint16_t size)
+{
+#if APP_STATIC_ALLOC
+    return APP_StaticArenaAlloc((p_circQueue_t == &BLEDATA_TRANSMITQUEUE) ? &s_pipeTxArena : &s_pipeRxArena, size);
+#else
+    (void)p_circQueue_t;
+    return OSAL_Malloc(size);
+#endif
+}
+
+
+/**
+ * BLECB PIPE Data Queue release the buffer of an element
+ * @param p_circQueue_t
+ * @param p_data
+ */
+static void BLECB_Pipe_DATA_QUEUE_Free(BLECB_Pipe_DATA_QUEUE_CircQueue *p_circQueue_t, uint8_t *p_data)
+{
+#if APP_STATIC_ALLOC
+    APP_StaticArenaFree((p_circQueue_t == &BLEDATA_TRANSMITQUEUE) ? &s_pipeTxArena : &s_pipeRxArena, p_data);
+#else
+    (void)p_circQueue_t;
+    OSAL_Free(p_data);
+#endif
+}
+
+
+/**
+ * BLECB PIPE buffer for reassembling a received message
+ * @param messageLength
+ * @return NULL when there is no room; the message is then dropped
+ */
+static uint8_t * BLECB_Pipe_MessageAlloc(uint16_t messageLength)
+{
+#if APP_STATIC_ALLOC
+    if(messageLength>APP_STATIC_PIPE_MSG_MAX) return NULL;
+    return s_pipeMessage;
+#else
+    return OSAL_Malloc(messageLength);
+#endif
+}
+
+
+/**
+ * BLECB PIPE release the reassembly buffer
+ * @param message
+ */
+static void BLECB_Pipe_MessageFree(uint8_t * message)
+{
+#if APP_STATIC_ALLOC
+    (void)message;
+#else
+    OSAL_Free(message);
+#endif
+}
+
+
 /**
  * BLECB PIPE Data Queue get valid
  * @param p_circQueue_t
@@ -125,9 +251,10 @@ uint8_t BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(BLECB_Pipe_DATA_QUEUE_CircQue
  * @param dataLeng
  * @param p_data
  * @param p_circQueue_t
+ * @param timestamp
  * @return 
  */
-int BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(uint16_t dataLeng, uint8_t *p_data, BLECB_Pipe_DATA_QUEUE_CircQueue *p_circQueue_t)
+int BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(uint16_t dataLeng, uint8_t *p_data, BLECB_Pipe_DATA_QUEUE_CircQueue *p_circQueue_t, uint32_t timestamp)
 {
     
     if ((dataLeng > 0) && (p_data != NULL) && (p_circQueue_t != NULL))
@@ -138,6 +265,7 @@ int BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(uint16_t dataLeng, uint8_t *p_da
             p_circQueue_t->currentAlloc  += dataLeng;
             p_circQueue_t->queueElem[p_circQueue_t->writeIdx].p_data = p_data;
             p_circQueue_t->queueElem[p_circQueue_t->writeIdx].processedUpTo = 0;
+            p_circQueue_t->queueElem[p_circQueue_t->writeIdx].timestamp = timestamp;
             p_circQueue_t->usedNum++;
             p_circQueue_t->writeIdx++;
             if (p_circQueue_t->writeIdx >= BLECB_Pipe_DATA_QUEUE_MAX_ELEMENTS)
@@ -227,7 +355,8 @@ void BLECB_Pipe_DATA_QUEUE_FreeElemCircQueue(BLECB_Pipe_DATA_QUEUE_CircQueue *p_
         p_circQueue_t->currentAlloc  -= p_circQueue_t->queueElem[p_circQueue_t->readIdx].dataLeng;
         p_circQueue_t->queueElem[p_circQueue_t->readIdx].dataLeng = 0;
         if (p_circQueue_t->queueElem[p_circQueue_t->readIdx].p_data != NULL)
-            OSAL_Free(p_circQueue_t->queueElem[p_circQueue_t->readIdx].p_data);
+            BLECB_Pipe_DATA_QUEUE_Free(p_circQueue_t, p_circQueue_t->queueElem[p_circQueue_t->readIdx].p_data);
+        p_circQueue_t->queueElem[p_circQueue_t->readIdx].p_data = NULL;
         if (p_circQueue_t->usedNum > 0)
             p_circQueue_t->usedNum--;
         p_circQueue_t->readIdx++;
@@ -245,7 +374,7 @@ void BLECB_Pipe_DATA_QUEUE_ClearQueue(BLECB_Pipe_DATA_QUEUE_CircQueue *p_circQue
     int i;
     for(i=0;i<BLECB_Pipe_DATA_QUEUE_MAX_ELEMENTS;i++){
         if(p_circQueue_t->queueElem[i].p_data != NULL)
-            OSAL_Free(p_circQueue_t->queueElem[i].p_data);
+            BLECB_Pipe_DATA_QUEUE_Free(p_circQueue_t, p_circQueue_t->queueElem[i].p_data);
     }
     memset(p_circQueue_t,0,sizeof(BLECB_Pipe_DATA_QUEUE_CircQueue));
 }
@@ -269,9 +398,74 @@ void BLECB_Pipe_dataqueue_Init( pipedatarecived_callback rxcallback ){
     MESSAGE_PARTIAL_L = 0;
     MESSAGE_BUFFER = NULL;
     MESSAGE_INCOMPLETE = NULL;
+    MESSAGE_DFU = false;
+    BLECB_Pipe_RxDropped = 0;
     
     STARTED = false;
     
+    //--- INIT FLOW CONTROL
+    BLECB_Pipe_RxHeld = false;
+    BLECB_Pipe_RxTimesRd = 0;
+    BLECB_Pipe_RxTimesNum = 0;
+    BLECB_Pipe_TxStalled = false;
+    
+}
+
+
+/**
+ * BLECB PIPE Data Queue RECEPTION TIME OF THE SDU JUST TAKEN FROM TRCBPS
+ * @return
+ */
+static uint32_t BLECB_Pipe_dataqueue_RxTime( void ){
+    uint32_t rxTime = APP_LatNow();
+    
+    if(BLECB_Pipe_RxTimesNum>0){
+        rxTime = BLECB_Pipe_RxTimes[BLECB_Pipe_RxTimesRd];
+        BLECB_Pipe_RxTimesRd = (BLECB_Pipe_RxTimesRd + 1) % BLE_TRCBPS_DATA_MAX_BUF_IN;
+        BLECB_Pipe_RxTimesNum--;
+    }
+    return rxTime;
+}
+
+
+/**
+ * BLECB PIPE Data Queue PULL SDUs FROM TRCBPS INTO THE RX QUEUE
+ * TRCBPS returns the credits of an SDU when it is taken, so SDUs are only
+ * taken while the RX queue is below its watermark and the sink is not full.
+ * With the flash spill they are taken past the watermark as well, into the
+ * flash ring, until it is full
+ */
+void BLECB_Pipe_dataqueue_PullRXData( void ){
+    uint8_t * newbuffer;
+    uint16_t dataLength;
+    uint32_t rxTime;
+    
+    while(1)
+    {
+        BLE_TRCBPS_GetDataLength(ActiveConnectionHandle,&dataLength);
+        if(dataLength==0) return;
+#if APP_SPILL_ENABLE
+        // Behind SDUs already spilled, or past the watermark: to flash, read back as the queue drains
+        if(!APP_SpillIsEmpty(APP_SPILL_RX) || BLEDATA_RECEIVEQUEUE.currentAlloc >= BLECB_Pipe_RX_PULL_WATERMARK){
+            if(dataLength>sizeof(BLECB_Pipe_SpillSdu) || !APP_SpillRoom(APP_SPILL_RX,dataLength)) return;
+            BLE_TRCBPS_GetData(ActiveConnectionHandle,BLECB_Pipe_SpillSdu);
+            APP_TRACE(APP_TRACE_EVT_CREDIT_GRANT, 0, dataLength);
+            (void)APP_SpillPut(APP_SPILL_RX,BLECB_Pipe_SpillSdu,dataLength,BLECB_Pipe_dataqueue_RxTime());
+            continue;
+        }
+#else
+        if(BLECB_Pipe_RxHeld || BLEDATA_RECEIVEQUEUE.currentAlloc >= BLECB_Pipe_RX_PULL_WATERMARK) return;
+#endif
+        if(BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_RECEIVEQUEUE)==0) return;
+        newbuffer = BLECB_Pipe_DATA_QUEUE_Alloc(&BLEDATA_RECEIVEQUEUE,dataLength);
+        if(newbuffer==NULL) return;     // the SDU stays in TRCBPS, retried on the next pass
+        BLE_TRCBPS_GetData(ActiveConnectionHandle,newbuffer);
+        APP_TRACE(APP_TRACE_EVT_CREDIT_GRANT, 0, dataLength);
+        
+        rxTime = BLECB_Pipe_dataqueue_RxTime();
+        BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(dataLength,newbuffer,&BLEDATA_RECEIVEQUEUE,rxTime);
+        APP_TRACE(APP_TRACE_EVT_PIPE_RX_ENQ, BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_RECEIVEQUEUE), dataLength);
+    }
 }
 
 
@@ -280,39 +474,111 @@ void BLECB_Pipe_dataqueue_Init( pipedatarecived_callback rxcallback ){
  * @param p_event
  */
 void BLECB_Pipe_dataqueue_InsertInRXQueue(BLE_TRCBPS_Event_T *p_event){
-    uint8_t * newbuffer;
-    uint16_t dataLength = 0 ;
-    APP_Msg_T appMsg;
-    
+    // TRCBPS raises the event from its SDU indication, so this is the arrival time
+    if(BLECB_Pipe_RxTimesNum<BLE_TRCBPS_DATA_MAX_BUF_IN){
+        BLECB_Pipe_RxTimes[(BLECB_Pipe_RxTimesRd + BLECB_Pipe_RxTimesNum) % BLE_TRCBPS_DATA_MAX_BUF_IN] = APP_LatNow();
+        BLECB_Pipe_RxTimesNum++;
+    }
+    BLECB_Pipe_dataqueue_PullRXData();
+}
+
+
+/**
+ * BLECB PIPE Data Queue CHECK IF THE SINK CAN TAKE A MESSAGE
+ * @param messageLength
+ * @return false if delivery has to wait for the sink to drain
+ */
+bool BLECB_Pipe_dataqueue_SinkReady( uint16_t messageLength ){
+    uint16_t needed = messageLength;
     
-    BLE_TRCBPS_GetDataLength(p_event->eventField.onReceiveData.connHandle,&dataLength);
-    newbuffer = OSAL_Malloc(dataLength);
-    BLE_TRCBPS_GetData(p_event->eventField.onReceiveData.connHandle,newbuffer);
-    if(BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(dataLength,newbuffer,&BLEDATA_RECEIVEQUEUE)==-1){
-            appData.state = APP_STATE_RXQUEUE_FULL;
-            appMsg.msgId = APP_MSG_IDLE;
-            OSAL_QUEUE_Send(&appData.appQueue, &appMsg, 0);
-            return;
-        }
+    if(BLECB_Pipe_SinkSpaceCallback==NULL) return true;
+    // A message larger than the whole sink is delivered once the sink is empty
+    if(needed>BLECB_Pipe_SinkSize) needed = BLECB_Pipe_SinkSize;
+    BLECB_Pipe_RxHeld = (BLECB_Pipe_SinkSpaceCallback() < needed);
+    return !BLECB_Pipe_RxHeld;
 }
 
 
 /**
- * BLECB PIPE Data Queue INSERT IN TX QUEUE
+ * BLECB PIPE Data Queue CHECK IF THE RECEIVER OF THE MESSAGE, THE FIRMWARE UPDATE OR THE SINK, CAN TAKE IT
+ * @param messageLength
+ * @return false if delivery has to wait
+ */
+bool BLECB_Pipe_dataqueue_LaneReady( uint16_t messageLength ){
+#if APP_DFU_ENABLE
+    if(MESSAGE_DFU){
+        BLECB_Pipe_RxHeld = !APP_DfuRxReady(messageLength);
+        return !BLECB_Pipe_RxHeld;
+    }
+#endif
+    return BLECB_Pipe_dataqueue_SinkReady(messageLength);
+}
+
+
+/**
+ * BLECB PIPE Data Queue COPY A MESSAGE INTO THE TX QUEUE
  * @param message
  * @param message_l
- * @return 
+ * @param body copied right after message, may be NULL
+ * @param body_l
+ * @param timestamp APP_LatNow() when the message entered the pipe
+ * @param protect BLECB_Pipe_TX_ flags; the length field counts what they append
+ * @return false if the TX queue is full
  */
-bool BLECB_Pipe_dataqueue_InsertInTXQueue(uint8_t * message, uint16_t message_l){
+static bool BLECB_Pipe_dataqueue_QueueTX(const uint8_t * message, uint16_t message_l, const uint8_t * body, uint16_t body_l,
+                                         uint32_t timestamp, uint8_t protect){
     if (BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_TRANSMITQUEUE) > 0){
-       uint8_t * new_buffer = OSAL_Malloc(message_l + 2);
-       new_buffer[0] = message_l & 0xFF;
-       new_buffer[1] = (message_l >> 8) & 0xFF;
-       memcpy(&new_buffer[2],message,message_l);
-       if(BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(message_l + 2,new_buffer,&BLEDATA_TRANSMITQUEUE)==-1){
-           OSAL_Free(new_buffer);
+       if((uint32_t)message_l + body_l > 0xFFFF - 2) return false;
+       uint16_t plain_l = message_l + body_l;
+       uint32_t field_l = plain_l;
+#if APP_DIGEST_ENABLE
+       if(protect & BLECB_Pipe_TX_DIGEST) field_l += APP_DIGEST_TRAILER_LEN;
+#endif
+#if APP_AEAD_ENABLE
+       if(protect & BLECB_Pipe_TX_SEAL) field_l += APP_AEAD_TAG_LEN;
+#endif
+       (void)protect;
+       if(field_l > 0xFFFF - 2) return false;
+       uint8_t * new_buffer = BLECB_Pipe_DATA_QUEUE_Alloc(&BLEDATA_TRANSMITQUEUE,field_l + 2);
+       if(new_buffer==NULL) return false;
+       new_buffer[0] = field_l & 0xFF;
+       new_buffer[1] = (field_l >> 8) & 0xFF;
+       if(message!=NULL) APP_DmaCopy(&new_buffer[2],message,message_l);
+       if(body!=NULL) APP_DmaCopy(&new_buffer[2 + message_l],body,body_l);
+#if BLECB_Pipe_TX_LOCKED
+       // The stream digest and the nonce follow the queue order: hashed, sealed and queued in one go
+       vTaskSuspendAll();
+       if(BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_TRANSMITQUEUE)==0){
+           (void)xTaskResumeAll();
+           BLECB_Pipe_DATA_QUEUE_Free(&BLEDATA_TRANSMITQUEUE,new_buffer);
+           return false;
+       }
+#if APP_DIGEST_ENABLE
+       if(protect & BLECB_Pipe_TX_DIGEST_END) APP_DigestTxEnd(&new_buffer[2]);
+       else if(protect & BLECB_Pipe_TX_DIGEST) {
+           APP_DigestTx(&new_buffer[2],plain_l);
+           plain_l += APP_DIGEST_TRAILER_LEN;
+       }
+#endif
+#if APP_AEAD_ENABLE
+       if((protect & BLECB_Pipe_TX_SEAL) && !APP_AeadSeal(&new_buffer[2],plain_l)){
+           (void)xTaskResumeAll();
+           BLECB_Pipe_DATA_QUEUE_Free(&BLEDATA_TRANSMITQUEUE,new_buffer);
+           return false;
+       }
+#endif
+#endif
+       if(BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(field_l + 2,new_buffer,&BLEDATA_TRANSMITQUEUE,timestamp)==-1){
+#if BLECB_Pipe_TX_LOCKED
+           (void)xTaskResumeAll();
+#endif
+           BLECB_Pipe_DATA_QUEUE_Free(&BLEDATA_TRANSMITQUEUE,new_buffer);
            return false;
        } 
+#if BLECB_Pipe_TX_LOCKED
+       (void)xTaskResumeAll();
+#endif
+       APP_TRACE(APP_TRACE_EVT_PIPE_TX_ENQ, BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_TRANSMITQUEUE), field_l + 2);
        return true;
     }else{
         return false;
@@ -321,14 +587,87 @@ bool BLECB_Pipe_dataqueue_InsertInTXQueue(uint8_t * message, uint16_t message_l)
 }
 
 
+/**
+ * BLECB PIPE Data Queue INSERT IN TX QUEUE
+ * @param message
+ * @param message_l
+ * @return false if neither the TX queue nor the flash spill took it
+ */
+bool BLECB_Pipe_dataqueue_InsertInTXQueue(uint8_t * message, uint16_t message_l){
+#if APP_AEAD_ENABLE
+    // No session yet: there is no key to seal it with
+    if(!APP_AeadTxReady()) return false;
+#endif
+#if APP_SPILL_ENABLE
+    // Once a message is spilled the following ones go after it, until the flash ring is read back
+    if(APP_SpillIsEmpty(APP_SPILL_TX) && BLECB_Pipe_dataqueue_QueueTX(message,message_l,NULL,0,APP_LatNow(),BLECB_Pipe_TX_PROTECT)) return true;
+    return APP_SpillPut(APP_SPILL_TX,message,message_l,APP_LatNow());
+#else
+    return BLECB_Pipe_dataqueue_QueueTX(message,message_l,NULL,0,APP_LatNow(),BLECB_Pipe_TX_PROTECT);
+#endif
+}
+
+
+#if APP_SPILL_ENABLE
+/**
+ * BLECB PIPE Data Queue READ SPILLED DATA BACK INTO THE QUEUES, OLDEST FIRST, AS THEY DRAIN
+ */
+static void BLECB_Pipe_dataqueue_ReadBack( void ){
+    const uint8_t * record;
+    uint8_t * newbuffer;
+    uint16_t dataLength;
+    uint32_t timestamp;
+    
+    BLECB_Pipe_ReadBackNoBuffer = false;
+    while(BLEDATA_TRANSMITQUEUE.currentAlloc < BLECB_Pipe_TX_READBACK_WATERMARK)
+    {
+        record = APP_SpillPeek(APP_SPILL_TX,&dataLength,&timestamp);
+        if(record==NULL) break;
+        if(!BLECB_Pipe_dataqueue_QueueTX(record,dataLength,NULL,0,timestamp,BLECB_Pipe_TX_PROTECT)){
+            BLECB_Pipe_ReadBackNoBuffer = true;
+            break;
+        }
+        APP_SpillPop(APP_SPILL_TX);
+    }
+    while(BLEDATA_RECEIVEQUEUE.currentAlloc < BLECB_Pipe_RX_PULL_WATERMARK)
+    {
+        record = APP_SpillPeek(APP_SPILL_RX,&dataLength,&timestamp);
+        if(record==NULL) return;
+        newbuffer = NULL;
+        if(BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_RECEIVEQUEUE)>0)
+            newbuffer = BLECB_Pipe_DATA_QUEUE_Alloc(&BLEDATA_RECEIVEQUEUE,dataLength);
+        if(newbuffer==NULL){
+            BLECB_Pipe_ReadBackNoBuffer = true;
+            return;
+        }
+        memcpy(newbuffer,record,dataLength);
+        BLECB_Pipe_DATA_QUEUE_InsertDataToCircQueue(dataLength,newbuffer,&BLEDATA_RECEIVEQUEUE,timestamp);
+        APP_SpillPop(APP_SPILL_RX);
+        APP_TRACE(APP_TRACE_EVT_PIPE_RX_ENQ, BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_RECEIVEQUEUE), dataLength);
+    }
+}
+
+
+/**
+ * BLECB PIPE Data Queue CHECK IF SPILLED DATA CAN BE READ BACK NOW
+ * @return
+ */
+static bool BLECB_Pipe_dataqueue_ReadBackReady( void ){
+    uint16_t dataLength;
+    uint32_t timestamp;
+    
+    if(BLEDATA_TRANSMITQUEUE.currentAlloc < BLECB_Pipe_TX_READBACK_WATERMARK && APP_SpillPeek(APP_SPILL_TX,&dataLength,&timestamp)!=NULL) return true;
+    return BLEDATA_RECEIVEQUEUE.currentAlloc < BLECB_Pipe_RX_PULL_WATERMARK && APP_SpillPeek(APP_SPILL_RX,&dataLength,&timestamp)!=NULL;
+}
+#endif
+
+
 /**
  * BLECB PIPE NOTIFY MAIN APP
  * @param msgid
  */
 void BLECB_Pipe_Notify_APP(int msgid){
-    APP_Msg_T appMsg;
-    appMsg.msgId = msgid;
-    OSAL_QUEUE_Send(&appData.appQueue, &appMsg, 0);
+    APP_MsgSend(msgid, NULL, 0);
 }
 
 
@@ -337,10 +676,7 @@ void BLECB_Pipe_Notify_APP(int msgid){
  * @param msgid
  */
 void BLECB_Pipe_Notify_APP_with_Data(int msgid, uint8_t * data, uint8_t size){
-    APP_Msg_T appMsg;
-    appMsg.msgId = msgid;
-    memcpy((uint8_t *)appMsg.msgData,data,size);
-    OSAL_QUEUE_Send(&appData.appQueue, &appMsg, 0);
+    APP_MsgSend(msgid, data, size);
 }
 
 
@@ -350,9 +686,22 @@ void BLECB_Pipe_Notify_APP_with_Data(int msgid, uint8_t * data, uint8_t size){
 void BLECB_Pipe_ProcessTXQueue( void ){
     if(appData.state!=APP_STATE_SERVICE_TASKS) return;
     if(BLECB_Pipe_DATA_QUEUE_Is_Empty(&BLEDATA_TRANSMITQUEUE)) return;
+#if APP_LOG_ENABLE
+    // A data log batch is one message spread over many SDUs: nothing goes in between
+    if(APP_LogIsSending()) return;
+#endif
     BLECB_Pipe_DATA_QUEUE_QueueElement * element = BLECB_Pipe_DATA_QUEUE_GetElemCircQueue(&BLEDATA_TRANSMITQUEUE);
     if(element!=NULL){
-        BLE_TRCBPS_SendData(ActiveConnectionHandle,element->dataLeng,element->p_data);
+        uint16_t ret = BLE_TRCBPS_SendData(ActiveConnectionHandle,element->dataLeng,element->p_data);
+        APP_TRACE(APP_TRACE_EVT_SDU_TX, (ret==MBA_RES_SUCCESS) ? 0 : 1, element->dataLeng);
+        if(ret==MBA_RES_SUCCESS)
+            APP_LatRecord(APP_LAT_STAGE_TX_TO_SDU, element->timestamp);
+        else if(ret==MBA_RES_NO_RESOURCE || ret==MBA_RES_OOM){
+            // Out of peer credits or stack buffers: keep the element until they come back
+            BLECB_Pipe_TxStalled = true;
+            return;
+        }
+        APP_TRACE(APP_TRACE_EVT_PIPE_TX_DEQ, BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_TRANSMITQUEUE), element->dataLeng);
         BLECB_Pipe_DATA_QUEUE_FreeElemCircQueue(&BLEDATA_TRANSMITQUEUE);
     }
 }
@@ -363,6 +712,9 @@ void BLECB_Pipe_ProcessTXQueue( void ){
  * @param rx
  */
 void BLECB_Pipe_CheckIfSpeedTest( uint16_t rx ){
+    if(MESSAGE_BUFFER==NULL) {
+        reck += rx;return;
+    }
     if(memcmp(MESSAGE_BUFFER,"\nSTART\n",7)==0) {
         BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_FILE_TX_START);
         start = xTaskGetTickCount();reck = 0;return;
@@ -370,12 +722,11 @@ void BLECB_Pipe_CheckIfSpeedTest( uint16_t rx ){
     if(memcmp(MESSAGE_BUFFER,"\nSTOP \n",7)==0) {
         long elapsedTicks = xTaskGetTickCount() - start;
         reck += 7;
-        uint8_t speed[52];
         long s = (reck * 1000) / elapsedTicks;
         uint16_t integers = s / 1000 ;
         uint16_t decimals = s - (integers * 1000);
-        sprintf((char *)speed,"\nTX SPEED: %-2d.%03d KBytes/sec (%-7ldB in %-5ldms)\n",integers,decimals,reck,elapsedTicks);
-        BLECB_Pipe_Notify_APP_with_Data(APP_MSG_BLECB_PIPE_FILE_TX_END,(uint8_t *)speed, 51);
+        // Formatted on the host (tools/dlog_decoder.py) when deferred logging is on
+        APP_DLOG("\nTX SPEED: %-2d.%03d KBytes/sec (%-7ldB in %-5ldms)\n",integers,decimals,reck,elapsedTicks);
         return;
     }
     reck += rx;
@@ -383,6 +734,107 @@ void BLECB_Pipe_CheckIfSpeedTest( uint16_t rx ){
 }
 
 
+/**
+ * CHECK IF A DIAGNOSTIC COMMAND (HEAP, PROFILE, TRACE, DMA BENCHMARK, HCI CAPTURE, FLASH SPILL, AES BENCHMARK, DIGEST) WAS RECEIVED
+ * @param rx
+ */
+void BLECB_Pipe_CheckIfDiagRequest( uint16_t rx ){
+    if(rx!=7 || MESSAGE_BUFFER==NULL) return;
+    if(memcmp(MESSAGE_BUFFER,"\nHEAP \n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_HEAP_DUMP);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nPROF \n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_PROF_REPORT);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nPROFR\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_PROF_RESET);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nTRCDP\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_TRACE_DUMP);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nTRCON\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_TRACE_START);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nTRCOF\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_TRACE_STOP);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nDMABM\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_DMA_BENCH);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nSNPON\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_SNOOP_START);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nSNPOF\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_SNOOP_STOP);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nSPILL\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_SPILL_REPORT);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nAESBM\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_AES_BENCH);
+    }
+    else if(memcmp(MESSAGE_BUFFER,"\nDIGST\n",7)==0) {
+        BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_DIGEST_REPORT);
+    }
+}
+
+
+/**
+ * BLECB PIPE Whether a DFU or data log message, which come in clear, may be
+ * taken: with APP_AEAD_ENABLE only from a peer that has shown the shared key
+ */
+static bool BLECB_Pipe_ClearAllowed( void ){
+#if APP_AEAD_ENABLE
+    return APP_AeadRxReady();
+#else
+    return true;
+#endif
+}
+
+
+/**
+ * BLECB PIPE DELIVER THE MESSAGE JUST REASSEMBLED
+ */
+void BLECB_Pipe_DeliverMessage( void ){
+#if APP_DFU_ENABLE
+    if(MESSAGE_DFU) {
+        if(MESSAGE_BUFFER==NULL) BLECB_Pipe_RxDropped++;
+        else if(BLECB_Pipe_ClearAllowed()) APP_DfuRxMessage(MESSAGE_BUFFER,MESSAGE_L);
+        return;
+    }
+#endif
+#if APP_LOG_ENABLE
+    if(MESSAGE_BUFFER!=NULL && APP_LogIsMessage(MESSAGE_BUFFER,MESSAGE_L)) {
+        if(BLECB_Pipe_ClearAllowed()) APP_LogRxMessage(MESSAGE_BUFFER,MESSAGE_L);
+        return;
+    }
+#endif
+#if APP_AEAD_ENABLE
+    // Opened in place; the session handshake and anything that fails to open stop here
+    if(MESSAGE_BUFFER==NULL) {
+        APP_AeadRxLost();
+        BLECB_Pipe_RxDropped++;
+        return;
+    }
+    int32_t opened = APP_AeadRxMessage(MESSAGE_BUFFER,MESSAGE_L);
+    if(opened<0) return;
+    MESSAGE_L = (uint16_t)opened;
+#endif
+#if APP_DIGEST_ENABLE
+    // Trailer checked and removed, or the stream end marker checked and consumed
+    if(MESSAGE_BUFFER!=NULL) {
+        int32_t checked = APP_DigestRxMessage(MESSAGE_BUFFER,MESSAGE_L);
+        if(checked<0) return;
+        MESSAGE_L = (uint16_t)checked;
+    }
+#endif
+    BLECB_Pipe_CheckIfSpeedTest(MESSAGE_L);
+    BLECB_Pipe_CheckIfDiagRequest(MESSAGE_L);
+    if(MESSAGE_BUFFER==NULL) BLECB_Pipe_RxDropped++;
+    else if(BLECB_Pipe_ReceivedDataCallback!=NULL) BLECB_Pipe_ReceivedDataCallback(MESSAGE_BUFFER,MESSAGE_L);
+}
+
+
 /**
  * BLECB PIPE Data Queue PROCESS RX QUEUE
  */
@@ -395,48 +847,66 @@ void BLECB_Pipe_ProcessRXQueue( void ){
         
         if(MESSAGE_L==0)
         {
+#if APP_DFU_ENABLE
+            MESSAGE_DFU = element->dataLeng > 2 && APP_DfuIsMessage(&element->p_data[2], element->dataLeng - 2);
+#endif
+            if(!BLECB_Pipe_dataqueue_LaneReady((((element->p_data[1]&0xFF)<<8) | (element->p_data[0]&0xFF)) & 0xFFFF)) return;
             uint16_t elementbytesMinusSize = element->dataLeng - 2;
             elementbytesCopied = elementbytesMinusSize;
             MESSAGE_L = (((element->p_data[1]&0xFF)<<8) | (element->p_data[0]&0xFF)) & 0xFFFF;
-            MESSAGE_BUFFER = OSAL_Malloc(MESSAGE_L);
+#if APP_DIGEST_ENABLE && !APP_AEAD_ENABLE
+            // Hashed as the SDUs leave the queue (sealed ones once opened); firmware update messages are not
+            APP_DigestRxStart(MESSAGE_DFU ? 0 : MESSAGE_L);
+#endif
+            MESSAGE_BUFFER = BLECB_Pipe_MessageAlloc(MESSAGE_L);
             if(elementbytesMinusSize>MESSAGE_L) elementbytesCopied = MESSAGE_L;
-            memcpy(MESSAGE_BUFFER,&element->p_data[2],elementbytesCopied);
+            // Without a buffer the message is still consumed from the queue, then dropped
+            if(MESSAGE_BUFFER!=NULL) APP_DmaCopy(MESSAGE_BUFFER,&element->p_data[2],elementbytesCopied);
+#if APP_DIGEST_ENABLE && !APP_AEAD_ENABLE
+            if(MESSAGE_BUFFER!=NULL) APP_DigestRxData(&element->p_data[2],elementbytesCopied);
+#endif
             MESSAGE_PARTIAL_L = elementbytesCopied;
             BLECB_Pipe_DATA_QUEUE_SetElemProcessedAmount(&BLEDATA_RECEIVEQUEUE,elementbytesCopied+2);
 
             if(MESSAGE_PARTIAL_L == MESSAGE_L) {
-                // fire callback
-                BLECB_Pipe_CheckIfSpeedTest(MESSAGE_L);
-                if(BLECB_Pipe_ReceivedDataCallback!=NULL) BLECB_Pipe_ReceivedDataCallback(MESSAGE_BUFFER,MESSAGE_L);
+                // fire callback; the latency runs from the SDU that completed the message
+                APP_LatRecord(APP_LAT_STAGE_SDU_TO_RX_CB, element->timestamp);
+                BLECB_Pipe_DeliverMessage();
                 MESSAGE_L = 0;
                 MESSAGE_PARTIAL_L = 0;
-                OSAL_Free(MESSAGE_BUFFER);
+                if(MESSAGE_BUFFER!=NULL) BLECB_Pipe_MessageFree(MESSAGE_BUFFER);
                 MESSAGE_BUFFER = NULL;
             }
             if(element->processedUpTo == element->dataLeng){
+                APP_TRACE(APP_TRACE_EVT_PIPE_RX_DEQ, BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_RECEIVEQUEUE), element->dataLeng);
                 BLECB_Pipe_DATA_QUEUE_FreeElemCircQueue(&BLEDATA_RECEIVEQUEUE);
             }
         } else {
+            if(!BLECB_Pipe_dataqueue_LaneReady(MESSAGE_L)) return;
            
             uint16_t bytestocompletemessage = MESSAGE_L - MESSAGE_PARTIAL_L;
             uint16_t bytesInElement = element->dataLeng - element->processedUpTo;
             elementbytesCopied = bytesInElement;
             if(bytesInElement>bytestocompletemessage) elementbytesCopied = bytestocompletemessage;
-            memcpy(&MESSAGE_BUFFER[MESSAGE_PARTIAL_L],&element->p_data[element->processedUpTo],elementbytesCopied);
+            if(MESSAGE_BUFFER!=NULL) APP_DmaCopy(&MESSAGE_BUFFER[MESSAGE_PARTIAL_L],&element->p_data[element->processedUpTo],elementbytesCopied);
+#if APP_DIGEST_ENABLE && !APP_AEAD_ENABLE
+            if(MESSAGE_BUFFER!=NULL) APP_DigestRxData(&element->p_data[element->processedUpTo],elementbytesCopied);
+#endif
             MESSAGE_PARTIAL_L += elementbytesCopied;
             uint16_t processed = element->processedUpTo + elementbytesCopied;
             BLECB_Pipe_DATA_QUEUE_SetElemProcessedAmount(&BLEDATA_RECEIVEQUEUE,processed);
             
             if(MESSAGE_PARTIAL_L == MESSAGE_L) {
-                // fire callback
-                BLECB_Pipe_CheckIfSpeedTest(MESSAGE_L);
-                if(BLECB_Pipe_ReceivedDataCallback!=NULL) BLECB_Pipe_ReceivedDataCallback(MESSAGE_BUFFER,MESSAGE_L);
+                // fire callback; the latency runs from the SDU that completed the message
+                APP_LatRecord(APP_LAT_STAGE_SDU_TO_RX_CB, element->timestamp);
+                BLECB_Pipe_DeliverMessage();
                 MESSAGE_L = 0;
                 MESSAGE_PARTIAL_L = 0;
-                OSAL_Free(MESSAGE_BUFFER);
+                if(MESSAGE_BUFFER!=NULL) BLECB_Pipe_MessageFree(MESSAGE_BUFFER);
                 MESSAGE_BUFFER = NULL;
             }
             if(element->processedUpTo == element->dataLeng){
+                APP_TRACE(APP_TRACE_EVT_PIPE_RX_DEQ, BLECB_Pipe_DATA_QUEUE_GetValidCircQueueNum(&BLEDATA_RECEIVEQUEUE), element->dataLeng);
                 BLECB_Pipe_DATA_QUEUE_FreeElemCircQueue(&BLEDATA_RECEIVEQUEUE);
             }   
         }      
@@ -450,10 +920,71 @@ void BLECB_Pipe_ProcessRXQueue( void ){
  */
 void _blecb_pipe_QUEUE_Task(  void *pvParameters  )
 {   
+    STACK_Event_T * p_stackEvt;
+    uint16_t wait;
+#if APP_DFU_ENABLE
+    uint16_t dfuWait;
+#endif
+#if APP_LOG_ENABLE
+    bool logPending = false;
+#endif
+#if APP_SPILL_ENABLE
+    uint16_t spillWait;
+#endif
+    bool rxEmpty, txEmpty;
+    
     while(1)
     {
+        //--- SLEEP UNTIL AN EVENT OR NEW TX DATA ARRIVES WHEN THERE IS NOTHING TO PROCESS
+        rxEmpty = BLECB_Pipe_DATA_QUEUE_Is_Empty(&BLEDATA_RECEIVEQUEUE);
+        txEmpty = BLECB_Pipe_DATA_QUEUE_Is_Empty(&BLEDATA_TRANSMITQUEUE);
+#if APP_LOG_ENABLE
+        txEmpty = txEmpty && !logPending;    // an offload waits for credits like the TX queue
+#endif
+        if(rxEmpty && txEmpty)
+            wait = OSAL_WAIT_FOREVER;
+        else if(appData.state!=APP_STATE_SERVICE_TASKS)
+            wait = 1;
+        else if((!rxEmpty && !BLECB_Pipe_RxHeld) || (!txEmpty && !BLECB_Pipe_TxStalled))
+            wait = 0;
+        else if(BLECB_Pipe_RxHeld)
+            wait = BLECB_Pipe_SINK_POLL_MS;     // the sink drains without an event
+        else
+            wait = BLECB_Pipe_TX_RETRY_MS;      // credits normally come back as an event first
+#if APP_DFU_ENABLE
+        //--- FIRMWARE UPDATE FLASH WORK AND RESPONSES; THE NVM INTERRUPT WAKES US WHEN AN OPERATION IS DONE
+        dfuWait = APP_DfuTasks();
+        if(dfuWait < wait) wait = dfuWait;
+#endif
+#if APP_SPILL_ENABLE
+        //--- FLASH SPILL: WRITES THE FLASH QUEUE REFUSED, AND THE READ BACK ONCE A ROW IS PROGRAMMED (THE NVM INTERRUPT WAKES US)
+        spillWait = APP_SpillTasks();
+        if(spillWait < wait) wait = spillWait;
+        if(BLECB_Pipe_dataqueue_ReadBackReady()){
+            // Retried on a timer when it ran out of buffers; the TX retry period fits
+            spillWait = BLECB_Pipe_ReadBackNoBuffer ? BLECB_Pipe_TX_RETRY_MS : 0;
+            if(spillWait < wait) wait = spillWait;
+        }
+#endif
+        
+        //--- STACK EVENTS FIRST: THEY CARRY THE DATA AND THE CREDITS
+        while(OSAL_QUEUE_Receive(&BLECB_Pipe_EventQueue, &p_stackEvt, wait) == OSAL_RESULT_TRUE)
+        {
+            if(p_stackEvt!=NULL) BLECB_Pipe_Process_Stack_Event(p_stackEvt);
+            wait = 0;
+        }
+        BLECB_Pipe_TxStalled = false;
+        
         BLECB_Pipe_ProcessRXQueue();
+#if APP_SPILL_ENABLE
+        BLECB_Pipe_dataqueue_ReadBack();
+#endif
+        BLECB_Pipe_dataqueue_PullRXData();
         BLECB_Pipe_ProcessTXQueue();
+#if APP_LOG_ENABLE
+        //--- DATA LOG OFFLOAD: AS MANY SDUs AS THE CREDITS ALLOW, STRAIGHT FROM FLASH
+        logPending = APP_LogTasks();
+#endif
     }
 }
 
@@ -462,7 +993,13 @@ void _blecb_pipe_QUEUE_Task(  void *pvParameters  )
  * BLECB PIPE FREERTOS TASK CREATION
  */
 void BLECB_Pipe_Task(void){
-    xTaskCreate((TaskFunction_t) _blecb_pipe_QUEUE_Task,
+#if APP_STATIC_ALLOC
+    APP_StaticArenaInit(&s_pipeTxArena, "PIPE_TX", s_pipeTxArena_mem, sizeof(s_pipeTxArena_mem));
+    APP_StaticArenaInit(&s_pipeRxArena, "PIPE_RX", s_pipeRxArena_mem, sizeof(s_pipeRxArena_mem));
+#endif
+    if(BLECB_Pipe_EventQueue==NULL)
+        APP_STATIC_QUEUE_CREATE(&BLECB_Pipe_EventQueue, BLECB_Pipe_EVENT_QUEUE_LENGTH, sizeof(STACK_Event_T *));
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _blecb_pipe_QUEUE_Task,
                 "QUEUES_Task",
                 1024,
                 NULL,
@@ -473,6 +1010,30 @@ void BLECB_Pipe_Task(void){
 
 
 
+/**
+ * BLECB PIPE TRCBPS VENDOR COMMAND: LATENCY REPORT / RESET
+ * @param p_cmd
+ */
+static void BLECB_Pipe_Process_Vendor_Cmd(BLE_TRCBPS_EvtVendorCmd_T *p_cmd){
+    uint8_t report[APP_LAT_REPORT_SIZE];
+    uint8_t action;
+    uint8_t stage;
+
+    if(p_cmd->p_payLoad[0]!=APP_LAT_VENDOR_OPCODE) return;
+    action = (p_cmd->length > 1) ? p_cmd->p_payLoad[1] : APP_LAT_CMD_REPORT;
+    if(action==APP_LAT_CMD_REPORT || action==APP_LAT_CMD_REPORT_RESET) {
+        // One notification per stage so a report fits the default ATT MTU
+        for(stage = 0; stage < APP_LAT_STAGE_NUM; stage++) {
+            APP_LatBuildReport((APP_LAT_Stage_T)stage, report);
+            BLE_TRCBPS_SendVendorCommand(p_cmd->connHandle, APP_LAT_VENDOR_OPCODE, APP_LAT_REPORT_SIZE, report);
+        }
+    }
+    if(action==APP_LAT_CMD_RESET || action==APP_LAT_CMD_REPORT_RESET) {
+        APP_LatReset();
+    }
+}
+
+
 /**
  * BLECB PIPE TRCBPS EVENT Consumer
  * @param p_event
@@ -482,15 +1043,55 @@ void BLECB_Pipe_Process_TRCB_Event(BLE_TRCBPS_Event_T *p_event)
     switch(p_event->eventId)
     {
         
+        case BLE_TRCBPS_EVT_CONNECTION_STATUS:
+        {
+            if(p_event->eventField.connStatus.chanType==BLE_TRCBPS_DATA_CHAN &&
+               p_event->eventField.connStatus.status==BLE_TRCBPS_STATUS_CONNECTED)
+                BLECB_Pipe_PeerMtu = p_event->eventField.connStatus.peerMtu;
+        }
+        break;
         case BLE_TRCBPS_EVT_RECEIVE_DATA:
         {
             BLECB_Pipe_dataqueue_InsertInRXQueue(p_event);
         }
         break;
+        case BLE_TRCBPS_EVT_VENDOR_CMD:
+        {
+            BLECB_Pipe_Process_Vendor_Cmd(&p_event->eventField.onVendorCmd);
+        }
+        break;
+        default:
+        break;
+    }
+}
+
+#if APP_TRCBPC_ENABLE
+/**
+ * BLECB PIPE TRCBPC EVENT Consumer: drop links on which no pipe can be opened
+ * @param p_event
+ */
+static void BLECB_Pipe_Process_TRCBPC_Event(BLE_TRCBPC_Event_T *p_event)
+{
+    switch(p_event->eventId)
+    {
+        case BLE_TRCBPC_EVT_PSM_READ:
+        {
+            if(p_event->eventField.onPsmRead.result!=MBA_RES_SUCCESS)
+            {
+                BLE_GAP_Disconnect(p_event->eventField.onPsmRead.connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+            }
+        }
+        break;
+        case BLE_TRCBPC_EVT_DISC_FAIL:
+        {
+            BLE_GAP_Disconnect(p_event->eventField.onDiscFail.connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+        }
+        break;
         default:
         break;
     }
 }
+#endif
 
 /**
  * BLECB PIPE Initialization
@@ -500,6 +1101,54 @@ void BLECB_Pipe_Init(pipedatarecived_callback rxcallback){
     phyInUse = DEFAULTPHY;
     BLE_TRCBPS_EventRegister(BLECB_Pipe_Process_TRCB_Event);
     BLECB_Pipe_dataqueue_Init(rxcallback);
+#if APP_DFU_ENABLE
+    APP_DfuInit();
+#endif
+#if APP_SPILL_ENABLE
+    APP_SpillInit();
+#endif
+#if APP_AEAD_ENABLE
+    APP_AeadInit();
+#endif
+#if APP_DIGEST_ENABLE
+    APP_DigestInit();
+#endif
+    
+    //--- ROUTE THE PIPE AND TRCBPS EVENTS TO THE PIPE TASK
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_GAP,
+                              APP_BLE_EVT_MASK(BLE_GAP_EVT_CONNECTED) | APP_BLE_EVT_MASK(BLE_GAP_EVT_DISCONNECTED) |
+                              APP_BLE_EVT_MASK(BLE_GAP_EVT_PHY_UPDATE) | APP_BLE_EVT_MASK(BLE_GAP_EVT_ENCRYPT_STATUS) |
+                              APP_BLE_EVT_MASK(BLE_GAP_EVT_TX_BUF_AVAILABLE),
+                              BLECB_Pipe_Event_Sink);
+#if APP_TRCBPC_ENABLE
+    //--- CENTRAL ROLE: ADVERTISING REPORTS AND THE GATT CLIENT PROCEDURES OF TRCBPC
+    BLE_TRCBPC_EventRegister(BLECB_Pipe_Process_TRCBPC_Event);
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_GAP, APP_BLE_EVT_MASK(BLE_GAP_EVT_ADV_REPORT), BLECB_Pipe_Event_Sink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_GATT,
+                              APP_BLE_EVT_MASK(GATTC_EVT_ERROR_RESP) | APP_BLE_EVT_MASK(GATTC_EVT_DISC_PRIM_SERV_BY_UUID_RESP) |
+                              APP_BLE_EVT_MASK(GATTC_EVT_DISC_CHAR_BY_UUID_RESP) | APP_BLE_EVT_MASK(GATTC_EVT_READ_RESP) |
+                              APP_BLE_EVT_MASK(GATTC_EVT_PROTOCOL_AVAILABLE) | APP_BLE_EVT_MASK(ATT_EVT_TIMEOUT),
+                              BLECB_Pipe_Event_Sink);
+#endif
+    APP_BleEvtRouterSubscribe(STACK_GRP_BLE_L2CAP,
+                              APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_CONN_IND) | APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_CONN_FAIL_IND) |
+                              APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_SDU_IND) | APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_ADD_CREDITS_IND) |
+                              APP_BLE_EVT_MASK(BLE_L2CAP_EVT_CB_DISC_IND),
+                              BLECB_Pipe_Event_Sink);
+    APP_BleEvtRouterSubscribe(STACK_GRP_GATT,
+                              APP_BLE_EVT_MASK(ATT_EVT_UPDATE_MTU) | APP_BLE_EVT_MASK(GATTS_EVT_WRITE),
+                              BLECB_Pipe_Event_Sink);
+}
+
+
+/**
+ * BLECB PIPE Register the RX sink space callback
+ * @param spacecallback returns the bytes the RX callback can take right now
+ * @param sinksize total size of the sink
+ */
+void BLECB_Pipe_SetRxFlowControl(pipesinkspace_callback spacecallback, uint16_t sinksize){
+    BLECB_Pipe_SinkSize = sinksize;
+    BLECB_Pipe_SinkSpaceCallback = spacecallback;
 }
 
 
@@ -507,9 +1156,135 @@ void BLECB_Pipe_Init(pipedatarecived_callback rxcallback){
  * BLECB PIPE Send Data
  * @param msg
  * @param size
+ * @return false if the TX queue is full, the message was not taken
  */
-void BLECB_Pipe_SendData(uint8_t * msg, uint16_t size){
-    BLECB_Pipe_dataqueue_InsertInTXQueue((uint8_t *)msg,size);
+bool BLECB_Pipe_SendData(uint8_t * msg, uint16_t size){
+    STACK_Event_T * p_wake = NULL;
+    if(!BLECB_Pipe_dataqueue_InsertInTXQueue((uint8_t *)msg,size)) return false;
+    OSAL_QUEUE_Send(&BLECB_Pipe_EventQueue, &p_wake, 0);
+    return true;
+}
+
+/**
+ * BLECB PIPE Send Data in clear and without a digest, for the session
+ * handshake, which has no key to seal with yet
+ * @param msg
+ * @param size
+ * @return false if the TX queue is full, the message was not taken
+ */
+bool BLECB_Pipe_SendPlain(uint8_t * msg, uint16_t size){
+#if BLECB_Pipe_TX_LOCKED
+    STACK_Event_T * p_wake = NULL;
+    if(!BLECB_Pipe_dataqueue_QueueTX(msg,size,NULL,0,APP_LatNow(),0)) return false;
+    OSAL_QUEUE_Send(&BLECB_Pipe_EventQueue, &p_wake, 0);
+    return true;
+#else
+    return BLECB_Pipe_SendData(msg,size);
+#endif
+}
+
+/**
+ * BLECB PIPE Send a DFU or data log message without a digest: sealed in the
+ * session with APP_AEAD_ENABLE, in clear otherwise. The header and the body
+ * are queued as one message; the body may point into flash
+ * @param hdr
+ * @param hdr_l
+ * @param body may be NULL
+ * @param body_l
+ * @return false if the TX queue is full or there is no session, the message was not taken
+ */
+bool BLECB_Pipe_SendProto(const uint8_t * hdr, uint16_t hdr_l, const uint8_t * body, uint16_t body_l){
+    STACK_Event_T * p_wake = NULL;
+#if APP_AEAD_ENABLE
+    if(!APP_AeadTxReady()) return false;
+    if(!BLECB_Pipe_dataqueue_QueueTX(hdr,hdr_l,body,body_l,APP_LatNow(),BLECB_Pipe_TX_SEAL)) return false;
+#else
+    if(!BLECB_Pipe_dataqueue_QueueTX(hdr,hdr_l,body,body_l,APP_LatNow(),0)) return false;
+#endif
+    OSAL_QUEUE_Send(&BLECB_Pipe_EventQueue, &p_wake, 0);
+    return true;
+}
+
+/**
+ * BLECB PIPE Send the digest of the messages sent since the last call
+ * (APP_DIGEST_PER_STREAM), after them
+ * @return false if the TX queue is full or spilled messages are still to be
+ * queued (they belong to the stream), or without APP_DIGEST_PER_STREAM
+ */
+bool BLECB_Pipe_SendDigest( void ){
+#if APP_DIGEST_ENABLE && APP_DIGEST_PER_STREAM
+    STACK_Event_T * p_wake = NULL;
+#if APP_AEAD_ENABLE
+    if(!APP_AeadTxReady()) return false;
+#endif
+#if APP_SPILL_ENABLE
+    if(!APP_SpillIsEmpty(APP_SPILL_TX)) return false;
+#endif
+    if(!BLECB_Pipe_dataqueue_QueueTX(NULL,APP_DIGEST_MARKER_LEN,NULL,0,APP_LatNow(),BLECB_Pipe_TX_SEAL | BLECB_Pipe_TX_DIGEST_END)) return false;
+    OSAL_QUEUE_Send(&BLECB_Pipe_EventQueue, &p_wake, 0);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * BLECB PIPE Send an SDU right away, around the TX queue; the stack copies it
+ * so it may point into flash. Pipe task only
+ * @param sdu
+ * @param size up to BLECB_Pipe_GetSduMax()
+ * @return false if out of peer credits or stack buffers, retry after the next stack event
+ */
+bool BLECB_Pipe_SendSdu(uint8_t * sdu, uint16_t size){
+    uint16_t ret = BLE_TRCBPS_SendData(ActiveConnectionHandle,size,sdu);
+    APP_TRACE(APP_TRACE_EVT_SDU_TX, (ret==MBA_RES_SUCCESS) ? 0 : 1, size);
+    if(ret==MBA_RES_NO_RESOURCE || ret==MBA_RES_OOM){
+        BLECB_Pipe_TxStalled = true;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * BLECB PIPE Largest SDU the peer takes
+ * @return peer MTU of the data channel, or the local one before it is known
+ */
+uint16_t BLECB_Pipe_GetSduMax(void){
+    if(BLECB_Pipe_PeerMtu==0 || BLECB_Pipe_PeerMtu>BLE_TRCBPS_DATA_MTU) return BLE_TRCBPS_DATA_MTU;
+    return BLECB_Pipe_PeerMtu;
+}
+
+/**
+ * BLECB PIPE Connection handle and peer CID of the data channel
+ * @param p_connHandle
+ * @param p_peerCid
+ * @return false while the data channel is closed
+ */
+bool BLECB_Pipe_GetChannel(uint16_t * p_connHandle, uint16_t * p_peerCid){
+    if(BLECB_Pipe_PeerCid==0) return false;
+    *p_connHandle = ActiveConnectionHandle;
+    *p_peerCid = BLECB_Pipe_PeerCid;
+    return true;
+}
+
+/**
+ * BLECB PIPE Wake the pipe task, from an interrupt
+ */
+void BLECB_Pipe_WakeISR(void){
+    STACK_Event_T * p_wake = NULL;
+    OSAL_QUEUE_SendISR(&BLECB_Pipe_EventQueue, &p_wake);
+}
+
+/**
+ * BLECB PIPE Start Link: advertise, or scan for a peer pipe in the central role
+ */
+void BLECB_Pipe_StartLink(void){
+#if APP_TRCBPC_ENABLE
+    BLECB_Pipe_Connecting = false;
+    BLE_GAP_SetScanningEnable(true, BLE_GAP_SCAN_FD_ENABLE, BLE_GAP_SCAN_MODE_OBSERVER, 0);
+#else
+    BLE_GAP_SetAdvEnable(0x01, 0x00);
+#endif
 }
 
 /**
@@ -522,6 +1297,22 @@ bool BLECB_Pipe_Process_GAP_Event(BLE_GAP_Event_T * p_event){
     {
         case BLE_GAP_EVT_CONNECTED:
         {
+#if APP_TRCBPC_ENABLE
+            if(p_event->eventField.evtConnect.status!=GAP_STATUS_SUCCESS)
+            {
+                //--- PEER WENT AWAY BEFORE THE LINK CAME UP: SCAN AGAIN
+                BLECB_Pipe_StartLink();
+                return true;
+            }
+            if(p_event->eventField.evtConnect.role==BLE_GAP_ROLE_CENTRAL)
+            {
+                //--- DISCOVER THE PEER SERVICE, READ ITS PSM AND OPEN THE DATA CHANNEL
+                if(BLE_TRCBPC_ConnReq(p_event->eventField.evtConnect.connHandle)!=MBA_RES_SUCCESS)
+                {
+                    BLE_GAP_Disconnect(p_event->eventField.evtConnect.connHandle, GAP_DISC_REASON_REMOTE_TERMINATE);
+                }
+            }
+#endif
             ActiveConnectionHandle = p_event->eventField.evtConnect.connHandle;
             if(phyInUse==BLE_GAP_PHY_OPTION_2M)
             {
@@ -540,13 +1331,66 @@ bool BLECB_Pipe_Process_GAP_Event(BLE_GAP_Event_T * p_event){
             //--- CLEAN-UP DATA QUEUES
             BLECB_Pipe_DATA_QUEUE_ClearQueue(&BLEDATA_RECEIVEQUEUE);
             BLECB_Pipe_DATA_QUEUE_ClearQueue(&BLEDATA_TRANSMITQUEUE);
+            BLECB_Pipe_RxHeld = false;
+            BLECB_Pipe_RxTimesNum = 0;
+            BLECB_Pipe_TxStalled = false;
+            BLECB_Pipe_PeerMtu = 0;
+            BLECB_Pipe_PeerCid = 0;
+#if APP_DFU_ENABLE
+            APP_DfuAbort();
+#endif
+#if APP_LOG_ENABLE
+            APP_LogAbort();
+#endif
+#if APP_SPILL_ENABLE
+            APP_SpillReset();
+#endif
+#if APP_AEAD_ENABLE
+            APP_AeadReset();
+#endif
+#if APP_DIGEST_ENABLE
+            APP_DigestReset();
+#endif
              
-            //--- RE-START ADVERTISING 
-            BLE_GAP_SetAdvEnable(0x01, 0x00);
+            //--- RE-START ADVERTISING (OR SCANNING IN THE CENTRAL ROLE)
+            BLECB_Pipe_StartLink();
             
             return true;
         }
         break;
+#if APP_TRCBPC_ENABLE
+        case BLE_GAP_EVT_ADV_REPORT:
+        {
+            BLE_GAP_EvtAdvReport_T * p_report = &p_event->eventField.evtAdvReport;
+            BLE_GAP_CreateConnParams_T createConnParam;
+
+            if(BLECB_Pipe_Connecting) return true;
+            if(p_report->eventType!=BLE_GAP_ADV_REPORT_EVT_TYPE_ADV_IND && p_report->eventType!=BLE_GAP_ADV_REPORT_EVT_TYPE_SCAN_RSP) return true;
+            if(!BLE_TRCBPC_IsServiceAdvertised(p_report->length, p_report->advData)) return true;
+
+            //--- PEER PIPE FOUND: STOP SCANNING AND CONNECT
+            BLE_GAP_SetScanningEnable(false, BLE_GAP_SCAN_FD_ENABLE, BLE_GAP_SCAN_MODE_OBSERVER, 0);
+            memset(&createConnParam, 0, sizeof(createConnParam));
+            createConnParam.scanInterval = BLECB_Pipe_SCAN_INTERVAL;
+            createConnParam.scanWindow = BLECB_Pipe_SCAN_INTERVAL;
+            createConnParam.filterPolicy = BLE_GAP_INIT_FP_FILTER_ACCEPT_LIST_NOT_USED;
+            createConnParam.peerAddr = p_report->addr;
+            createConnParam.connParams.intervalMin = APP_TRCBPC_CONN_INTERVAL;
+            createConnParam.connParams.intervalMax = APP_TRCBPC_CONN_INTERVAL;
+            createConnParam.connParams.latency = 0;
+            createConnParam.connParams.supervisionTimeout = BLECB_Pipe_SUPERVISION_TIMEOUT;
+            if(BLE_GAP_CreateConnection(&createConnParam)==MBA_RES_SUCCESS)
+            {
+                BLECB_Pipe_Connecting = true;
+            }
+            else
+            {
+                BLECB_Pipe_StartLink();
+            }
+            return true;
+        }
+        break;
+#endif
         case BLE_GAP_EVT_PHY_UPDATE:
         {
             phyInUse = p_event->eventField.evtPhyUpdate.rxPhy;
@@ -574,6 +1418,7 @@ bool BLECB_Pipe_Process_L2CAP_Event(BLE_L2CAP_Event_T *p_event){
         
         case BLE_L2CAP_EVT_CB_CONN_IND:
         {
+            BLECB_Pipe_PeerCid = p_event->eventField.evtCbConnInd.remoteCid;
             BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_CONNECTED);
             return true;
         }
@@ -582,6 +1427,7 @@ bool BLECB_Pipe_Process_L2CAP_Event(BLE_L2CAP_Event_T *p_event){
         
         case BLE_L2CAP_EVT_CB_DISC_IND:
         {
+            BLECB_Pipe_PeerCid = 0;
             BLECB_Pipe_Notify_APP(APP_MSG_BLECB_PIPE_DISCONNECTED);
             return true;
         }
@@ -596,24 +1442,22 @@ bool BLECB_Pipe_Process_L2CAP_Event(BLE_L2CAP_Event_T *p_event){
 
 
 /**
- * BLECB PIPE Global Event Handler
- * @param event
- * @return 
+ * BLECB PIPE Stack Event Handler, runs in the pipe task
+ * @param p_stackEvt routed event, released here
  */
-bool BLECB_Pipe_Event_Handler(STACK_Event_T * p_stackEvt){
+static void BLECB_Pipe_Process_Stack_Event(STACK_Event_T * p_stackEvt){
     
-    bool caught = false;
     switch(p_stackEvt->groupId)
     {
         case STACK_GRP_BLE_GAP:
         {
-            caught = BLECB_Pipe_Process_GAP_Event((BLE_GAP_Event_T *)p_stackEvt->p_event);
+            BLECB_Pipe_Process_GAP_Event((BLE_GAP_Event_T *)p_stackEvt->p_event);
         }
         break;
         
         case STACK_GRP_BLE_L2CAP:
         {
-            caught = BLECB_Pipe_Process_L2CAP_Event((BLE_L2CAP_Event_T *)p_stackEvt->p_event);
+            BLECB_Pipe_Process_L2CAP_Event((BLE_L2CAP_Event_T *)p_stackEvt->p_event);
          }
         break;
         
@@ -621,10 +1465,19 @@ bool BLECB_Pipe_Event_Handler(STACK_Event_T * p_stackEvt){
         break;
     }
     
-    if(!caught) return false;
-    
-    BLE_DM_BleEventHandler(p_stackEvt);
     BLE_TRCBPS_BleEventHandler(p_stackEvt);
-    OSAL_Free(p_stackEvt->p_event);
-    return true;
-}
\ No newline at end of file
+#if APP_TRCBPC_ENABLE
+    BLE_TRCBPC_BleEventHandler(p_stackEvt);
+#endif
+    APP_BleEvtPoolRelease(p_stackEvt);
+}
+
+
+/**
+ * BLECB PIPE Router Sink, runs in the BLE stack callback
+ * @param p_stackEvt
+ * @return false if the pipe event queue is full
+ */
+static bool BLECB_Pipe_Event_Sink(STACK_Event_T * p_stackEvt){
+    return (OSAL_QUEUE_Send(&BLECB_Pipe_EventQueue, &p_stackEvt, 0) == OSAL_RESULT_TRUE);
+}
@@ -28,6 +28,7 @@
 /* ************************************************************************** */
 #include <stdbool.h>                    // Defines true
 #include "ble_trcbps/ble_trcbps.h"
+#include "app_ble_evt_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,12 +36,18 @@ extern "C" {
     
         #define BLECB_Pipe_DATA_QUEUE_MAX_ELEMENTS     255
         #define BLECB_Pipe_DATA_QUEUE_MAX_ALLOC        10240
+        #define BLECB_Pipe_EVENT_QUEUE_LENGTH          (APP_BLE_EVT_POOL_SDU_SLOTS + 8)
+        #define BLECB_Pipe_RX_PULL_WATERMARK           2048    /**< RX queue bytes above which SDUs (and credits) are left in TRCBPS, or spilled to flash */
+        #define BLECB_Pipe_TX_READBACK_WATERMARK       4096    /**< TX queue bytes below which spilled messages are read back from flash */
+        #define BLECB_Pipe_SINK_POLL_MS                1       /**< Poll period while the RX sink is full */
+        #define BLECB_Pipe_TX_RETRY_MS                 10      /**< Retry period while the peer has no credits */
 
         typedef struct 
         {
             uint16_t                   dataLeng;            /**< Data length. */
             uint8_t                    *p_data;             /**< Pointer to the data buffer */
             uint16_t                   processedUpTo;       /**< Data already processed for this element */
+            uint32_t                   timestamp;           /**< APP_LatNow() when the data entered the pipe */
         } BLECB_Pipe_DATA_QUEUE_QueueElement;
 
         typedef struct 
@@ -55,11 +62,21 @@ extern "C" {
         
         
         typedef void (* pipedatarecived_callback)(uint8_t *, uint16_t);
+        typedef uint16_t (* pipesinkspace_callback)(void);
         extern pipedatarecived_callback BLECB_Pipe_ReceivedDataCallback;
+        extern uint32_t BLECB_Pipe_RxDropped;          /**< Messages dropped for lack of a reassembly buffer */
         void BLECB_Pipe_Task(void);
         void BLECB_Pipe_Init(pipedatarecived_callback rxcallback);
-        bool BLECB_Pipe_Event_Handler(STACK_Event_T * event);
-        void BLECB_Pipe_SendData(uint8_t * msg, uint16_t size);
+        void BLECB_Pipe_SetRxFlowControl(pipesinkspace_callback spacecallback, uint16_t sinksize);
+        bool BLECB_Pipe_SendData(uint8_t * msg, uint16_t size);
+        bool BLECB_Pipe_SendPlain(uint8_t * msg, uint16_t size);   /**< As SendData, but never sealed (APP_AEAD_ENABLE) nor hashed (APP_DIGEST_ENABLE): the session handshake */
+        bool BLECB_Pipe_SendProto(const uint8_t * hdr, uint16_t hdr_l, const uint8_t * body, uint16_t body_l); /**< Header and body as one message, sealed in the session (APP_AEAD_ENABLE) but never hashed: DFU and data log */
+        bool BLECB_Pipe_SendDigest(void);              /**< End the TX digest stream (APP_DIGEST_PER_STREAM): queue its marker after the messages it covers */
+        bool BLECB_Pipe_SendSdu(uint8_t * sdu, uint16_t size);     /**< Send one SDU now, around the TX queue (pipe task only); false while out of credits */
+        uint16_t BLECB_Pipe_GetSduMax(void);           /**< Largest SDU the peer takes on the data channel */
+        bool BLECB_Pipe_GetChannel(uint16_t * p_connHandle, uint16_t * p_peerCid); /**< Connection handle and peer L2CAP CID of the data channel; false while it is closed */
+        void BLECB_Pipe_WakeISR(void);                 /**< Wake the pipe task from an interrupt, e.g. a flash completion of the firmware update */
+        void BLECB_Pipe_StartLink(void);               /**< Advertise, or scan for a peer pipe when APP_TRCBPC_ENABLE */
     
 #ifdef __cplusplus
 }
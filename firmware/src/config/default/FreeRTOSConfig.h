@@ -29,6 +29,11 @@
 #ifndef FREERTOS_CONFIG_H
 #define FREERTOS_CONFIG_H
 
+/* APP_STATIC_ALLOC and the static build heap size */
+#ifndef __ASSEMBLER__
+#include "configuration.h"
+#endif
+
 /*-----------------------------------------------------------
  * Application specific definitions.
  *
@@ -49,8 +54,13 @@
 #define configMAX_PRIORITIES                    ( 5UL )
 #define configMINIMAL_STACK_SIZE                ( 256 )
 #define configSUPPORT_DYNAMIC_ALLOCATION        1
+#if APP_STATIC_ALLOC
+#define configSUPPORT_STATIC_ALLOCATION         1
+#define configTOTAL_HEAP_SIZE                   ( ( size_t ) APP_STATIC_HEAP_SIZE )
+#else
 #define configSUPPORT_STATIC_ALLOCATION         0
 #define configTOTAL_HEAP_SIZE                   ( ( size_t ) 40960 )
+#endif
 #define configMAX_TASK_NAME_LEN                 ( 16 )
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
@@ -73,7 +83,7 @@
 
 /* Run time and task stats gathering related definitions. */
 #define configGENERATE_RUN_TIME_STATS           0
-#define configUSE_TRACE_FACILITY                0
+#define configUSE_TRACE_FACILITY                1
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
 /* Co-routine related definitions. */
@@ -106,7 +116,7 @@
 #define INCLUDE_vTaskSuspend                    1
 #define INCLUDE_vTaskDelayUntil                 1
 #define INCLUDE_vTaskDelay                      1
-#define INCLUDE_xTaskGetSchedulerState          0
+#define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       0
 #define INCLUDE_uxTaskGetStackHighWaterMark     0
 #define INCLUDE_xTaskGetIdleTaskHandle          0
@@ -120,4 +130,11 @@
 #define INCLUDE_xTaskResumeFromISR              0
 
 
+/* CPU profiler. configGENERATE_RUN_TIME_STATS is left off: its 32 bit counters
+ * wrap after 67 s at 64 MHz, app_prof.c keeps 64 bit totals from the DWT. */
+#ifndef __ASSEMBLER__
+#include "freertos_trace_hooks.h"
+#endif
+
+
 #endif /* FREERTOS_CONFIG_H */
@@ -236,6 +236,29 @@ typedef struct BLE_DM_ConnParamUpdate_T
 } BLE_DM_ConnParamUpdate_T;
 
 
+/**@brief The structure contains information about configuration used for the multi-link scheduler of BLE_DM_Conn submodule.
+ * @note  The scheduler gives each link an interval that is a power of two multiple of a common base interval, so the anchor
+ *        points of the links keep fixed offsets from each other and the controller can place them without overlapping.
+ *        The base interval holds one connection event of eventLength for every link of the highest weight. */
+typedef struct BLE_DM_ConnSchedConfig_T
+{
+    bool                            enable;                         /**< Set true to let the scheduler update the parameters of the links where the device is Central. */
+    uint16_t                        eventLength;                    /**< Air time of one connection event, in units of 1.25 ms. */
+    uint16_t                        minInterval;                    /**< Minimum base interval, in units of 1.25 ms. See @ref BLE_GAP_CP_RANGE. */
+    uint16_t                        maxInterval;                    /**< Maximum interval of any link, in units of 1.25 ms. See @ref BLE_GAP_CP_RANGE. */
+    uint16_t                        timeout;                        /**< Supervision timeout requested with the intervals, in units of 10 ms. Raised when too short for an interval. */
+} BLE_DM_ConnSchedConfig_T;
+
+/**@brief The structure contains the scheduling state of one link. */
+typedef struct BLE_DM_ConnShare_T
+{
+    uint8_t                         role;                           /**< Role of the device on the link. See @ref BLE_GAP_ROLE. */
+    uint8_t                         weight;                         /**< Scheduling weight. See @ref BLE_DM_ConnSchedSetWeight. */
+    uint16_t                        interval;                       /**< Connection interval in use, in units of 1.25 ms. */
+    uint16_t                        targetInterval;                 /**< Connection interval chosen by the scheduler, 0 if the link is not scheduled. */
+    uint16_t                        share;                          /**< Share of the connection events of all links that goes to this link, in 1/1000. */
+} BLE_DM_ConnShare_T;
+
 /**@brief BLE_DM callback type. This callback function sends BLE_DM events to the application. */
 typedef void (*BLE_DM_EventCb_T)(BLE_DM_Event_T *p_event);
 
@@ -388,6 +411,40 @@ void BLE_DM_GetPairedDeviceList(uint8_t *p_devId, uint8_t *p_devCnt);
 */
 uint16_t BLE_DM_ConnectionParameterUpdate(uint16_t connHandle, BLE_DM_ConnParamUpdate_T *p_params);
 
+/**@brief Configure the multi-link scheduler.
+ * @note  The scheduler runs again on every connection, disconnection and weight change. It updates one link at a time
+ *        with @ref BLE_DM_ConnectionParameterUpdate, so @ref BLE_DM_EVT_CONN_UPDATE_SUCCESS and @ref BLE_DM_EVT_CONN_UPDATE_FAIL
+ *        are sent for its updates too.
+ *
+ * @param[in] p_config              Pointer to the @ref BLE_DM_ConnSchedConfig_T structure buffer.
+ *
+ * @retval MBA_RES_SUCCESS          Successfully configure the scheduler.
+ * @retval MBA_RES_INVALID_PARA     The intervals are out of range or eventLength is 0.
+*/
+uint16_t BLE_DM_ConnSchedConfig(const BLE_DM_ConnSchedConfig_T *p_config);
+
+/**@brief Set the scheduling weight of a link.
+ * @note  A link of weight w gets w times the connection events of a link of weight 1. Links start with weight 1.
+ *
+ * @param[in] connHandle            Connection handle associated with this connection.
+ * @param[in] weight                1, 2, 4 or 8.
+ *
+ * @retval MBA_RES_SUCCESS          Successfully set the weight.
+ * @retval MBA_RES_INVALID_PARA     Invalid connection handle or weight.
+*/
+uint16_t BLE_DM_ConnSchedSetWeight(uint16_t connHandle, uint8_t weight);
+
+/**@brief Get the scheduling state of a link and its share of the connection events of all links.
+ * @note  The share follows from the intervals in use: a link with half the interval of another gets twice its share.
+ *
+ * @param[in] connHandle            Connection handle associated with this connection.
+ * @param[out] p_share              Pointer to the @ref BLE_DM_ConnShare_T structure buffer.
+ *
+ * @retval MBA_RES_SUCCESS          Successfully get the state.
+ * @retval MBA_RES_INVALID_PARA     Invalid connection handle.
+*/
+uint16_t BLE_DM_ConnSchedGetShare(uint16_t connHandle, BLE_DM_ConnShare_T *p_share);
+
 /**@} */ //BLE_DM_FUNS
 
 #endif
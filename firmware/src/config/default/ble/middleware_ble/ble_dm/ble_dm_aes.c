@@ -45,6 +45,13 @@
 // *****************************************************************************
 #include <stdint.h>
 #include <string.h>
+#ifndef BLE_DM_AES_SW_ONLY
+#include "device.h"
+#include "peripheral/clk/plib_clk.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "crypto/crypto.h"
+#endif
 #include "ble_dm/ble_dm_aes.h"
 
 // *****************************************************************************
@@ -427,7 +434,7 @@ static void BLE_DM_AesEcbDecrypt(struct BLE_DM_AesCtx_T *p_ctx, const uint8_t *p
   BLE_DM_AesInvCipher((BLE_DM_AesState_T*)p_buf, p_ctx->roundKey);
 }
 
-void BLE_DM_Aes128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
+void BLE_DM_AesSw128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
 {
     struct BLE_DM_AesCtx_T ctx;
     memcpy(p_ciphertext, p_plaintext, 16);
@@ -435,7 +442,7 @@ void BLE_DM_Aes128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphe
     BLE_DM_AesEcbEncrypt(&ctx, p_ciphertext);
 }
 
-void BLE_DM_Aes128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
+void BLE_DM_AesSw128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
 {
 	struct BLE_DM_AesCtx_T ctx;
 	memcpy(p_plaintext, p_ciphertext,16);
@@ -443,3 +450,87 @@ void BLE_DM_Aes128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphe
 	BLE_DM_AesEcbDecrypt(&ctx, p_plaintext);
 }
 
+#ifndef BLE_DM_AES_SW_ONLY
+
+// The engine moves words: blocks go through aligned copies
+static bool BLE_DM_AesHwBlock(const uint8_t *p_key, const uint8_t *p_in, uint8_t *p_out, bool encrypt)
+{
+    CRYPT_AES_CTX mcAes;
+    uint32_t in[BLE_DM_AES_BLOCK_LEN / 4];
+    uint32_t out[BLE_DM_AES_BLOCK_LEN / 4];
+    int ret;
+
+    ret = CRYPT_AES_KeySet(&mcAes, p_key, 16, NULL, encrypt ? CRYPT_AES_ENCRYPTION : CRYPT_AES_DECRYPTION);
+    if (ret == 0)
+    {
+        memcpy(in, p_in, BLE_DM_AES_BLOCK_LEN);
+        vTaskSuspendAll();
+        if (encrypt)
+            ret = CRYPT_AES_DIRECT_Encrypt(&mcAes, (unsigned char *)out, (unsigned char *)in);
+        else
+            ret = CRYPT_AES_DIRECT_Decrypt(&mcAes, (unsigned char *)out, (unsigned char *)in);
+        (void)xTaskResumeAll();
+        memcpy(p_out, out, BLE_DM_AES_BLOCK_LEN);
+    }
+    memset(&mcAes, 0, sizeof(mcAes));
+    return ret == 0;
+}
+
+bool BLE_DM_AesHwInit(void)
+{
+    // FIPS-197 appendix C.1
+    static const uint8_t s_katKey[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+    static const uint8_t s_katPlain[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+    static const uint8_t s_katCipher[16] = {
+        0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+    static uint8_t s_hwState;       // 0: not tested, 1: in use, 2: failed, software only
+    uint8_t block[16];
+
+    if (s_hwState == 0)
+    {
+        // Left disabled by the clock setup
+        CLK_PMD3Enable(CFG_PMD3_AESMD_Msk);
+
+        s_hwState = 2;
+        if (BLE_DM_AesHwBlock(s_katKey, s_katPlain, block, true) && memcmp(block, s_katCipher, 16) == 0
+            && BLE_DM_AesHwBlock(s_katKey, s_katCipher, block, false) && memcmp(block, s_katPlain, 16) == 0)
+        {
+            s_hwState = 1;
+        }
+    }
+    return s_hwState == 1;
+}
+
+void BLE_DM_Aes128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
+{
+    if (!BLE_DM_AesHwInit() || !BLE_DM_AesHwBlock(p_key, p_plaintext, p_ciphertext, true))
+        BLE_DM_AesSw128Encrypt(p_key, p_plaintext, p_ciphertext);
+}
+
+void BLE_DM_Aes128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
+{
+    if (!BLE_DM_AesHwInit() || !BLE_DM_AesHwBlock(p_key, p_ciphertext, p_plaintext, false))
+        BLE_DM_AesSw128Decrypt(p_key, p_plaintext, p_ciphertext);
+}
+
+#else
+
+bool BLE_DM_AesHwInit(void)
+{
+    return false;
+}
+
+void BLE_DM_Aes128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
+{
+    BLE_DM_AesSw128Encrypt(p_key, p_plaintext, p_ciphertext);
+}
+
+void BLE_DM_Aes128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext)
+{
+    BLE_DM_AesSw128Decrypt(p_key, p_plaintext, p_ciphertext);
+}
+
+#endif /* BLE_DM_AES_SW_ONLY */
+
@@ -35,13 +35,28 @@
 
   Description:
     This file contains the AES functions for BLE Device Manager module internal use.
+    BLE_DM_Aes128Encrypt/Decrypt run on the AES engine once it has passed a
+    known answer test, and in software otherwise; the software path is also
+    available on its own, and builds for a host with BLE_DM_AES_SW_ONLY.
  *******************************************************************************/
 
 
 #ifndef BLE_DM_AES_H
 #define BLE_DM_AES_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 void BLE_DM_Aes128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext);
 void BLE_DM_Aes128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext);
 
+/* Software path only, whatever the engine state. The key is expanded on every call. */
+void BLE_DM_AesSw128Encrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext);
+void BLE_DM_AesSw128Decrypt(uint8_t *p_key, uint8_t *p_plaintext, uint8_t *p_ciphertext);
+
+/* Power the AES engine on and check it against the FIPS-197 vector, once.
+ * Returns whether BLE_DM_Aes128Encrypt/Decrypt use it. Other users of the
+ * engine call it first, and start the engine with the scheduler suspended. */
+bool BLE_DM_AesHwInit(void);
+
 #endif //BLE_DM_AES_H
\ No newline at end of file
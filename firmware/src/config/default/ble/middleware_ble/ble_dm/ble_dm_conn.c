@@ -50,6 +50,15 @@
 #include "ble_dm/ble_dm_info.h"
 #include "ble_dm/ble_dm_internal.h"
 
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+
+#define BLE_DM_CONN_SCHED_MAX_WEIGHT    8           /**< Highest scheduling weight, so the longest interval is 8 base intervals. */
+#define BLE_DM_CONN_SCHED_RETRY         3           /**< Update attempts for a new target interval, a PHY update or a peer procedure can collide with it. */
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Data Types
@@ -60,6 +69,12 @@ typedef struct BLE_DM_ConnUpdateDb_T
 {
     uint16_t                    connHandle;                 /**< The connection handle. */
     bool                        isProcedureInitiator;       /**< Record the update procedure is initiated by this module or remote */
+    uint8_t                     role;                       /**< Role of the local device on the link. */
+    uint16_t                    interval;                   /**< Connection interval in use. */
+    uint16_t                    latency;                    /**< Peripheral latency in use. */
+    uint8_t                     weight;                     /**< Scheduling weight, a power of two. */
+    uint16_t                    targetInterval;             /**< Interval chosen by the scheduler, 0 when the link is not scheduled. */
+    uint8_t                     schedRetry;                 /**< Update attempts left for targetInterval. */
 } BLE_DM_ConnUpdateDb_T;
 
 typedef struct BLE_DM_ConnCtrl_T
@@ -67,6 +82,8 @@ typedef struct BLE_DM_ConnCtrl_T
     BLE_DM_ConnUpdateDb_T       updateDb[BLE_GAP_MAX_LINK_NBR];         /**< Connection update instances for each link. */
     BLE_DM_ConnConfig_T         userConnConfig;
     bool                        autoReplyUpdate;                        /**< Automatically accept connection parameter update request from peer. */
+    BLE_DM_ConnSchedConfig_T    schedConfig;                            /**< Multi-link scheduler configuration. */
+    BLE_DM_ConnUpdateDb_T       *p_schedBusy;                           /**< Link with a scheduler update in progress. */
 } BLE_DM_ConnCtrl_T;
 
 // *****************************************************************************
@@ -110,6 +127,135 @@ void BLE_DM_ConnInit()
     {
         ble_dm_ConnInitUpdateDb(&s_dmConnCtrl.updateDb[i]);
     }
+    s_dmConnCtrl.p_schedBusy = NULL;
+}
+
+static uint16_t ble_dm_ConnSchedTimeout(uint16_t interval, uint16_t latency)
+{
+    uint32_t minTimeout;
+
+    /* Timeout (10 ms) shall be above (1 + latency) * interval (1.25 ms) * 2 */
+    minTimeout = (((uint32_t)interval * (1U + latency) * 2U) / 8U) + 1U;
+    if (minTimeout < s_dmConnCtrl.schedConfig.timeout)
+    {
+        minTimeout = s_dmConnCtrl.schedConfig.timeout;
+    }
+    if (minTimeout > BLE_GAP_CP_CONN_SUPERVISION_TIMEOUT_MAX)
+    {
+        minTimeout = BLE_GAP_CP_CONN_SUPERVISION_TIMEOUT_MAX;
+    }
+    return (uint16_t)minTimeout;
+}
+
+/* Request the target interval of the next link not on it yet. One update at a time: procedures on several
+ * links at once make the controller move anchors it has just placed. */
+static void ble_dm_ConnSchedNext(void)
+{
+    BLE_DM_ConnUpdateDb_T *p_conn;
+    BLE_DM_ConnParamUpdate_T params;
+    uint8_t i;
+
+    if (s_dmConnCtrl.p_schedBusy != NULL)
+    {
+        return;
+    }
+
+    for (i=0; i<BLE_GAP_MAX_LINK_NBR; i++)
+    {
+        p_conn = &s_dmConnCtrl.updateDb[i];
+        if ((p_conn->connHandle == 0) || (p_conn->targetInterval == 0) ||
+            (p_conn->targetInterval == p_conn->interval) || (p_conn->schedRetry == 0))
+        {
+            continue;
+        }
+
+        p_conn->schedRetry--;
+        params.intervalMin = p_conn->targetInterval;
+        params.intervalMax = p_conn->targetInterval;
+        params.latency = p_conn->latency;
+        params.timeout = ble_dm_ConnSchedTimeout(p_conn->targetInterval, p_conn->latency);
+        if (BLE_DM_ConnectionParameterUpdate(p_conn->connHandle, &params) == MBA_RES_SUCCESS)
+        {
+            s_dmConnCtrl.p_schedBusy = p_conn;
+            return;
+        }
+    }
+}
+
+/* Choose the interval of every Central link. With weights w (powers of two) and W the highest, a link gets
+ * an interval of W/w base intervals, and one base interval holds ceil(sum(w)/W) events of eventLength. */
+static void ble_dm_ConnSchedRun(void)
+{
+    BLE_DM_ConnUpdateDb_T *p_conn;
+    uint16_t sumWeight = 0;
+    uint8_t maxWeight = 0;
+    uint32_t base;
+    uint32_t multiple;
+    uint8_t i;
+
+    for (i=0; i<BLE_GAP_MAX_LINK_NBR; i++)
+    {
+        p_conn = &s_dmConnCtrl.updateDb[i];
+        if ((p_conn->connHandle != 0) && (p_conn->role == BLE_GAP_ROLE_CENTRAL))
+        {
+            sumWeight += p_conn->weight;
+            if (p_conn->weight > maxWeight)
+            {
+                maxWeight = p_conn->weight;
+            }
+        }
+    }
+
+    if ((!s_dmConnCtrl.schedConfig.enable) || (sumWeight == 0))
+    {
+        for (i=0; i<BLE_GAP_MAX_LINK_NBR; i++)
+        {
+            s_dmConnCtrl.updateDb[i].targetInterval = 0;
+        }
+        return;
+    }
+
+    base = (uint32_t)s_dmConnCtrl.schedConfig.eventLength * ((sumWeight + maxWeight - 1U) / maxWeight);
+    if (base < s_dmConnCtrl.schedConfig.minInterval)
+    {
+        base = s_dmConnCtrl.schedConfig.minInterval;
+    }
+    if (base > s_dmConnCtrl.schedConfig.maxInterval)
+    {
+        base = s_dmConnCtrl.schedConfig.maxInterval;
+    }
+
+    for (i=0; i<BLE_GAP_MAX_LINK_NBR; i++)
+    {
+        p_conn = &s_dmConnCtrl.updateDb[i];
+        if ((p_conn->connHandle == 0) || (p_conn->role != BLE_GAP_ROLE_CENTRAL))
+        {
+            continue;
+        }
+
+        /* Stay a power of two multiple, shorter if the full multiple is above maxInterval */
+        multiple = maxWeight / p_conn->weight;
+        while ((multiple > 1U) && ((base * multiple) > s_dmConnCtrl.schedConfig.maxInterval))
+        {
+            multiple >>= 1;
+        }
+        if (p_conn->targetInterval != (uint16_t)(base * multiple))
+        {
+            p_conn->targetInterval = (uint16_t)(base * multiple);
+            p_conn->schedRetry = BLE_DM_CONN_SCHED_RETRY;
+        }
+    }
+
+    ble_dm_ConnSchedNext();
+}
+
+static void ble_dm_ConnSchedDone(BLE_DM_ConnUpdateDb_T *p_conn)
+{
+    if (s_dmConnCtrl.p_schedBusy == p_conn)
+    {
+        s_dmConnCtrl.p_schedBusy = NULL;
+        ble_dm_ConnSchedNext();
+    }
 }
 
 static void ble_dm_ConnProcGapConnected(BLE_GAP_Event_T *p_event)
@@ -124,6 +270,11 @@ static void ble_dm_ConnProcGapConnected(BLE_GAP_Event_T *p_event)
         if (p_conn != NULL)
         {
             p_conn->connHandle = p_event->eventField.evtConnect.connHandle;
+            p_conn->role = p_event->eventField.evtConnect.role;
+            p_conn->interval = p_event->eventField.evtConnect.interval;
+            p_conn->latency = p_event->eventField.evtConnect.latency;
+            p_conn->weight = 1;
+            ble_dm_ConnSchedRun();
         }
     }
 }
@@ -136,7 +287,12 @@ static void ble_dm_ConnProcGapDisconnected(BLE_GAP_Event_T *p_event)
 
     if (p_conn != NULL)
     {
+        if (s_dmConnCtrl.p_schedBusy == p_conn)
+        {
+            s_dmConnCtrl.p_schedBusy = NULL;
+        }
         ble_dm_ConnInitUpdateDb(p_conn);
+        ble_dm_ConnSchedRun();
     }
 }
 
@@ -148,6 +304,12 @@ static void ble_dm_ConnProcGapConnParamUpdate(BLE_GAP_Event_T *p_event)
 
     if (p_conn != NULL)
     {
+        if (p_event->eventField.evtConnParamUpdate.status == 0)
+        {
+            p_conn->interval = p_event->eventField.evtConnParamUpdate.connParam.intervalMax;
+            p_conn->latency = p_event->eventField.evtConnParamUpdate.connParam.latency;
+        }
+
         if (p_conn->isProcedureInitiator)
         {
             BLE_DM_Event_T  dmEvt;
@@ -165,6 +327,7 @@ static void ble_dm_ConnProcGapConnParamUpdate(BLE_GAP_Event_T *p_event)
             BLE_DM_ConveyEvent(&dmEvt);
             p_conn->isProcedureInitiator = false;
         }
+        ble_dm_ConnSchedDone(p_conn);
     }
 }
 
@@ -309,6 +472,7 @@ static void ble_dm_ConnProcL2capConnParamUpdateResp(BLE_L2CAP_Event_T *p_event)
             dmEvt.connHandle = p_event->eventField.evtConnParamUpdateRsp.connHandle;
             BLE_DM_ConveyEvent(&dmEvt);
             p_conn->isProcedureInitiator = false;
+            ble_dm_ConnSchedDone(p_conn);
         }
     }
 }
@@ -423,3 +587,74 @@ uint16_t BLE_DM_ConnectionParameterUpdate(uint16_t connHandle, BLE_DM_ConnParamU
     return error;
 }
 
+uint16_t BLE_DM_ConnSchedConfig(const BLE_DM_ConnSchedConfig_T *p_config)
+{
+    if (p_config->enable)
+    {
+        if ((p_config->eventLength == 0) ||
+            (p_config->minInterval < BLE_GAP_CP_MIN_CONN_INTVAL_MIN) ||
+            (p_config->maxInterval > BLE_GAP_CP_MAX_CONN_INTVAL_MAX) ||
+            (p_config->minInterval > p_config->maxInterval) ||
+            (p_config->timeout > BLE_GAP_CP_CONN_SUPERVISION_TIMEOUT_MAX))
+        {
+            return MBA_RES_INVALID_PARA;
+        }
+    }
+
+    s_dmConnCtrl.schedConfig = *p_config;
+    ble_dm_ConnSchedRun();
+    return MBA_RES_SUCCESS;
+}
+
+uint16_t BLE_DM_ConnSchedSetWeight(uint16_t connHandle, uint8_t weight)
+{
+    BLE_DM_ConnUpdateDb_T *p_conn;
+
+    p_conn = ble_dm_ConnFindConnByHandle(connHandle);
+
+    if ((p_conn == NULL) || (connHandle == 0) || (weight == 0) ||
+        (weight > BLE_DM_CONN_SCHED_MAX_WEIGHT) || ((weight & (weight - 1U)) != 0))
+    {
+        return MBA_RES_INVALID_PARA;
+    }
+
+    if (p_conn->weight != weight)
+    {
+        p_conn->weight = weight;
+        ble_dm_ConnSchedRun();
+    }
+    return MBA_RES_SUCCESS;
+}
+
+uint16_t BLE_DM_ConnSchedGetShare(uint16_t connHandle, BLE_DM_ConnShare_T *p_share)
+{
+    BLE_DM_ConnUpdateDb_T *p_conn;
+    uint32_t rate;
+    uint32_t sumRate = 0;
+    uint8_t i;
+
+    p_conn = ble_dm_ConnFindConnByHandle(connHandle);
+
+    if ((p_conn == NULL) || (connHandle == 0) || (p_conn->interval == 0))
+    {
+        return MBA_RES_INVALID_PARA;
+    }
+
+    /* Events per unit of time are inversely proportional to the interval */
+    for (i=0; i<BLE_GAP_MAX_LINK_NBR; i++)
+    {
+        if ((s_dmConnCtrl.updateDb[i].connHandle != 0) && (s_dmConnCtrl.updateDb[i].interval != 0))
+        {
+            sumRate += 0x100000UL / s_dmConnCtrl.updateDb[i].interval;
+        }
+    }
+    rate = 0x100000UL / p_conn->interval;
+
+    p_share->role = p_conn->role;
+    p_share->weight = p_conn->weight;
+    p_share->interval = p_conn->interval;
+    p_share->targetInterval = p_conn->targetInterval;
+    p_share->share = (uint16_t)((rate * 1000UL + (sumRate / 2U)) / sumRate);
+    return MBA_RES_SUCCESS;
+}
+
@@ -47,10 +47,10 @@
 // *****************************************************************************
 #include <stdint.h>
 #include <string.h>
-#include "crypto/crypto.h"
 #include "ble_dm/ble_dm_dds.h"
 #include "ble_dm/ble_dm_aes.h"
 #include "pds.h"
+#include "pds_journal.h"
 
 
 typedef enum BLE_DM_PdsBleItem_T{
@@ -93,23 +93,20 @@ PDS_DECLARE_FILE(PDS_BLE_ITEM_ID_8, sizeof(BLE_DM_PairedDevInfo_T), &s_pairedInf
 
 static uint8_t ble_dm_DdsCheckResolveAddress(uint8_t *p_remoteIrk, uint8_t *p_remoteAddr)
 {
-    uint8_t data[16], temp[16];
+    uint8_t data[16], temp[16], key[16];
     uint8_t i;
-    CRYPT_AES_CTX mcAes;
 
     /* convert irk as aes key */
     for(i=0; i<16; i++)
-      temp[i]=p_remoteIrk[15-i];
-
-    CRYPT_AES_KeySet(&mcAes, temp, 16, NULL, CRYPT_AES_ENCRYPTION);
+      key[i]=p_remoteIrk[15-i];
 
     /* get prand from address */
     memset(&data[0], 0, 13);
     for(i=0; i<3; i++)
       data[13+i]=p_remoteAddr[5-i];
 
-    /* calculate localHash value */
-    CRYPT_AES_DIRECT_Encrypt(&mcAes, temp, data);
+    /* calculate localHash value, on the AES engine when it is usable */
+    BLE_DM_Aes128Encrypt(key, data, temp);
 
     /* extract hash value from address */
     for(i=0; i<3; i++)
@@ -119,14 +116,41 @@ static uint8_t ble_dm_DdsCheckResolveAddress(uint8_t *p_remoteIrk, uint8_t *p_re
     return (memcmp(temp + 13, data, 3) == 0);
 }
 
+/* Paired devices are kept in the PDS journal. Bonds stored by PDS before the
+ * journal existed are still read from PDS until they are rewritten or deleted. */
+static bool ble_dm_DdsExists(uint8_t devId)
+{
+    return PDS_JNL_Exists(BLE_DM_DDS_FILE_PAIRED_START + devId)
+        || PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId);
+}
+
+static bool ble_dm_DdsLoad(uint8_t devId)
+{
+    if (PDS_JNL_Exists(BLE_DM_DDS_FILE_PAIRED_START + devId))
+        return PDS_JNL_Read(BLE_DM_DDS_FILE_PAIRED_START + devId, &s_pairedInfo, sizeof(BLE_DM_PairedDevInfo_T));
+
+    return PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId)
+        && PDS_Restore(BLE_DM_DDS_FILE_PAIRED_START + devId);
+}
+
+static bool ble_dm_DdsDelete(uint8_t devId)
+{
+    PDS_JNL_Delete(BLE_DM_DDS_FILE_PAIRED_START + devId);
+
+    if (PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId))
+        return (PDS_Delete(BLE_DM_DDS_FILE_PAIRED_START + devId) == PDS_SUCCESS);
+
+    return true;
+}
+
 
 uint16_t BLE_DM_DdsGetPairedDevice(uint8_t devId, BLE_DM_PairedDevInfo_T * p_pairedDevInfo)
 {
     if (devId >= BLE_DM_MAX_PAIRED_DEVICE_NUM
-        || PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId) == false)
+        || ble_dm_DdsExists(devId) == false)
         return MBA_RES_INVALID_PARA;
 
-    if (PDS_Restore(BLE_DM_DDS_FILE_PAIRED_START + devId))
+    if (ble_dm_DdsLoad(devId))
     {
         memcpy(p_pairedDevInfo, &s_pairedInfo, sizeof(BLE_DM_PairedDevInfo_T));
         return MBA_RES_SUCCESS;
@@ -140,9 +164,8 @@ uint16_t BLE_DM_DdsSetPairedDevice(uint8_t devId, BLE_DM_PairedDevInfo_T *p_pair
     if (devId >= BLE_DM_MAX_PAIRED_DEVICE_NUM)
         return MBA_RES_INVALID_PARA;
 
-    memcpy(&s_pairedInfo, p_pairedDevInfo, sizeof(BLE_DM_PairedDevInfo_T));
-
-    if (PDS_Store(BLE_DM_DDS_FILE_PAIRED_START + devId))
+    /* Queued in RAM and coalesced; programmed later between connection events. */
+    if (PDS_JNL_Write(BLE_DM_DDS_FILE_PAIRED_START + devId, p_pairedDevInfo, sizeof(BLE_DM_PairedDevInfo_T)))
     {
         return MBA_RES_SUCCESS;
     }
@@ -156,7 +179,7 @@ uint8_t BLE_DM_DdsGetFreeDeviceId()
 
     for (devId = 0; devId < BLE_DM_MAX_PAIRED_DEVICE_NUM; devId++)
     {
-        if (!PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId))
+        if (!ble_dm_DdsExists(devId))
         {
             break;
         }
@@ -175,9 +198,9 @@ uint8_t BLE_DM_DdsGetDeviceId(BLE_GAP_Addr_T *p_bdAddr)
     
     for (devId = 0; devId < BLE_DM_MAX_PAIRED_DEVICE_NUM; devId++)
     {
-        if (PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId))
+        if (ble_dm_DdsExists(devId))
         {
-            if (PDS_Restore(BLE_DM_DDS_FILE_PAIRED_START + devId))
+            if (ble_dm_DdsLoad(devId))
             {
                 if (p_bdAddr->addrType == BLE_GAP_ADDR_TYPE_RANDOM_RESOLVABLE)
                 {
@@ -203,7 +226,7 @@ uint16_t BLE_DM_DdsDeletePairedDevice(uint8_t devId)
     if (devId >= BLE_DM_MAX_PAIRED_DEVICE_NUM)
         return MBA_RES_INVALID_PARA;
 
-    if (PDS_Delete(BLE_DM_DDS_FILE_PAIRED_START + devId) == PDS_SUCCESS)
+    if (ble_dm_DdsDelete(devId))
     {
         return MBA_RES_SUCCESS;
     }
@@ -217,7 +240,7 @@ uint16_t BLE_DM_DdsDeleteAllPairedDevice()
 
     for (devId = 0; devId < BLE_DM_MAX_PAIRED_DEVICE_NUM; devId++)
     {
-        if (PDS_Delete(BLE_DM_DDS_FILE_PAIRED_START + devId) != PDS_SUCCESS)
+        if (!ble_dm_DdsDelete(devId))
             return MBA_RES_FAIL;
     }
 
@@ -226,7 +249,7 @@ uint16_t BLE_DM_DdsDeleteAllPairedDevice()
 
 bool BLE_DM_DdsChkDeviceId(uint8_t devId)
 {
-    return PDS_IsAbleToRestore(BLE_DM_DDS_FILE_PAIRED_START + devId);
+    return ble_dm_DdsExists(devId);
 }
 
 
@@ -45,6 +45,7 @@
 // Section: Included Files
 // *****************************************************************************
 // *****************************************************************************
+#define OSAL_MEM_TAG    OSAL_MEM_TAG_BLE_DM      /* must precede the OSAL includes */
 #include <string.h>
 #include "osal/osal_freertos_extend.h"
 #include "ble_dm/ble_dm.h"
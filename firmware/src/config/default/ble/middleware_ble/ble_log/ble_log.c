@@ -0,0 +1,148 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  BLE Log Middleware Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ble_log.c
+
+  Summary:
+    This file rebuilds HCI packets from the BT system log of the ble_stack.
+
+  Description:
+    BLE_LOG_StackLogHandler is given to BT_SYS_LogEnable. Each log event is
+    turned into the HCI packet it describes, without the H4 packet type byte,
+    and passed to the callback registered with BLE_LOG_EventRegister. A
+    command logged with return parameters is followed by the Command Complete
+    event carrying them. The packet buffer is only valid during the callback.
+ *******************************************************************************/
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include "ble_log/ble_log.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+#define BLE_LOG_HCI_EVT_CMD_COMPLETE        0x0E
+#define BLE_LOG_ACL_PB_FIRST_FLUSHABLE      0x2000
+#define BLE_LOG_PACKET_MAX                  (4 + 255 + 1)
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+static BLE_LOG_EventCb_T    s_logEventCb;
+static uint8_t              s_logPacket[BLE_LOG_PACKET_MAX];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Functions
+// *****************************************************************************
+// *****************************************************************************
+static uint16_t ble_log_Copy(uint16_t offset, const uint8_t *p_data, uint16_t length)
+{
+    if (offset + length > BLE_LOG_PACKET_MAX)
+        length = BLE_LOG_PACKET_MAX - offset;
+
+    if (p_data != NULL && length > 0)
+        memcpy(&s_logPacket[offset], p_data, length);
+
+    return offset + length;
+}
+
+void BLE_LOG_EventRegister(BLE_LOG_EventCb_T eventCb)
+{
+    s_logEventCb = eventCb;
+}
+
+void BLE_LOG_StackLogHandler(BT_SYS_LogEvent_T *p_log)
+{
+    BLE_LOG_EventCb_T   eventCb = s_logEventCb;
+    uint16_t            length;
+
+    if (eventCb == NULL || p_log == NULL)
+        return;
+
+    switch (p_log->logType)
+    {
+        case BT_SYS_LOG_TYPE_HCI_COMMAND:
+        {
+            s_logPacket[0] = (uint8_t)p_log->logId;
+            s_logPacket[1] = (uint8_t)(p_log->logId >> 8);
+            s_logPacket[2] = (uint8_t)p_log->payloadLength;
+            length = ble_log_Copy(3, p_log->p_logPayload, p_log->payloadLength);
+            eventCb(BLE_LOG_TYPE_HCI_COMMAND, length, s_logPacket);
+
+            if (p_log->paramsLength > 0)
+            {
+                s_logPacket[0] = BLE_LOG_HCI_EVT_CMD_COMPLETE;
+                s_logPacket[1] = (uint8_t)(3 + p_log->paramsLength);
+                s_logPacket[2] = 1;     /* Num_HCI_Command_Packets */
+                s_logPacket[3] = (uint8_t)p_log->logId;
+                s_logPacket[4] = (uint8_t)(p_log->logId >> 8);
+                length = ble_log_Copy(5, p_log->p_returnParams, p_log->paramsLength);
+                eventCb(BLE_LOG_TYPE_HCI_EVENT, length, s_logPacket);
+            }
+        }
+        break;
+
+        case BT_SYS_LOG_TYPE_HCI_ACL_TX:
+        case BT_SYS_LOG_TYPE_HCI_ACL_RX:
+        {
+            uint16_t handle = (p_log->logId & 0x0FFF) | BLE_LOG_ACL_PB_FIRST_FLUSHABLE;
+
+            s_logPacket[0] = (uint8_t)handle;
+            s_logPacket[1] = (uint8_t)(handle >> 8);
+            s_logPacket[2] = (uint8_t)p_log->payloadLength;
+            s_logPacket[3] = (uint8_t)(p_log->payloadLength >> 8);
+            length = ble_log_Copy(4, p_log->p_logPayload, p_log->payloadLength);
+            eventCb((p_log->logType == BT_SYS_LOG_TYPE_HCI_ACL_TX) ? BLE_LOG_TYPE_HCI_ACL_TX : BLE_LOG_TYPE_HCI_ACL_RX,
+                    length, s_logPacket);
+        }
+        break;
+
+        case BT_SYS_LOG_TYPE_HCI_EVENT:
+        {
+            s_logPacket[0] = (uint8_t)p_log->logId;
+            s_logPacket[1] = (uint8_t)p_log->payloadLength;
+            length = ble_log_Copy(2, p_log->p_logPayload, p_log->payloadLength);
+            eventCb(BLE_LOG_TYPE_HCI_EVENT, length, s_logPacket);
+        }
+        break;
+
+        default:
+        break;
+    }
+}
@@ -0,0 +1,503 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  BLE Transparent Credit Based Client Profile Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ble_trcbpc.c
+
+  Summary:
+    This file contains the BLE Transparent Credit Based Client functions for application user.
+
+  Description:
+    Discovery runs as three GATT client procedures on each link: Discover
+    Primary Service By UUID, Discover Characteristics By UUID within the
+    service range, then Read of the PSM value. A procedure refused with
+    MBA_RES_BUSY is retried on GATTC_EVT_PROTOCOL_AVAILABLE.
+ *******************************************************************************/
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "mba_error_defs.h"
+#include "ble_gap.h"
+#include "gatt.h"
+#include "ble_util/byte_stream.h"
+#include "ble_trcbs/ble_trcbs.h"
+#include "ble_trcbps/ble_trcbps.h"
+#include "ble_trcbpc/ble_trcbpc.h"
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+#define BLE_TRCBPC_AD_TYPE_UUID128_INCOMPLETE               0x06    /**< AD type: Incomplete List of 128-bit Service UUIDs. */
+#define BLE_TRCBPC_AD_TYPE_UUID128_COMPLETE                 0x07    /**< AD type: Complete List of 128-bit Service UUIDs. */
+#define BLE_TRCBPC_CHAR_DECL_VALUE_HDL_OFFSET               0x03    /**< Offset of the value handle in a characteristic declaration pair. */
+#define BLE_TRCBPC_CHAR_DECL_MIN_LEN                        0x05    /**< Declaration handle, properties and value handle. */
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+/**@brief The structure contains the discovery state of one link. */
+typedef struct BLE_TRCBPC_ConnList_T
+{
+    uint16_t     connHandle;                                                         /**< Connection handle. */
+    uint8_t      state;                                                              /**< Discovery state. See @ref BLE_TRCBPC_STATUS. */
+    bool         pending;                                                            /**< The current step was refused as busy and waits for GATTC_EVT_PROTOCOL_AVAILABLE. */
+    uint16_t     svcStartHdl;                                                        /**< Start handle of the peer service, 0 while not found. */
+    uint16_t     svcEndHdl;                                                          /**< End group handle of the peer service. */
+    uint16_t     psmValHdl;                                                          /**< Value handle of the PSM characteristic, 0 while not found. */
+} BLE_TRCBPC_ConnList_T;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+static BLE_TRCBPC_EventCb_T            s_bleTrcbpcProcess;
+static BLE_TRCBPC_ConnList_T           s_trcbpcConnList[BLE_TRCBPC_MAX_CONN_NBR];
+static const uint8_t                   s_trcbpcSvcUuid[ATT_UUID_LENGTH_16] = {UUID_MCHP_PROPRIETARY_SERVICE_TRCB_16};
+static const uint8_t                   s_trcbpcPsmUuid[ATT_UUID_LENGTH_16] = {UUID_MCHP_TRCB_L2CAP_PSM_16};
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static BLE_TRCBPC_ConnList_T *ble_trcbpc_GetConnListByHandle(uint16_t connHandle)
+{
+    uint8_t i;
+
+    for (i = 0; i < BLE_TRCBPC_MAX_CONN_NBR; i++)
+    {
+        if ((s_trcbpcConnList[i].state != BLE_TRCBPC_STATUS_IDLE) && (s_trcbpcConnList[i].connHandle == connHandle))
+        {
+            return &s_trcbpcConnList[i];
+        }
+    }
+
+    return NULL;
+}
+
+static BLE_TRCBPC_ConnList_T *ble_trcbpc_GetFreeConnList(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < BLE_TRCBPC_MAX_CONN_NBR; i++)
+    {
+        if (s_trcbpcConnList[i].state == BLE_TRCBPC_STATUS_IDLE)
+        {
+            return &s_trcbpcConnList[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void ble_trcbpc_ConveyEvent(BLE_TRCBPC_Event_T *p_evt)
+{
+    if (s_bleTrcbpcProcess)
+    {
+        s_bleTrcbpcProcess(p_evt);
+    }
+}
+
+static void ble_trcbpc_Fail(BLE_TRCBPC_ConnList_T *p_conn, uint8_t errCode)
+{
+    BLE_TRCBPC_Event_T evtPara;
+
+    evtPara.eventId = BLE_TRCBPC_EVT_DISC_FAIL;
+    evtPara.eventField.onDiscFail.connHandle = p_conn->connHandle;
+    evtPara.eventField.onDiscFail.status = p_conn->state;
+    evtPara.eventField.onDiscFail.errCode = errCode;
+
+    memset((uint8_t *)p_conn, 0, sizeof(BLE_TRCBPC_ConnList_T));
+
+    ble_trcbpc_ConveyEvent(&evtPara);
+}
+
+/* Issue the GATT request of the current state. */
+static uint16_t ble_trcbpc_RunStep(BLE_TRCBPC_ConnList_T *p_conn)
+{
+    uint16_t ret = MBA_RES_FAIL;
+
+    switch (p_conn->state)
+    {
+        case BLE_TRCBPC_STATUS_DISC_SERVICE:
+        {
+            GATTC_DiscoverPrimaryServiceByUuidParams_T discParams;
+
+            discParams.startHandle = 0x0001;
+            discParams.endHandle = 0xFFFF;
+            discParams.valueLength = ATT_UUID_LENGTH_16;
+            memcpy(discParams.value, s_trcbpcSvcUuid, ATT_UUID_LENGTH_16);
+            ret = GATTC_DiscoverPrimaryServiceByUUID(p_conn->connHandle, &discParams);
+        }
+        break;
+
+        case BLE_TRCBPC_STATUS_DISC_PSM:
+        {
+            GATTC_DiscoverCharacteristicByUuidParams_T discParams;
+
+            discParams.startHandle = p_conn->svcStartHdl;
+            discParams.endHandle = p_conn->svcEndHdl;
+            discParams.uuidLength = ATT_UUID_LENGTH_16;
+            memcpy(discParams.uuid, s_trcbpcPsmUuid, ATT_UUID_LENGTH_16);
+            ret = GATTC_DiscoverCharacteristicsByUUID(p_conn->connHandle, &discParams);
+        }
+        break;
+
+        case BLE_TRCBPC_STATUS_READ_PSM:
+        {
+            ret = GATTC_Read(p_conn->connHandle, p_conn->psmValHdl, 0);
+        }
+        break;
+
+        default:
+            break;
+    }
+
+    p_conn->pending = (ret == MBA_RES_BUSY);
+
+    if (p_conn->pending)
+    {
+        return MBA_RES_SUCCESS;
+    }
+
+    return ret;
+}
+
+/* Advance to the next state, or fail when the previous one found nothing. */
+static void ble_trcbpc_NextStep(BLE_TRCBPC_ConnList_T *p_conn)
+{
+    if (p_conn->state == BLE_TRCBPC_STATUS_DISC_SERVICE)
+    {
+        if (p_conn->svcStartHdl == 0)
+        {
+            ble_trcbpc_Fail(p_conn, 0);
+            return;
+        }
+        p_conn->state = BLE_TRCBPC_STATUS_DISC_PSM;
+    }
+    else if (p_conn->state == BLE_TRCBPC_STATUS_DISC_PSM)
+    {
+        if (p_conn->psmValHdl == 0)
+        {
+            ble_trcbpc_Fail(p_conn, 0);
+            return;
+        }
+        p_conn->state = BLE_TRCBPC_STATUS_READ_PSM;
+    }
+    else
+    {
+        return;
+    }
+
+    if (ble_trcbpc_RunStep(p_conn) != MBA_RES_SUCCESS)
+    {
+        ble_trcbpc_Fail(p_conn, 0);
+    }
+}
+
+static void ble_trcbpc_PsmRead(BLE_TRCBPC_ConnList_T *p_conn, GATT_EvtReadResp_T *p_read)
+{
+    BLE_TRCBPC_Event_T evtPara;
+    uint16_t psm;
+
+    if (p_read->attrDataLength < 2)
+    {
+        ble_trcbpc_Fail(p_conn, 0);
+        return;
+    }
+
+    /* The server stores the PSM big endian, see ble_trcbs.c */
+    BUF_BE_TO_U16(&psm, p_read->readValue);
+
+    p_conn->state = BLE_TRCBPC_STATUS_DONE;
+
+    evtPara.eventId = BLE_TRCBPC_EVT_PSM_READ;
+    evtPara.eventField.onPsmRead.connHandle = p_conn->connHandle;
+    evtPara.eventField.onPsmRead.psm = psm;
+    evtPara.eventField.onPsmRead.result = BLE_TRCBPS_ConnReqByPsm(p_conn->connHandle, psm);
+
+    ble_trcbpc_ConveyEvent(&evtPara);
+}
+
+static void ble_trcbpc_GattEventProcess(GATT_Event_T *p_event)
+{
+    BLE_TRCBPC_ConnList_T *p_conn = NULL;
+
+    switch (p_event->eventId)
+    {
+        case GATTC_EVT_DISC_PRIM_SERV_BY_UUID_RESP:
+        {
+            p_conn = ble_trcbpc_GetConnListByHandle(p_event->eventField.onDiscPrimServByUuidResp.connHandle);
+
+            if ((p_conn == NULL) || (p_conn->state != BLE_TRCBPC_STATUS_DISC_SERVICE))
+            {
+                break;
+            }
+
+            /* Keep the first instance of the service */
+            if ((p_conn->svcStartHdl == 0) && (p_event->eventField.onDiscPrimServByUuidResp.handleInfoLength >= 4))
+            {
+                BUF_LE_TO_U16(&p_conn->svcStartHdl, &p_event->eventField.onDiscPrimServByUuidResp.handleInfo[0]);
+                BUF_LE_TO_U16(&p_conn->svcEndHdl, &p_event->eventField.onDiscPrimServByUuidResp.handleInfo[2]);
+            }
+
+            if (p_event->eventField.onDiscPrimServByUuidResp.procedureStatus == GATT_PROCEDURE_STATUS_FINISH)
+            {
+                ble_trcbpc_NextStep(p_conn);
+            }
+        }
+        break;
+
+        case GATTC_EVT_DISC_CHAR_BY_UUID_RESP:
+        {
+            GATT_EvtDiscCharResp_T *p_char = &p_event->eventField.onDiscCharByUuid;
+
+            p_conn = ble_trcbpc_GetConnListByHandle(p_char->connHandle);
+
+            if ((p_conn == NULL) || (p_conn->state != BLE_TRCBPC_STATUS_DISC_PSM))
+            {
+                break;
+            }
+
+            if ((p_conn->psmValHdl == 0) && (p_char->attrPairLength >= BLE_TRCBPC_CHAR_DECL_MIN_LEN)
+                && (p_char->attrDataLength >= p_char->attrPairLength))
+            {
+                BUF_LE_TO_U16(&p_conn->psmValHdl, &p_char->attrData[BLE_TRCBPC_CHAR_DECL_VALUE_HDL_OFFSET]);
+            }
+
+            if (p_char->procedureStatus == GATT_PROCEDURE_STATUS_FINISH)
+            {
+                ble_trcbpc_NextStep(p_conn);
+            }
+        }
+        break;
+
+        case GATTC_EVT_READ_RESP:
+        {
+            p_conn = ble_trcbpc_GetConnListByHandle(p_event->eventField.onReadResp.connHandle);
+
+            if ((p_conn != NULL) && (p_conn->state == BLE_TRCBPC_STATUS_READ_PSM)
+                && (p_event->eventField.onReadResp.charHandle == p_conn->psmValHdl))
+            {
+                ble_trcbpc_PsmRead(p_conn, &p_event->eventField.onReadResp);
+            }
+        }
+        break;
+
+        case GATTC_EVT_ERROR_RESP:
+        {
+            p_conn = ble_trcbpc_GetConnListByHandle(p_event->eventField.onError.connHandle);
+
+            if ((p_conn == NULL) || (p_conn->state == BLE_TRCBPC_STATUS_DONE))
+            {
+                break;
+            }
+
+            /* Attribute Not Found ends a discovery procedure; anything else is a failure */
+            if ((p_event->eventField.onError.errCode == ATT_ERRCODE_ATTRIBUTE_NOT_FOUND)
+                && (((p_conn->state == BLE_TRCBPC_STATUS_DISC_SERVICE) && (p_event->eventField.onError.reqOpcode == ATT_FIND_BY_TYPE_VALUE_REQ))
+                || ((p_conn->state == BLE_TRCBPC_STATUS_DISC_PSM) && (p_event->eventField.onError.reqOpcode == ATT_READ_BY_TYPE_REQ))))
+            {
+                ble_trcbpc_NextStep(p_conn);
+            }
+            else
+            {
+                ble_trcbpc_Fail(p_conn, p_event->eventField.onError.errCode);
+            }
+        }
+        break;
+
+        case GATTC_EVT_PROTOCOL_AVAILABLE:
+        {
+            p_conn = ble_trcbpc_GetConnListByHandle(p_event->eventField.onClientProtocolAvailable.connHandle);
+
+            if ((p_conn != NULL) && (p_conn->pending))
+            {
+                if (ble_trcbpc_RunStep(p_conn) != MBA_RES_SUCCESS)
+                {
+                    ble_trcbpc_Fail(p_conn, 0);
+                }
+            }
+        }
+        break;
+
+        case ATT_EVT_TIMEOUT:
+        {
+            uint8_t i;
+
+            /* The event does not name the link: fail every discovery in progress */
+            for (i = 0; i < BLE_TRCBPC_MAX_CONN_NBR; i++)
+            {
+                if ((s_trcbpcConnList[i].state != BLE_TRCBPC_STATUS_IDLE) && (s_trcbpcConnList[i].state != BLE_TRCBPC_STATUS_DONE))
+                {
+                    ble_trcbpc_Fail(&s_trcbpcConnList[i], 0);
+                }
+            }
+        }
+        break;
+
+        default:
+            break;
+    }
+}
+
+static void ble_trcbpc_GapEventProcess(BLE_GAP_Event_T *p_event)
+{
+    if (p_event->eventId == BLE_GAP_EVT_DISCONNECTED)
+    {
+        BLE_TRCBPC_ConnList_T *p_conn = ble_trcbpc_GetConnListByHandle(p_event->eventField.evtDisconnect.connHandle);
+
+        if (p_conn != NULL)
+        {
+            memset((uint8_t *)p_conn, 0, sizeof(BLE_TRCBPC_ConnList_T));
+        }
+    }
+}
+
+void BLE_TRCBPC_EventRegister(BLE_TRCBPC_EventCb_T bleTrcbpcHandler)
+{
+    s_bleTrcbpcProcess = bleTrcbpcHandler;
+}
+
+uint16_t BLE_TRCBPC_Init(void)
+{
+    memset((uint8_t *)s_trcbpcConnList, 0, sizeof(s_trcbpcConnList));
+
+    return MBA_RES_SUCCESS;
+}
+
+bool BLE_TRCBPC_IsServiceAdvertised(uint8_t length, const uint8_t *p_advData)
+{
+    uint8_t idx = 0;
+
+    while ((idx + 1) < length)
+    {
+        uint8_t adLen = p_advData[idx];
+        uint8_t adType = p_advData[idx + 1];
+        uint8_t pos;
+
+        if ((adLen == 0) || ((idx + 1 + adLen) > length))
+        {
+            break;
+        }
+
+        if ((adType == BLE_TRCBPC_AD_TYPE_UUID128_INCOMPLETE) || (adType == BLE_TRCBPC_AD_TYPE_UUID128_COMPLETE))
+        {
+            for (pos = idx + 2; (pos + ATT_UUID_LENGTH_16) <= (idx + 1 + adLen); pos += ATT_UUID_LENGTH_16)
+            {
+                if (memcmp(&p_advData[pos], s_trcbpcSvcUuid, ATT_UUID_LENGTH_16) == 0)
+                {
+                    return true;
+                }
+            }
+        }
+
+        idx += adLen + 1;
+    }
+
+    return false;
+}
+
+uint16_t BLE_TRCBPC_ConnReq(uint16_t connHandle)
+{
+    BLE_TRCBPC_ConnList_T *p_conn = NULL;
+    uint16_t ret;
+
+    p_conn = ble_trcbpc_GetConnListByHandle(connHandle);
+
+    if (p_conn != NULL)
+    {
+        if (p_conn->state != BLE_TRCBPC_STATUS_DONE)
+        {
+            return MBA_RES_BAD_STATE;
+        }
+    }
+    else
+    {
+        p_conn = ble_trcbpc_GetFreeConnList();
+
+        if (p_conn == NULL)
+        {
+            return MBA_RES_NO_RESOURCE;
+        }
+    }
+
+    memset((uint8_t *)p_conn, 0, sizeof(BLE_TRCBPC_ConnList_T));
+    p_conn->connHandle = connHandle;
+    p_conn->state = BLE_TRCBPC_STATUS_DISC_SERVICE;
+
+    ret = ble_trcbpc_RunStep(p_conn);
+
+    if (ret != MBA_RES_SUCCESS)
+    {
+        memset((uint8_t *)p_conn, 0, sizeof(BLE_TRCBPC_ConnList_T));
+    }
+
+    return ret;
+}
+
+void BLE_TRCBPC_BleEventHandler(STACK_Event_T *p_stackEvent)
+{
+    switch (p_stackEvent->groupId)
+    {
+        case STACK_GRP_BLE_GAP:
+        {
+            ble_trcbpc_GapEventProcess((BLE_GAP_Event_T *)p_stackEvent->p_event);
+        }
+        break;
+
+        case STACK_GRP_GATT:
+        {
+            ble_trcbpc_GattEventProcess((GATT_Event_T *)p_stackEvent->p_event);
+        }
+        break;
+
+        default:
+        break;
+    }
+}
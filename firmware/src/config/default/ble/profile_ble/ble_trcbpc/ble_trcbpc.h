@@ -0,0 +1,215 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  BLE Transparent Credit Based Client Profile Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    ble_trcbpc.h
+
+  Summary:
+    This file contains the BLE Transparent Credit Based Client functions for application user.
+
+  Description:
+    The client discovers the Transparent Credit Based service of a connected
+    peer, reads its L2CAP PSM characteristic and opens the data channel on it.
+    The channel is then owned by the server profile (ble_trcbps.h): data is
+    sent and received with the BLE_TRCBPS_SendData/GetData API in both roles.
+ *******************************************************************************/
+
+
+/**
+ * @addtogroup BLE_TRCBPC
+ * @{
+ * @brief Header file for the BLE Transparent Credit Based Profile Client role library.
+ * @note Definitions and prototypes for the BLE Transparent Credit Based profile client application programming interface.
+ */
+#ifndef BLE_TRCBPC_H
+#define BLE_TRCBPC_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include "gatt.h"
+#include "ble_gap.h"
+#include "stack_mgr.h"
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+
+/**@addtogroup BLE_TRCBPC_DEFINES Defines
+ * @{ */
+
+/**@defgroup BLE_TRCBPC_MAX_CONN_NBR Maximum connection number
+ * @brief The definition of maximum connection number of BLE Transparent Credit Based Profile Client.
+ * @{ */
+#define BLE_TRCBPC_MAX_CONN_NBR                           BLE_GAP_MAX_LINK_NBR    /**< Maximum allowing Connection Numbers. */
+/** @} */
+
+/**@defgroup BLE_TRCBPC_STATUS TRCBPC status
+ * @brief The definition of BLE Transparent Credit Based Profile Client discovery status.
+ * @{ */
+#define BLE_TRCBPC_STATUS_IDLE                            0x00    /**< No discovery on the link. */
+#define BLE_TRCBPC_STATUS_DISC_SERVICE                    0x01    /**< Discovering the Transparent Credit Based service. */
+#define BLE_TRCBPC_STATUS_DISC_PSM                        0x02    /**< Discovering the L2CAP PSM characteristic. */
+#define BLE_TRCBPC_STATUS_READ_PSM                        0x03    /**< Reading the L2CAP PSM characteristic. */
+#define BLE_TRCBPC_STATUS_DONE                            0x04    /**< PSM read, data channel connection requested. */
+/** @} */
+
+/**@} */ //BLE_TRCBPC_DEFINES
+
+
+/**@addtogroup BLE_TRCBPC_ENUMS Enumerations
+ * @{ */
+
+/**@brief Enumeration type of BLE Transparent Credit Based Profile Client callback events. */
+typedef enum BLE_TRCBPC_EventId_T
+{
+    BLE_TRCBPC_EVT_PSM_READ = 0x00,                                       /**< The peer PSM was read and the data channel connection requested. See @ref BLE_TRCBPC_EvtPsmRead_T for event details. The channel status follows as @ref BLE_TRCBPS_EVT_CONNECTION_STATUS. */
+    BLE_TRCBPC_EVT_DISC_FAIL                                              /**< Discovery failed: no service, no PSM characteristic, ATT error or timeout. See @ref BLE_TRCBPC_EvtDiscFail_T for event details. */
+} BLE_TRCBPC_EventId_T;
+
+/**@} */ //BLE_TRCBPC_ENUMS
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+/**@addtogroup BLE_TRCBPC_STRUCTS Structures
+ * @{ */
+
+/**@brief Data structure for @ref BLE_TRCBPC_EVT_PSM_READ event. */
+typedef struct BLE_TRCBPC_EvtPsmRead_T
+{
+    uint16_t                connHandle;                                  /**< Connection handle associated with this connection. */
+    uint16_t                psm;                                         /**< PSM of the peer data channel. */
+    uint16_t                result;                                      /**< Result of the data channel connection request. See @ref BLE_TRCBPS_ConnReqByPsm. */
+} BLE_TRCBPC_EvtPsmRead_T;
+
+/**@brief Data structure for @ref BLE_TRCBPC_EVT_DISC_FAIL event. */
+typedef struct BLE_TRCBPC_EvtDiscFail_T
+{
+    uint16_t                connHandle;                                  /**< Connection handle associated with this connection. */
+    uint8_t                 status;                                      /**< Discovery status when it failed. See @ref BLE_TRCBPC_STATUS. */
+    uint8_t                 errCode;                                     /**< ATT error code, 0 when the service or characteristic is missing or on timeout. See @ref ATT_ERROR_CODES. */
+} BLE_TRCBPC_EvtDiscFail_T;
+
+/**@brief The union of BLE Transparent Credit Based Profile Client event types. */
+typedef union BLE_TRCBPC_EventField_T
+{
+    BLE_TRCBPC_EvtPsmRead_T           onPsmRead;                           /**< Handle @ref BLE_TRCBPC_EVT_PSM_READ. */
+    BLE_TRCBPC_EvtDiscFail_T          onDiscFail;                          /**< Handle @ref BLE_TRCBPC_EVT_DISC_FAIL. */
+} BLE_TRCBPC_EventField_T;
+
+/**@brief BLE Transparent Credit Based Profile Client callback event. */
+typedef struct BLE_TRCBPC_Event_T
+{
+    BLE_TRCBPC_EventId_T       eventId;                                   /**< Event ID. See @ref BLE_TRCBPC_EventId_T. */
+    BLE_TRCBPC_EventField_T    eventField;                                /**< Event field. */
+} BLE_TRCBPC_Event_T;
+
+/**@brief BLE Transparent Credit Based Profile Client callback type. This callback function sends BLE Transparent Credit Based Profile Client events to the application. */
+typedef void(*BLE_TRCBPC_EventCb_T)(BLE_TRCBPC_Event_T *p_event);
+
+/**@} */ //BLE_TRCBPC_STRUCTS
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Function Prototypes
+// *****************************************************************************
+// *****************************************************************************
+/**@addtogroup BLE_TRCBPC_FUNS Functions
+ * @{ */
+
+/**
+ *@brief Register BLE Transparent Credit Based Profile Client callback.
+ *
+ *@param[in] bleTrcbpcHandler                Client callback function.
+ *
+ */
+void BLE_TRCBPC_EventRegister(BLE_TRCBPC_EventCb_T bleTrcbpcHandler);
+
+
+/**@brief Initialize BLE Transparent Credit Based Profile Client.
+ *        GATTC_Init must have been called.
+ *
+ * @retval MBA_RES_SUCCESS                   Successfully initialize the client.
+ *
+ */
+uint16_t BLE_TRCBPC_Init(void);
+
+
+/**@brief Check whether advertising or scan response data lists the Transparent Credit Based service UUID.
+ *
+ * @param[in] length                          Length of the data.
+ * @param[in] p_advData                       Pointer to the AD structures, as in @ref BLE_GAP_EvtAdvReport_T.
+ *
+ * @retval true                               The service UUID is listed.
+ * @retval false                              The service UUID is not listed.
+ *
+ */
+bool BLE_TRCBPC_IsServiceAdvertised(uint8_t length, const uint8_t *p_advData);
+
+
+/**@brief Discover the peer Transparent Credit Based service, read its PSM and request the data channel.
+ *        @ref BLE_TRCBPC_EVT_PSM_READ or @ref BLE_TRCBPC_EVT_DISC_FAIL reports the outcome.
+ *
+ * @param[in] connHandle                       Connection handle.
+ *
+ * @retval MBA_RES_SUCCESS                    Successfully start the discovery.
+ * @retval MBA_RES_NO_RESOURCE                No free connection entry.
+ * @retval MBA_RES_BAD_STATE                  A discovery is already running on this connection.
+ * @retval MBA_RES_OOM                        No available memory.
+ *
+ */
+uint16_t BLE_TRCBPC_ConnReq(uint16_t connHandle);
+
+
+/**@brief Handle BLE_Stack events.
+ *        This API should be called in the application while catching BLE_Stack events.
+ *        The client needs the GAP disconnect event and the GATT client events.
+ *
+ * @param[in] p_stackEvent                    Pointer to BLE_Stack events buffer.
+ *
+*/
+void BLE_TRCBPC_BleEventHandler(STACK_Event_T *p_stackEvent);
+
+
+/**@} */ //BLE_TRCBPC_FUNS
+
+#endif
+
+/**
+  @}
+ */
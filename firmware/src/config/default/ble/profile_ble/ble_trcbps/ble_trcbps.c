@@ -43,6 +43,7 @@
 // Section: Included Files
 // *****************************************************************************
 // *****************************************************************************
+#define OSAL_MEM_TAG    OSAL_MEM_TAG_TRCBPS      /* heap accounting tag, see osal_freertos.h */
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -54,6 +55,7 @@
 #include "ble_util/byte_stream.h"
 #include "ble_trcbs/ble_trcbs.h"
 #include "ble_trcbps/ble_trcbps.h"
+#include "app_static.h"
 
 
 // *****************************************************************************
@@ -82,6 +84,15 @@
 #define BLE_TRCBPS_CLR_FLAG(x, y)    ((x) &= ~(1 << (y)))
 #define BLE_TRCBPS_CHK_FLAG(x, y)    ((x) & (1 << (y)))
 
+/* Received SDUs wait in queueIn; the static build keeps them in an arena. */
+#if APP_STATIC_ALLOC
+#define BLE_TRCBPS_RX_ALLOC(len)     APP_StaticArenaAlloc(&s_trcbpsRxArena, (len))
+#define BLE_TRCBPS_RX_FREE(p)        APP_StaticArenaFree(&s_trcbpsRxArena, (p))
+#else
+#define BLE_TRCBPS_RX_ALLOC(len)     OSAL_Malloc(len)
+#define BLE_TRCBPS_RX_FREE(p)        OSAL_Free(p)
+#endif
+
 /**@defgroup BLE_TRCBPS_CCCD BLE_TRCBPS_CCCD
  * @brief The definition of Client Characteristic Configuration Descriptor
  * @{ */
@@ -144,6 +155,9 @@ static uint8_t                         s_trcbpFlag;
 static GATTS_SendWriteRespParams_T     *sp_trcbpsRespParams;
 static GATTS_SendErrRespParams_T       *sp_trcbpsErrParams;
 static uint16_t                        s_trcbpsRespErrConnHandle;
+#if APP_STATIC_ALLOC
+APP_STATIC_ARENA_DEFINE(s_trcbpsRxArena, trcbps, APP_STATIC_TRCBPS_RX_ARENA_SIZE);
+#endif
 
 MW_ASSERT((BLE_TRCBPS_MAX_CONN_NBR * BLE_TRCBPS_MAX_CHAN_NBR) == BLE_TRCBPS_MAX_CONNLIST_NBR);
 
@@ -161,7 +175,7 @@ static void ble_trcbps_InitConnList(BLE_TRCBPS_ConnList_T *p_conn, bool clearQue
         {
             if (p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet)
             {
-                OSAL_Free(p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet);
+                BLE_TRCBPS_RX_FREE(p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet);
                 p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet = NULL;
             }
 
@@ -206,8 +220,9 @@ static BLE_TRCBPS_ChanType_T ble_trcbps_CovertSpsmToType(uint16_t spsm)
     {
         return BLE_TRCBPS_CTRL_CHAN;
     }
-    else if (spsm == BLE_TRCB_DATA_PSM)
+    else if ((spsm == BLE_TRCB_DATA_PSM) || (spsm >= BLE_TRCBPS_LE_PSM_DYNAMIC_MIN))
     {
+        /* A client opens the data channel on the PSM the peer publishes */
         return BLE_TRCBPS_DATA_CHAN;
     }
     else
@@ -252,7 +267,7 @@ static BLE_TRCBPS_ConnList_T *ble_trcbps_GetConnListByChanType(uint16_t connHand
 
     for (i = 0; i < BLE_TRCBPS_MAX_CONNLIST_NBR; i++)
     {
-        if ((s_trcbpConnList[i].connHandle == connHandle) && (s_trcbpConnList[i].spsm == ble_trcbps_GetSpsm(type)))
+        if ((s_trcbpConnList[i].connHandle == connHandle) && (ble_trcbps_CovertSpsmToType(s_trcbpConnList[i].spsm) == type))
         {
             return &s_trcbpConnList[i];
         }
@@ -330,7 +345,7 @@ static void ble_trcbps_RcvData(BLE_TRCBPS_ConnList_T *p_conn, BLE_L2CAP_Event_T
     {
         uint8_t *p_buffer;
 
-        p_buffer = OSAL_Malloc(p_event->eventField.evtCbSduInd.length);
+        p_buffer = BLE_TRCBPS_RX_ALLOC(p_event->eventField.evtCbSduInd.length);
 
         if (p_buffer == NULL)
         {
@@ -469,6 +484,10 @@ uint16_t BLE_TRCBPS_Init(void)
     sp_trcbpsErrParams = NULL;
     s_trcbpsRespErrConnHandle = 0;
 
+#if APP_STATIC_ALLOC
+    APP_StaticArenaInit(&s_trcbpsRxArena, "TRCBPS_RX", s_trcbpsRxArena_mem, sizeof(s_trcbpsRxArena_mem));
+#endif
+
     for (i = 0; i < BLE_TRCBPS_MAX_CONNLIST_NBR; i++)
     {
         ble_trcbps_InitConnList(&s_trcbpConnList[i], false);
@@ -485,6 +504,11 @@ uint16_t BLE_TRCBPS_QueryPsm(uint16_t *dataPsm)
 }
 
 uint16_t BLE_TRCBPS_ConnReq(uint16_t connHandle)
+{
+    return BLE_TRCBPS_ConnReqByPsm(connHandle, ble_trcbps_GetSpsm(BLE_TRCBPS_DATA_CHAN));
+}
+
+uint16_t BLE_TRCBPS_ConnReqByPsm(uint16_t connHandle, uint16_t spsm)
 {
     BLE_TRCBPS_ConnList_T *p_conn = NULL;
     uint16_t ret;
@@ -496,7 +520,12 @@ uint16_t BLE_TRCBPS_ConnReq(uint16_t connHandle)
         return MBA_RES_NO_RESOURCE;
     }
 
-    ret = BLE_L2CAP_CbConnReq(connHandle, ble_trcbps_GetSpsm(BLE_TRCBPS_DATA_CHAN));
+    if (ble_trcbps_CovertSpsmToType(spsm) != BLE_TRCBPS_DATA_CHAN)
+    {
+        return MBA_RES_INVALID_PARA;
+    }
+
+    ret = BLE_L2CAP_CbConnReq(connHandle, spsm);
 
     if (ret == MBA_RES_SUCCESS)
     {
@@ -506,7 +535,7 @@ uint16_t BLE_TRCBPS_ConnReq(uint16_t connHandle)
 
         p_conn->connHandle = connHandle;
         p_conn->state = BLE_TRCBPS_STATUS_CONNECTING;
-        p_conn->spsm = ble_trcbps_GetSpsm(BLE_TRCBPS_DATA_CHAN);
+        p_conn->spsm = spsm;
 
         connStatusPara.connHandle = p_conn->connHandle;
         connStatusPara.chanType = BLE_TRCBPS_DATA_CHAN;
@@ -695,7 +724,7 @@ uint16_t BLE_TRCBPS_GetData(uint16_t connHandle, uint8_t *p_data)
         {
             memcpy(p_data, p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet, p_conn->queueIn.packetList[p_conn->queueIn.readIndex].length);
 
-            OSAL_Free(p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet);
+            BLE_TRCBPS_RX_FREE(p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet);
             p_conn->queueIn.packetList[p_conn->queueIn.readIndex].p_packet = NULL;
         }
 
@@ -974,7 +1003,13 @@ static void ble_trcbps_L2capEventProcess(BLE_L2CAP_Event_T *p_event)
         case BLE_L2CAP_EVT_CB_CONN_IND:
         {
             BLE_TRCBPS_ConnList_T *p_conn = NULL;
-            p_conn = ble_trcbps_GetFreeConnList();
+
+            /* Channel opened by BLE_TRCBPS_ConnReqByPsm: complete its entry */
+            p_conn = ble_trcbps_GetConnListByHandle(p_event->eventField.evtCbConnInd.connHandle);
+            if ((p_conn == NULL) || (p_conn->state != BLE_TRCBPS_STATUS_CONNECTING))
+            {
+                p_conn = ble_trcbps_GetFreeConnList();
+            }
 
             if (p_conn != NULL)
             {
@@ -100,6 +100,7 @@
 #define BLE_TRCBPS_DATA_MAX_CREDITS           0x0008                                /**< Maximum credit value of data channel. */
 #define BLE_TRCBPS_DATA_MAX_ACCU_CREDITS      0x0005                                /**< Maximum accumulation credits which will be sent to the peer device of data channel. */
 #define BLE_TRCBPS_PERMISSION                 0x00                                  /**< Permission setting. */
+#define BLE_TRCBPS_LE_PSM_DYNAMIC_MIN         0x0080                                /**< First dynamically assigned LE PSM. A data channel may be opened on any PSM from here up, except the control channel PSM. */
 
 /** @} */
 
@@ -261,6 +262,20 @@ uint16_t BLE_TRCBPS_QueryPsm(uint16_t *dataPsm);
 uint16_t BLE_TRCBPS_ConnReq(uint16_t connHandle);
 
 
+/**@brief Issue a L2CAP CoC connection request for the Data pipe on a given PSM.
+ *        Used by the client role (see ble_trcbpc.h), which opens the channel on the PSM read from the peer's TRCBS service.
+ * @param[in] connHandle                       Connection handle.
+ * @param[in] spsm                             PSM of the peer's data channel. See @ref BLE_TRCBPS_PARA.
+ *
+ * @retval MBA_RES_SUCCESS                    Successfully issue a connection request.
+ * @retval MBA_RES_OOM                        No available memory.
+ * @retval MBA_RES_INVALID_PARA               The connection handle doesn't exist or the SPSM is not a data channel PSM.
+ * @retval MBA_RES_NO_RESOURCE                No Transmit buffers available for sending connection request.
+ *
+ */
+uint16_t BLE_TRCBPS_ConnReqByPsm(uint16_t connHandle, uint16_t spsm);
+
+
 /**@brief Issue a L2CAP CoC disconnect request for Transparent Credit Based Profile Data pipe.
  * @param[in] connHandle                       Connection handle.
  *
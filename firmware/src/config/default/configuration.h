@@ -122,7 +122,7 @@ extern "C" {
 #define NO_MD4
 #define NO_MD5
 #define NO_SHA // specifically, no SHA1 (legacy name)
-#define NO_SHA256
+#define WOLFSSL_HAVE_MCHP_HW_SHA264 // SHA-256 on the ICM (crypt_sha256_sam11105.c), wolfSSL's spelling
 #define NO_SHA224
 #define NO_HMAC
 #define NO_DES3
@@ -134,6 +134,8 @@ extern "C" {
 #define WOLFSSL_HAVE_MCHP_HW_AES_DIRECT
 #define HAVE_AES_CBC
 #define WOLFSSL_HAVE_MCHP_HW_AES_CBC
+#define HAVE_AES_ECB
+#define WOLFSSL_HAVE_MCHP_HW_AES_ECB // multi block ECB, for the CCM key stream of app_aead.c
 #define NO_RC4
 #define NO_HC128
 #define NO_RABBIT
@@ -159,6 +161,133 @@ extern "C" {
 // *****************************************************************************
 // *****************************************************************************
 
+/*** Static allocation build (app_static.h) ***/
+/* 1: tasks, queues and semaphores of the application and the pipe are
+ * created on storage reserved at link time, and the pipe and TRCBPS data
+ * buffers come from the arenas below instead of the heap. The heap is then
+ * left to the BLE stack and to control path requests. */
+#ifndef APP_STATIC_ALLOC
+#define APP_STATIC_ALLOC                        0
+#endif
+
+/* FreeRTOS heap of the static build (configTOTAL_HEAP_SIZE is 40960 in the
+ * dynamic build, task stacks included). The "\nHEAP \n" pipe command reports
+ * its low-water mark. */
+#define APP_STATIC_HEAP_SIZE                    20480
+
+/* Pipe TX queue: BLECB_Pipe_DATA_QUEUE_MAX_ALLOC plus one 1 KB message.
+ * BLECB_Pipe_SendData returns false while it is full. */
+#define APP_STATIC_PIPE_TX_ARENA_SIZE           (10240 + 1024)
+
+/* Pipe RX queue: BLECB_Pipe_RX_PULL_WATERMARK plus the 4 byte header and
+ * rounding of up to BLECB_Pipe_DATA_QUEUE_MAX_ELEMENTS SDUs. SDUs stay in
+ * TRCBPS, with their credits, while it is full. */
+#define APP_STATIC_PIPE_RX_ARENA_SIZE           4352
+
+/* Largest pipe message delivered to the receive callback; longer messages
+ * are dropped and counted (BLECB_Pipe_RxDropped). */
+#define APP_STATIC_PIPE_MSG_MAX                 4096
+
+/* TRCBPS receive queues: the data (8) and control (2) channel buffers of
+ * one link at the 247 byte ATT MTU. Scale with the number of links. */
+#define APP_STATIC_TRCBPS_RX_ARENA_SIZE         2560
+
+/*** SPI slave host interface (app_spi_host.h) ***/
+/* 1: the pipe is connected to an SPI master on SERCOM1 instead of the
+ * console; the SERCOM1 interrupt is only enabled then. The UART bridge
+ * takes precedence when both are enabled. */
+#ifndef APP_SPI_HOST_ENABLE
+#define APP_SPI_HOST_ENABLE                     0
+#endif
+
+/*** Central role pipe client (ble_trcbpc.h) ***/
+/* 1: the board scans for a peer advertising the Transparent Credit Based
+ * service, connects to it, reads its PSM and opens the pipe data channel,
+ * instead of advertising. Flash the other board with 0 to get a board to
+ * board link. */
+#ifndef APP_TRCBPC_ENABLE
+#define APP_TRCBPC_ENABLE                       0
+#endif
+
+/* Connection interval requested by the central (1.25 ms units). */
+#define APP_TRCBPC_CONN_INTERVAL                12
+
+/*** Multi node gateway (app_gateway.h) ***/
+/* 1: the board is a central to up to APP_GATEWAY_MAX_NODES pipe nodes and
+ * sends their data, tagged per node, on the UART. The single link pipe is
+ * not started. */
+#ifndef APP_GATEWAY_ENABLE
+#define APP_GATEWAY_ENABLE                      0
+#endif
+
+/*** Firmware update over the pipe (app_dfu.h) ***/
+/* 1: update images sent on the pipe are written to the upper flash panel
+ * and booted once verified. Define it for the linker as well (WBZ451.ld):
+ * the image then has to fit in the lower panel. */
+#ifndef APP_DFU_ENABLE
+#define APP_DFU_ENABLE                          0
+#endif
+/* HMAC-SHA256 key of the start message, as an initializer list, e.g.
+ * -DAPP_DFU_KEY="{0x3a,0x91,...}" with 32 random bytes. Only images sent
+ * with this key are taken. It has no default: an update build without it
+ * does not compile. */
+
+/*** Flash data log (app_log.h) ***/
+/* 1: fixed size records are kept in a flash ring of APP_LOG_LENGTH bytes
+ * and offloaded on request over the pipe. Define both for the linker as
+ * well (WBZ451.ld), which reserves the ring after the PDS journal. */
+#ifndef APP_LOG_ENABLE
+#define APP_LOG_ENABLE                          0
+#endif
+#ifndef APP_LOG_LENGTH
+#define APP_LOG_LENGTH                          0x10000
+#endif
+
+/*** Pipe queue spill to flash (app_spill.h) ***/
+/* 1: past their RAM watermarks the pipe TX and RX queues carry on in a
+ * flash ring of APP_SPILL_LENGTH bytes, half for each, read back in order
+ * as the queues drain. Define both for the linker as well (WBZ451.ld),
+ * which reserves the ring at the top of the application flash. */
+#ifndef APP_SPILL_ENABLE
+#define APP_SPILL_ENABLE                        0
+#endif
+#ifndef APP_SPILL_LENGTH
+#define APP_SPILL_LENGTH                        0x8000
+#endif
+
+/*** Pipe payload encryption (app_aead.h) ***/
+/* 1: once the peer has opened a session, every pipe message is AES-128-CCM
+ * sealed with a key derived for the connection, on the AES engine. Data is
+ * refused both ways until then. */
+#ifndef APP_AEAD_ENABLE
+#define APP_AEAD_ENABLE                         0
+#endif
+#ifndef APP_AEAD_TAG_LEN
+#define APP_AEAD_TAG_LEN                        8
+#endif
+/* Key shared with the peers, as an initializer list of 16 bytes, e.g.
+ * -DAPP_AEAD_KEY="{0x5c,0x07,...}". APP_AeadSetKey may replace it at run
+ * time. It has no default: an encrypting build without it does not
+ * compile. */
+
+/*** Pipe transfer digest (app_digest.h) ***/
+/* 1: application messages carry a SHA-256 computed on the ICM as they go
+ * through the pipe, checked on reception: a trailer on each message, or
+ * with APP_DIGEST_PER_STREAM one end marker per stream (BLECB_Pipe_SendDigest).
+ * APP_DIGEST_LEN bytes of the digest are sent; 32 is all of it. */
+#ifndef APP_DIGEST_ENABLE
+#define APP_DIGEST_ENABLE                       0
+#endif
+#ifndef APP_DIGEST_PER_STREAM
+#define APP_DIGEST_PER_STREAM                   0
+#endif
+#ifndef APP_DIGEST_LEN
+#define APP_DIGEST_LEN                          32
+#endif
+
+/* Scanning, central role and GATT client of the BLE stack */
+#define APP_BLE_CENTRAL_ENABLE                  (APP_TRCBPC_ENABLE || APP_GATEWAY_ENABLE)
+
 
 //DOM-IGNORE-BEGIN
 #ifdef __cplusplus
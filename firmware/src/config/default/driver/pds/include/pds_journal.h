@@ -0,0 +1,187 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  PDS Journal Header File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    pds_journal.h
+
+  Summary:
+    Append-only journal for small persistent records.
+
+  Description:
+    The journal keeps small, frequently updated records (bonding information,
+    CCCD values, configuration) in two dedicated flash pages reserved by the
+    linker script right after the PDS area. Records are appended to the active
+    page; a newer record for the same identifier supersedes the older one.
+    When the active page fills up the live records are copied to the spare
+    page, which then becomes active.
+
+    Writes never touch flash in the caller's context. They are buffered in RAM,
+    and repeated writes to the same identifier are coalesced into a single
+    flash record. PDS_JNL_TaskHandler(), called by the idle task, queues the
+    flash work one record, erase or page header at a time on the application
+    flash queue (app_flash.h), which programs each quad word in its own BLE RF
+    suspend window and defers page erases to a window where the BLE sleeps.
+ *******************************************************************************/
+
+#ifndef PDS_JOURNAL_H
+#define PDS_JOURNAL_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include "pds.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+extern "C" {
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+
+/**@brief Maximum number of distinct record identifiers kept by the journal. */
+#ifndef PDS_JNL_MAX_ITEMS
+#define PDS_JNL_MAX_ITEMS                   12
+#endif
+
+/**@brief Maximum payload size of a single journal record, in bytes. */
+#ifndef PDS_JNL_MAX_DATA_SIZE
+#define PDS_JNL_MAX_DATA_SIZE               64
+#endif
+
+/**@brief Start compaction in the background once the free space in the active page drops below this many bytes. */
+#ifndef PDS_JNL_COMPACT_THRESHOLD
+#define PDS_JNL_COMPACT_THRESHOLD           1024
+#endif
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+/**@brief Journal statistics. */
+typedef struct PDS_JNL_Stats_T
+{
+    uint32_t    eraseCount;             /**< Lifetime number of journal page erases. Persisted in the page header. */
+    uint32_t    recordsWritten;         /**< Records programmed to flash since boot, including compaction copies. */
+    uint32_t    writesCoalesced;        /**< Writes that replaced a record still pending in RAM. */
+    uint32_t    compactions;            /**< Completed compactions since boot. */
+    uint32_t    flashErrors;            /**< Records, erases and page headers the flash queue reported failed. */
+    uint16_t    freeBytes;              /**< Free space left in the active page. */
+    uint8_t     pendingItems;           /**< Records waiting in RAM to be programmed. */
+} PDS_JNL_Stats_T;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Function Prototypes
+// *****************************************************************************
+// *****************************************************************************
+
+/**@brief Initialize the journal.
+ *
+ * Selects the active page and rebuilds the RAM index. A journal area that
+ * holds no valid page is formatted by the first compaction. Must be called
+ * once after NVM_Initialize().
+ */
+void PDS_JNL_Init(void);
+
+/**@brief Queue a record to be written.
+ *
+ * The data is copied, so the caller's buffer may be reused immediately. A
+ * later write to the same identifier replaces a still-pending one.
+ *
+ * @param[in] id                        Record identifier.
+ * @param[in] p_data                    Record data.
+ * @param[in] len                       Record length, 1 to @ref PDS_JNL_MAX_DATA_SIZE.
+ *
+ * @retval true                         The record is queued.
+ * @retval false                        Invalid length or no free identifier slot.
+ */
+bool PDS_JNL_Write(PDS_MemId_t id, const void *p_data, uint8_t len);
+
+/**@brief Read the latest version of a record, including one still pending in RAM.
+ *
+ * @param[in] id                        Record identifier.
+ * @param[out] p_data                   Destination buffer.
+ * @param[in] len                       Number of bytes to read. Must not exceed the stored record length.
+ *
+ * @retval true                         The record was found and copied.
+ * @retval false                        The record does not exist or is shorter than len.
+ */
+bool PDS_JNL_Read(PDS_MemId_t id, void *p_data, uint8_t len);
+
+/**@brief Check whether a record exists.
+ *
+ * @param[in] id                        Record identifier.
+ *
+ * @retval true                         The record exists.
+ * @retval false                        The record does not exist or has been deleted.
+ */
+bool PDS_JNL_Exists(PDS_MemId_t id);
+
+/**@brief Delete a record. The deletion is persisted in the background.
+ *
+ * @param[in] id                        Record identifier.
+ */
+void PDS_JNL_Delete(PDS_MemId_t id);
+
+/**@brief Check whether the journal has work to do.
+ *
+ * @retval true                         PDS_JNL_TaskHandler() should be called.
+ * @retval false                        Nothing to do, or the queued flash job is not done yet.
+ */
+bool PDS_JNL_IsWorkPending(void);
+
+/**@brief Complete the finished flash job and queue the next one. Idle task only, since
+ * the idle task also starts the queued flash operations.
+ */
+void PDS_JNL_TaskHandler(void);
+
+/**@brief Get the journal statistics.
+ *
+ * @param[out] p_stats                  Statistics snapshot.
+ */
+void PDS_JNL_GetStats(PDS_JNL_Stats_T *p_stats);
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+// DOM-IGNORE-END
+
+#endif /* PDS_JOURNAL_H */
@@ -0,0 +1,909 @@
+/*******************************************************************************
+* Copyright (C) 2022 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+/*******************************************************************************
+  PDS Journal Source File
+
+  Company:
+    Microchip Technology Inc.
+
+  File Name:
+    pds_journal.c
+
+  Summary:
+    Append-only journal for small persistent records.
+
+  Description:
+    Flash layout of each journal page:
+
+      +--------------------+  offset 0
+      | page header (16 B) |  magic, generation, erase count, crc
+      +--------------------+  offset 16
+      | record header      |  id, type, length, sequence, data crc, header crc
+      | record data        |  padded to a multiple of 16 bytes
+      +--------------------+
+      | ...                |
+      +--------------------+
+      | erased (0xFF)      |
+      +--------------------+  offset NVM_FLASH_PAGESIZE
+
+    Everything is programmed with quad word (16 byte) writes. A record header
+    is programmed before its data so a torn record is detected by its data crc
+    and skipped. The page header of a compacted page is programmed last, so a
+    compaction interrupted by a reset leaves the previous page active.
+
+    The writes and erases go through the application flash queue. One job, a
+    record, a page erase or a page header, is queued at a time; its quads are
+    staged in s_jnlJob and the completion callbacks count them down. The task
+    handler updates the index once the whole job is done.
+ *******************************************************************************/
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+#include <stdint.h>
+#include <string.h>
+#include "definitions.h"
+#include "app_flash.h"
+#include "pds_journal.h"
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Macros
+// *****************************************************************************
+// *****************************************************************************
+#define PDS_JNL_PAGE_SIZE               NVM_FLASH_PAGESIZE
+#define PDS_JNL_QUAD_SIZE               16U
+#define PDS_JNL_HDR_SIZE                PDS_JNL_QUAD_SIZE
+#define PDS_JNL_PAGE_MAGIC              0x4C4E4A50U     /* "PJNL" */
+
+#define PDS_JNL_REC_TYPE_DATA           0x5AU
+#define PDS_JNL_REC_TYPE_TOMBSTONE      0xA5U
+
+#define PDS_JNL_SLOT_USED               0x01U
+#define PDS_JNL_SLOT_PENDING            0x02U
+#define PDS_JNL_SLOT_DELETE             0x04U
+#define PDS_JNL_SLOT_BUSY               0x08U           /* Being programmed by the task handler. */
+#define PDS_JNL_SLOT_COPIED             0x10U           /* Pending data copied to the spare page; cleared with PENDING on commit. */
+
+#define PDS_JNL_ALIGN_QUAD(x)           (((x) + (PDS_JNL_QUAD_SIZE - 1U)) & ~(PDS_JNL_QUAD_SIZE - 1U))
+#define PDS_JNL_REC_SIZE(len)           (PDS_JNL_HDR_SIZE + PDS_JNL_ALIGN_QUAD((uint16_t)(len)))
+
+#define PDS_JNL_JOB_QUADS               (1U + (PDS_JNL_ALIGN_QUAD(PDS_JNL_MAX_DATA_SIZE) / PDS_JNL_QUAD_SIZE))
+
+/* All live records plus the compaction threshold must fit in one page, otherwise compaction cannot make progress. */
+_Static_assert((PDS_JNL_MAX_ITEMS * PDS_JNL_REC_SIZE(PDS_JNL_MAX_DATA_SIZE)) + PDS_JNL_HDR_SIZE + PDS_JNL_COMPACT_THRESHOLD
+               <= PDS_JNL_PAGE_SIZE, "PDS journal page too small for PDS_JNL_MAX_ITEMS");
+_Static_assert(PDS_JNL_MAX_DATA_SIZE <= 0xFF, "PDS journal record length is 8 bits");
+_Static_assert(PDS_JNL_JOB_QUADS <= APP_FLASH_QUEUE_LEN, "a PDS journal record must fit in the flash queue");
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef struct pds_jnl_PageHdr_T
+{
+    uint32_t        magic;
+    uint32_t        generation;
+    uint32_t        eraseCount;
+    uint32_t        crc;
+} pds_jnl_PageHdr_T;
+
+typedef struct pds_jnl_RecHdr_T
+{
+    uint16_t        id;
+    uint8_t         type;
+    uint8_t         len;
+    uint32_t        seq;
+    uint32_t        dataCrc;
+    uint32_t        hdrCrc;
+} pds_jnl_RecHdr_T;
+
+typedef struct pds_jnl_Slot_T
+{
+    PDS_MemId_t     id;
+    uint16_t        offset;                             /* Offset of the latest record in the active page, 0 if none. */
+    uint8_t         flags;
+    uint8_t         len;                                /* Length of the pending data. */
+    uint8_t         data[PDS_JNL_MAX_DATA_SIZE];        /* Pending data. */
+} pds_jnl_Slot_T;
+
+typedef enum pds_jnl_CompactState_T
+{
+    PDS_JNL_COMPACT_IDLE,
+    PDS_JNL_COMPACT_ERASE,
+    PDS_JNL_COMPACT_COPY,
+    PDS_JNL_COMPACT_COMMIT
+} pds_jnl_CompactState_T;
+
+typedef enum pds_jnl_JobType_T
+{
+    PDS_JNL_JOB_NONE,
+    PDS_JNL_JOB_APPEND,
+    PDS_JNL_JOB_ERASE,
+    PDS_JNL_JOB_COPY,
+    PDS_JNL_JOB_COMMIT
+} pds_jnl_JobType_T;
+
+typedef struct pds_jnl_Job_T
+{
+    pds_jnl_JobType_T   type;
+    volatile uint8_t    outstanding;                    /* Queued operations not completed yet. */
+    volatile bool       ok;                             /* Cleared by a failed operation. */
+    pds_jnl_Slot_T      *p_slot;
+    uint8_t             recType;
+    uint8_t             len;
+    uint8_t             flags;                          /* Slot flags taken by the job. */
+    uint32_t            quads[PDS_JNL_JOB_QUADS][PDS_JNL_QUAD_SIZE / sizeof(uint32_t)];
+} pds_jnl_Job_T;
+
+_Static_assert(sizeof(pds_jnl_PageHdr_T) == PDS_JNL_QUAD_SIZE, "page header must be one quad word");
+_Static_assert(sizeof(pds_jnl_RecHdr_T) == PDS_JNL_QUAD_SIZE, "record header must be one quad word");
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Local Variables
+// *****************************************************************************
+// *****************************************************************************
+
+extern uint32_t __pds_jnl_start;
+
+static pds_jnl_Slot_T           s_jnlSlots[PDS_JNL_MAX_ITEMS];
+static uint16_t                 s_jnlNewOffset[PDS_JNL_MAX_ITEMS];
+static PDS_JNL_Stats_T          s_jnlStats;
+
+static uint8_t                  s_jnlActivePage;
+static uint32_t                 s_jnlGeneration;
+static uint16_t                 s_jnlWriteOffset;
+static uint32_t                 s_jnlSeq;
+static uint8_t                  s_jnlNextSlot;
+
+static pds_jnl_CompactState_T   s_jnlCompactState;
+static uint8_t                  s_jnlCompactIdx;
+static uint16_t                 s_jnlCompactOffset;
+static pds_jnl_Job_T            s_jnlJob;
+
+static const uint32_t s_jnlCrcNibble[16] =
+{
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+    0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+    0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU
+};
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Functions
+// *****************************************************************************
+// *****************************************************************************
+
+static uint32_t pds_jnl_Crc32(const void *p_data, uint16_t len)
+{
+    const uint8_t *p_byte = (const uint8_t *)p_data;
+    uint32_t crc = 0xFFFFFFFFU;
+
+    while (len--)
+    {
+        crc ^= *p_byte++;
+        crc = (crc >> 4) ^ s_jnlCrcNibble[crc & 0x0FU];
+        crc = (crc >> 4) ^ s_jnlCrcNibble[crc & 0x0FU];
+    }
+
+    return ~crc;
+}
+
+static uint32_t pds_jnl_PageAddr(uint8_t page)
+{
+    return (uint32_t)&__pds_jnl_start + ((uint32_t)page * PDS_JNL_PAGE_SIZE);
+}
+
+static bool pds_jnl_IsErased(uint32_t addr, uint16_t len)
+{
+    const uint32_t *p_word = (const uint32_t *)addr;
+    uint16_t i;
+
+    for (i = 0; i < len / sizeof(uint32_t); i++)
+    {
+        if (p_word[i] != 0xFFFFFFFFU)
+            return false;
+    }
+
+    return true;
+}
+
+/* Completion of a queued job operation, in the NVM interrupt. */
+static void pds_jnl_FlashDone(bool ok, uintptr_t context)
+{
+    (void)context;
+
+    if (!ok)
+        s_jnlJob.ok = false;
+    s_jnlJob.outstanding--;
+}
+
+/* Queue count staged quads of the job from addr on. The caller is the idle task, which also starts the queued
+ * operations, so none completes meanwhile. Returns false if nothing could be queued. */
+static bool pds_jnl_SubmitQuads(uint32_t addr, uint8_t count)
+{
+    APP_FLASH_Op_T op;
+    uint8_t i;
+
+    op.type = APP_FLASH_OP_WRITE_QUAD;
+    op.callback = pds_jnl_FlashDone;
+    op.context = 0;
+    s_jnlJob.ok = true;
+
+    for (i = 0; i < count; i++)
+    {
+        op.addr = addr + ((uint32_t)i * PDS_JNL_QUAD_SIZE);
+        op.p_data = s_jnlJob.quads[i];
+        if (!APP_FlashSubmit(&op))
+            break;
+        s_jnlJob.outstanding++;
+    }
+
+    if (i == 0)
+        return false;
+    if (i < count)
+        s_jnlJob.ok = false;                            /* The record is torn; its header may still land. */
+
+    return true;
+}
+
+static bool pds_jnl_ReadPageHdr(uint8_t page, pds_jnl_PageHdr_T *p_hdr)
+{
+    memcpy(p_hdr, (const void *)pds_jnl_PageAddr(page), sizeof(pds_jnl_PageHdr_T));
+
+    return (p_hdr->magic == PDS_JNL_PAGE_MAGIC
+        && p_hdr->crc == pds_jnl_Crc32(p_hdr, offsetof(pds_jnl_PageHdr_T, crc)));
+}
+
+/* Stage one record in the job. p_data may point to RAM or flash. Returns the number of quads. */
+static uint8_t pds_jnl_StageRecord(PDS_MemId_t id, uint8_t type, const uint8_t *p_data, uint8_t len)
+{
+    pds_jnl_RecHdr_T *p_hdr = (pds_jnl_RecHdr_T *)s_jnlJob.quads[0];
+
+    p_hdr->id = id;
+    p_hdr->type = type;
+    p_hdr->len = len;
+    p_hdr->seq = ++s_jnlSeq;
+    p_hdr->dataCrc = pds_jnl_Crc32(p_data, len);
+    p_hdr->hdrCrc = pds_jnl_Crc32(p_hdr, offsetof(pds_jnl_RecHdr_T, hdrCrc));
+
+    memset(s_jnlJob.quads[1], 0xFF, PDS_JNL_ALIGN_QUAD(len));
+    memcpy(s_jnlJob.quads[1], p_data, len);
+    s_jnlJob.recType = type;
+    s_jnlJob.len = len;
+
+    return (uint8_t)(PDS_JNL_REC_SIZE(len) / PDS_JNL_QUAD_SIZE);
+}
+
+static const pds_jnl_RecHdr_T *pds_jnl_RecAt(uint8_t page, uint16_t offset)
+{
+    return (const pds_jnl_RecHdr_T *)(pds_jnl_PageAddr(page) + offset);
+}
+
+static pds_jnl_Slot_T *pds_jnl_FindSlot(PDS_MemId_t id)
+{
+    uint8_t i;
+
+    for (i = 0; i < PDS_JNL_MAX_ITEMS; i++)
+    {
+        if ((s_jnlSlots[i].flags & PDS_JNL_SLOT_USED) && s_jnlSlots[i].id == id)
+            return &s_jnlSlots[i];
+    }
+
+    return NULL;
+}
+
+static pds_jnl_Slot_T *pds_jnl_AllocSlot(PDS_MemId_t id)
+{
+    pds_jnl_Slot_T *p_slot = pds_jnl_FindSlot(id);
+    uint8_t i;
+
+    if (p_slot != NULL)
+        return p_slot;
+
+    for (i = 0; i < PDS_JNL_MAX_ITEMS; i++)
+    {
+        if (!(s_jnlSlots[i].flags & PDS_JNL_SLOT_USED))
+        {
+            s_jnlSlots[i].id = id;
+            s_jnlSlots[i].offset = 0;
+            s_jnlSlots[i].flags = PDS_JNL_SLOT_USED;
+            return &s_jnlSlots[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Release a slot that has neither a flash record nor pending work. Called with the scheduler suspended. */
+static void pds_jnl_ReleaseIfEmpty(pds_jnl_Slot_T *p_slot)
+{
+    if (p_slot->offset == 0 && !(p_slot->flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE | PDS_JNL_SLOT_BUSY)))
+        p_slot->flags = 0;
+}
+
+/* Rebuild the RAM index from the active page. */
+static void pds_jnl_Scan(void)
+{
+    const pds_jnl_RecHdr_T *p_hdr;
+    pds_jnl_Slot_T *p_slot;
+    uint16_t offset = PDS_JNL_HDR_SIZE;
+    uint16_t size;
+
+    while (offset + PDS_JNL_HDR_SIZE <= PDS_JNL_PAGE_SIZE)
+    {
+        p_hdr = pds_jnl_RecAt(s_jnlActivePage, offset);
+
+        if (pds_jnl_IsErased((uint32_t)p_hdr, PDS_JNL_HDR_SIZE))
+            break;
+
+        size = PDS_JNL_REC_SIZE(p_hdr->len);
+        if (p_hdr->hdrCrc != pds_jnl_Crc32(p_hdr, offsetof(pds_jnl_RecHdr_T, hdrCrc))
+            || (p_hdr->type != PDS_JNL_REC_TYPE_DATA && p_hdr->type != PDS_JNL_REC_TYPE_TOMBSTONE)
+            || p_hdr->len > PDS_JNL_MAX_DATA_SIZE
+            || offset + size > PDS_JNL_PAGE_SIZE)
+        {
+            /* Unreadable header: the rest of the page cannot be trusted or appended to. Compact it away. */
+            offset = PDS_JNL_PAGE_SIZE;
+            break;
+        }
+
+        if ((int32_t)(p_hdr->seq - s_jnlSeq) > 0)
+            s_jnlSeq = p_hdr->seq;
+
+        /* A torn record keeps the header but fails the data crc; the previous version stays valid. */
+        if (p_hdr->dataCrc == pds_jnl_Crc32((const uint8_t *)p_hdr + PDS_JNL_HDR_SIZE, p_hdr->len))
+        {
+            if (p_hdr->type == PDS_JNL_REC_TYPE_DATA)
+            {
+                p_slot = pds_jnl_AllocSlot(p_hdr->id);
+                if (p_slot != NULL)
+                    p_slot->offset = offset;
+            }
+            else
+            {
+                p_slot = pds_jnl_FindSlot(p_hdr->id);
+                if (p_slot != NULL)
+                {
+                    p_slot->offset = 0;
+                    pds_jnl_ReleaseIfEmpty(p_slot);
+                }
+            }
+        }
+
+        offset += size;
+    }
+
+    s_jnlWriteOffset = offset;
+}
+
+void PDS_JNL_Init(void)
+{
+    pds_jnl_PageHdr_T hdr[2];
+    bool valid[2];
+
+    memset(s_jnlSlots, 0, sizeof(s_jnlSlots));
+    memset(&s_jnlStats, 0, sizeof(s_jnlStats));
+    memset(&s_jnlJob, 0, sizeof(s_jnlJob));
+    s_jnlCompactState = PDS_JNL_COMPACT_IDLE;
+    s_jnlSeq = 0;
+    s_jnlNextSlot = 0;
+
+    valid[0] = pds_jnl_ReadPageHdr(0, &hdr[0]);
+    valid[1] = pds_jnl_ReadPageHdr(1, &hdr[1]);
+
+    if (valid[0] && valid[1])
+        s_jnlActivePage = ((int32_t)(hdr[1].generation - hdr[0].generation) > 0) ? 1 : 0;
+    else if (valid[0] || valid[1])
+        s_jnlActivePage = valid[1] ? 1 : 0;
+    else
+    {
+        /* Blank or unrecognized journal area: nothing can be appended until the first compaction formats page 1. */
+        s_jnlActivePage = 0;
+        s_jnlGeneration = 0;
+        s_jnlWriteOffset = PDS_JNL_PAGE_SIZE;
+        return;
+    }
+
+    s_jnlGeneration = hdr[s_jnlActivePage].generation;
+    s_jnlStats.eraseCount = hdr[s_jnlActivePage].eraseCount;
+
+    pds_jnl_Scan();
+}
+
+bool PDS_JNL_Write(PDS_MemId_t id, const void *p_data, uint8_t len)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot;
+    bool result = false;
+
+    if (len == 0 || len > PDS_JNL_MAX_DATA_SIZE || p_data == NULL)
+        return false;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot = pds_jnl_AllocSlot(id);
+    if (p_slot != NULL)
+    {
+        if (p_slot->flags & PDS_JNL_SLOT_PENDING)
+            s_jnlStats.writesCoalesced++;
+
+        memcpy(p_slot->data, p_data, len);
+        p_slot->len = len;
+        p_slot->flags = (p_slot->flags | PDS_JNL_SLOT_PENDING) & ~(PDS_JNL_SLOT_DELETE | PDS_JNL_SLOT_COPIED);
+        result = true;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    return result;
+}
+
+bool PDS_JNL_Read(PDS_MemId_t id, void *p_data, uint8_t len)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    const pds_jnl_RecHdr_T *p_hdr;
+    pds_jnl_Slot_T *p_slot;
+    bool result = false;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot = pds_jnl_FindSlot(id);
+    if (p_slot != NULL && !(p_slot->flags & PDS_JNL_SLOT_DELETE))
+    {
+        if (p_slot->flags & PDS_JNL_SLOT_PENDING)
+        {
+            if (len <= p_slot->len)
+            {
+                memcpy(p_data, p_slot->data, len);
+                result = true;
+            }
+        }
+        else if (p_slot->offset != 0)
+        {
+            p_hdr = pds_jnl_RecAt(s_jnlActivePage, p_slot->offset);
+            if (len <= p_hdr->len)
+            {
+                memcpy(p_data, (const uint8_t *)p_hdr + PDS_JNL_HDR_SIZE, len);
+                result = true;
+            }
+        }
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    return result;
+}
+
+bool PDS_JNL_Exists(PDS_MemId_t id)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot;
+    bool result = false;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot = pds_jnl_FindSlot(id);
+    if (p_slot != NULL && !(p_slot->flags & PDS_JNL_SLOT_DELETE))
+        result = (p_slot->offset != 0) || (p_slot->flags & PDS_JNL_SLOT_PENDING);
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    return result;
+}
+
+void PDS_JNL_Delete(PDS_MemId_t id)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot = pds_jnl_FindSlot(id);
+    if (p_slot != NULL)
+    {
+        p_slot->flags &= ~(PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_COPIED);
+        if (p_slot->offset != 0 || (p_slot->flags & PDS_JNL_SLOT_BUSY) || s_jnlCompactState != PDS_JNL_COMPACT_IDLE)
+            p_slot->flags |= PDS_JNL_SLOT_DELETE;       /* A tombstone is needed to mask the flash record. */
+        pds_jnl_ReleaseIfEmpty(p_slot);
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+}
+
+static bool pds_jnl_HasPendingSlots(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < PDS_JNL_MAX_ITEMS; i++)
+    {
+        if (s_jnlSlots[i].flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE))
+            return true;
+    }
+
+    return false;
+}
+
+bool PDS_JNL_IsWorkPending(void)
+{
+    if (s_jnlJob.type != PDS_JNL_JOB_NONE)
+        return (s_jnlJob.outstanding == 0);             /* Done, the index is to be updated. */
+
+    return (s_jnlCompactState != PDS_JNL_COMPACT_IDLE)
+        || (PDS_JNL_PAGE_SIZE - s_jnlWriteOffset < PDS_JNL_COMPACT_THRESHOLD)
+        || pds_jnl_HasPendingSlots();
+}
+
+/* Queue one pending record or tombstone for the active page. Returns false when there is nothing to do or no room. */
+static bool pds_jnl_StartAppend(void)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot = NULL;
+    uint8_t data[PDS_JNL_MAX_DATA_SIZE];
+    uint8_t type = 0, len = 0, flags = 0;
+    uint8_t i, idx, quads;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    for (i = 0; i < PDS_JNL_MAX_ITEMS; i++)
+    {
+        idx = (uint8_t)((s_jnlNextSlot + i) % PDS_JNL_MAX_ITEMS);
+        if (s_jnlSlots[idx].flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE))
+        {
+            p_slot = &s_jnlSlots[idx];
+            s_jnlNextSlot = (uint8_t)((idx + 1) % PDS_JNL_MAX_ITEMS);
+            break;
+        }
+    }
+
+    if (p_slot != NULL)
+    {
+        flags = p_slot->flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE);
+        if (flags & PDS_JNL_SLOT_PENDING)
+        {
+            type = PDS_JNL_REC_TYPE_DATA;
+            len = p_slot->len;
+            memcpy(data, p_slot->data, len);
+        }
+        else
+        {
+            type = PDS_JNL_REC_TYPE_TOMBSTONE;
+        }
+
+        if (type == PDS_JNL_REC_TYPE_TOMBSTONE && p_slot->offset == 0)
+        {
+            /* Nothing in flash to mask. */
+            p_slot->flags &= ~PDS_JNL_SLOT_DELETE;
+            pds_jnl_ReleaseIfEmpty(p_slot);
+            OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+            return true;
+        }
+
+        if (s_jnlWriteOffset + PDS_JNL_REC_SIZE(len) > PDS_JNL_PAGE_SIZE)
+            p_slot = NULL;                              /* Leave it pending; the page must be compacted first. */
+        else
+            p_slot->flags = (p_slot->flags & ~flags) | PDS_JNL_SLOT_BUSY;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    if (p_slot == NULL)
+        return false;
+
+    quads = pds_jnl_StageRecord(p_slot->id, type, data, len);
+    s_jnlJob.p_slot = p_slot;
+    s_jnlJob.flags = flags;
+    if (pds_jnl_SubmitQuads(pds_jnl_PageAddr(s_jnlActivePage) + s_jnlWriteOffset, quads))
+    {
+        s_jnlJob.type = PDS_JNL_JOB_APPEND;
+        return true;
+    }
+
+    /* Flash queue full: nothing was programmed, retry later. */
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot->flags &= ~PDS_JNL_SLOT_BUSY;
+    if (!(p_slot->flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE)))
+        p_slot->flags |= flags;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    return false;
+}
+
+static void pds_jnl_FinishAppend(bool ok)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot = s_jnlJob.p_slot;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot->flags &= ~PDS_JNL_SLOT_BUSY;
+    if (ok)
+    {
+        p_slot->offset = (s_jnlJob.recType == PDS_JNL_REC_TYPE_DATA) ? s_jnlWriteOffset : 0;
+        pds_jnl_ReleaseIfEmpty(p_slot);
+    }
+    else if (!(p_slot->flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE)))
+    {
+        p_slot->flags |= s_jnlJob.flags;                /* Not superseded meanwhile: retry later. */
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    /* Whatever was programmed, even partially, occupies the space. */
+    s_jnlWriteOffset += PDS_JNL_REC_SIZE(s_jnlJob.len);
+}
+
+/* Queue the erase of the spare page. Returns false if it is already erased or the flash queue is full. */
+static bool pds_jnl_StartErase(void)
+{
+    APP_FLASH_Op_T op;
+
+    op.type = APP_FLASH_OP_ERASE_PAGE;
+    op.addr = pds_jnl_PageAddr(s_jnlActivePage ^ 1U);
+    op.p_data = NULL;
+    op.callback = pds_jnl_FlashDone;
+    op.context = 0;
+
+    if (pds_jnl_IsErased(op.addr, PDS_JNL_PAGE_SIZE))
+    {
+        s_jnlCompactIdx = 0;
+        s_jnlCompactOffset = PDS_JNL_HDR_SIZE;
+        s_jnlCompactState = PDS_JNL_COMPACT_COPY;
+        return false;
+    }
+
+    s_jnlJob.ok = true;
+    if (!APP_FlashSubmit(&op))
+        return false;
+
+    s_jnlJob.outstanding = 1;
+    s_jnlJob.type = PDS_JNL_JOB_ERASE;
+    s_jnlStats.eraseCount++;
+
+    return true;
+}
+
+/* Queue the copy of one slot into the spare page during compaction. Returns false if the flash queue is full,
+ * true if the copy is queued or the slot has nothing to copy. */
+static bool pds_jnl_StartCopy(uint8_t idx)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot = &s_jnlSlots[idx];
+    const pds_jnl_RecHdr_T *p_hdr;
+    uint8_t data[PDS_JNL_MAX_DATA_SIZE];
+    const uint8_t *p_src = NULL;
+    uint8_t len = 0, flags = 0, quads;
+    uint8_t spare = s_jnlActivePage ^ 1U;
+
+    s_jnlNewOffset[idx] = 0;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot->flags &= ~PDS_JNL_SLOT_COPIED;
+    if (p_slot->flags & PDS_JNL_SLOT_PENDING)
+    {
+        /* Pending data supersedes the flash copy and is written straight to the new page.
+         * It stays pending until the new page is committed, so a failed compaction loses nothing. */
+        flags = PDS_JNL_SLOT_PENDING;
+        len = p_slot->len;
+        memcpy(data, p_slot->data, len);
+        p_src = data;
+    }
+    else if ((p_slot->flags & PDS_JNL_SLOT_USED) && !(p_slot->flags & PDS_JNL_SLOT_DELETE) && p_slot->offset != 0)
+    {
+        p_hdr = pds_jnl_RecAt(s_jnlActivePage, p_slot->offset);
+        len = p_hdr->len;
+        p_src = (const uint8_t *)p_hdr + PDS_JNL_HDR_SIZE;
+    }
+    else if (p_slot->flags & PDS_JNL_SLOT_DELETE)
+    {
+        /* The new page has no record to mask. */
+        p_slot->flags &= ~PDS_JNL_SLOT_DELETE;
+    }
+    if (p_src != NULL)
+        p_slot->flags |= PDS_JNL_SLOT_BUSY;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    if (p_src == NULL)
+        return true;
+
+    quads = pds_jnl_StageRecord(p_slot->id, PDS_JNL_REC_TYPE_DATA, p_src, len);
+    s_jnlJob.p_slot = p_slot;
+    s_jnlJob.flags = flags;
+    if (pds_jnl_SubmitQuads(pds_jnl_PageAddr(spare) + s_jnlCompactOffset, quads))
+    {
+        s_jnlJob.type = PDS_JNL_JOB_COPY;
+        return true;
+    }
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot->flags &= ~PDS_JNL_SLOT_BUSY;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    return false;
+}
+
+static void pds_jnl_FinishCopy(bool ok)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    pds_jnl_Slot_T *p_slot = s_jnlJob.p_slot;
+    uint8_t len = s_jnlJob.len;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    p_slot->flags &= ~PDS_JNL_SLOT_BUSY;
+    if (ok && (s_jnlJob.flags & PDS_JNL_SLOT_PENDING) && (p_slot->flags & PDS_JNL_SLOT_PENDING)
+        && p_slot->len == len && memcmp(p_slot->data, s_jnlJob.quads[1], len) == 0)
+    {
+        p_slot->flags |= PDS_JNL_SLOT_COPIED;           /* Not rewritten meanwhile. */
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    if (!ok)
+    {
+        s_jnlCompactState = PDS_JNL_COMPACT_ERASE;
+        return;
+    }
+
+    s_jnlNewOffset[s_jnlCompactIdx] = s_jnlCompactOffset;
+    s_jnlCompactOffset += PDS_JNL_REC_SIZE(len);
+    s_jnlCompactIdx++;
+}
+
+/* Queue the page header that makes the spare page active. */
+static bool pds_jnl_StartCommit(void)
+{
+    pds_jnl_PageHdr_T *p_hdr = (pds_jnl_PageHdr_T *)s_jnlJob.quads[0];
+
+    p_hdr->magic = PDS_JNL_PAGE_MAGIC;
+    p_hdr->generation = s_jnlGeneration + 1U;
+    p_hdr->eraseCount = s_jnlStats.eraseCount;
+    p_hdr->crc = pds_jnl_Crc32(p_hdr, offsetof(pds_jnl_PageHdr_T, crc));
+
+    if (!pds_jnl_SubmitQuads(pds_jnl_PageAddr(s_jnlActivePage ^ 1U), 1))
+        return false;
+
+    s_jnlJob.type = PDS_JNL_JOB_COMMIT;
+
+    return true;
+}
+
+static void pds_jnl_FinishCommit(bool ok)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint8_t i;
+
+    if (!ok)
+    {
+        s_jnlCompactState = PDS_JNL_COMPACT_ERASE;
+        return;
+    }
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    s_jnlActivePage ^= 1U;
+    s_jnlGeneration++;
+    s_jnlWriteOffset = s_jnlCompactOffset;
+    for (i = 0; i < PDS_JNL_MAX_ITEMS; i++)
+    {
+        if (s_jnlSlots[i].flags & PDS_JNL_SLOT_USED)
+        {
+            if (s_jnlSlots[i].flags & PDS_JNL_SLOT_COPIED)
+                s_jnlSlots[i].flags &= ~(PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_COPIED);
+            s_jnlSlots[i].offset = s_jnlNewOffset[i];
+            pds_jnl_ReleaseIfEmpty(&s_jnlSlots[i]);
+        }
+    }
+    s_jnlCompactState = PDS_JNL_COMPACT_IDLE;
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+
+    s_jnlStats.compactions++;
+}
+
+static void pds_jnl_FinishJob(void)
+{
+    bool ok = s_jnlJob.ok;
+
+    if (!ok)
+        s_jnlStats.flashErrors++;
+    else if (s_jnlJob.type == PDS_JNL_JOB_APPEND || s_jnlJob.type == PDS_JNL_JOB_COPY)
+        s_jnlStats.recordsWritten++;
+
+    switch (s_jnlJob.type)
+    {
+        case PDS_JNL_JOB_APPEND:
+            pds_jnl_FinishAppend(ok);
+            break;
+
+        case PDS_JNL_JOB_ERASE:
+            if (ok)
+            {
+                s_jnlCompactIdx = 0;
+                s_jnlCompactOffset = PDS_JNL_HDR_SIZE;
+                s_jnlCompactState = PDS_JNL_COMPACT_COPY;
+            }
+            break;
+
+        case PDS_JNL_JOB_COPY:
+            pds_jnl_FinishCopy(ok);
+            break;
+
+        default:
+            pds_jnl_FinishCommit(ok);
+            break;
+    }
+
+    s_jnlJob.type = PDS_JNL_JOB_NONE;
+}
+
+void PDS_JNL_TaskHandler(void)
+{
+    if (s_jnlJob.outstanding != 0)
+        return;
+
+    if (s_jnlJob.type != PDS_JNL_JOB_NONE)
+        pds_jnl_FinishJob();
+
+    if (s_jnlCompactState == PDS_JNL_COMPACT_IDLE)
+    {
+        if (PDS_JNL_PAGE_SIZE - s_jnlWriteOffset < PDS_JNL_COMPACT_THRESHOLD)
+            s_jnlCompactState = PDS_JNL_COMPACT_ERASE;
+        else
+            (void)pds_jnl_StartAppend();
+    }
+
+    if (s_jnlCompactState == PDS_JNL_COMPACT_ERASE)
+    {
+        /* The flash queue defers the erase to a window where the BLE sleeps. */
+        if (pds_jnl_StartErase())
+            return;
+    }
+
+    if (s_jnlCompactState == PDS_JNL_COMPACT_COPY)
+    {
+        while (s_jnlCompactIdx < PDS_JNL_MAX_ITEMS)
+        {
+            if (!pds_jnl_StartCopy(s_jnlCompactIdx) || s_jnlJob.type != PDS_JNL_JOB_NONE)
+                return;                                 /* Queued, or the flash queue is full. */
+            s_jnlCompactIdx++;
+        }
+        s_jnlCompactState = PDS_JNL_COMPACT_COMMIT;
+    }
+
+    if (s_jnlCompactState == PDS_JNL_COMPACT_COMMIT)
+        (void)pds_jnl_StartCommit();
+}
+
+void PDS_JNL_GetStats(PDS_JNL_Stats_T *p_stats)
+{
+    OSAL_CRITSECT_DATA_TYPE critState;
+    uint8_t i;
+
+    critState = OSAL_CRIT_Enter(OSAL_CRIT_TYPE_LOW);
+    memcpy(p_stats, &s_jnlStats, sizeof(PDS_JNL_Stats_T));
+    p_stats->freeBytes = PDS_JNL_PAGE_SIZE - s_jnlWriteOffset;
+    p_stats->pendingItems = 0;
+    for (i = 0; i < PDS_JNL_MAX_ITEMS; i++)
+    {
+        if (s_jnlSlots[i].flags & (PDS_JNL_SLOT_PENDING | PDS_JNL_SLOT_DELETE))
+            p_stats->pendingItems++;
+    }
+    OSAL_CRIT_Leave(OSAL_CRIT_TYPE_LOW, critState);
+}
@@ -39,6 +39,8 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "definitions.h"
+#include "app_heap_diag.h"
+#include "app_static.h"
 
 /*
 *********************************************************************************************************
@@ -108,6 +110,7 @@ void vApplicationMallocFailedHook( void )
       FreeRTOSConfig.h, and the xPortGetFreeHeapSize() API function can be used
       to query the size of free heap space that remains (although it does not
       provide information on how the remaining heap might be fragmented). */
+   APP_HeapDiagMallocFailed();
    taskDISABLE_INTERRUPTS();
    for( ;; );
 }
@@ -130,6 +133,41 @@ void vApplicationIdleHook( void )
 
 /*-----------------------------------------------------------*/
 
+#if ( configSUPPORT_STATIC_ALLOCATION == 1 )
+/*
+*********************************************************************************************************
+*                                     vApplicationGetIdleTaskMemory()
+*
+* Description : Provides the stack and control block of the idle task when static allocation is
+*               enabled (APP_STATIC_ALLOC). The stack goes with the other task stacks into the
+*               .app_static_tasks linker section.
+*
+* Argument(s) : ppxIdleTaskTCBBuffer     Returns the idle task control block.
+*
+*               ppxIdleTaskStackBuffer   Returns the idle task stack.
+*
+*               pulIdleTaskStackSize     Returns the stack depth in words.
+*
+* Return(s)   : none
+*
+* Caller(s)   : vTaskStartScheduler()
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+                                    StackType_t **ppxIdleTaskStackBuffer,
+                                    uint32_t *pulIdleTaskStackSize )
+{
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ] APP_STATIC_SECTION(tasks);
+
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+#endif
+
 /*-----------------------------------------------------------*/
 
 void vApplicationTickHook( void )
@@ -0,0 +1,42 @@
+/*******************************************************************************
+  FreeRTOS Trace Hooks Header
+
+  File Name:
+    freertos_trace_hooks.h
+
+  Summary:
+    Kernel trace macros routed to the CPU profiler.
+
+  Description:
+    Included by FreeRTOSConfig.h only. It carries the traceTASK_SWITCHED_IN/OUT
+    macros and the two hook prototypes they call, so the kernel configuration
+    does not depend on the profiler's application header (app_prof.h).
+
+  Remarks:
+    APP_PROF_ENABLE defaults here; app_prof.h includes this file so both see
+    the same value.
+*******************************************************************************/
+
+#ifndef FREERTOS_TRACE_HOOKS_H
+#define FREERTOS_TRACE_HOOKS_H
+
+#include <stdint.h>
+
+/* Build the profiler in. The context switch hooks cost about 40 cycles each,
+ * the interrupt wrappers about 30 cycles per interrupt. */
+#ifndef APP_PROF_ENABLE
+#define APP_PROF_ENABLE                 1
+#endif
+
+void APP_ProfTaskSwitchedIn(uint32_t taskNumber, void *p_task);
+void APP_ProfTaskSwitchedOut(void);
+
+#if APP_PROF_ENABLE
+#define traceTASK_SWITCHED_IN()         APP_ProfTaskSwitchedIn(pxCurrentTCB->uxTCBNumber, pxCurrentTCB)
+#define traceTASK_SWITCHED_OUT()        APP_ProfTaskSwitchedOut()
+#endif
+
+#endif // FREERTOS_TRACE_HOOKS_H
+/*******************************************************************************
+ End of File
+*/
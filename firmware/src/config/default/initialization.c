@@ -46,6 +46,7 @@
 #include "configuration.h"
 #include "definitions.h"
 #include "device.h"
+#include "app_static.h"
 
 
 
@@ -360,6 +361,8 @@ void SYS_Initialize ( void* data )
 
     SERCOM0_USART_Initialize();
 
+    DMAC_Initialize();
+
     NVM_Initialize();
 
 
@@ -387,6 +390,8 @@ void SYS_Initialize ( void* data )
 *******************************************************************************/
     // Initialize PDS- Persistent Data Server
     PDS_Init(MAX_PDS_ITEMS_COUNT, MAX_PDS_DIRECTORIES_COUNT);
+    // Initialize PDS journal for small, frequently updated records
+    PDS_JNL_Init();
 
 
 /*******************************************************************************
@@ -434,13 +439,13 @@ void SYS_Initialize ( void* data )
     osalAPIList.OSAL_QUEUE_AddToSet  = OSAL_QUEUE_AddToSet;
     osalAPIList.OSAL_QUEUE_SelectFromSet = OSAL_QUEUE_SelectFromSet;
 
-    osalAPIList.OSAL_MemAlloc = OSAL_Malloc;
+    osalAPIList.OSAL_MemAlloc = OSAL_MallocBleStack;
     osalAPIList.OSAL_MemFree = OSAL_Free;
 
 
 
     // Create BLE Stack Message QUEUE
-    OSAL_QUEUE_Create(&bleRequestQueueHandle, QUEUE_LENGTH_BLE, QUEUE_ITEM_SIZE_BLE);
+    APP_STATIC_QUEUE_CREATE(&bleRequestQueueHandle, QUEUE_LENGTH_BLE, QUEUE_ITEM_SIZE_BLE);
 
     // Retrieve BLE calibration data
     btSysCfg.addrValid = IB_GetBdAddr(&btSysCfg.devAddr[0]);
@@ -53,6 +53,7 @@
 #include "device_vectors.h"
 #include "interrupts.h"
 #include "definitions.h"
+#include "app_prof.h"
 
 
 // *****************************************************************************
@@ -79,7 +80,7 @@ void __attribute__((optimize("-O1"),section(".text.Dummy_Handler"),long_call, no
 }
 
 /* MISRAC 2012 deviation block start */
-/* MISRA C-2012 Rule 8.6 deviated 40 times.  Deviation record ID -  H3_MISRAC_2012_R_8_6_DR_1 */
+/* MISRA C-2012 Rule 8.6 deviated 39 times.  Deviation record ID -  H3_MISRAC_2012_R_8_6_DR_1 */
 /* Device vectors list dummy definition*/
 extern void vPortSVCHandler            ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void xPortPendSVHandler         ( void ) __attribute__((weak, alias("Dummy_Handler")));
@@ -88,7 +89,6 @@ extern void EIC_Handler                ( void ) __attribute__((weak, alias("Dumm
 extern void FREQM_Handler              ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void CHANGE_NOTICE_A_Handler    ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void CHANGE_NOTICE_B_Handler    ( void ) __attribute__((weak, alias("Dummy_Handler")));
-extern void DMAC_0_3_Handler           ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void DMAC_4_15_Handler          ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void EVSYS_0_3_Handler          ( void ) __attribute__((weak, alias("Dummy_Handler")));
 extern void EVSYS_4_11_Handler         ( void ) __attribute__((weak, alias("Dummy_Handler")));
@@ -144,21 +144,39 @@ const H3DeviceVectors exception_table=
     .pfnSVCall_Handler             = vPortSVCHandler,
     .pfnDebugMonitor_Handler       = DebugMonitor_Handler,
     .pfnPendSV_Handler             = xPortPendSVHandler,
+#if APP_PROF_ENABLE
+    .pfnSysTick_Handler            = APP_PROF_SysTick_Handler,
+#else
     .pfnSysTick_Handler            = xPortSysTickHandler,
+#endif
     .pfnRTC_Handler                = RTC_Handler,
     .pfnEIC_Handler                = EIC_Handler,
     .pfnFREQM_Handler              = FREQM_Handler,
+#if APP_PROF_ENABLE
+    .pfnFLASH_CONTROL_Handler      = APP_PROF_NVM_Handler,
+#else
     .pfnFLASH_CONTROL_Handler      = NVM_InterruptHandler,
+#endif
     .pfnCHANGE_NOTICE_A_Handler    = CHANGE_NOTICE_A_Handler,
     .pfnCHANGE_NOTICE_B_Handler    = CHANGE_NOTICE_B_Handler,
-    .pfnDMAC_0_3_Handler           = DMAC_0_3_Handler,
+    .pfnDMAC_0_3_Handler           = DMAC_0_3_InterruptHandler,
     .pfnDMAC_4_15_Handler          = DMAC_4_15_Handler,
     .pfnEVSYS_0_3_Handler          = EVSYS_0_3_Handler,
     .pfnEVSYS_4_11_Handler         = EVSYS_4_11_Handler,
     .pfnPAC_Handler                = PAC_Handler,
     .pfnRAMECC_Handler             = RAMECC_Handler,
+#if APP_PROF_ENABLE
+    .pfnSERCOM0_Handler            = APP_PROF_SERCOM0_Handler,
+#else
     .pfnSERCOM0_Handler            = SERCOM0_USART_InterruptHandler,
+#endif
+#if !APP_SPI_HOST_ENABLE
     .pfnSERCOM1_Handler            = SERCOM1_Handler,
+#elif APP_PROF_ENABLE
+    .pfnSERCOM1_Handler            = APP_PROF_SERCOM1_Handler,
+#else
+    .pfnSERCOM1_Handler            = SERCOM1_SPI_InterruptHandler,
+#endif
     .pfnSERCOM2_Handler            = SERCOM2_Handler,
     .pfnSERCOM3_Handler            = SERCOM3_Handler,
     .pfnTCC0_Handler               = TCC0_Handler,
@@ -176,15 +194,31 @@ const H3DeviceVectors exception_table=
     .pfnPUKCC_Handler              = PUKCC_Handler,
     .pfnQSPI_Handler               = QSPI_Handler,
     .pfnZB_INT0_Handler            = ZB_INT0_Handler,
+#if APP_PROF_ENABLE
+    .pfnBT_INT0_Handler            = APP_PROF_BT_INT0_Handler,
+#else
     .pfnBT_INT0_Handler            = BT_INT0_Handler,
+#endif
+#if APP_PROF_ENABLE
+    .pfnBT_INT1_Handler            = APP_PROF_BT_INT1_Handler,
+#else
     .pfnBT_INT1_Handler            = BT_INT1_Handler,
+#endif
     .pfnARBITER_Handler            = ARBITER_Handler,
     .pfnADC_FAULT_Handler          = ADC_FAULT_Handler,
     .pfnADC_EOS_Handler            = ADC_EOS_Handler,
     .pfnADC_BGVR_RDY_Handler       = ADC_BGVR_RDY_Handler,
     .pfnCLKI_WAKEUP_NMI_Handler    = CLKI_WAKEUP_NMI_Handler,
+#if APP_PROF_ENABLE
+    .pfnBT_LC_Handler              = APP_PROF_BT_LC_Handler,
+#else
     .pfnBT_LC_Handler              = BT_LC_Handler,
+#endif
+#if APP_PROF_ENABLE
+    .pfnBT_RC_Handler              = APP_PROF_BT_RC_Handler,
+#else
     .pfnBT_RC_Handler              = BT_RC_Handler,
+#endif
 
 
 };
@@ -48,12 +48,39 @@
 /*  This section lists the other files that are included in this file.
  */
 
+#include <string.h>
 #include "FreeRTOS.h"
 #include "queue.h"
 #include "semphr.h"
 #include "task.h"
 
 #include "osal/osal_freertos.h"
+#include "app_trace.h"
+
+#if (OSAL_MEM_STATS_ENABLE == 1)
+/* Header in front of every block handed out by OSAL_Malloc. It is 8 bytes so
+   the user pointer keeps the portBYTE_ALIGNMENT of heap_4. */
+typedef struct OSAL_MEM_HDR
+{
+  uint32_t tagMagic;                    /* OSAL_MEM_MAGIC | tag, cleared on free */
+  uint32_t size;                        /* Requested size */
+} OSAL_MEM_HDR;
+
+#define OSAL_MEM_MAGIC                  0xA10C5E00UL
+#define OSAL_MEM_MAGIC_MASK             0xFFFFFF00UL
+
+static OSAL_MEM_TAG_STATS osalMemTagStats[OSAL_MEM_TAG_NUM];
+static uint32_t osalMemForeignFrees;
+static uint32_t osalMemLastFailSize;
+static uint8_t  osalMemLastFailTag;
+static uint32_t osalMemPendingSize;     /* Request being served, seen non-zero only from the malloc failed hook */
+static uint8_t  osalMemPendingTag;
+#endif
+
+static const char * const osalMemTagNames[OSAL_MEM_TAG_NUM] =
+{
+  "DEFAULT", "BLE_STACK", "BLE_EVT", "BLE_DM", "TRCBPS", "PIPE", "APP"
+};
 
 // *****************************************************************************
 // *****************************************************************************
@@ -773,7 +800,7 @@ OSAL_RESULT OSAL_MUTEX_Unlock(OSAL_MUTEX_HANDLE_TYPE* mutexID)
  */
 void* OSAL_Malloc(size_t size)
 {
-    return pvPortMalloc(size);
+    return OSAL_MallocTagged(size, OSAL_MEM_TAG_DEFAULT);
 }
 
 // *****************************************************************************
@@ -822,7 +849,233 @@ void* OSAL_Malloc(size_t size)
  */
 void OSAL_Free(void* pData)
 {
+#if (OSAL_MEM_STATS_ENABLE == 1)
+    OSAL_MEM_HDR *pHdr;
+    OSAL_MEM_TAG_STATS *pTag;
+    uint8_t tag;
+
+    if (pData == NULL)
+    {
+        return;
+    }
+
+    pHdr = (OSAL_MEM_HDR *)pData - 1;
+
+    vTaskSuspendAll();
+    tag = (uint8_t)pHdr->tagMagic;
+    if ((pHdr->tagMagic & OSAL_MEM_MAGIC_MASK) != OSAL_MEM_MAGIC || tag >= OSAL_MEM_TAG_NUM)
+    {
+        /* Not allocated by OSAL_Malloc, or already freed */
+        osalMemForeignFrees++;
+        APP_TRACE(APP_TRACE_EVT_HEAP_FREE, 0xFF, 0);
+        pHdr = pData;
+    }
+    else
+    {
+        pTag = &osalMemTagStats[tag];
+        pTag->liveBytes -= pHdr->size;
+        pTag->freeCount++;
+        APP_TRACE(APP_TRACE_EVT_HEAP_FREE, tag, pHdr->size);
+        pHdr->tagMagic = 0;
+    }
+    (void)xTaskResumeAll();
+
+    vPortFree(pHdr);
+#else
     vPortFree(pData);
+#endif
+}
+
+// *****************************************************************************
+/* Function:
+    void* OSAL_MallocTagged(size_t size, uint8_t tag)
+
+  Summary:
+    Allocates memory and accounts it to a module.
+
+  Description:
+     Same as OSAL_Malloc, with the block accounted to tag. Source files
+     normally do not call it directly but define OSAL_MEM_TAG, which maps their
+     OSAL_Malloc calls to it.
+
+  Parameters:
+    size      - Size of the requested memory block in bytes
+    tag       - One of OSAL_MEM_TAG_ID
+
+  Returns:
+     Pointer to the block of allocated memory. NULL is returned if memory could
+     not be allocated.
+
+  Remarks:
+    The scheduler is kept suspended across the allocation so the malloc failed
+    hook can read the failing request with OSAL_MemGetHeapStats.
+ */
+void* OSAL_MallocTagged(size_t size, uint8_t tag)
+{
+#if (OSAL_MEM_STATS_ENABLE == 1)
+    OSAL_MEM_HDR *pHdr;
+    OSAL_MEM_TAG_STATS *pTag;
+
+    if (tag >= OSAL_MEM_TAG_NUM)
+    {
+        tag = OSAL_MEM_TAG_DEFAULT;
+    }
+    pTag = &osalMemTagStats[tag];
+
+    vTaskSuspendAll();
+    osalMemPendingSize = size;
+    osalMemPendingTag = tag;
+    if (size > pTag->largestRequest)
+    {
+        pTag->largestRequest = size;
+    }
+
+    pHdr = pvPortMalloc(sizeof(OSAL_MEM_HDR) + size);
+    if (pHdr != NULL)
+    {
+        pHdr->tagMagic = OSAL_MEM_MAGIC | tag;
+        pHdr->size = size;
+        pTag->allocCount++;
+        pTag->liveBytes += size;
+        APP_TRACE(APP_TRACE_EVT_HEAP_ALLOC, tag, size);
+        if (pTag->liveBytes > pTag->peakBytes)
+        {
+            pTag->peakBytes = pTag->liveBytes;
+        }
+        pHdr++;
+    }
+    else
+    {
+        pTag->failCount++;
+        APP_TRACE(APP_TRACE_EVT_HEAP_FAIL, tag, size);
+        osalMemLastFailSize = size;
+        osalMemLastFailTag = tag;
+    }
+    osalMemPendingSize = 0;
+    (void)xTaskResumeAll();
+
+    return pHdr;
+#else
+    (void)tag;
+    return pvPortMalloc(size);
+#endif
+}
+
+// *****************************************************************************
+/* Function:
+    void* OSAL_MallocBleStack(size_t size)
+
+  Summary:
+    OSAL_Malloc entry handed to the BLE stack library through osalAPIList, so
+    its blocks are accounted to OSAL_MEM_TAG_BLE_STACK.
+ */
+void* OSAL_MallocBleStack(size_t size)
+{
+    return OSAL_MallocTagged(size, OSAL_MEM_TAG_BLE_STACK);
+}
+
+// *****************************************************************************
+/* Function:
+    void OSAL_MemGetTagStats(uint8_t tag, OSAL_MEM_TAG_STATS* pStats)
+
+  Summary:
+    Get the allocation counters of one module. All zero when
+    OSAL_MEM_STATS_ENABLE is not set.
+ */
+void OSAL_MemGetTagStats(uint8_t tag, OSAL_MEM_TAG_STATS* pStats)
+{
+    memset(pStats, 0, sizeof(OSAL_MEM_TAG_STATS));
+#if (OSAL_MEM_STATS_ENABLE == 1)
+    if (tag < OSAL_MEM_TAG_NUM)
+    {
+        vTaskSuspendAll();
+        memcpy(pStats, &osalMemTagStats[tag], sizeof(OSAL_MEM_TAG_STATS));
+        (void)xTaskResumeAll();
+    }
+#endif
+}
+
+// *****************************************************************************
+/* Function:
+    void OSAL_MemGetHeapStats(OSAL_MEM_HEAP_STATS* pStats)
+
+  Summary:
+    Get a snapshot of the whole heap.
+
+  Description:
+     Combines vPortGetHeapStats with the OSAL counters. Called from the
+     malloc failed hook, lastFailSize and lastFailTag describe the request
+     that just failed.
+ */
+void OSAL_MemGetHeapStats(OSAL_MEM_HEAP_STATS* pStats)
+{
+    HeapStats_t heapStats;
+#if (OSAL_MEM_STATS_ENABLE == 1)
+    uint8_t tag;
+#endif
+
+    memset(pStats, 0, sizeof(OSAL_MEM_HEAP_STATS));
+    vPortGetHeapStats(&heapStats);
+    pStats->heapSize = configTOTAL_HEAP_SIZE;
+    pStats->freeBytes = heapStats.xAvailableHeapSpaceInBytes;
+    pStats->minEverFreeBytes = heapStats.xMinimumEverFreeBytesRemaining;
+    pStats->largestFreeBlock = heapStats.xSizeOfLargestFreeBlockInBytes;
+    pStats->smallestFreeBlock = heapStats.xSizeOfSmallestFreeBlockInBytes;
+    pStats->freeBlocks = heapStats.xNumberOfFreeBlocks;
+
+#if (OSAL_MEM_STATS_ENABLE == 1)
+    vTaskSuspendAll();
+    for (tag = 0; tag < OSAL_MEM_TAG_NUM; tag++)
+    {
+        pStats->trackedBytes += osalMemTagStats[tag].liveBytes
+            + (osalMemTagStats[tag].allocCount - osalMemTagStats[tag].freeCount) * sizeof(OSAL_MEM_HDR);
+    }
+    pStats->foreignFrees = osalMemForeignFrees;
+    if (osalMemPendingSize != 0)
+    {
+        pStats->lastFailSize = osalMemPendingSize;
+        pStats->lastFailTag = osalMemPendingTag;
+    }
+    else
+    {
+        pStats->lastFailSize = osalMemLastFailSize;
+        pStats->lastFailTag = osalMemLastFailTag;
+    }
+    (void)xTaskResumeAll();
+#endif
+}
+
+// *****************************************************************************
+/* Function:
+    void OSAL_MemResetPeaks(void)
+
+  Summary:
+    Restart the peak tracking of every module from its current live bytes.
+ */
+void OSAL_MemResetPeaks(void)
+{
+#if (OSAL_MEM_STATS_ENABLE == 1)
+    uint8_t tag;
+
+    vTaskSuspendAll();
+    for (tag = 0; tag < OSAL_MEM_TAG_NUM; tag++)
+    {
+        osalMemTagStats[tag].peakBytes = osalMemTagStats[tag].liveBytes;
+    }
+    (void)xTaskResumeAll();
+#endif
+}
+
+// *****************************************************************************
+/* Function:
+    const char* OSAL_MemTagName(uint8_t tag)
+
+  Summary:
+    Printable name of a heap accounting tag.
+ */
+const char* OSAL_MemTagName(uint8_t tag)
+{
+    return (tag < OSAL_MEM_TAG_NUM) ? osalMemTagNames[tag] : "?";
 }
 
 // *****************************************************************************
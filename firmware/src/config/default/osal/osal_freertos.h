@@ -107,6 +107,67 @@ typedef enum OSAL_RESULT
   OSAL_RESULT_TRUE = 1
 } OSAL_RESULT;
 
+// *****************************************************************************
+/* OSAL heap accounting
+
+  Summary:
+    Per module accounting of the blocks allocated with OSAL_Malloc.
+
+  Description:
+    With OSAL_MEM_STATS_ENABLE set, every block allocated through the OSAL
+    carries an 8 byte header holding its size and the tag of the module that
+    allocated it. A source file selects its tag by defining OSAL_MEM_TAG before
+    including any OSAL header. Untagged callers are accounted as
+    OSAL_MEM_TAG_DEFAULT; the BLE stack library allocates through osalAPIList
+    and is accounted as OSAL_MEM_TAG_BLE_STACK. Kernel objects (tasks, queues,
+    message buffers) come straight from pvPortMalloc and only show up in the
+    heap totals.
+
+  Remarks:
+    Memory from OSAL_Malloc must be returned with OSAL_Free, never vPortFree.
+*/
+
+#ifndef OSAL_MEM_STATS_ENABLE
+#define OSAL_MEM_STATS_ENABLE           1
+#endif
+
+typedef enum OSAL_MEM_TAG_ID
+{
+  OSAL_MEM_TAG_DEFAULT,
+  OSAL_MEM_TAG_BLE_STACK,
+  OSAL_MEM_TAG_BLE_EVT,
+  OSAL_MEM_TAG_BLE_DM,
+  OSAL_MEM_TAG_TRCBPS,
+  OSAL_MEM_TAG_PIPE,
+  OSAL_MEM_TAG_APP,
+
+  OSAL_MEM_TAG_NUM
+} OSAL_MEM_TAG_ID;
+
+typedef struct OSAL_MEM_TAG_STATS
+{
+  uint32_t liveBytes;                   /* Bytes currently allocated, headers excluded */
+  uint32_t peakBytes;                   /* Highest liveBytes since boot or the last reset */
+  uint32_t allocCount;                  /* Successful allocations */
+  uint32_t freeCount;                   /* Blocks returned */
+  uint32_t failCount;                   /* Allocations that returned NULL */
+  uint32_t largestRequest;              /* Largest single request */
+} OSAL_MEM_TAG_STATS;
+
+typedef struct OSAL_MEM_HEAP_STATS
+{
+  uint32_t heapSize;                    /* configTOTAL_HEAP_SIZE */
+  uint32_t freeBytes;                   /* Sum of all free blocks */
+  uint32_t minEverFreeBytes;            /* Low water mark of freeBytes */
+  uint32_t largestFreeBlock;            /* Largest block that can still be allocated */
+  uint32_t smallestFreeBlock;
+  uint32_t freeBlocks;                  /* Number of free blocks, i.e. fragments */
+  uint32_t trackedBytes;                /* Live bytes of all tags, headers included */
+  uint32_t foreignFrees;                /* OSAL_Free calls on blocks without an OSAL header */
+  uint32_t lastFailSize;                /* Size of the last failed request, 0 if none */
+  uint8_t  lastFailTag;                 /* Tag of the last failed request */
+} OSAL_MEM_HEAP_STATS;
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: Section: Interface Routines Group
@@ -129,6 +190,16 @@ OSAL_RESULT OSAL_MUTEX_Unlock(OSAL_MUTEX_HANDLE_TYPE* mutexID);
 
 void* OSAL_Malloc(size_t size);
 void OSAL_Free(void* pData);
+void* OSAL_MallocTagged(size_t size, uint8_t tag);
+void* OSAL_MallocBleStack(size_t size);
+void OSAL_MemGetTagStats(uint8_t tag, OSAL_MEM_TAG_STATS* pStats);
+void OSAL_MemGetHeapStats(OSAL_MEM_HEAP_STATS* pStats);
+void OSAL_MemResetPeaks(void);
+const char* OSAL_MemTagName(uint8_t tag);
+
+#if defined(OSAL_MEM_TAG) && (OSAL_MEM_STATS_ENABLE == 1)
+#define OSAL_Malloc(size)               OSAL_MallocTagged((size), (OSAL_MEM_TAG))
+#endif
 
 OSAL_RESULT OSAL_Initialize(void);
 
@@ -206,3 +206,20 @@ void CLK_Initialize( void )
     // set aclb_reset_n[24], bt_en_main_clk[20]
     BTZBSYS_REGS->BTZBSYS_SUBSYS_CNTRL_REG0 = 0x01100000U;
 }
+
+void CLK_PMD3Enable( uint32_t mask )
+{
+    uint32_t primask = __get_PRIMASK();
+
+    /* The unlock sequence must not be split by another write to the registers */
+    __disable_irq();
+    if((CFG_REGS->CFG_PMD3 & mask) != 0U)
+    {
+        CFG_REGS->CFG_SYSKEY = 0x00000000U;
+        CFG_REGS->CFG_SYSKEY = 0xAA996655U;
+        CFG_REGS->CFG_SYSKEY = 0x556699AAU;
+        CFG_REGS->CFG_PMD3 &= ~mask;
+        CFG_REGS->CFG_SYSKEY = 0x33333333U;
+    }
+    __set_PRIMASK(primask);
+}
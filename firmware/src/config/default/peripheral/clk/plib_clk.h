@@ -59,6 +59,7 @@
 
 #include <stddef.h>
 #include <stdbool.h>  
+#include <stdint.h>
 
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus // Provide C++ Compatibility
@@ -106,6 +107,38 @@
 
 void CLK_Initialize( void );
 
+// *****************************************************************************
+/* Function:
+    void CLK_PMD3Enable( uint32_t mask )
+
+  Summary:
+    Enables the peripherals that CLK_Initialize left disabled in CFG_PMD3.
+
+  Description:
+    This function clears the mask bits of CFG_PMD3 under the system unlock
+    sequence, with interrupts disabled around it. Bits already clear are left
+    alone, so calling it again does no harm.
+
+  Precondition:
+    CLK_Initialize must have been called.
+
+  Parameters:
+    mask - CFG_PMD3_xxxMD_Msk bits of the peripherals to enable.
+
+  Returns:
+    None.
+
+  Example:
+    <code>
+    CLK_PMD3Enable(CFG_PMD3_RNGMD_Msk);
+    </code>
+
+  Remarks:
+    None.
+*/
+
+void CLK_PMD3Enable( uint32_t mask );
+
 // DOM-IGNORE-BEGIN
 #ifdef __cplusplus  // Provide C++ Compatibility
 
@@ -0,0 +1,341 @@
+/*******************************************************************************
+  Direct Memory Access Controller (DMAC) PLIB
+
+  Company
+    Microchip Technology Inc.
+
+  File Name
+    plib_dmac.c
+
+  Summary
+    Source for DMAC peripheral library interface Implementation.
+
+  Description
+    This file defines the interface to the DMAC peripheral library. This
+    library provides access to and control of the DMAC controller.
+
+  Remarks:
+    None.
+*******************************************************************************/
+
+/*******************************************************************************
+* Copyright (C) 2018 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include "interrupts.h"
+#include "plib_dmac.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global Data
+// *****************************************************************************
+// *****************************************************************************
+
+#define DMAC_CHANNELS_NUMBER        4U
+
+/* DMAC channels object configuration structure */
+typedef struct
+{
+    DMAC_CHANNEL_CALLBACK   callback;
+    uintptr_t               context;
+    volatile bool           busyStatus;
+    volatile bool           complete;
+} DMAC_CH_OBJECT ;
+
+/* Write back memory section for DMAC */
+static dmac_descriptor_registers_t  write_back_section[DMAC_CHANNELS_NUMBER]    __ALIGNED(16);
+
+/* Descriptor section for DMAC */
+static dmac_descriptor_registers_t  descriptor_section[DMAC_CHANNELS_NUMBER]    __ALIGNED(16);
+
+/* DMAC Channels object information structure */
+static DMAC_CH_OBJECT dmacChannelObj[DMAC_CHANNELS_NUMBER];
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: DMAC PLib Interface Implementations
+// *****************************************************************************
+// *****************************************************************************
+
+/*******************************************************************************
+This function initializes the DMAC controller of the device.
+********************************************************************************/
+
+void DMAC_Initialize( void )
+{
+    uint32_t channel;
+
+    /* Initialize DMAC Channel objects */
+    for(channel = 0U; channel < DMAC_CHANNELS_NUMBER; channel++)
+    {
+        dmacChannelObj[channel].callback = NULL;
+        dmacChannelObj[channel].context = 0U;
+        dmacChannelObj[channel].busyStatus = false;
+        dmacChannelObj[channel].complete = false;
+    }
+
+    /* Update the Base address and Write Back address register */
+    DMAC_REGS->DMAC_BASEADDR = (uint32_t) descriptor_section;
+    DMAC_REGS->DMAC_WRBADDR  = (uint32_t) write_back_section;
+
+    /***************** Configure DMA channel 0 (SERCOM1 RX) ********************/
+
+    DMAC_REGS->CHANNEL[0].DMAC_CHCTRLA = DMAC_CHCTRLA_TRIGACT_BURST | DMAC_CHCTRLA_TRIGSRC(SERCOM1_DMAC_ID_RX) | DMAC_CHCTRLA_THRESHOLD_1BEAT | DMAC_CHCTRLA_BURSTLEN_SINGLE;
+    DMAC_REGS->CHANNEL[0].DMAC_CHPRILVL = DMAC_CHPRILVL_PRILVL(1);
+
+    descriptor_section[0].DMAC_BTCTRL = DMAC_BTCTRL_BLOCKACT_NOACT | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_VALID_Msk | DMAC_BTCTRL_DSTINC_Msk;
+    descriptor_section[0].DMAC_DESCADDR = 0U;
+
+    /***************** Configure DMA channel 1 (SERCOM1 TX) ********************/
+
+    DMAC_REGS->CHANNEL[1].DMAC_CHCTRLA = DMAC_CHCTRLA_TRIGACT_BURST | DMAC_CHCTRLA_TRIGSRC(SERCOM1_DMAC_ID_TX) | DMAC_CHCTRLA_THRESHOLD_1BEAT | DMAC_CHCTRLA_BURSTLEN_SINGLE;
+    DMAC_REGS->CHANNEL[1].DMAC_CHPRILVL = DMAC_CHPRILVL_PRILVL(1);
+
+    descriptor_section[1].DMAC_BTCTRL = DMAC_BTCTRL_BLOCKACT_NOACT | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_VALID_Msk | DMAC_BTCTRL_SRCINC_Msk;
+    descriptor_section[1].DMAC_DESCADDR = 0U;
+
+    /***************** Configure DMA channel 2 (memory to memory) ********************/
+
+    DMAC_REGS->CHANNEL[2].DMAC_CHCTRLA = DMAC_CHCTRLA_TRIGACT_BLOCK | DMAC_CHCTRLA_TRIGSRC(0) | DMAC_CHCTRLA_THRESHOLD_1BEAT | DMAC_CHCTRLA_BURSTLEN_4BEAT;
+    DMAC_REGS->CHANNEL[2].DMAC_CHPRILVL = DMAC_CHPRILVL_PRILVL(0);
+
+    descriptor_section[2].DMAC_BTCTRL = DMAC_BTCTRL_BLOCKACT_INT | DMAC_BTCTRL_BEATSIZE_WORD | DMAC_BTCTRL_VALID_Msk | DMAC_BTCTRL_SRCINC_Msk | DMAC_BTCTRL_DSTINC_Msk;
+    descriptor_section[2].DMAC_DESCADDR = 0U;
+
+    /***************** Configure DMA channel 3 (SERCOM0 TX) ********************/
+
+    DMAC_REGS->CHANNEL[3].DMAC_CHCTRLA = DMAC_CHCTRLA_TRIGACT_BURST | DMAC_CHCTRLA_TRIGSRC(SERCOM0_DMAC_ID_TX) | DMAC_CHCTRLA_THRESHOLD_1BEAT | DMAC_CHCTRLA_BURSTLEN_SINGLE;
+    DMAC_REGS->CHANNEL[3].DMAC_CHPRILVL = DMAC_CHPRILVL_PRILVL(0);
+
+    descriptor_section[3].DMAC_BTCTRL = DMAC_BTCTRL_BLOCKACT_INT | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_VALID_Msk | DMAC_BTCTRL_SRCINC_Msk;
+    descriptor_section[3].DMAC_DESCADDR = 0U;
+
+    /* Enable the DMAC module & Priority Level x Enable */
+    DMAC_REGS->DMAC_CTRL = (uint16_t)(DMAC_CTRL_DMAENABLE_Msk | DMAC_CTRL_LVLEN0_Msk | DMAC_CTRL_LVLEN1_Msk | DMAC_CTRL_LVLEN2_Msk | DMAC_CTRL_LVLEN3_Msk);
+}
+
+/*******************************************************************************
+    This function schedules a DMA transfer on the specified DMA channel.
+********************************************************************************/
+
+bool DMAC_ChannelTransfer( DMAC_CHANNEL channel, const void *srcAddr, const void *destAddr, size_t blockSize )
+{
+    uint8_t beat_size;
+    bool returnStatus = false;
+    dmac_descriptor_registers_t *const dmacDescReg = &descriptor_section[channel];
+
+    if (dmacChannelObj[channel].busyStatus == false)
+    {
+        dmacChannelObj[channel].busyStatus = true;
+        dmacChannelObj[channel].complete = false;
+
+        /* An incrementing address is the address of the last beat plus one */
+        if ((dmacDescReg->DMAC_BTCTRL & DMAC_BTCTRL_SRCINC_Msk) == DMAC_BTCTRL_SRCINC_Msk)
+        {
+            dmacDescReg->DMAC_SRCADDR = (uint32_t)srcAddr + blockSize;
+        }
+        else
+        {
+            dmacDescReg->DMAC_SRCADDR = (uint32_t)srcAddr;
+        }
+
+        if ((dmacDescReg->DMAC_BTCTRL & DMAC_BTCTRL_DSTINC_Msk) == DMAC_BTCTRL_DSTINC_Msk)
+        {
+            dmacDescReg->DMAC_DSTADDR = (uint32_t)destAddr + blockSize;
+        }
+        else
+        {
+            dmacDescReg->DMAC_DSTADDR = (uint32_t)destAddr;
+        }
+
+        /* Calculate the beat size and then set the BTCNT value */
+        beat_size = (uint8_t)((dmacDescReg->DMAC_BTCTRL & DMAC_BTCTRL_BEATSIZE_Msk) >> DMAC_BTCTRL_BEATSIZE_Pos);
+        dmacDescReg->DMAC_BTCNT = (uint16_t)(blockSize / (1UL << beat_size));
+
+        /* The write back descriptor is only updated once the channel has
+         * been active; start it at the full count so a transfer that never
+         * got a trigger reads back as 0 bytes transferred. */
+        write_back_section[channel].DMAC_BTCNT = dmacDescReg->DMAC_BTCNT;
+
+        DMAC_REGS->CHANNEL[channel].DMAC_CHINTFLAG = (uint8_t)(DMAC_CHINTFLAG_TCMPL_Msk | DMAC_CHINTFLAG_TERR_Msk | DMAC_CHINTFLAG_SUSP_Msk);
+
+        /* Enable the channel */
+        DMAC_REGS->CHANNEL[channel].DMAC_CHCTRLA |= DMAC_CHCTRLA_ENABLE_Msk;
+
+        /* Verify if Trigger source is Software Trigger */
+        if ((DMAC_REGS->CHANNEL[channel].DMAC_CHCTRLA & DMAC_CHCTRLA_TRIGSRC_Msk) == 0U)
+        {
+            /* Trigger the DMA transfer */
+            DMAC_REGS->DMAC_SWTRIGCTRL |= (1UL << (uint32_t)channel);
+        }
+
+        returnStatus = true;
+    }
+
+    return returnStatus;
+}
+
+/*******************************************************************************
+    This function disables the specified DMAC channel.
+********************************************************************************/
+
+void DMAC_ChannelDisable( DMAC_CHANNEL channel )
+{
+    /* Disable the DMA channel */
+    DMAC_REGS->CHANNEL[channel].DMAC_CHCTRLA &= (~DMAC_CHCTRLA_ENABLE_Msk);
+
+    while((DMAC_REGS->CHANNEL[channel].DMAC_CHCTRLA & DMAC_CHCTRLA_ENABLE_Msk) != 0U)
+    {
+        /* Wait till the channel is disabled */
+    }
+
+    dmacChannelObj[channel].busyStatus = false;
+}
+
+/*******************************************************************************
+    This function returns the status of the channel. A channel without
+    interrupts only reads as idle once it is disabled.
+********************************************************************************/
+
+bool DMAC_ChannelIsBusy( DMAC_CHANNEL channel )
+{
+    return (bool)dmacChannelObj[channel].busyStatus;
+}
+
+/*******************************************************************************
+    This function returns the number of beats transferred since the last
+    DMAC_ChannelTransfer. Valid once the channel is disabled or complete.
+********************************************************************************/
+
+uint16_t DMAC_ChannelGetTransferredCount( DMAC_CHANNEL channel )
+{
+    uint16_t transferredCount = descriptor_section[channel].DMAC_BTCNT;
+
+    /* TCMPL is only cleared by the interrupt handler of channels with a callback */
+    if ((dmacChannelObj[channel].complete == false) && ((DMAC_REGS->CHANNEL[channel].DMAC_CHINTFLAG & DMAC_CHINTFLAG_TCMPL_Msk) == 0U))
+    {
+        transferredCount -= write_back_section[channel].DMAC_BTCNT;
+    }
+
+    return transferredCount;
+}
+
+/*******************************************************************************
+    This function returns the current channel settings.
+********************************************************************************/
+
+DMAC_CHANNEL_CONFIG DMAC_ChannelSettingsGet( DMAC_CHANNEL channel )
+{
+    return (DMAC_CHANNEL_CONFIG)descriptor_section[channel].DMAC_BTCTRL;
+}
+
+/*******************************************************************************
+    This function changes the channel settings. It fails while the channel is
+    busy.
+********************************************************************************/
+
+bool DMAC_ChannelSettingsSet( DMAC_CHANNEL channel, DMAC_CHANNEL_CONFIG setting )
+{
+    if (dmacChannelObj[channel].busyStatus == true)
+    {
+        return false;
+    }
+
+    /* The descriptor must stay valid */
+    descriptor_section[channel].DMAC_BTCTRL = (uint16_t)(setting | DMAC_BTCTRL_VALID_Msk);
+
+    return true;
+}
+
+/*******************************************************************************
+    This function function allows a DMAC PLIB client to set an event handler.
+********************************************************************************/
+
+void DMAC_ChannelCallbackRegister( DMAC_CHANNEL channel, const DMAC_CHANNEL_CALLBACK callback, const uintptr_t context )
+{
+    dmacChannelObj[channel].callback = callback;
+    dmacChannelObj[channel].context  = context;
+
+    if (callback != NULL)
+    {
+        DMAC_REGS->CHANNEL[channel].DMAC_CHINTENSET = (uint8_t)(DMAC_CHINTENSET_TERR_Msk | DMAC_CHINTENSET_TCMPL_Msk);
+    }
+    else
+    {
+        DMAC_REGS->CHANNEL[channel].DMAC_CHINTENCLR = (uint8_t)(DMAC_CHINTENCLR_TERR_Msk | DMAC_CHINTENCLR_TCMPL_Msk);
+    }
+}
+
+/*******************************************************************************
+    This function handles the DMA interrupt events of channels 0 to 3.
+*/
+void DMAC_0_3_InterruptHandler( void )
+{
+    DMAC_CH_OBJECT  *dmacChObj;
+    uint8_t channel;
+    uint8_t flags;
+    DMAC_TRANSFER_EVENT event = DMAC_TRANSFER_EVENT_NONE;
+
+    /* Get active channel number */
+    channel = (uint8_t)((uint32_t)DMAC_REGS->DMAC_INTPEND & DMAC_INTPEND_ID_Msk);
+    flags = DMAC_REGS->CHANNEL[channel].DMAC_CHINTFLAG & DMAC_REGS->CHANNEL[channel].DMAC_CHINTENSET;
+
+    if (channel >= DMAC_CHANNELS_NUMBER)
+    {
+        DMAC_REGS->CHANNEL[channel].DMAC_CHINTFLAG = flags;
+        return;
+    }
+
+    dmacChObj = &dmacChannelObj[channel];
+
+    /* Check channel transfer error interrupt */
+    if ((flags & DMAC_CHINTFLAG_TERR_Msk) != 0U)
+    {
+        DMAC_REGS->CHANNEL[channel].DMAC_CHINTFLAG = (uint8_t)DMAC_CHINTFLAG_TERR_Msk;
+        event = DMAC_TRANSFER_EVENT_ERROR;
+        dmacChObj->busyStatus = false;
+    }
+    /* Check channel transfer complete interrupt */
+    else if ((flags & DMAC_CHINTFLAG_TCMPL_Msk) != 0U)
+    {
+        DMAC_REGS->CHANNEL[channel].DMAC_CHINTFLAG = (uint8_t)DMAC_CHINTFLAG_TCMPL_Msk;
+        event = DMAC_TRANSFER_EVENT_COMPLETE;
+        dmacChObj->complete = true;
+        dmacChObj->busyStatus = false;
+    }
+    else
+    {
+        /* Nothing to report */
+    }
+
+    /* Execute the callback function */
+    if ((dmacChObj->callback != NULL) && (event != DMAC_TRANSFER_EVENT_NONE))
+    {
+        dmacChObj->callback(event, dmacChObj->context);
+    }
+}
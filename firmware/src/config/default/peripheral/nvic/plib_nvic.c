@@ -39,6 +39,7 @@
 *******************************************************************************/
 
 #include "device.h"
+#include "configuration.h"
 #include "plib_nvic.h"
 
 
@@ -64,6 +65,12 @@ void NVIC_Initialize( void )
     NVIC_EnableIRQ(FLASH_CONTROL_IRQn);
     NVIC_SetPriority(SERCOM0_IRQn, 7);
     NVIC_EnableIRQ(SERCOM0_IRQn);
+    NVIC_SetPriority(DMAC_0_3_IRQn, 6);
+    NVIC_EnableIRQ(DMAC_0_3_IRQn);
+#if APP_SPI_HOST_ENABLE
+    NVIC_SetPriority(SERCOM1_IRQn, 6);
+    NVIC_EnableIRQ(SERCOM1_IRQn);
+#endif
 
     /* Enable Usage fault */
     SCB->SHCSR |= (SCB_SHCSR_USGFAULTENA_Msk);
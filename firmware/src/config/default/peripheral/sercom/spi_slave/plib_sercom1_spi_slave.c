@@ -0,0 +1,226 @@
+/*******************************************************************************
+  SERCOM Serial Peripheral Interface (SPI) Slave PLIB
+
+  Company
+    Microchip Technology Inc.
+
+  File Name
+    plib_sercom1_spi_slave.c
+
+  Summary
+    SERCOM1 SPI slave PLIB Implementation File.
+
+  Description
+    This file defines the interface to the SERCOM1 SPI slave peripheral
+    library.
+
+  Remarks:
+    With PLOADEN the first bytes of the armed TX buffer are already in the
+    SERCOM when slave select goes low. Whatever the host did not clock out is
+    dropped by resetting the SERCOM at the end of every transfer, so the host
+    must leave slave select high long enough for the interrupt to re-arm.
+*******************************************************************************/
+
+/*******************************************************************************
+* Copyright (C) 2018 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include "interrupts.h"
+#include "peripheral/dmac/plib_dmac.h"
+#include "plib_sercom1_spi_slave.h"
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Global Data
+// *****************************************************************************
+// *****************************************************************************
+
+#define SERCOM1_SPI_RX_DMAC_CHANNEL     DMAC_CHANNEL_0
+#define SERCOM1_SPI_TX_DMAC_CHANNEL     DMAC_CHANNEL_1
+
+static SPI_SLAVE_OBJECT sercom1SPISObj;
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: SERCOM1 SPI Slave Implementation
+// *****************************************************************************
+// *****************************************************************************
+
+static void SERCOM1_SPI_Configure( void )
+{
+    /*
+     * Configures SPI slave mode
+     * Configures DOPO and DIPO
+     * Configures clock polarity and phase (mode 0)
+     * Configures data order (MSB first)
+     */
+    SERCOM1_REGS->SPIS.SERCOM_CTRLA = SERCOM_SPIS_CTRLA_MODE_SPI_SLAVE | SERCOM_SPIS_CTRLA_DOPO(0x0UL) | SERCOM_SPIS_CTRLA_DIPO(0x3UL) | SERCOM_SPIS_CTRLA_CPOL_IDLE_LOW | SERCOM_SPIS_CTRLA_CPHA_LEADING_EDGE | SERCOM_SPIS_CTRLA_DORD_MSB | SERCOM_SPIS_CTRLA_IBON_Msk;
+
+    /*
+     * Configures RXEN
+     * Configures slave data preload
+     * Configures slave select low detection
+     * Configures CHSIZE
+     */
+    SERCOM1_REGS->SPIS.SERCOM_CTRLB = SERCOM_SPIS_CTRLB_RXEN_Msk | SERCOM_SPIS_CTRLB_PLOADEN_Msk | SERCOM_SPIS_CTRLB_SSDE_Msk | SERCOM_SPIS_CTRLB_CHSIZE_8_BIT;
+
+    /* Wait for sync */
+    while((SERCOM1_REGS->SPIS.SERCOM_SYNCBUSY) != 0U)
+    {
+        /* Do nothing */
+    }
+
+    /* Slave select low and high (TXC in slave mode) frame the transfers */
+    SERCOM1_REGS->SPIS.SERCOM_INTENSET = (uint8_t)(SERCOM_SPIS_INTENSET_SSL_Msk | SERCOM_SPIS_INTENSET_TXC_Msk);
+
+    /* Enable SERCOM1 SPI slave */
+    SERCOM1_REGS->SPIS.SERCOM_CTRLA |= SERCOM_SPIS_CTRLA_ENABLE_Msk;
+
+    /* Wait for sync */
+    while((SERCOM1_REGS->SPIS.SERCOM_SYNCBUSY) != 0U)
+    {
+        /* Do nothing */
+    }
+}
+
+static void SERCOM1_SPI_Reset( void )
+{
+    /* Drops the preloaded TX data and any unread RX data */
+    SERCOM1_REGS->SPIS.SERCOM_CTRLA = SERCOM_SPIS_CTRLA_SWRST_Msk;
+
+    while((SERCOM1_REGS->SPIS.SERCOM_SYNCBUSY & SERCOM_SPIS_SYNCBUSY_SWRST_Msk) != 0U)
+    {
+        /* Do nothing */
+    }
+
+    SERCOM1_SPI_Configure();
+}
+
+void SERCOM1_SPI_Initialize( void )
+{
+    /* Initialize instance object */
+    sercom1SPISObj.transferIsBusy = false;
+    sercom1SPISObj.transferArmed = false;
+    sercom1SPISObj.rxCount = 0U;
+    sercom1SPISObj.errorStatus = SPI_SLAVE_ERROR_NONE;
+    sercom1SPISObj.callback = NULL;
+    sercom1SPISObj.context = 0U;
+
+    SERCOM1_SPI_Reset();
+}
+
+void SERCOM1_SPI_CallbackRegister( SERCOM_SPI_SLAVE_CALLBACK callBack, uintptr_t context )
+{
+    sercom1SPISObj.callback = callBack;
+
+    sercom1SPISObj.context = context;
+}
+
+bool SERCOM1_SPI_WriteRead( void* pTransmitData, size_t txSize, void* pReceiveData, size_t rxSize )
+{
+    bool isRequestAccepted = false;
+
+    if ((sercom1SPISObj.transferIsBusy == false) && (sercom1SPISObj.transferArmed == false))
+    {
+        sercom1SPISObj.transferArmed = true;
+
+        if (rxSize > 0U)
+        {
+            (void)DMAC_ChannelTransfer(SERCOM1_SPI_RX_DMAC_CHANNEL, (const void *)&SERCOM1_REGS->SPIS.SERCOM_DATA, pReceiveData, rxSize);
+        }
+
+        /* DRE is set while slave select is high, so this preloads the first bytes */
+        if (txSize > 0U)
+        {
+            (void)DMAC_ChannelTransfer(SERCOM1_SPI_TX_DMAC_CHANNEL, pTransmitData, (const void *)&SERCOM1_REGS->SPIS.SERCOM_DATA, txSize);
+        }
+
+        isRequestAccepted = true;
+    }
+
+    return isRequestAccepted;
+}
+
+size_t SERCOM1_SPI_ReadCountGet( void )
+{
+    return sercom1SPISObj.rxCount;
+}
+
+SPI_SLAVE_ERROR SERCOM1_SPI_ErrorGet( void )
+{
+    SPI_SLAVE_ERROR errorStatus = sercom1SPISObj.errorStatus;
+
+    sercom1SPISObj.errorStatus = SPI_SLAVE_ERROR_NONE;
+
+    return errorStatus;
+}
+
+bool SERCOM1_SPI_IsBusy( void )
+{
+    return sercom1SPISObj.transferIsBusy;
+}
+
+void SERCOM1_SPI_InterruptHandler( void )
+{
+    uint8_t intFlag = (uint8_t)(SERCOM1_REGS->SPIS.SERCOM_INTFLAG & SERCOM1_REGS->SPIS.SERCOM_INTENSET);
+
+    if ((intFlag & SERCOM_SPIS_INTFLAG_SSL_Msk) != 0U)
+    {
+        SERCOM1_REGS->SPIS.SERCOM_INTFLAG = (uint8_t)SERCOM_SPIS_INTFLAG_SSL_Msk;
+
+        sercom1SPISObj.transferIsBusy = true;
+    }
+
+    /* Slave select deasserted */
+    if ((intFlag & SERCOM_SPIS_INTFLAG_TXC_Msk) != 0U)
+    {
+        SERCOM1_REGS->SPIS.SERCOM_INTFLAG = (uint8_t)SERCOM_SPIS_INTFLAG_TXC_Msk;
+
+        sercom1SPISObj.rxCount = 0U;
+
+        if (sercom1SPISObj.transferArmed == true)
+        {
+            DMAC_ChannelDisable(SERCOM1_SPI_RX_DMAC_CHANNEL);
+            DMAC_ChannelDisable(SERCOM1_SPI_TX_DMAC_CHANNEL);
+
+            sercom1SPISObj.rxCount = DMAC_ChannelGetTransferredCount(SERCOM1_SPI_RX_DMAC_CHANNEL);
+        }
+
+        sercom1SPISObj.errorStatus |= (SPI_SLAVE_ERROR)(SERCOM1_REGS->SPIS.SERCOM_STATUS & SERCOM_SPIS_STATUS_BUFOVF_Msk);
+
+        SERCOM1_SPI_Reset();
+
+        sercom1SPISObj.transferArmed = false;
+        sercom1SPISObj.transferIsBusy = false;
+
+        if (sercom1SPISObj.callback != NULL)
+        {
+            sercom1SPISObj.callback(sercom1SPISObj.context);
+        }
+    }
+}
@@ -0,0 +1,98 @@
+/*******************************************************************************
+  SERCOM Serial Peripheral Interface (SPI) Slave PLIB
+
+  Company
+    Microchip Technology Inc.
+
+  File Name
+    plib_sercom1_spi_slave.h
+
+  Summary
+    SERCOM1 SPI slave peripheral library interface.
+
+  Description
+    This file defines the interface to the SERCOM1 SPI slave peripheral
+    library. Data moves between the SERCOM and the caller's buffers on DMAC
+    channels 0 (RX) and 1 (TX); a transfer ends when the host deasserts slave
+    select.
+
+  Remarks:
+    Pads: DO on PAD0, SCK on PAD1, SS on PAD2, DI on PAD3. The SERCOM1 pins
+    are routed through PPS, which is board specific and left to GPIO setup.
+*******************************************************************************/
+
+/*******************************************************************************
+* Copyright (C) 2018 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+
+#ifndef PLIB_SERCOM1_SPI_SLAVE_H // Guards against multiple inclusion
+#define PLIB_SERCOM1_SPI_SLAVE_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include "plib_sercom_spi_slave_common.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus // Provide C++ Compatibility
+
+    extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Routines
+// *****************************************************************************
+// *****************************************************************************
+
+void SERCOM1_SPI_Initialize( void );
+
+/* Arm the buffers of the next transfer. Fails while a transfer is armed or in
+ * progress. Bytes clocked beyond txSize repeat the last byte; bytes beyond
+ * rxSize are lost and reported as SPI_SLAVE_ERROR_BUFOVF. */
+bool SERCOM1_SPI_WriteRead( void* pTransmitData, size_t txSize, void* pReceiveData, size_t rxSize );
+
+/* Bytes exchanged in the last finished transfer */
+size_t SERCOM1_SPI_ReadCountGet( void );
+
+SPI_SLAVE_ERROR SERCOM1_SPI_ErrorGet( void );
+
+bool SERCOM1_SPI_IsBusy( void );
+
+void SERCOM1_SPI_CallbackRegister( SERCOM_SPI_SLAVE_CALLBACK callBack, uintptr_t context );
+
+void SERCOM1_SPI_InterruptHandler( void );
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus // Provide C++ Compatibility
+
+    }
+
+#endif
+// DOM-IGNORE-END
+
+#endif // PLIB_SERCOM1_SPI_SLAVE_H
@@ -0,0 +1,157 @@
+/*******************************************************************************
+  SERCOM SPI Slave PLIB
+
+  Company
+    Microchip Technology Inc.
+
+  File Name
+    plib_sercom_spi_slave_common.h
+
+  Summary
+    Data Type definition of the SPI slave Peripheral Interface Plib.
+
+  Description
+    This file defines the Data Types for the SPI slave Plib.
+
+  Remarks:
+    None.
+*******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2018 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+#ifndef PLIB_SERCOM_SPI_SLAVE_COMMON_H // Guards against multiple inclusion
+#define PLIB_SERCOM_SPI_SLAVE_COMMON_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "device.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus // Provide C++ Compatibility
+
+    extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section:Preprocessor macros
+// *****************************************************************************
+// *****************************************************************************
+
+    /* Error status when no error has occurred */
+#define SPI_SLAVE_ERROR_NONE 0U
+
+    /* Error status when the host clocked more bytes than were armed for reception */
+#define SPI_SLAVE_ERROR_BUFOVF SERCOM_SPIS_STATUS_BUFOVF_Msk
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// *****************************************************************************
+/* SPI Slave Errors
+
+  Summary:
+    Defines the data type for the SPI slave peripheral errors.
+
+  Description:
+    This may be used to check the type of error that occurred during the last
+    transfer.
+
+  Remarks:
+    None.
+*/
+
+typedef uint16_t SPI_SLAVE_ERROR;
+
+// *****************************************************************************
+/* SPI Slave Callback Function Pointer
+
+  Summary:
+    Defines the data type and function signature for the SPI slave peripheral
+    callback function.
+
+  Description:
+    The callback is called from the interrupt context when the host deasserts
+    slave select. The buffers of the finished transfer are free again and the
+    next transfer may be armed from within the callback.
+
+  Remarks:
+    None.
+*/
+
+typedef void (*SERCOM_SPI_SLAVE_CALLBACK) ( uintptr_t context );
+
+// *****************************************************************************
+/* SPI Slave Object
+
+  Summary:
+    Defines the data type for the data structures used for peripheral
+    operations.
+
+  Description:
+    This may be used for peripheral operations.
+
+  Remarks:
+    None.
+*/
+
+typedef struct
+{
+    volatile bool                   transferIsBusy;
+
+    volatile bool                   transferArmed;
+
+    volatile size_t                 rxCount;
+
+    volatile SPI_SLAVE_ERROR        errorStatus;
+
+    SERCOM_SPI_SLAVE_CALLBACK       callback;
+
+    uintptr_t                       context;
+
+} SPI_SLAVE_OBJECT;
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus // Provide C++ Compatibility
+
+    }
+
+#endif
+// DOM-IGNORE-END
+
+#endif // PLIB_SERCOM_SPI_SLAVE_COMMON_H
@@ -0,0 +1,88 @@
+/*******************************************************************************
+  Cache System Service Library Interface Header File
+
+  File Name:
+    sys_cache.h
+
+  Summary:
+    Cache system service library interface.
+
+  Description:
+    This file defines the interface to the Cache system service library.
+    The WBZ451 has no L1 data cache (device_cache.h), so every maintenance
+    operation resolves to the empty DCACHE_* macros. It is included by the
+    ICM SHA port of wolfCrypt (crypt_sha256_sam11105.c).
+
+*******************************************************************************/
+
+// DOM-IGNORE-BEGIN
+/*******************************************************************************
+* Copyright (C) 2019 Microchip Technology Inc. and its subsidiaries.
+*
+* Subject to your compliance with these terms, you may use Microchip software
+* and any derivatives exclusively with Microchip products. It is your
+* responsibility to comply with third party license terms applicable to your
+* use of third party software (including open source software) that may
+* accompany Microchip software.
+*
+* THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+* EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY IMPLIED
+* WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS FOR A
+* PARTICULAR PURPOSE.
+*
+* IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+* INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+* WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP HAS
+* BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO THE
+* FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL CLAIMS IN
+* ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT OF FEES, IF ANY,
+* THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS SOFTWARE.
+*******************************************************************************/
+// DOM-IGNORE-END
+
+#ifndef SYS_CACHE_H
+#define SYS_CACHE_H
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Included Files
+// *****************************************************************************
+// *****************************************************************************
+
+#include "device.h"
+
+// DOM-IGNORE-BEGIN
+#ifdef __cplusplus  // Provide C++ Compatibility
+
+extern "C" {
+
+#endif
+// DOM-IGNORE-END
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: System Cache Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+#define SYS_CACHE_EnableCaches()                                ICACHE_ENABLE(); DCACHE_ENABLE()
+#define SYS_CACHE_DisableCaches()                               DCACHE_DISABLE(); ICACHE_DISABLE()
+#define SYS_CACHE_EnableICache()                                ICACHE_ENABLE()
+#define SYS_CACHE_DisableICache()                               ICACHE_DISABLE()
+#define SYS_CACHE_InvalidateICache()                            ICACHE_INVALIDATE()
+#define SYS_CACHE_EnableDCache()                                DCACHE_ENABLE()
+#define SYS_CACHE_DisableDCache()                               DCACHE_DISABLE()
+#define SYS_CACHE_InvalidateDCache()                            DCACHE_INVALIDATE()
+#define SYS_CACHE_CleanDCache()                                 DCACHE_CLEAN()
+#define SYS_CACHE_CleanInvalidateDCache()                       DCACHE_CLEAN_INVALIDATE()
+#define SYS_CACHE_InvalidateDCache_by_Addr(addr, size)          DCACHE_INVALIDATE_BY_ADDR(addr, size)
+#define SYS_CACHE_CleanDCache_by_Addr(addr, size)               DCACHE_CLEAN_BY_ADDR(addr, size)
+#define SYS_CACHE_CleanInvalidateDCache_by_Addr(addr, size)     DCACHE_CLEAN_INVALIDATE_BY_ADDR(addr, size)
+
+//DOM-IGNORE-BEGIN
+#ifdef __cplusplus
+}
+#endif
+//DOM-IGNORE-END
+
+#endif // SYS_CACHE_H
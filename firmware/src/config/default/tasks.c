@@ -52,6 +52,7 @@
 
 #include "configuration.h"
 #include "definitions.h"
+#include "app_static.h"
 
 
 // *****************************************************************************
@@ -99,14 +100,14 @@ void SYS_Tasks ( void )
 
     /* Maintain Middleware & Other Libraries */
     
-    if (xTaskCreate(BM_Task,     "BLE", TASK_BLE_STACK_SIZE, NULL  , TASK_BLE_PRIORITY, NULL) != pdPASS)
+    if (APP_STATIC_TASK_CREATE(BM_Task,     "BLE", TASK_BLE_STACK_SIZE, NULL  , TASK_BLE_PRIORITY, NULL) != pdPASS)
         while (1);
 
 
 
     /* Maintain the application's state machine. */
         /* Create OS Thread for APP_Tasks. */
-    xTaskCreate((TaskFunction_t) _APP_Tasks,
+    APP_STATIC_TASK_CREATE((TaskFunction_t) _APP_Tasks,
                 "APP_Tasks",
                 1024,
                 NULL,
@@ -27,6 +27,7 @@
 #include <stdlib.h>                     // Defines EXIT_FAILURE
 #include "definitions.h"                // SYS function prototypes
 #include "blecb_pipe.h"
+#include "app_dfu.h"
 
 // *****************************************************************************
 // *****************************************************************************
@@ -36,6 +37,11 @@
 
 int main ( void )
 {
+#if APP_DFU_ENABLE
+    /* Restart in the other flash panel if it holds a newer image */
+    APP_DfuBootSelect();
+#endif
+
     /* Initialize all modules */
     SYS_Initialize ( NULL );
 
@@ -0,0 +1,361 @@
+#!/usr/bin/env python3
+"""Open an encrypted pipe session as the peer (app_aead.c), and talk in it.
+
+The firmware must be built with APP_AEAD_ENABLE=1 and APP_AEAD_KEY; give
+the same 16 bytes with --key or --key-file. Over an LE credit based channel
+on Linux (BlueZ), with the address of the board and the PSM read from its
+Transparent Credit Based service:
+
+    aead_peer.py --key-file aead.key --addr 00:04:25:1A:2B:3C --psm 0x0081
+
+The peer sends a hello with a random of its own, the board answers with
+another, and both take AES-128(key, peer random | board random) as the
+session key. The peer then sends an empty sealed message to show it holds
+the key: the board takes firmware updates and data log requests only after
+one of the peer's messages has opened. Each line of stdin is then sent
+sealed, and each message of the board is printed opened; its firmware
+update and data log responses are sealed too. Messages the board sends in
+clear (the session response) are shown in hex on stderr.
+
+dfu_send.py and log_offload.py open a session with open_session() from here
+when given --aead-key or --aead-key-file.
+
+AES is written out here so the tools need nothing beyond the standard
+library. It is slow, but only the handshake and the sealed messages go
+through it. --self-test checks it against FIPS-197 and CCM against RFC 3610
+packet vector #1.
+"""
+
+import argparse
+import ctypes
+import hmac
+import os
+import select
+import socket
+import struct
+import sys
+
+MAGIC = b"\x7eAEK"
+OP_HELLO = b"H"
+OP_RESPONSE = ord("R")
+RANDOM_LEN = 8
+RSP_LEN = 14
+KEY_LEN = 16
+TAG_LEN = 8
+DIR_BOARD = 0
+DIR_PEER = 1
+CLEAR_MAGICS = (MAGIC,)
+
+STATUS = {
+    0: "ok",
+    1: "no shared key on the board",
+    2: "a session is already up",
+    3: "bad size",
+}
+
+SOL_BLUETOOTH = 274
+BT_SNDMTU = 12
+BDADDR_LE_PUBLIC = 1
+BDADDR_LE_RANDOM = 2
+
+
+def _xtime(a):
+    return ((a << 1) ^ 0x1B) & 0xFF if a & 0x80 else a << 1
+
+
+def _make_sbox():
+    box = [0x63] * 256
+    p = q = 1
+    while True:
+        # p runs through the field by multiplying by 3, q by dividing by 3,
+        # so q is the inverse of p
+        p ^= _xtime(p)
+        q ^= q << 1
+        q ^= q << 2
+        q ^= q << 4
+        q &= 0xFF
+        if q & 0x80:
+            q ^= 0x09
+        x = q
+        for r in range(1, 5):
+            x ^= ((q << r) | (q >> (8 - r))) & 0xFF
+        box[p] = x ^ 0x63
+        if p == 1:
+            return box
+
+
+SBOX = _make_sbox()
+
+
+class Aes128:
+    """AES-128, encryption only: CCM needs no more."""
+
+    def __init__(self, key):
+        w = list(key)
+        rcon = 1
+        for i in range(16, 176, 4):
+            t = w[i - 4:i]
+            if i % 16 == 0:
+                t = [SBOX[t[1]] ^ rcon, SBOX[t[2]], SBOX[t[3]], SBOX[t[0]]]
+                rcon = _xtime(rcon)
+            w += [w[i - 16 + j] ^ t[j] for j in range(4)]
+        self.rk = [w[r * 16:r * 16 + 16] for r in range(11)]
+
+    def encrypt(self, block):
+        s = [b ^ k for b, k in zip(block, self.rk[0])]
+        for r in range(1, 11):
+            # SubBytes and ShiftRows; byte i is row i % 4 of column i // 4
+            s = [SBOX[s[((i // 4 + i % 4) % 4) * 4 + i % 4]] for i in range(16)]
+            if r != 10:
+                m = []
+                for c in range(0, 16, 4):
+                    a0, a1, a2, a3 = s[c:c + 4]
+                    t = a0 ^ a1 ^ a2 ^ a3
+                    m += [a0 ^ t ^ _xtime(a0 ^ a1), a1 ^ t ^ _xtime(a1 ^ a2),
+                          a2 ^ t ^ _xtime(a2 ^ a3), a3 ^ t ^ _xtime(a3 ^ a0)]
+                s = m
+            s = [b ^ k for b, k in zip(s, self.rk[r])]
+        return bytes(s)
+
+
+def _xor(a, b):
+    return bytes(x ^ y for x, y in zip(a, b))
+
+
+def ccm(aes, nonce, data, tag_len, opening, aad=b""):
+    """CCM as the board runs it: a 13 byte nonce and a 2 byte length field.
+    Encrypt data, or decrypt it when opening; return it with the tag the
+    message carries (to compare with the received one when opening)."""
+    flags = 0x01 | (8 * ((tag_len - 2) // 2)) | (0x40 if aad else 0)
+    mac = aes.encrypt(bytes([flags]) + nonce + struct.pack(">H", len(data)))
+    header = struct.pack(">H", len(aad)) + aad if aad else b""
+    header += b"\0" * (-len(header) % 16)
+    for off in range(0, len(header), 16):
+        mac = aes.encrypt(_xor(mac, header[off:off + 16]))
+
+    out = bytearray()
+    for off in range(0, len(data), 16):
+        counter = bytes([0x01]) + nonce + struct.pack(">H", off // 16 + 1)
+        out += _xor(data[off:off + 16], aes.encrypt(counter))
+    plain = bytes(out) if opening else data
+    plain += b"\0" * (-len(plain) % 16)
+    for off in range(0, len(plain), 16):
+        mac = aes.encrypt(_xor(mac, plain[off:off + 16]))
+    s0 = aes.encrypt(bytes([0x01]) + nonce + b"\0\0")
+    return bytes(out), _xor(mac, s0)[:tag_len]
+
+
+def nonce(direction, count):
+    return bytes([direction]) + struct.pack("<Q", count) + b"\0" * 4
+
+
+class Session:
+    """The peer's end of a session: the handshake, then sealing and opening
+    with a message counter each way."""
+
+    def __init__(self, key, tag_len=TAG_LEN):
+        self.shared = Aes128(key)
+        self.tag_len = tag_len
+        self.random = os.urandom(RANDOM_LEN)
+        self.aes = None
+        self.tx = 0
+        self.rx = 0
+
+    def hello(self):
+        return MAGIC + OP_HELLO + self.random
+
+    def accept(self, msg):
+        """Take the board's response; return its status, 0 once the session is up."""
+        status = msg[5]
+        if status == 0:
+            self.aes = Aes128(self.shared.encrypt(self.random + msg[6:6 + RANDOM_LEN]))
+            self.tx = 0
+            self.rx = 0
+        return status
+
+    def seal(self, plain):
+        out, tag = ccm(self.aes, nonce(DIR_PEER, self.tx), plain, self.tag_len, False)
+        self.tx += 1
+        return out + tag
+
+    def open(self, msg):
+        """The plaintext, or None when the message is not the board's next
+        sealed one; the counter only moves on a message that opens."""
+        if len(msg) < self.tag_len:
+            return None
+        body = msg[:len(msg) - self.tag_len]
+        out, tag = ccm(self.aes, nonce(DIR_BOARD, self.rx), body, self.tag_len, True)
+        if not hmac.compare_digest(tag, msg[len(body):]):
+            return None
+        self.rx += 1
+        return out
+
+
+def is_response(msg):
+    return len(msg) == RSP_LEN and msg[:4] == MAGIC and msg[4] == OP_RESPONSE
+
+
+def open_session(ch, key, timeout, tag_len=TAG_LEN):
+    """Open a session on a tool's channel (send(), sock and its rx buffer)
+    and show the key with an empty sealed message. The board sends nothing
+    else until the session is up."""
+    session = Session(key, tag_len)
+    ch.send(session.hello())
+    while True:
+        ready, _, _ = select.select([ch.sock], [], [], timeout)
+        if not ready:
+            sys.exit("no session response within %.0f s" % timeout)
+        ch.rx += ch.sock.recv(65535)
+        while len(ch.rx) >= 2:
+            length = struct.unpack("<H", ch.rx[:2])[0]
+            if len(ch.rx) < 2 + length:
+                break
+            msg = bytes(ch.rx[2:2 + length])
+            del ch.rx[:2 + length]
+            if not is_response(msg):
+                continue
+            status = session.accept(msg)
+            if status:
+                sys.exit("session refused: %s" % STATUS.get(status, status))
+            ch.send(session.seal(b""))
+            return session
+
+
+def load_key(ap, text, path, what):
+    """The key from --...key (hex) or --...key-file (raw bytes), or None."""
+    if text is not None and path is not None:
+        ap.error("give one of the %s options" % what)
+    if text is not None:
+        key = bytes.fromhex(text)
+    elif path is not None:
+        with open(path, "rb") as f:
+            key = f.read()
+    else:
+        return None
+    if len(key) != KEY_LEN:
+        ap.error("%s must be %d bytes" % (what, KEY_LEN))
+    return key
+
+
+class Channel:
+    """LE credit based channel to the pipe; messages are split into SDUs."""
+
+    def __init__(self, addr, psm, random_addr):
+        self.sock = socket.socket(socket.AF_BLUETOOTH, socket.SOCK_SEQPACKET,
+                                  socket.BTPROTO_L2CAP)
+        # struct sockaddr_l2 with the LE address type, which the socket
+        # module cannot fill in.
+        sa = struct.pack("<HH6sHBx", socket.AF_BLUETOOTH, psm,
+                         bytes.fromhex(addr.replace(":", ""))[::-1], 0,
+                         BDADDR_LE_RANDOM if random_addr else BDADDR_LE_PUBLIC)
+        libc = ctypes.CDLL(None, use_errno=True)
+        if libc.connect(self.sock.fileno(), ctypes.c_char_p(sa), len(sa)) != 0:
+            err = ctypes.get_errno()
+            sys.exit("connect %s psm 0x%04X: %s" % (addr, psm, os.strerror(err)))
+        self.mtu = self.sock.getsockopt(SOL_BLUETOOTH, BT_SNDMTU, 2)
+        self.mtu = struct.unpack("<H", self.mtu)[0]
+        self.rx = bytearray()
+
+    def send(self, msg):
+        frame = struct.pack("<H", len(msg)) + msg
+        for i in range(0, len(frame), self.mtu):
+            self.sock.send(frame[i:i + self.mtu])
+
+    def receive(self):
+        """The whole pipe messages in what the socket has now."""
+        self.rx += self.sock.recv(65535)
+        out = []
+        while len(self.rx) >= 2:
+            length = struct.unpack("<H", self.rx[:2])[0]
+            if len(self.rx) < 2 + length:
+                break
+            out.append(bytes(self.rx[2:2 + length]))
+            del self.rx[:2 + length]
+        return out
+
+
+def self_test():
+    aes = Aes128(bytes(range(16)))
+    ok_aes = aes.encrypt(bytes.fromhex("00112233445566778899aabbccddeeff")) == \
+        bytes.fromhex("69c4e0d86a7b0430d8cdb78070b4c55a")
+
+    # RFC 3610 packet vector #1
+    key = bytes(range(0xC0, 0xD0))
+    n = bytes.fromhex("00000003020100a0a1a2a3a4a5")
+    sealed = bytes.fromhex("588c979a61c663d2f066d0c2c0f989806d5f6b61dac384"
+                           "17e8d12cfdf926e0")
+    out, tag = ccm(Aes128(key), n, bytes(range(8, 31)), 8, False, bytes(range(8)))
+    ok_seal = out + tag == sealed
+    out, tag = ccm(Aes128(key), n, sealed[:23], 8, True, bytes(range(8)))
+    ok_open = out == bytes(range(8, 31)) and tag == sealed[23:]
+
+    # Both ends of a session, the board's played here by a second Session
+    peer = Session(key)
+    board = Session(key)
+    peer.accept(MAGIC + b"R\0" + board.random)
+    board.aes = peer.aes
+    msg = peer.seal(b"hello board")
+    out, tag = ccm(board.aes, nonce(DIR_PEER, 0), msg[:-TAG_LEN], TAG_LEN, True)
+    ok_session = out == b"hello board" and tag == msg[-TAG_LEN:]
+    out, tag = ccm(board.aes, nonce(DIR_BOARD, 0), b"hello peer", TAG_LEN, False)
+    ok_session = ok_session and peer.open(out + tag) == b"hello peer" and peer.open(out + tag) is None
+
+    for name, ok in (("FIPS-197 C.1", ok_aes), ("RFC 3610 #1 seal", ok_seal),
+                     ("RFC 3610 #1 open", ok_open), ("session round trip", ok_session)):
+        print("%-20s %s" % (name, "ok" if ok else "FAIL"))
+    return ok_aes and ok_seal and ok_open and ok_session
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--key", help="APP_AEAD_KEY as hex")
+    ap.add_argument("--key-file", help="file holding APP_AEAD_KEY, raw bytes")
+    ap.add_argument("--addr", help="board address")
+    ap.add_argument("--random", action="store_true",
+                    help="the board address is a random one")
+    ap.add_argument("--psm", type=lambda s: int(s, 0), help="data channel PSM")
+    ap.add_argument("--tag-len", type=int, default=TAG_LEN,
+                    help="APP_AEAD_TAG_LEN of the firmware (default %d)" % TAG_LEN)
+    ap.add_argument("--timeout", type=float, default=5.0,
+                    help="seconds to wait for the session response (default 5)")
+    ap.add_argument("--self-test", action="store_true",
+                    help="check AES and CCM against published vectors, then exit")
+    args = ap.parse_args()
+
+    if args.self_test:
+        sys.exit(0 if self_test() else 1)
+    if args.tag_len not in range(4, 17, 2):
+        ap.error("--tag-len must be 4, 6, 8, 10, 12, 14 or 16")
+    key = load_key(ap, args.key, args.key_file, "the key")
+    if key is None:
+        ap.error("give --key or --key-file")
+    if args.addr is None or args.psm is None:
+        ap.error("give --addr and --psm")
+
+    ch = Channel(args.addr, args.psm, args.random)
+    session = open_session(ch, key, args.timeout, args.tag_len)
+    print("session up", file=sys.stderr)
+
+    while True:
+        ready, _, _ = select.select([ch.sock, sys.stdin], [], [])
+        if sys.stdin in ready:
+            line = sys.stdin.buffer.readline()
+            if not line:
+                return
+            ch.send(session.seal(line))
+        if ch.sock in ready:
+            for msg in ch.receive():
+                plain = session.open(msg)
+                if plain is not None:
+                    sys.stdout.buffer.write(plain)
+                    sys.stdout.flush()
+                elif msg[:4] in CLEAR_MAGICS:
+                    print("clear: %s" % msg.hex(), file=sys.stderr)
+                else:
+                    print("dropped %d bytes: not the next sealed message" % len(msg),
+                          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
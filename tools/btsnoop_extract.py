@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Collect HCI capture frames sent by the firmware (app_btsnoop.c).
+
+Capture is started with "\\nSNPON\\n" over the pipe (or at boot with
+APP_BTSNOOP_AUTOSTART) and stopped with "\\nSNPOF\\n". The firmware streams
+btsnoop records in frames on the debug UART, or over the pipe when the UART
+bridge owns the UART. Feed this script a raw capture of that stream; other
+output around the frames is skipped:
+
+    btsnoop_extract.py -o hci.btsnoop uart.bin
+    wireshark hci.btsnoop
+
+For a live view, read the serial port and pipe pcap into Wireshark:
+
+    stty -F /dev/ttyUSB0 115200 raw
+    btsnoop_extract.py --pcap -o - /dev/ttyUSB0 | wireshark -k -i -
+
+Record times are microseconds of device uptime (shown as 1970-01-01 plus
+uptime); --wallclock shifts them so the first record is at the time the
+script saw it. The device cycle counter stops while it sleeps, so idle gaps
+appear shorter than they were.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = b"\x7eSNP"
+VERSION = 1
+RECORD_HDR_SIZE = 24
+
+BTSNOOP_MAGIC = b"btsnoop\0"
+BTSNOOP_VERSION = 1
+BTSNOOP_DATALINK_H4 = 1002
+BTSNOOP_EPOCH_US = 0x00DCDDB30F2F8000
+
+PCAP_MAGIC = 0xA1B2C3D4
+PCAP_LINKTYPE_H4_WITH_PHDR = 201
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class FrameParser:
+    """Incremental frame parser; feed() returns the complete frames found."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        while True:
+            pos = self.buf.find(SYNC)
+            if pos < 0:
+                del self.buf[:max(0, len(self.buf) - len(SYNC) + 1)]
+                return frames
+            del self.buf[:pos]
+            if len(self.buf) < 8:
+                return frames
+            version, flags, length = struct.unpack_from("<BBH", self.buf, 4)
+            if version != VERSION or length < 4:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < 4 + length + 2:
+                return frames
+            crc, = struct.unpack_from("<H", self.buf, 4 + length)
+            if crc != crc16_ccitt(self.buf[4:4 + length]):
+                self.bad += 1
+                del self.buf[:1]
+                continue
+            frames.append((flags, bytes(self.buf[8:4 + length])))
+            del self.buf[:4 + length + 2]
+
+
+def split_records(payload):
+    """Yield (orig_len, flags, drops, ts_us, packet) from a frame payload."""
+    pos = 0
+    while pos + RECORD_HDR_SIZE <= len(payload):
+        orig_len, incl_len, flags, drops, ts_us = struct.unpack_from(">IIIIQ", payload, pos)
+        pos += RECORD_HDR_SIZE
+        packet = payload[pos:pos + incl_len]
+        if len(packet) != incl_len:
+            return
+        pos += incl_len
+        yield orig_len, flags, drops, ts_us, packet
+
+
+class BtsnoopWriter:
+    def __init__(self, out):
+        self.out = out
+        out.write(BTSNOOP_MAGIC + struct.pack(">II", BTSNOOP_VERSION, BTSNOOP_DATALINK_H4))
+
+    def write(self, orig_len, flags, drops, ts_us, packet):
+        self.out.write(struct.pack(">IIIIQ", orig_len, len(packet), flags, drops, ts_us) + packet)
+
+
+class PcapWriter:
+    def __init__(self, out):
+        self.out = out
+        out.write(struct.pack("<IHHiIII", PCAP_MAGIC, 2, 4, 0, 0, 65535, PCAP_LINKTYPE_H4_WITH_PHDR))
+
+    def write(self, orig_len, flags, drops, ts_us, packet):
+        us = max(0, ts_us - BTSNOOP_EPOCH_US)
+        direction = struct.pack(">I", flags & 1)
+        self.out.write(struct.pack("<IIII", us // 1000000, us % 1000000, len(packet) + 4, orig_len + 4))
+        self.out.write(direction + packet)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw capture file or serial device (default: stdin)")
+    parser.add_argument("-o", "--output", default="hci.btsnoop", help="output file, - for stdout (default: hci.btsnoop)")
+    parser.add_argument("--pcap", action="store_true", help="write pcap (for wireshark -k -i -) instead of btsnoop")
+    parser.add_argument("--wallclock", action="store_true", help="shift times to the host clock")
+    args = parser.parse_args()
+
+    src = open(args.capture, "rb", buffering=0) if args.capture else sys.stdin.buffer
+    out = sys.stdout.buffer if args.output == "-" else open(args.output, "wb")
+    writer = (PcapWriter if args.pcap else BtsnoopWriter)(out)
+    frames = FrameParser()
+    shift = None
+    records = 0
+    sessions = 0
+    drops = 0
+
+    # read1 returns what is available, so a live stream is not held back
+    read = getattr(src, "read1", src.read)
+    try:
+        while True:
+            data = read(4096)
+            if not data:
+                break
+            for flags, payload in frames.feed(data):
+                if flags & 0x01:
+                    sessions += 1
+                for record in split_records(payload):
+                    orig_len, rflags, drops, ts_us, packet = record
+                    if args.wallclock:
+                        if shift is None:
+                            shift = BTSNOOP_EPOCH_US + int(time.time() * 1e6) - ts_us
+                        ts_us += shift
+                    writer.write(orig_len, rflags, drops, ts_us, packet)
+                    records += 1
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        out.flush()
+        if out is not sys.stdout.buffer:
+            out.close()
+
+    sys.stderr.write("%d records, %d capture starts, %d dropped on the device, %d corrupt frames\n"
+                     % (records, sessions, drops, frames.bad))
+    return 0 if records else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
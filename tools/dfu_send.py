@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+"""Send a firmware update over the pipe (app_dfu.c).
+
+The firmware must be built with APP_DFU_ENABLE=1 for both the compiler and
+the linker, so the image fits in the lower flash panel. The image starts at
+its vectors, whose link address is read from the .map the build writes next
+to the .hex (--map otherwise). The image is cut from the production .hex at
+that address up to its last byte; the boot flash and PDS records in the .hex
+are left out. The start message carries the address, and the board refuses
+an image linked for another layout, e.g. with or without APP_LOG_ENABLE.
+The start message is authenticated with an HMAC-SHA256 under the key the
+firmware was built with (APP_DFU_KEY), given with --key or --key-file.
+A build with APP_AEAD_ENABLE takes the update only in a session opened with
+its APP_AEAD_KEY, given with --aead-key or --aead-key-file (aead_peer.py);
+the update messages go in clear and the responses come sealed.
+
+Over an LE credit based channel on Linux (BlueZ), with the address of the
+board and the PSM read from its Transparent Credit Based service:
+
+    dfu_send.py --key-file dfu.key --addr 00:04:25:1A:2B:3C --psm 0x0081 \
+        ble_cbp.X.production.hex
+
+Each pipe message is a 2 byte little endian length followed by the
+message, split into SDUs of the channel MTU. The board answers the start
+message once the space is erased, then takes data as fast as it can program
+it, holding back credits while both row buffers are busy. After the finish
+message it checks the SHA-256, makes the image active and resets.
+
+Without --addr the message stream is written to a file (-o) to be played
+by another client; responses are then not checked.
+"""
+
+import argparse
+import ctypes
+import hashlib
+import hmac
+import os
+import re
+import select
+import socket
+import struct
+import sys
+import time
+
+import aead_peer
+
+MAGIC = b"\x7eDFU"
+OP_START = b"S"
+OP_DATA = b"D"
+OP_FINISH = b"F"
+OP_ABORT = b"A"
+OP_RESPONSE = ord("R")
+CHUNK_MAX = 1024
+RSP_LEN = 11
+FLASH_START = 0x01000000
+
+STATUS = {
+    0: "ok",
+    1: "bad state",
+    2: "bad size",
+    3: "bad offset",
+    4: "flash error",
+    5: "digest mismatch",
+    6: "image not linked for the panel layout",
+    7: "image linked at another address",
+    8: "start message not authenticated with the board's key",
+}
+
+SOL_BLUETOOTH = 274
+BT_SNDMTU = 12
+BDADDR_LE_PUBLIC = 1
+BDADDR_LE_RANDOM = 2
+
+
+def read_hex(path, base):
+    """Return the bytes of an Intel HEX file from base to the last byte."""
+    mem = {}
+    upper = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(":"):
+                continue
+            rec = bytes.fromhex(line[1:])
+            if sum(rec) & 0xFF:
+                sys.exit("%s: bad checksum in %s" % (path, line))
+            count, addr, kind = rec[0], struct.unpack(">H", rec[1:3])[0], rec[3]
+            data = rec[4:4 + count]
+            if kind == 0:
+                start = upper + addr
+                for i, b in enumerate(data):
+                    mem[start + i] = b
+            elif kind == 1:
+                break
+            elif kind == 2:
+                upper = struct.unpack(">H", data)[0] << 4
+            elif kind == 4:
+                upper = struct.unpack(">H", data)[0] << 16
+    addrs = [a for a in mem if a >= base]
+    if not addrs:
+        sys.exit("%s: nothing at 0x%08X or above" % (path, base))
+    image = bytearray(b"\xff" * (max(addrs) + 1 - base))
+    for a in addrs:
+        image[a - base] = mem[a]
+    return bytes(image)
+
+
+def read_map(path):
+    """Return the address of the vectors, where the image starts, from a .map."""
+    try:
+        with open(path) as f:
+            text = f.read()
+    except OSError as e:
+        sys.exit("%s: %s" % (path, e.strerror))
+    m = (re.search(r"^\s*(0x[0-9A-Fa-f]+)\s+__svectors\b", text, re.M)
+         or re.search(r"^\.vectors\s+(0x[0-9A-Fa-f]+)", text, re.M))
+    if m is None:
+        sys.exit("%s: no __svectors or .vectors in the map" % path)
+    base = int(m.group(1), 16)
+    if base < FLASH_START:
+        sys.exit("%s: vectors at 0x%08X, in boot flash: not built with APP_DFU_ENABLE=1"
+                 % (path, base))
+    return base
+
+
+def messages(image, base, key, chunk):
+    start = (MAGIC + OP_START + struct.pack("<II", len(image), base)
+             + hashlib.sha256(image).digest())
+    yield start + hmac.new(key, start, hashlib.sha256).digest()
+    for offset in range(0, len(image), chunk):
+        yield MAGIC + OP_DATA + struct.pack("<I", offset) + image[offset:offset + chunk]
+    yield MAGIC + OP_FINISH
+
+
+class Channel:
+    """LE credit based channel to the pipe; one send is one SDU."""
+
+    def __init__(self, addr, psm, random_addr):
+        self.sock = socket.socket(socket.AF_BLUETOOTH, socket.SOCK_SEQPACKET,
+                                  socket.BTPROTO_L2CAP)
+        # struct sockaddr_l2 with the LE address type, which the socket
+        # module cannot fill in.
+        sa = struct.pack("<HH6sHBx", socket.AF_BLUETOOTH, psm,
+                         bytes.fromhex(addr.replace(":", ""))[::-1], 0,
+                         BDADDR_LE_RANDOM if random_addr else BDADDR_LE_PUBLIC)
+        libc = ctypes.CDLL(None, use_errno=True)
+        if libc.connect(self.sock.fileno(), ctypes.c_char_p(sa), len(sa)) != 0:
+            err = ctypes.get_errno()
+            sys.exit("connect %s psm 0x%04X: %s" % (addr, psm, os.strerror(err)))
+        self.mtu = self.sock.getsockopt(SOL_BLUETOOTH, BT_SNDMTU, 2)
+        self.mtu = struct.unpack("<H", self.mtu)[0]
+        self.rx = bytearray()
+        self.session = None
+
+    def send(self, msg):
+        frame = struct.pack("<H", len(msg)) + msg
+        for i in range(0, len(frame), self.mtu):
+            self.sock.send(frame[i:i + self.mtu])
+
+    def responses(self, timeout):
+        """Return the DFU responses received within timeout seconds."""
+        out = []
+        end = time.monotonic() + timeout
+        while True:
+            left = end - time.monotonic()
+            ready, _, _ = select.select([self.sock], [], [], max(left, 0))
+            if not ready:
+                return out
+            self.rx += self.sock.recv(65535)
+            while len(self.rx) >= 2:
+                length = struct.unpack("<H", self.rx[:2])[0]
+                if len(self.rx) < 2 + length:
+                    break
+                msg = bytes(self.rx[2:2 + length])
+                del self.rx[:2 + length]
+                if self.session is not None:
+                    msg = self.session.open(msg)
+                    if msg is None:
+                        continue
+                if (len(msg) == RSP_LEN and msg[:4] == MAGIC
+                        and msg[4] == OP_RESPONSE):
+                    out.append((chr(msg[5]), msg[6],
+                                struct.unpack("<I", msg[7:11])[0]))
+            if out:
+                return out
+
+
+def expect(ch, op, timeout):
+    for rop, status, value in ch.responses(timeout):
+        if status:
+            ch.send(MAGIC + OP_ABORT)
+            sys.exit("'%s' refused: %s (0x%X)" % (rop, STATUS.get(status, status), value))
+        if rop == op:
+            return value
+    sys.exit("no response to '%s' within %.0f s" % (op, timeout))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", help=".hex file, or .bin starting at the vectors")
+    ap.add_argument("--map", help="linker map of the image (default: the .hex"
+                    " with .map instead)")
+    ap.add_argument("--key", help="APP_DFU_KEY as hex")
+    ap.add_argument("--key-file", help="file holding APP_DFU_KEY, raw bytes")
+    ap.add_argument("--aead-key", help="APP_AEAD_KEY as hex, to open a session first")
+    ap.add_argument("--aead-key-file", help="file holding APP_AEAD_KEY, raw bytes")
+    ap.add_argument("--addr", help="board address")
+    ap.add_argument("--random", action="store_true",
+                    help="the board address is a random one")
+    ap.add_argument("--psm", type=lambda s: int(s, 0), help="data channel PSM")
+    ap.add_argument("--chunk", type=int, default=CHUNK_MAX,
+                    help="image bytes per data message (default %d)" % CHUNK_MAX)
+    ap.add_argument("--timeout", type=float, default=30.0,
+                    help="seconds to wait for the erase and the finish (default 30)")
+    ap.add_argument("-o", "--output", help="write the message stream here instead")
+    args = ap.parse_args()
+
+    if not 1 <= args.chunk <= CHUNK_MAX:
+        ap.error("--chunk must be 1..%d" % CHUNK_MAX)
+    if (args.key is None) == (args.key_file is None):
+        ap.error("give one of --key and --key-file")
+    if args.key is not None:
+        key = bytes.fromhex(args.key)
+    else:
+        with open(args.key_file, "rb") as f:
+            key = f.read()
+    if not key:
+        ap.error("the key is empty")
+    aead_key = aead_peer.load_key(ap, args.aead_key, args.aead_key_file, "the AEAD key")
+    is_hex = args.image.lower().endswith(".hex")
+    if args.map is None:
+        if not is_hex:
+            ap.error("--map is needed with a .bin")
+        args.map = args.image[:-4] + ".map"
+    base = read_map(args.map)
+    if is_hex:
+        image = read_hex(args.image, base)
+    else:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    print("image %d bytes at 0x%08X, sha256 %s"
+          % (len(image), base, hashlib.sha256(image).hexdigest()), file=sys.stderr)
+
+    if args.addr is None:
+        if args.output is None:
+            ap.error("give --addr and --psm, or -o")
+        with open(args.output, "wb") as out:
+            for msg in messages(image, base, key, args.chunk):
+                out.write(struct.pack("<H", len(msg)) + msg)
+        return
+
+    if args.psm is None:
+        ap.error("--psm is needed with --addr")
+    ch = Channel(args.addr, args.psm, args.random)
+    if aead_key is not None:
+        ch.session = aead_peer.open_session(ch, aead_key, args.timeout)
+    msgs = messages(image, base, key, args.chunk)
+
+    t0 = time.monotonic()
+    ch.send(next(msgs))
+    expect(ch, "S", args.timeout)
+    t1 = time.monotonic()
+    print("erased in %.2f s, sdu %d" % (t1 - t0, ch.mtu), file=sys.stderr)
+
+    sent = 0
+    for msg in msgs:
+        if msg[4:5] == OP_FINISH:
+            break
+        ch.send(msg)
+        sent += len(msg) - 9
+        # A refused data message is answered right away; nothing comes back
+        # otherwise.
+        for rop, status, value in ch.responses(0):
+            if status:
+                sys.exit("'%s' refused: %s (0x%X)" % (rop, STATUS.get(status, status), value))
+        print("\r%d/%d" % (sent, len(image)), end="", file=sys.stderr)
+    t2 = time.monotonic()
+    ch.send(MAGIC + OP_FINISH)
+    seq = expect(ch, "F", args.timeout)
+    t3 = time.monotonic()
+    print("\nsent in %.2f s (%.1f kbit/s), finished in %.2f s, sequence %d"
+          % (t2 - t1, len(image) * 8 / (t2 - t1) / 1000, t3 - t2, seq), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
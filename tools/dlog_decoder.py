@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""Decode deferred log frames sent by the firmware (app_dlog.c).
+
+APP_DLOG() calls only store a format string id and raw arguments; the drain
+task sends them on the debug UART in binary frames. The format strings are
+not in flash, they live in the .app_dlog_fmt section of the ELF. Give this
+script the ELF of the running build and a raw capture of the UART (other
+output around the frames is skipped):
+
+    dlog_decoder.py ble_cbp.X/dist/default/production/ble_cbp.X.production.elf uart.bin
+    dlog_decoder.py --timestamps app.elf uart.bin
+
+The text is printed as the firmware would have printed it. With --timestamps
+each record goes on its own line, prefixed by the time since the first
+record. The cycle counter stops while the device sleeps, so idle gaps are
+shorter than they were in wall clock time.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = b"\x7eDLG"
+VERSION = 1
+HEADER_SIZE = 16
+SECTION = ".app_dlog_fmt"
+
+HDR_VALID = 0x80000000
+HDR_NARGS_POS = 24
+HDR_ID_MASK = 0x00FFFFFF
+
+# printf conversion: flags, width, precision, length modifier, conversion
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*|\*)(?:\.(\d*|\*))?(hh|h|ll|l|j|z|t|L)?([diouxXcpsfFeEgGaA%])")
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def read_format_section(path):
+    """Return (base address, bytes) of the format string section of an ELF32."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1 or elf[5] != 1:
+        raise ValueError("%s: not a little endian ELF32 file" % path)
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    sections = []
+    for i in range(shnum):
+        name, _, _, addr, offset, size = struct.unpack_from("<IIIIII", elf, shoff + i * shentsize)
+        sections.append((name, addr, offset, size))
+    strtab_offset = sections[shstrndx][2]
+    for name, addr, offset, size in sections:
+        end = elf.index(b"\0", strtab_offset + name)
+        if elf[strtab_offset + name:end].decode("ascii", "replace") == SECTION:
+            return addr, elf[offset:offset + size]
+    raise ValueError("%s: no %s section, is deferred logging enabled in this build?" % (path, SECTION))
+
+
+class Frame:
+    def __init__(self, cpu_hz, dropped, words):
+        self.cpu_hz = cpu_hz
+        self.dropped = dropped
+        self.words = words
+
+
+def parse_frames(data):
+    frames = []
+    pos = data.find(SYNC)
+    while pos >= 0:
+        frame, pos = parse_frame(data, pos)
+        if frame is not None:
+            frames.append(frame)
+        pos = data.find(SYNC, pos)
+    return frames
+
+
+def parse_frame(data, pos):
+    if len(data) < pos + HEADER_SIZE:
+        return None, pos + 1
+    version, _, length = struct.unpack_from("<BBH", data, pos + 4)
+    end = pos + 4 + length
+    if version != VERSION or length < HEADER_SIZE - 4 or (length - (HEADER_SIZE - 4)) % 4 or len(data) < end + 2:
+        return None, pos + 1
+    crc, = struct.unpack_from("<H", data, end)
+    if crc != crc16_ccitt(data[pos + 4:end]):
+        return None, pos + 1
+    cpu_hz, dropped = struct.unpack_from("<II", data, pos + 8)
+    words = list(struct.unpack_from("<%dI" % ((end - pos - HEADER_SIZE) // 4), data, pos + HEADER_SIZE))
+    return Frame(cpu_hz, dropped, words), end + 2
+
+
+def records(frames):
+    """Yield (cpu_hz, dropped, cycles, id, args) with the cycle counter unwrapped."""
+    prev_ts = None
+    cycles = 0
+    for frame in frames:
+        i = 0
+        while i + 2 <= len(frame.words):
+            hdr, ts = frame.words[i], frame.words[i + 1]
+            nargs = (hdr >> HDR_NARGS_POS) & 0x7
+            if not hdr & HDR_VALID or i + 2 + nargs > len(frame.words):
+                break
+            if prev_ts is not None:
+                cycles += (ts - prev_ts) & 0xFFFFFFFF
+            prev_ts = ts
+            yield frame.cpu_hz, frame.dropped, cycles, hdr & HDR_ID_MASK, frame.words[i + 2:i + 2 + nargs]
+            i += 2 + nargs
+
+
+def format_record(fmt, args):
+    """Apply a C format string to 32 bit arguments."""
+    args = list(args)
+    out = []
+    pos = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, width, precision, length, conv = match.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = str(to_signed(args.pop(0))) if args else ""
+        if precision == "*":
+            precision = str(args.pop(0)) if args else ""
+        if not args:
+            out.append("<missing>")
+            continue
+        value = args.pop(0)
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        if length == "hh":
+            value &= 0xFF
+        elif length == "h":
+            value &= 0xFFFF
+        if conv in "di":
+            bits = 8 if length == "hh" else 16 if length == "h" else 32
+            value = value - (1 << bits) if value & (1 << (bits - 1)) else value
+            out.append((spec + "d") % value)
+        elif conv in "ouxXc":
+            out.append((spec + ("d" if conv == "u" else conv)) % value)
+        elif conv == "p":
+            out.append("0x%08x" % value)
+        else:
+            out.append("<%%%s unsupported>" % conv)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def to_signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def lookup(strings, base, fmt_id):
+    offset = fmt_id - base if fmt_id >= base else fmt_id
+    if offset >= len(strings):
+        return None
+    end = strings.find(b"\0", offset)
+    return strings[offset:end if end >= 0 else len(strings)].decode("utf-8", "replace")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="ELF of the build that produced the capture")
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--timestamps", action="store_true", help="one record per line with its time")
+    args = parser.parse_args()
+
+    try:
+        base, strings = read_format_section(args.elf)
+    except (OSError, ValueError) as err:
+        sys.stderr.write("%s\n" % err)
+        return 1
+    if args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    frames = parse_frames(data)
+    if not frames:
+        sys.stderr.write("no log frame found\n")
+        return 1
+
+    dropped = frames[0].dropped
+    count = 0
+    for cpu_hz, total_dropped, cycles, fmt_id, fmt_args in records(frames):
+        if total_dropped != dropped:
+            sys.stdout.write("\n<%d records dropped, ring full>\n" % (total_dropped - dropped))
+            dropped = total_dropped
+        fmt = lookup(strings, base, fmt_id)
+        text = format_record(fmt, fmt_args) if fmt is not None else "<unknown id 0x%06x %s>" % (
+            fmt_id, " ".join("0x%x" % a for a in fmt_args))
+        if args.timestamps:
+            sys.stdout.write("%14.3f us  %s\n" % (cycles * 1e6 / (cpu_hz or 64000000), text.strip("\r\n")))
+        else:
+            sys.stdout.write(text)
+        count += 1
+    if not args.timestamps:
+        sys.stdout.write("\n")
+    sys.stderr.write("%d records, %d dropped on the device before the last frame\n" % (count, dropped))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Split the uplink of the multi node gateway (app_gateway.c) per node.
+
+With APP_GATEWAY_ENABLE the board connects to up to six pipe nodes and sends
+every SDU they deliver on the UART, in a frame tagged with the node number,
+plus a stats frame every second. Feed this script a raw capture of the UART;
+other output around the frames is skipped:
+
+    gateway_demux.py -d nodes/ uart.bin
+
+writes nodes/node0.bin, nodes/node1.bin, ... with the data of each node in
+order, and prints a line per stats frame:
+
+    stty -F /dev/ttyUSB0 115200 raw
+    gateway_demux.py /dev/ttyUSB0
+
+Node numbers are slots on the gateway: a slot freed by a disconnection is
+reused by the next node, the address in the stats tells them apart.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SYNC = b"\x7eGWY"
+VERSION = 1
+NODE_STATS = 0xFF
+STATS_NODE = struct.Struct("<B B 6s I I I H I")
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class FrameParser:
+    """Incremental frame parser; feed() returns the complete frames found."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.bad = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        while True:
+            pos = self.buf.find(SYNC)
+            if pos < 0:
+                del self.buf[:max(0, len(self.buf) - len(SYNC) + 1)]
+                return frames
+            del self.buf[:pos]
+            if len(self.buf) < 8:
+                return frames
+            version, node, length = struct.unpack_from("<BBH", self.buf, 4)
+            if version != VERSION or length < 4:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < 4 + length + 2:
+                return frames
+            crc, = struct.unpack_from("<H", self.buf, 4 + length)
+            if crc != crc16_ccitt(self.buf[4:4 + length]):
+                self.bad += 1
+                del self.buf[:1]
+                continue
+            frames.append((node, bytes(self.buf[8:4 + length])))
+            del self.buf[:4 + length + 2]
+
+
+def parse_stats(payload):
+    """Return (time_ms, [(node, addr, rx, up, held, queued, rx_bps)])."""
+    time_ms, = struct.unpack_from("<I", payload, 0)
+    nodes = []
+    for pos in range(4, len(payload) - STATS_NODE.size + 1, STATS_NODE.size):
+        node, addr_type, addr, rx, up, held, queued, rx_bps = STATS_NODE.unpack_from(payload, pos)
+        text = ":".join("%02X" % b for b in reversed(addr)) + ("/r" if addr_type else "")
+        nodes.append((node, text, rx, up, held, queued, rx_bps))
+    return time_ms, nodes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw capture file or serial device (default: stdin)")
+    parser.add_argument("-d", "--dir", help="write the data of each node to DIR/node<n>.bin")
+    parser.add_argument("-q", "--quiet", action="store_true", help="do not print the stats frames")
+    args = parser.parse_args()
+
+    src = open(args.capture, "rb", buffering=0) if args.capture else sys.stdin.buffer
+    if args.dir:
+        os.makedirs(args.dir, exist_ok=True)
+    frames = FrameParser()
+    outs = {}
+    totals = {}
+    first_ms = last_ms = None
+
+    # read1 returns what is available, so a live stream is not held back
+    read = getattr(src, "read1", src.read)
+    try:
+        while True:
+            data = read(4096)
+            if not data:
+                break
+            for node, payload in frames.feed(data):
+                if node != NODE_STATS:
+                    totals[node] = totals.get(node, 0) + len(payload)
+                    if args.dir:
+                        if node not in outs:
+                            outs[node] = open(os.path.join(args.dir, "node%d.bin" % node), "wb")
+                        outs[node].write(payload)
+                    continue
+                if len(payload) < 4:
+                    continue
+                time_ms, nodes = parse_stats(payload)
+                first_ms = time_ms if first_ms is None else first_ms
+                last_ms = time_ms
+                if args.quiet:
+                    continue
+                total = sum(n[6] for n in nodes)
+                print("%10.3f s  %d nodes  %8.1f kbit/s" % (time_ms / 1000.0, len(nodes), total / 1000.0))
+                for node, addr, rx, up, held, queued, rx_bps in nodes:
+                    print("    %d %-20s %8.1f kbit/s  rx %10d  up %10d  queued %5d  held %d"
+                          % (node, addr, rx_bps / 1000.0, rx, up, queued, held))
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for out in outs.values():
+            out.close()
+
+    for node in sorted(totals):
+        line = "node %d: %d bytes" % (node, totals[node])
+        if first_ms is not None and last_ms > first_ms:
+            line += ", %.1f kbit/s" % (totals[node] * 8.0 / (last_ms - first_ms))
+        sys.stderr.write(line + "\n")
+    sys.stderr.write("%d corrupt frames\n" % frames.bad)
+    return 0 if totals or first_ms is not None else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
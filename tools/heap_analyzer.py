@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""Analyze heap snapshots dumped by the firmware (app_heap_diag.c).
+
+A snapshot is requested by sending "\\nHEAP \\n" over the pipe; the firmware
+answers on the debug UART and over the pipe, and dumps one on its own when an
+allocation fails. Feed this script any capture holding one or more snapshots
+(other log output around them is ignored):
+
+    heap_analyzer.py uart.log
+    heap_analyzer.py --csv heap.csv uart.log
+
+For every snapshot it reports fragmentation; across snapshots it reports the
+allocation rate of each module and modules whose live bytes keep growing.
+"""
+
+import argparse
+import csv
+import re
+import sys
+
+FIELD_RE = re.compile(r"(\w+)=(\S+)")
+
+
+class Snapshot:
+    def __init__(self, heap):
+        self.heap = heap
+        self.mods = {}
+
+    @property
+    def t(self):
+        return self.heap["t"]
+
+    @property
+    def used(self):
+        return self.heap["size"] - self.heap["free"]
+
+    @property
+    def fragmentation(self):
+        """Share of the free heap that is not in the largest free block."""
+        free = self.heap["free"]
+        return 0.0 if free == 0 else 1.0 - self.heap["largest"] / free
+
+    @property
+    def untracked(self):
+        """Heap used outside OSAL_Malloc: kernel objects and heap_4 block headers."""
+        return max(0, self.used - self.heap["tracked"])
+
+
+def parse_fields(text):
+    fields = {}
+    for key, value in FIELD_RE.findall(text):
+        if key == "fail":
+            tag, _, size = value.partition(":")
+            fields["fail_tag"] = tag
+            fields["fail"] = int(size or 0)
+        else:
+            fields[key] = int(value)
+    return fields
+
+
+def parse(stream):
+    snapshots = []
+    current = None
+    for raw in stream:
+        line = raw.strip()
+        start = line.find("#")
+        if start < 0:
+            continue
+        line = line[start:]
+        if line.startswith("#HEAP "):
+            current = Snapshot(parse_fields(line[6:]))
+        elif line.startswith("#MOD ") and current is not None:
+            name, _, rest = line[5:].partition(" ")
+            current.mods[name] = parse_fields(rest)
+        elif line.startswith("#END") and current is not None:
+            snapshots.append(current)
+            current = None
+    return snapshots
+
+
+def kib(value):
+    return "%.1fK" % (value / 1024.0)
+
+
+def print_snapshots(snapshots):
+    print("%10s %7s %7s %7s %7s %6s %6s %9s" %
+          ("t(ms)", "used", "free", "minfree", "largest", "blocks", "frag", "untracked"))
+    for snap in snapshots:
+        h = snap.heap
+        print("%10d %7s %7s %7s %7s %6d %5.0f%% %9s" %
+              (snap.t, kib(snap.used), kib(h["free"]), kib(h["minfree"]), kib(h["largest"]),
+               h["blocks"], snap.fragmentation * 100.0, kib(snap.untracked)))
+
+
+def rate(first, last, name, key):
+    if first is None or last.t <= first.t:
+        return None
+    return (last.mods[name][key] - first.mods.get(name, {}).get(key, 0)) * 1000.0 / (last.t - first.t)
+
+
+def print_modules(snapshots):
+    last = snapshots[-1]
+    first = snapshots[0] if len(snapshots) > 1 else None
+    prev = snapshots[-2] if len(snapshots) > 1 else None
+    tracked = sum(m["live"] for m in last.mods.values()) or 1
+
+    print("\nModules at t=%d ms" % last.t)
+    print("%-10s %8s %8s %6s %8s %8s %6s %10s %13s" %
+          ("module", "live", "peak", "share", "blocks", "allocs", "fails", "alloc/s", "alloc/s(last)"))
+    for name, m in sorted(last.mods.items(), key=lambda item: -item[1]["peak"]):
+        total = rate(first, last, name, "allocs")
+        recent = rate(prev, last, name, "allocs")
+        print("%-10s %8d %8d %5.0f%% %8d %8d %6d %10s %13s" %
+              (name, m["live"], m["peak"], m["live"] * 100.0 / tracked, m["allocs"] - m["frees"],
+               m["allocs"], m["fails"],
+               "-" if total is None else "%.1f" % total,
+               "-" if recent is None else "%.1f" % recent))
+
+
+def print_findings(snapshots):
+    last = snapshots[-1]
+    h = last.heap
+    print()
+    if h.get("fail", 0):
+        cause = "fragmentation" if h["fail"] < h["free"] else "exhaustion"
+        print("Last failed request: %s asked for %d bytes, %d free, largest free block %d (%s)" %
+              (h.get("fail_tag", "?"), h["fail"], h["free"], h["largest"], cause))
+    if h.get("foreign", 0):
+        print("%d OSAL_Free calls on blocks not allocated by OSAL_Malloc (or freed twice)" % h["foreign"])
+
+    if len(snapshots) >= 3:
+        for name in last.mods:
+            series = [s.mods.get(name, {}).get("live", 0) for s in snapshots]
+            if all(b > a for a, b in zip(series, series[1:])):
+                print("Possible leak: %s live bytes grew in every interval (%d -> %d)" %
+                      (name, series[0], series[-1]))
+
+
+def write_csv(path, snapshots):
+    names = sorted({name for s in snapshots for name in s.mods})
+    with open(path, "w", newline="") as out:
+        writer = csv.writer(out)
+        writer.writerow(["t_ms", "used", "free", "minfree", "largest", "blocks", "fragmentation"] +
+                        ["%s_live" % n for n in names] + ["%s_allocs" % n for n in names])
+        for s in snapshots:
+            h = s.heap
+            writer.writerow([s.t, s.used, h["free"], h["minfree"], h["largest"], h["blocks"],
+                             "%.3f" % s.fragmentation] +
+                            [s.mods.get(n, {}).get("live", 0) for n in names] +
+                            [s.mods.get(n, {}).get("allocs", 0) for n in names])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", help="capture file, stdin if omitted")
+    parser.add_argument("--csv", help="also write the time series to this CSV file")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, errors="replace") as stream:
+            snapshots = parse(stream)
+    else:
+        snapshots = parse(sys.stdin)
+
+    if not snapshots:
+        sys.exit("no complete #HEAP ... #END snapshot found")
+
+    print_snapshots(snapshots)
+    print_modules(snapshots)
+    print_findings(snapshots)
+    if args.csv:
+        write_csv(args.csv, snapshots)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""Query and offload the flash data log over the pipe (app_log.c).
+
+The firmware must be built with APP_LOG_ENABLE=1 for both the compiler and
+the linker. Over an LE credit based channel on Linux (BlueZ), with the
+address of the board and the PSM read from its Transparent Credit Based
+service:
+
+    log_offload.py --addr 00:04:25:1A:2B:3C --psm 0x0081 query
+    log_offload.py --addr 00:04:25:1A:2B:3C --psm 0x0081 offload -o log.csv
+    log_offload.py --addr 00:04:25:1A:2B:3C --psm 0x0081 offload --t0 1000 --t1 2000
+
+A build with APP_AEAD_ENABLE answers only in a session opened with its
+APP_AEAD_KEY, given with --aead-key or --aead-key-file (aead_peer.py); the
+requests go in clear, and the batches and responses come sealed.
+
+Times are in the unit the firmware logs them in; both ends of the range are
+included. The records come in batches, each one pipe message (a 2 byte
+little endian length, then the message) spread over many SDUs; the board
+answers the offload once the last batch is sent.
+
+--raw saves the pipe messages as received, opened in a session; -i decodes
+such a file instead of connecting.
+"""
+
+import argparse
+import ctypes
+import os
+import select
+import socket
+import struct
+import sys
+import time
+
+import aead_peer
+
+MAGIC = b"\x7eLOG"
+OP_QUERY = b"Q"
+OP_OFFLOAD = b"O"
+OP_CANCEL = b"C"
+OP_BATCH = ord("B")
+OP_RESPONSE = ord("R")
+RSP_LEN = 15
+RECORD_SIZE = 32
+
+STATUS = {
+    0: "ok",
+    1: "bad state (log not reserved, or an offload is running)",
+    2: "bad size",
+}
+
+SOL_BLUETOOTH = 274
+BDADDR_LE_PUBLIC = 1
+BDADDR_LE_RANDOM = 2
+
+
+class Channel:
+    """LE credit based channel to the pipe, yielding whole pipe messages."""
+
+    def __init__(self, addr, psm, random_addr):
+        self.sock = socket.socket(socket.AF_BLUETOOTH, socket.SOCK_SEQPACKET,
+                                  socket.BTPROTO_L2CAP)
+        # struct sockaddr_l2 with the LE address type, which the socket
+        # module cannot fill in.
+        sa = struct.pack("<HH6sHBx", socket.AF_BLUETOOTH, psm,
+                         bytes.fromhex(addr.replace(":", ""))[::-1], 0,
+                         BDADDR_LE_RANDOM if random_addr else BDADDR_LE_PUBLIC)
+        libc = ctypes.CDLL(None, use_errno=True)
+        if libc.connect(self.sock.fileno(), ctypes.c_char_p(sa), len(sa)) != 0:
+            err = ctypes.get_errno()
+            sys.exit("connect %s psm 0x%04X: %s" % (addr, psm, os.strerror(err)))
+        self.rx = bytearray()
+        self.bytes = 0
+
+    def send(self, msg):
+        self.sock.send(struct.pack("<H", len(msg)) + msg)
+
+    def messages(self, timeout):
+        """Yield the pipe messages until none comes for timeout seconds."""
+        while True:
+            ready, _, _ = select.select([self.sock], [], [], timeout)
+            if not ready:
+                return
+            sdu = self.sock.recv(65535)
+            self.bytes += len(sdu)
+            self.rx += sdu
+            while len(self.rx) >= 2:
+                length = struct.unpack("<H", self.rx[:2])[0]
+                if len(self.rx) < 2 + length:
+                    break
+                msg = bytes(self.rx[2:2 + length])
+                del self.rx[:2 + length]
+                yield msg
+
+
+def read_messages(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    pos = 0
+    while pos + 2 <= len(data):
+        length = struct.unpack("<H", data[pos:pos + 2])[0]
+        yield data[pos + 2:pos + 2 + length]
+        pos += 2 + length
+
+
+def response(msg):
+    """(request, status, first sequence, count) of a log response, or None."""
+    if len(msg) != RSP_LEN or msg[:4] != MAGIC or msg[4] != OP_RESPONSE:
+        return None
+    first, count = struct.unpack("<II", msg[7:15])
+    return chr(msg[5]), msg[6], first, count
+
+
+def records(msg, size):
+    """(seq, time, data) of each record of a batch."""
+    body = msg[5:]
+    for off in range(0, len(body) - size + 1, size):
+        seq, t = struct.unpack("<II", body[off:off + 8])
+        yield seq, t, body[off + 8:off + size]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("command", nargs="?", choices=("query", "offload"), default="offload")
+    ap.add_argument("--t0", type=lambda s: int(s, 0), default=0, help="range start (default 0)")
+    ap.add_argument("--t1", type=lambda s: int(s, 0), default=0xFFFFFFFF,
+                    help="range end, included (default 0xFFFFFFFF)")
+    ap.add_argument("--addr", help="board address")
+    ap.add_argument("--random", action="store_true",
+                    help="the board address is a random one")
+    ap.add_argument("--psm", type=lambda s: int(s, 0), help="data channel PSM")
+    ap.add_argument("--aead-key", help="APP_AEAD_KEY as hex, to open a session first")
+    ap.add_argument("--aead-key-file", help="file holding APP_AEAD_KEY, raw bytes")
+    ap.add_argument("--record-size", type=int, default=RECORD_SIZE,
+                    help="APP_LOG_RECORD_SIZE of the firmware (default %d)" % RECORD_SIZE)
+    ap.add_argument("--timeout", type=float, default=5.0,
+                    help="seconds without data before giving up (default 5)")
+    ap.add_argument("-o", "--output", help="write the records as CSV here (default stdout)")
+    ap.add_argument("--raw", help="also save the pipe messages received here, opened")
+    ap.add_argument("-i", "--input", help="decode pipe messages saved with --raw")
+    args = ap.parse_args()
+
+    if args.input is not None:
+        source = read_messages(args.input)
+        ch = None
+        session = None
+    else:
+        if args.addr is None or args.psm is None:
+            ap.error("give --addr and --psm, or -i")
+        ch = Channel(args.addr, args.psm, args.random)
+        aead_key = aead_peer.load_key(ap, args.aead_key, args.aead_key_file, "the AEAD key")
+        session = None
+        if aead_key is not None:
+            session = aead_peer.open_session(ch, aead_key, args.timeout)
+        op = OP_QUERY if args.command == "query" else OP_OFFLOAD
+        ch.send(MAGIC + op + struct.pack("<II", args.t0, args.t1))
+        source = ch.messages(args.timeout)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    raw = open(args.raw, "wb") if args.raw else None
+    t_start = time.monotonic()
+    count = 0
+    last = None
+    gaps = 0
+    done = None
+    try:
+        for msg in source:
+            if session is not None:
+                msg = session.open(msg)
+                if msg is None:
+                    continue
+            if raw is not None:
+                raw.write(struct.pack("<H", len(msg)) + msg)
+            if msg[:4] != MAGIC or len(msg) < 5:
+                continue
+            if msg[4] == OP_BATCH:
+                for seq, t, data in records(msg, args.record_size):
+                    if last is not None and seq != last + 1:
+                        gaps += 1
+                    last = seq
+                    count += 1
+                    out.write("%d,%d,%s\n" % (seq, t, data.hex()))
+                continue
+            rsp = response(msg)
+            if rsp is None:
+                continue
+            op, status, first, n = rsp
+            if status:
+                sys.exit("'%s' refused: %s" % (op, STATUS.get(status, status)))
+            if op == "Q":
+                print("%d records from sequence %d" % (n, first), file=sys.stderr)
+                done = rsp
+                break
+            if op == "O":
+                done = rsp
+                break
+    except KeyboardInterrupt:
+        if ch is not None:
+            ch.send(MAGIC + OP_CANCEL)
+        raise
+    finally:
+        if out is not sys.stdout:
+            out.close()
+        if raw is not None:
+            raw.close()
+
+    if args.command == "offload" or args.input is not None:
+        secs = time.monotonic() - t_start
+        print("%d records, %d gaps in sequence" % (count, gaps), file=sys.stderr)
+        if ch is not None and secs > 0:
+            print("%d bytes in %.2f s (%.1f kbit/s)" % (ch.bytes, secs, ch.bytes * 8 / secs / 1000),
+                  file=sys.stderr)
+        if done is not None and done[3] != count:
+            print("board reports %d records sent" % done[3], file=sys.stderr)
+    if ch is not None and done is None:
+        sys.exit("no response within %.0f s" % args.timeout)
+
+
+if __name__ == "__main__":
+    main()
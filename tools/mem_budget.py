@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Summarize the RAM use of a build from its linker map file.
+
+The static allocation build (APP_STATIC_ALLOC in configuration.h) puts task
+stacks, queue storage and the pipe and TRCBPS arenas into one linker section
+per group. WBZ451.ld gives each group a budget and fails the link when one
+is exceeded. This script reads the map the link writes and prints each group
+against its budget, then the heaps, the other static data and the main
+stack. Any other build's map works too; the group lines are then empty.
+
+    mem_budget.py ble_cbp.X/dist/default/production/ble_cbp.X.production.map
+    mem_budget.py --top 15 app.map
+
+The exit status is 1 when a group is over budget, so the script can run as
+a post-build step.
+"""
+
+import argparse
+import re
+import sys
+
+SYMBOL = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+__app_static_(\w+?)_(start|end|budget)\b")
+RAM_ROW = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\d+)")
+RAM_TOTAL = re.compile(r"Total RAM used\s*:\s*0x[0-9a-fA-F]+\s+(\d+)\s+[\d.]+% of 0x([0-9a-fA-F]+)")
+STACK_ROW = re.compile(r"^stack\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+\s+(\d+)")
+
+GROUP_ORDER = ["tasks", "queues", "pipe", "trcbps"]
+GROUP_NAMES = {
+    "tasks": "task stacks",
+    "queues": "queue storage",
+    "pipe": "pipe arenas",
+    "trcbps": "TRCBPS arena",
+}
+HEAPS = {
+    ".bss.ucHeap": "FreeRTOS heap",
+    ".bss.g_extHeap": "BLE stack heap",
+}
+
+
+def parse_map(path):
+    groups = {}
+    rows = []
+    total = ram_size = stack = None
+    in_ram = False
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\r\n")
+            match = SYMBOL.match(line)
+            if match:
+                value, group, kind = int(match.group(1), 16), match.group(2), match.group(3)
+                groups.setdefault(group, {})[kind] = value
+                continue
+            if line.startswith("RAM Data-Memory Usage"):
+                in_ram = True
+                continue
+            if in_ram:
+                match = RAM_TOTAL.search(line)
+                if match:
+                    total, ram_size = int(match.group(1)), int(match.group(2), 16)
+                    in_ram = False
+                    continue
+                match = RAM_ROW.match(line)
+                if match:
+                    rows.append((match.group(1), int(match.group(2), 16), int(match.group(4))))
+                continue
+            match = STACK_ROW.match(line)
+            if match and stack is None:
+                stack = int(match.group(1))
+    return groups, rows, total, ram_size, stack
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", help="linker map file of the build")
+    parser.add_argument("--top", type=int, default=0, metavar="N", help="also list the N largest other RAM sections")
+    args = parser.parse_args()
+
+    try:
+        groups, rows, total, ram_size, stack = parse_map(args.map)
+    except OSError as err:
+        sys.stderr.write("%s\n" % err)
+        return 1
+    if total is None and not groups:
+        sys.stderr.write("%s: no RAM usage report or static allocation symbols found\n" % args.map)
+        return 1
+
+    over = False
+    print("%-22s %8s %8s %7s" % ("static group", "used", "budget", "use"))
+    for group in GROUP_ORDER + sorted(set(groups) - set(GROUP_ORDER)):
+        info = groups.get(group, {})
+        used = info.get("end", 0) - info.get("start", 0)
+        budget = info.get("budget")
+        if budget is None:
+            print("%-22s %8d %8s %7s" % (GROUP_NAMES.get(group, group), used, "-", "-"))
+            continue
+        pct = 100.0 * used / budget if budget else 0.0
+        flag = "  OVER BUDGET" if used > budget else ""
+        over = over or used > budget
+        print("%-22s %8d %8d %6.1f%%%s" % (GROUP_NAMES.get(group, group), used, budget, pct, flag))
+
+    heaps = {}
+    other = []
+    for name, addr, length in rows:
+        if name.startswith(".app_static_"):
+            continue
+        if name in HEAPS:
+            heaps[HEAPS[name]] = heaps.get(HEAPS[name], 0) + length
+        else:
+            other.append((length, name, addr))
+
+    print()
+    for name in sorted(heaps):
+        print("%-22s %8d" % (name, heaps[name]))
+    if rows:
+        print("%-22s %8d" % ("other static data", sum(length for length, _, _ in other)))
+    if stack is not None:
+        print("%-22s %8d" % ("main stack (reserved)", stack))
+    if total is not None:
+        print("%-22s %8d of %d (%.1f%%)" % ("total RAM used", total, ram_size, 100.0 * total / ram_size))
+
+    if args.top and other:
+        print()
+        for length, name, addr in sorted(other, reverse=True)[:args.top]:
+            print("  0x%08x %8d  %s" % (addr, length, name))
+
+    return 1 if over else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
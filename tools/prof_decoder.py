@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Decode CPU profile reports sent by the firmware (app_prof.c).
+
+A report is requested by sending "\\nPROF \\n" over the pipe and the window is
+restarted with "\\nPROFR\\n". The firmware answers with a binary frame on the
+debug UART and over the pipe. Feed this script a raw capture holding one or
+more frames (other output around them is skipped):
+
+    prof_decoder.py uart.bin
+    prof_decoder.py --folded prof.folded uart.bin    # for flamegraph.pl / speedscope
+
+For every frame it prints per task and per interrupt time, share of the
+window and worst case single run, followed by a bar chart of where the CPU
+went. Load is measured against wall clock time because the cycle counter
+stops while the idle task sleeps.
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\x7ePRF"
+VERSION = 1
+RECORD_KINDS = ("task", "isr")
+IDLE_TASK = "IDLE"
+BAR_WIDTH = 50
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Record:
+    def __init__(self, kind, name, cycles, count, max_cycles):
+        self.kind = kind
+        self.name = name
+        self.cycles = cycles
+        self.count = count
+        self.max_cycles = max_cycles
+
+
+class Report:
+    def __init__(self, cpu_hz, wall_ms, records):
+        self.cpu_hz = cpu_hz
+        self.wall_ms = wall_ms
+        self.records = records
+
+    @property
+    def window_cycles(self):
+        return self.cpu_hz * self.wall_ms // 1000
+
+    @property
+    def busy_cycles(self):
+        return sum(r.cycles for r in self.records
+                   if not (r.kind == "task" and r.name == IDLE_TASK))
+
+    def us(self, cycles):
+        return cycles * 1e6 / self.cpu_hz
+
+
+def parse_frame(data, pos):
+    """Parse the frame at pos. Returns (report, next position) or (None, pos + 1)."""
+    if len(data) < pos + 8:
+        return None, pos + 1
+    version, count, length = struct.unpack_from("<BBH", data, pos + 4)
+    end = pos + 4 + length
+    if version != VERSION or length < 12 or len(data) < end + 2:
+        return None, pos + 1
+    crc, = struct.unpack_from("<H", data, end)
+    if crc != crc16_ccitt(data[pos + 4:end]):
+        return None, pos + 1
+
+    cpu_hz, wall_ms = struct.unpack_from("<II", data, pos + 8)
+    offset = pos + 16
+    records = []
+    for _ in range(count):
+        kind, name_len = struct.unpack_from("<BB", data, offset)
+        offset += 2
+        name = data[offset:offset + name_len].decode("ascii", "replace")
+        offset += name_len
+        cycles, calls, max_cycles = struct.unpack_from("<QII", data, offset)
+        offset += 16
+        records.append(Record(RECORD_KINDS[kind] if kind < len(RECORD_KINDS) else "?",
+                              name, cycles, calls, max_cycles))
+    if offset != end:
+        return None, pos + 1
+    return Report(cpu_hz, wall_ms, records), end + 2
+
+
+def parse_reports(data):
+    reports = []
+    pos = data.find(SYNC)
+    while pos >= 0:
+        report, pos = parse_frame(data, pos)
+        if report is not None:
+            reports.append(report)
+        pos = data.find(SYNC, pos)
+    return reports
+
+
+def print_report(index, report, out):
+    window = report.window_cycles or 1
+    busy = report.busy_cycles
+    out.write("\n=== report %d: %.3f s at %.1f MHz, load %.1f %%, idle %.1f %%\n" % (
+        index, report.wall_ms / 1000.0, report.cpu_hz / 1e6,
+        100.0 * busy / window, max(0.0, 100.0 - 100.0 * busy / window)))
+    out.write("%-5s %-16s %12s %7s %10s %10s %10s\n" % (
+        "kind", "name", "time [ms]", "cpu %", "count", "avg [us]", "max [us]"))
+    for r in sorted(report.records, key=lambda r: r.cycles, reverse=True):
+        avg = r.cycles / r.count if r.count else 0
+        out.write("%-5s %-16s %12.3f %7.2f %10d %10.1f %10.1f\n" % (
+            r.kind, r.name, report.us(r.cycles) / 1000.0, 100.0 * r.cycles / window,
+            r.count, report.us(avg), report.us(r.max_cycles)))
+
+    # Flame style summary: one bar per consumer, scaled to the whole window
+    out.write("\n%-22s |%s|\n" % ("cpu", "#" * BAR_WIDTH))
+    for r in sorted(report.records, key=lambda r: r.cycles, reverse=True):
+        if r.cycles == 0:
+            continue
+        width = max(1, int(round(BAR_WIDTH * r.cycles / window)))
+        out.write("%-22s |%-*s|\n" % ("  %s:%s" % (r.kind, r.name), BAR_WIDTH, "#" * min(width, BAR_WIDTH)))
+
+
+def write_folded(reports, path):
+    """Folded stacks (cpu;kind;name cycles) summed over all reports."""
+    totals = {}
+    for report in reports:
+        for r in report.records:
+            key = "cpu;%s;%s" % (r.kind, r.name.replace(";", "_").replace(" ", "_"))
+            totals[key] = totals.get(key, 0) + r.cycles
+    with open(path, "w") as f:
+        for key, cycles in sorted(totals.items()):
+            if cycles:
+                f.write("%s %d\n" % (key, cycles))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--folded", metavar="FILE", help="also write folded stacks to FILE")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    reports = parse_reports(data)
+    if not reports:
+        sys.stderr.write("no profile report found\n")
+        return 1
+    for index, report in enumerate(reports):
+        print_report(index, report, sys.stdout)
+    if args.folded:
+        write_folded(reports, args.folded)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
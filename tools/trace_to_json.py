@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""Convert event trace frames drained from the firmware (app_trace.c) to JSON.
+
+Tracing runs from boot. Over the pipe, "\\nTRCOF\\n" freezes the ring,
+"\\nTRCON\\n" resumes it and "\\nTRCDP\\n" drains it; the frames are sent on
+the debug UART and over the pipe. Feed this script a raw capture holding one
+or more drains (other output around them is skipped):
+
+    trace_to_json.py uart.bin > trace.json
+    trace_to_json.py --text uart.bin
+
+The JSON is in the Chrome trace event format, which chrome://tracing,
+https://ui.perfetto.dev and speedscope open directly. Each event class gets
+its own track; queue depths, credits and heap usage are shown as counters.
+
+Timestamps are core cycles since the drain window started, converted to
+microseconds. The cycle counter stops while the device sleeps, so idle gaps
+are shorter than they were in wall clock time.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+SYNC = b"\x7eTRC"
+VERSION = 1
+HEADER_SIZE = 20
+
+EVT_NAMES = {
+    1: "pipe_tx_enq",
+    2: "pipe_tx_deq",
+    3: "pipe_rx_enq",
+    4: "pipe_rx_deq",
+    5: "sdu_tx",
+    6: "sdu_rx",
+    7: "credit_grant",
+    8: "credit_recv",
+    9: "stack_evt",
+    10: "heap_alloc",
+    11: "heap_free",
+    12: "heap_fail",
+    13: "bt_sys",
+    14: "data",
+    15: "mark",
+}
+EVT_DATA = 14
+EVT_BT_SYS = 13
+
+# Track (thread id, name) per event id
+TRACKS = {
+    1: (1, "pipe"), 2: (1, "pipe"), 3: (1, "pipe"), 4: (1, "pipe"),
+    5: (2, "l2cap"), 6: (2, "l2cap"), 7: (2, "l2cap"), 8: (2, "l2cap"),
+    9: (3, "stack events"),
+    10: (4, "heap"), 11: (4, "heap"), 12: (4, "heap"),
+    13: (5, "bt_sys"),
+    15: (6, "marks"),
+}
+
+STACK_GROUPS = {1: "GAP", 2: "L2CAP", 3: "SMP", 4: "GATT"}
+MEM_TAGS = ["DEFAULT", "BLE_STACK", "BLE_EVT", "BLE_DM", "TRCBPS", "PIPE", "APP"]
+
+
+def crc16_ccitt(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+class Frame:
+    def __init__(self, last, cpu_hz, seq, head, events):
+        self.last = last
+        self.cpu_hz = cpu_hz
+        self.seq = seq
+        self.head = head
+        self.events = events
+
+
+def parse_frames(data):
+    frames = []
+    pos = data.find(SYNC)
+    while pos >= 0:
+        frame, pos = parse_frame(data, pos)
+        if frame is not None:
+            frames.append(frame)
+        pos = data.find(SYNC, pos)
+    return frames
+
+
+def parse_frame(data, pos):
+    if len(data) < pos + HEADER_SIZE:
+        return None, pos + 1
+    version, flags, length = struct.unpack_from("<BBH", data, pos + 4)
+    end = pos + 4 + length
+    if version != VERSION or length < HEADER_SIZE - 4 or (length - (HEADER_SIZE - 4)) % 8 or len(data) < end + 2:
+        return None, pos + 1
+    crc, = struct.unpack_from("<H", data, end)
+    if crc != crc16_ccitt(data[pos + 4:end]):
+        return None, pos + 1
+    cpu_hz, seq, head = struct.unpack_from("<III", data, pos + 8)
+    events = [struct.unpack_from("<II", data, off) for off in range(pos + HEADER_SIZE, end, 8)]
+    return Frame(bool(flags & 1), cpu_hz, seq, head, events), end + 2
+
+
+def group_drains(frames):
+    """Split frames into drains; a drain ends with a frame flagged last."""
+    drains, current = [], []
+    for frame in frames:
+        current.append(frame)
+        if frame.last:
+            drains.append(current)
+            current = []
+    if current:
+        drains.append(current)
+    return drains
+
+
+def decode_drain(frames):
+    """Yield (seq, cycles, id, aux, arg, payload) with the cycle counter unwrapped."""
+    raw = {}
+    for frame in frames:
+        for i, evt in enumerate(frame.events):
+            raw[frame.seq + i] = evt
+    if not raw:
+        return []
+
+    decoded = []
+    prev_ts = None
+    cycles = 0
+    seqs = sorted(raw)
+    i = 0
+    while i < len(seqs):
+        seq = seqs[i]
+        ts, info = raw[seq]
+        evt_id, aux, arg = info & 0xFF, (info >> 8) & 0xFF, info >> 16
+        i += 1
+        if evt_id == EVT_DATA:
+            continue    # orphaned continuation, its header was overwritten
+
+        # Signed 32 bit delta: tolerates writers that stamped slightly out of order
+        if prev_ts is not None:
+            delta = (ts - prev_ts) & 0xFFFFFFFF
+            if delta & 0x80000000:
+                delta -= 1 << 32
+            cycles += delta
+        prev_ts = ts
+
+        payload = None
+        if evt_id == EVT_BT_SYS:
+            payload = bytearray([arg & 0xFF, arg >> 8])[:aux]
+            while i < len(seqs) and seqs[i] == seqs[i - 1] + 1 and raw[seqs[i]][1] & 0xFF == EVT_DATA:
+                cts, cinfo = raw[seqs[i]]
+                payload += struct.pack("<I", cts) + struct.pack("<I", cinfo)[1:]
+                i += 1
+            payload = bytes(payload[:aux])
+        decoded.append((seq, cycles, evt_id, aux, arg, payload))
+    return decoded
+
+
+def describe(evt_id, aux, arg, payload):
+    if evt_id == 9:
+        return "%s evt 0x%02x" % (STACK_GROUPS.get(aux, "grp%d" % aux), arg), {"group": aux, "event": arg}
+    if evt_id in (10, 11, 12):
+        tag = MEM_TAGS[aux] if aux < len(MEM_TAGS) else ("?" if aux == 0xFF else str(aux))
+        return "%s %s %d" % (EVT_NAMES[evt_id], tag, arg), {"tag": tag, "size": arg}
+    if evt_id == EVT_BT_SYS:
+        return "bt_sys %s" % payload.hex(), {"length": aux, "payload": payload.hex()}
+    if evt_id == 5:
+        return "sdu_tx %d%s" % (arg, " rejected" if aux else ""), {"length": arg, "rejected": aux}
+    if evt_id in (1, 2, 3, 4):
+        return "%s %d" % (EVT_NAMES[evt_id], arg), {"length": arg, "free_slots": aux}
+    return "%s %d" % (EVT_NAMES.get(evt_id, "evt%d" % evt_id), arg), {"aux": aux, "arg": arg}
+
+
+def to_chrome(drains):
+    out = [{"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "WBZ451"}}]
+    for tid, name in sorted(set(TRACKS.values())):
+        out.append({"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": name}})
+
+    offset_us = 0.0
+    for frames, events in drains:
+        cpu_hz = frames[0].cpu_hz or 64000000
+        heap = {}
+        credits = 0
+        end_us = offset_us
+        for seq, cycles, evt_id, aux, arg, payload in events:
+            ts = offset_us + cycles * 1e6 / cpu_hz
+            end_us = max(end_us, ts)
+            args = describe(evt_id, aux, arg, payload)[1]
+            args["seq"] = seq
+            tid = TRACKS.get(evt_id, (7, "other"))[0]
+            out.append({"ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                        "name": EVT_NAMES.get(evt_id, "evt%d" % evt_id), "args": args})
+
+            if evt_id in (1, 2):
+                out.append({"ph": "C", "pid": 1, "ts": ts, "name": "pipe tx free slots", "args": {"slots": aux}})
+            elif evt_id in (3, 4):
+                out.append({"ph": "C", "pid": 1, "ts": ts, "name": "pipe rx free slots", "args": {"slots": aux}})
+            elif evt_id in (5, 8):
+                credits += arg if evt_id == 8 else (0 if aux else -1)
+                out.append({"ph": "C", "pid": 1, "ts": ts, "name": "peer credits (relative)", "args": {"credits": credits}})
+            elif evt_id in (10, 11) and aux != 0xFF:
+                tag = MEM_TAGS[aux] if aux < len(MEM_TAGS) else str(aux)
+                heap[tag] = heap.get(tag, 0) + (arg if evt_id == 10 else -arg)
+                out.append({"ph": "C", "pid": 1, "ts": ts, "name": "heap (relative)", "args": dict(heap)})
+        # Lay successive drains one after the other with a small gap
+        offset_us = end_us + 1000.0
+    return {"traceEvents": out, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--text", action="store_true", help="print a text listing instead of JSON")
+    args = parser.parse_args()
+
+    if args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    drains = []
+    for frames in group_drains(parse_frames(data)):
+        events = decode_drain(frames)
+        head = frames[-1].head
+        first = frames[0].seq
+        received = sum(len(f.events) for f in frames)
+        sys.stderr.write("drain: %d events recorded, %d overwritten, %d received\n" % (head, first, received))
+        drains.append((frames, events))
+    if not drains:
+        sys.stderr.write("no trace frame found\n")
+        return 1
+
+    if args.text:
+        for frames, events in drains:
+            cpu_hz = frames[0].cpu_hz or 64000000
+            for seq, cycles, evt_id, aux, arg, payload in events:
+                sys.stdout.write("%8d %12.3f us  %s\n" % (seq, cycles * 1e6 / cpu_hz, describe(evt_id, aux, arg, payload)[0]))
+    else:
+        json.dump(to_chrome(drains), sys.stdout)
+        sys.stdout.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())